@@ -10,7 +10,6 @@
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
 #include <WiFi.h>
-#include <WiFiMulti.h>
 #include <AsyncTCP.h>
 #include "myEveryN.h"
 
@@ -40,23 +39,41 @@ static uint32_t rtPrevUs    = 0;
 #include <WebSerial.h>
 #include "Vitocal_datapoints.h"
 #include "Vitocal_polling.h"
-#include <string.h>  // for strcmp
+#include "Vitocal_blockread.h"
+#include "Vitocal_scheduler.h"
+#include "Vitocal_adaptive.h"
+#include "Vitocal_writequeue.h"
+#include "Vitocal_log.h"
+#include "Vitocal_metrics.h"
+#include "Vitocal_profiler.h"
+#include "Vitocal_history.h"
+#include "Vitocal_values.h"
+#include "Vitocal_mqttqueue.h"
+#include "Vitocal_sse.h"
+#include "Vitocal_api.h"
+#include "Vitocal_dpdefs.h"
+#include "Vitocal_dashboard.h"
+#include "Vitocal_capture.h"
+#include "Vitocal_protocol.h"
+#include "Vitocal_wifi.h"
+#include "Vitocal_optotask.h"
+#include "Vitocal_aggregate.h"
+#include "Vitocal_discovery.h"
 
 // forward declarations
 void onVitoResponse(const uint8_t* data, uint8_t length, const VitoWiFi::Datapoint& request);
 void onVitoError(VitoWiFi::OptolinkResult error, const VitoWiFi::Datapoint& request);
 
 // serial config
-#define OPTOLINK_SERIAL Serial0
+#define OPTOLINK_UART   0           // Serial0
 #define CONSOLE_SERIAL  WebSerial   // configure "Serial" or "WebSerial"
 #define SERIALBAUDRATE  115200
 
-// Initialize VitoWiFi with the hardware serial port
-VitoWiFi::VitoWiFi<VitoWiFi::VS1> vitoWIFI(&OPTOLINK_SERIAL);
-
-inline bool isDp(const VitoWiFi::Datapoint& req, const VitoWiFi::Datapoint& dp) {
-    return strcmp(req.name(), dp.name()) == 0;
-}
+// Initialize VitoWiFi with the hardware serial port behind the capture tap
+// (Vitocal_capture.h); VS1 or VS2 is chosen in setup() (VITO_PROTOCOL, see
+// Vitocal_protocol.h)
+VitoCaptureSerial optolinkSerial(OPTOLINK_UART);
+VitoOptolink vitoWIFI(&optolinkSerial);
 
 // Web server configuration and WiFi credentials
 #if __has_include("secrets.h")
@@ -75,9 +92,6 @@ IPAddress       secondaryDNS(192, 168, 0, 1);   //optional
 AsyncWebServer    server(80);
 AsyncEventSource  events("/events");
 
-// MultiWifi object
-WiFiMulti WiFiMulti;
-
 // Home Assistant integration
 #define BROKER_ADDR             "homeassistant.local"    
 #define BROKER_USERNAME         MQTT_USER
@@ -110,7 +124,10 @@ HADevice device;
 #else
 HADevice device(HA_DEVICE_UNIQUE_ID);
 #endif
-HAMqtt mqtt(client, device, 30);
+// max entities: the 40 of HA_mqtt_addin.h, its derived figures and the LittleFS definitions
+#define VITO_HA_ENTITIES (40 + VITO_AGG_OUTPUTS + VITO_DEFS_MAX)
+static_assert(VITO_HA_ENTITIES <= 255, "HAMqtt counts its entities in a uint8_t");
+HAMqtt mqtt(client, device, VITO_HA_ENTITIES);
 
 
 // HA sensors and voids
@@ -119,23 +136,20 @@ HAMqtt mqtt(client, device, 30);
 // other
 // Loop bookkeeping and simple runtime state
 static int     count     = 0;
-static int     eHeiz1    = 0;
-static int     eHeiz2    = 0;
 static boolean toggle    = false;
-// Error handling and health monitoring
+// Error handling and health monitoring (counted by the Optolink task)
 volatile uint32_t vitoErrorCount = 0;
 volatile uint32_t vitoConsecutiveErrors = 0;
 volatile uint32_t vitoErrorThreshold = 30;   // threshold for consecutive errors (configurable via HA)
 static const uint32_t vitoErrorWindowMs  = 60000; // window for total errors
 uint32_t vitoErrorWindowStartMs = 0;
 
-// Default group intervals tuned for stability vs. throughput
-static const uint32_t DEFAULT_FAST_INTERVAL_MS   = 60000UL; // relays/pumps/compressor/status
-static const uint32_t DEFAULT_MEDIUM_INTERVAL_MS = 85000UL; // temperatures
-static const uint32_t DEFAULT_SLOW_INTERVAL_MS   = 180000UL; // setpoints/hysteresis/heating curve
-VitoPollGroupState vitoFastState   = {0, 0, 0, DEFAULT_FAST_INTERVAL_MS};
-VitoPollGroupState vitoMediumState = {0, 0, 0, DEFAULT_MEDIUM_INTERVAL_MS};
-VitoPollGroupState vitoSlowState   = {0, 0, 0, DEFAULT_SLOW_INTERVAL_MS};
+// Poll class intervals; defaults from dpspec.toml (Vitocal_dpspec.h)
+VitoPollClassState vitoPollClasses[VITO_CLASS_COUNT] = {
+  {vitoClassDefaultMs[VITO_CLASS_FAST],   vitoClassDefaultMs[VITO_CLASS_FAST]},
+  {vitoClassDefaultMs[VITO_CLASS_MEDIUM], vitoClassDefaultMs[VITO_CLASS_MEDIUM]},
+  {vitoClassDefaultMs[VITO_CLASS_SLOW],   vitoClassDefaultMs[VITO_CLASS_SLOW]},
+};
 
 // Global VitoWiFi scheduling state:
 // - at most one in-flight request at a time
@@ -148,201 +162,410 @@ static const uint32_t vitoResponseGapMs = VITO_RESPONSE_GAP_MS;
 static bool     vitoBusy           = false; // true while we wait for a response
 static uint32_t vitoLastResponseMs = 0;     // millis() when last response/error arrived
 
-// labels
-static const char* const operationModeLabels[] = {
-  "Abschaltbetrieb",
-  "Warmwasser",
-  "Heizen und Warmwasser",
-  "undefiniert",
-  "dauernd reduziert",
-  "dauernd normal",
-  "normal Abschalt",
-  "nur kuehlen"
-};
+// Optolink throughput: completed reads (transactions) since boot, counted by
+// the Optolink task; loop() reports the rate per window
+static volatile uint32_t vitoReadCount = 0;
+static uint32_t vitoReadCountAtWindow  = 0;
+static uint32_t vitoReadWindowStartMs  = 0;
 
-static const char* const manualModeLabels[] = {
-  "normal",
-  "manuell",
-  "WW auf Temp2"
-};
+// --- Per-datapoint timing, indexed by VitoDpId ---------------------------
+// (values, their age and error state: Vitocal_values.h)
+static uint32_t dpLastRequestMs[DP_COUNT] = {0};  // when we queued the read() (Optolink task)
 
-static const char* labelOrFallback(uint8_t index, const char* const* table, size_t tableSize)
-{
-  if (tableSize == 0) {
-    return "n/a";
+// HA / loop() context: the Optolink task rescales the schedule (Vitocal_optotask.h)
+void vitoSetClassInterval(uint8_t cls, uint32_t intervalMs) {
+  if (cls >= VITO_CLASS_COUNT || intervalMs == 0) {
+    return;
   }
-  if (index < tableSize) {
-    return table[index];
-  }
-  return "Unknown";
-}
-
-// per-DP last-success timestamps (ms since boot)
-static uint32_t lastTempOutsideMs      = 0;
-static uint32_t lastWWobenMs           = 0;
-static uint32_t lastVorlaufSollMs      = 0;
-static uint32_t lastVorlaufIstMs       = 0;
-static uint32_t lastRuecklaufMs        = 0;
-static uint32_t lastRelEHeiz1Ms        = 0;
-static uint32_t lastRelEHeiz2Ms        = 0;
-static uint32_t lastHeizkreispumpeMs   = 0;
-static uint32_t lastWWZirkPumpeMs      = 0;
-static uint32_t lastRelVerdichterMs    = 0;
-static uint32_t lastRelPrimaerMs       = 0;
-static uint32_t lastRelSekundaerMs     = 0;
-static uint32_t lastVentilHeizenWWMs   = 0;
-static uint32_t lastOperationModeMs    = 0;
-static uint32_t lastManualModeMs       = 0;
-static uint32_t lastRaumSollMs         = 0;
-static uint32_t lastRaumSollRedMs      = 0;
-static uint32_t lastWWSollMs           = 0;
-static uint32_t lastWWSoll2Ms          = 0;
-static uint32_t lastHystWWSollMs       = 0;
-static uint32_t lastHKniveauMs         = 0;
-static uint32_t lastHKneigungMs        = 0;
-
-// --- Per-datapoint timing info: request -> response round-trip ----------
-
-struct DpTimingInfo {
-    const VitoWiFi::Datapoint* dp;
-    uint32_t lastRequestMs;   // when we queued the read()
-};
+  vitoPollClasses[cls].intervalMs = intervalMs;
+  vitoOptoClassInterval(cls, intervalMs);
+}
 
-DpTimingInfo dpTiming[] = {
-    { &dpTempOutside,      0 },
-    { &dpWWoben,           0 },
-    { &dpVorlaufSoll,      0 },
-    { &dpVorlaufIst,       0 },
-    { &dpRuecklauf,        0 },
-    { &dpRelEHeizStufe1,   0 },
-    { &dpRelEHeizStufe2,   0 },
-    { &dpHeizkreispumpe,   0 },
-    { &dpWWZirkPumpe,      0 },
-    { &dpRelVerdichter,    0 },
-    { &dpRelPrimaerquelle, 0 },
-    { &dpRelSekundaerPumpe,0 },
-    { &dpVentilHeizenWW,   0 },
-    { &dpOperationMode,    0 },
-    { &dpManualMode,       0 },
-    { &dpTempRaumSoll,     0 },
-    { &dpTempRaumSollRed,  0 },
-    { &dpTempWWSoll,       0 },
-    { &dpTempWWSoll2,      0 },
-    { &dpTempHystWWSoll,   0 },
-    { &dpTempHKniveau,     0 },
-    { &dpTempHKNeigung,    0 },
-    { &dpStoerung,         0 }
-};
 
-constexpr size_t dpTimingCount = sizeof(dpTiming) / sizeof(dpTiming[0]);
-
-
-// VitoWiFi datapoint polling groups
-// fast: relays, pumps, compressor, error (operational status)
-VitoWiFi::Datapoint* vitoFast[] = {
-  &dpHeizkreispumpe,
-  &dpWWZirkPumpe,
-  &dpRelVerdichter,
-  &dpRelPrimaerquelle,
-  &dpRelSekundaerPumpe,
-  &dpRelEHeizStufe1,
-  &dpRelEHeizStufe2,
-  &dpVentilHeizenWW,
-  &dpStoerung
-};
-const int vitoFastSize = sizeof(vitoFast) / sizeof(vitoFast[0]);
-
-// medium: temperatures
-VitoWiFi::Datapoint* vitoMedium[] = {
-  &dpTempOutside,
-  &dpWWoben,
-  &dpVorlaufSoll,
-  &dpVorlaufIst,
-  &dpRuecklauf,
-  &dpOperationMode,
-  &dpManualMode,
-};
-const int vitoMediumSize = sizeof(vitoMedium) / sizeof(vitoMedium[0]);
-
-// slow: setpoints, hysteresis, heating curve
-VitoWiFi::Datapoint* vitoSlow[] = {
-  &dpTempRaumSoll,
-  &dpTempRaumSollRed,
-  &dpTempWWSoll,
-  &dpTempWWSoll2,
-  &dpTempHystWWSoll,
-  &dpTempHKniveau,
-  &dpTempHKNeigung
-};
-const int vitoSlowSize = sizeof(vitoSlow) / sizeof(vitoSlow[0]);
+// Block reads per group (planned in setup(), see Vitocal_blockread.h)
+VitoBlockRange vitoFastBlocks   = {0, 0};
+VitoBlockRange vitoMediumBlocks = {0, 0};
+VitoBlockRange vitoSlowBlocks   = {0, 0};
+
+// (Re)plan the block reads of all groups; setup() and the Optolink task after
+// the circuit breakers split or rejoined a block (vitoBlockReplan).
+static void vitoPlanBlocks() {
+  vitoPlanReset();
+  vitoFastBlocks   = vitoPlanGroup(vitoFast,   vitoFastSize);
+  vitoMediumBlocks = vitoPlanGroup(vitoMedium, vitoMediumSize);
+  vitoSlowBlocks   = vitoPlanGroup(vitoSlow,   vitoSlowSize);
+  memset(vitoBlockSchedule, 0, sizeof(vitoBlockSchedule));
+  vitoLog(VITO_LOG_INFO, VITO_EV_PLAN, VITO_DP_NONE, vitoFastBlocks.count, vitoMediumBlocks.count,
+          vitoSlowBlocks.count);
+}
 
-// --- per-DP timing helpers -------------------------------------
-inline void logDpFloat(const char* tag, float val, uint32_t& lastMs) {
-    uint32_t now = millis();
-    uint32_t dt  = lastMs ? (now - lastMs) : 0;
-    lastMs = now;
+// --- Datapoint hooks (dpspec.toml "hook", see Vitocal_dpentities.h) -----
+// Side effects beyond the datapoint's own HA entity
+static void onVorlaufIst(const VitoDpValue& v) {
+    HVACwaermepumpe.setCurrentTemperature(v.f);
+}
+
+// Hook of both heater relays: the stage follows a change of either of them
+static void onRelEHeiz(const VitoDpValue&) {
+    static uint32_t lastMs = 0;
+    int eHeiz = vitoValGet(DP_REL_EHEIZ1).u8 + (2 * vitoValGet(DP_REL_EHEIZ2).u8);
+    RelEHeizStufeSens.setValue(static_cast<uint8_t>(eHeiz));
+    HVACwaermepumpe.setAuxState(eHeiz != 0);
+    vitoLogValue(VITO_EV_COMBINED, DP_REL_EHEIZ2, (uint32_t)eHeiz, lastMs);
+}
+
+static void onRelVerdichter(const VitoDpValue& v) {
+    HVACwaermepumpe.setMode(v.u8 ? HAHVAC::HeatMode : HAHVAC::OffMode);
+}
+
+static void onManualMode(const VitoDpValue& v) {
+    selectManualMode.setState(v.u8);
+}
 
-    CONSOLE_SERIAL.print(tag);
-    CONSOLE_SERIAL.print(": ");
-    CONSOLE_SERIAL.print(val, 1);
-    if (dt) {
-        CONSOLE_SERIAL.print(" (Δt=");
-        CONSOLE_SERIAL.print(dt);
-        CONSOLE_SERIAL.print(" ms)");
+static void onRaumSoll(const VitoDpValue& v) {
+    HVACwaermepumpe.setTargetTemperature(v.f);
+}
+
+// Log text for a datapoint, formatted when the log is drained (Vitocal_log.h)
+const char* vitoLogTag(uint8_t id) {
+    return id < DP_COUNT ? vitoDpTable[id].tag : "?";
+}
+
+const char* vitoLogLabel(uint8_t id, uint8_t value) {
+    return id < DP_COUNT ? vitoLabelOrFallback(value, vitoDpTable[id].labels, vitoDpTable[id].labelCount) : "?";
+}
+
+// Last write result -> console and HA "Vito Last Write"
+static void vitoReportWrite(uint8_t id, uint8_t result, float written, uint32_t latencyMs, float readBack) {
+    switch (result) {
+    case VITO_WRITE_CONFIRMED:
+        snprintf(vitoWriteStatusText, sizeof(vitoWriteStatusText), "%s=%.1f ok (%lu ms)", vitoDpNames[id], written,
+                 (unsigned long)latencyMs);
+        break;
+    case VITO_WRITE_MISMATCH:
+        snprintf(vitoWriteStatusText, sizeof(vitoWriteStatusText), "%s=%.1f rejected, is %.1f", vitoDpNames[id], written, readBack);
+        break;
+    default:
+        snprintf(vitoWriteStatusText, sizeof(vitoWriteStatusText), "%s=%.1f failed", vitoDpNames[id], written);
+        break;
     }
-    CONSOLE_SERIAL.println();
+    vitoLog(VITO_LOG_INFO, VITO_EV_WRITE, id, result, vitoLogFloatBits(written),
+            result == VITO_WRITE_CONFIRMED ? latencyMs : vitoLogFloatBits(readBack));
+    vitoWriteStatusSens.setValue(vitoWriteStatusText);
 }
 
-inline void logDpUint(const char* tag, uint8_t v, uint32_t& lastMs) {
+// Failed write: put the last confirmed value back on the HA entity.
+static void vitoRepublish(uint8_t id) {
+    const VitoDpEntry& e = vitoDpTable[id];
+    const VitoPublishState& st = vitoPublishState[id];
+    if (!st.hasPublished) {
+        return;
+    }
+    VitoDpValue v = {st.published, (uint8_t)st.published, nullptr};
+    if (e.kind == VitoDpKind::Label) {
+        v.label = vitoLabelOrFallback(v.u8, e.labels, e.labelCount);
+    }
+    vitoPublishDp(id, e, v, true, millis());
+    if (e.hook) {
+        e.hook(v);
+    }
+}
+
+// Optolink task side of one decoded read: link metrics, polling state and the
+// write queue. The value goes on to loop() as a message (raw: its reply bytes).
+static void vitoOptoValue(uint8_t id, const VitoWiFi::VariantValue& value, const uint8_t* raw, uint8_t rawLen) {
+    float f = vitoDecodeEntry(vitoDpTable[id], value).f;
     uint32_t now = millis();
-    uint32_t dt  = lastMs ? (now - lastMs) : 0;
-    lastMs = now;
 
-    CONSOLE_SERIAL.print(tag);
-    CONSOLE_SERIAL.print(": ");
-    CONSOLE_SERIAL.print(v);
-    if (dt) {
-        CONSOLE_SERIAL.print(" (Δt=");
-        CONSOLE_SERIAL.print(dt);
-        CONSOLE_SERIAL.print(" ms)");
+    // link metrics: round trip of this read, age of the value it replaces
+    vitoMetricsOnRead(id, now - dpLastRequestMs[id], vitoSchedAge(id, now));
+
+    // polling follows the raw reads, HA gets them through the publish policy
+    vitoAdaptOnValue(id, f, now);
+    vitoSchedOnUpdate(id, now);
+
+    VitoOptoMsg m = {now, VITO_MSG_VALUE, id, VITO_WRITE_NOT_OURS, 0, {0, 0, 0, 0}, 0.0f, 0};
+    m.len = rawLen < VITO_MSG_RAW_MAX ? rawLen : VITO_MSG_RAW_MAX;
+    memcpy(m.raw, raw, m.len);
+    // read-back of a queued write: reported with the value that was written
+    m.aux = vitoWriteOnRead(id, f, now);
+    if (m.aux != VITO_WRITE_NOT_OURS) {
+        m.value = vitoWriteSlots[id].inFlight;
+        m.arg   = vitoWriteSlots[id].lastLatencyMs;
+    } else if (vitoWritePending(id)) {
+        m.len |= VITO_MSG_PENDING;
     }
-    CONSOLE_SERIAL.println();
+    vitoOptoPost(m);
 }
 
-inline void logDpMode(const char* tag, uint8_t v, const char* label, uint32_t& lastMs) {
-    uint32_t now = millis();
-    uint32_t dt  = lastMs ? (now - lastMs) : 0;
-    lastMs = now;
 
-    CONSOLE_SERIAL.print(tag);
-    CONSOLE_SERIAL.print(": ");
-    CONSOLE_SERIAL.print(v);
-    CONSOLE_SERIAL.print(" -> ");
-    CONSOLE_SERIAL.print(label);
-    if (dt) {
-        CONSOLE_SERIAL.print(" (Δt=");
-        CONSOLE_SERIAL.print(dt);
-        CONSOLE_SERIAL.print(" ms)");
+// Slice a block reply into its members and hand on each of them.
+static void vitoOptoBlock(uint8_t b, const uint8_t* data, uint8_t length) {
+    const VitoBlock& blk = vitoBlocks[b];
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        uint8_t id = vitoBlockMembers[blk.first + i];
+        const uint8_t* slice = vitoBlockSlice(blk, id, data, length);
+        if (slice == nullptr) {
+            continue;
+        }
+        VitoWiFi::Datapoint m = vitoDpDatapoint(id);
+        vitoOptoValue(id, m.decode(slice, m.length()), slice, m.length());
     }
-    CONSOLE_SERIAL.println();
 }
 
 
-// Run one paced polling step for a group.
-// - intervalMs: minimum time between start-of-round to start-of-next-round
-// - responseGapMs: minimum time after last response/error before any new request
-// Returns true if a request was actually queued.
-bool pollVitoGroup(
-    VitoPollGroupState &state,
-    VitoWiFi::Datapoint **group,
-    int groupSize,
-    uint32_t responseGapMs
-) {
+// --- Value store sinks (Vitocal_values.h), run on new reply bytes ------------
+static void vitoLogSink(uint8_t id, uint32_t, uint32_t sinceMs) {
+    const VitoDpValue& v = vitoValGet(id);
+    switch (vitoDpTable[id].kind) {
+    case VitoDpKind::Temperature:
+    case VitoDpKind::Setpoint:
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_VALUE_F, id, 0, vitoLogFloatBits(v.f), sinceMs);
+        break;
+    case VitoDpKind::Label:
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_VALUE_LABEL, id, 0, v.u8, sinceMs);
+        break;
+    default:
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_VALUE_U, id, 0, v.u8, sinceMs);
+        break;
+    }
+}
+
+static void vitoHistorySink(uint8_t id, uint32_t now, uint32_t) {
+    vitoHistoryAppend(id, now, vitoValGet(id).f);
+}
+
+static void vitoSseSink(uint8_t id, uint32_t, uint32_t) {
+    vitoSseMark(id);
+}
+
+static void vitoAggSink(uint8_t id, uint32_t now, uint32_t) {
+    vitoAggOnValue(id, vitoValGet(id).f, now);
+}
+
+static void vitoValSubscribeAll() {
+    if (VITO_LOG_DEBUG <= VITO_LOG_LEVEL) {
+        vitoValSubscribe(vitoLogSink);
+    }
+    vitoValSubscribe(vitoHistorySink);
+    vitoValSubscribe(vitoSseSink);
+    vitoValSubscribe(vitoAggSink);
+}
+
+
+// loop() side of a value: into the value store, which hands new bytes to
+// log, history, live stream and derived figures; then HA and the hook. The
+// same bytes again are not decoded and, unless the publish policy still
+// wants them (filter, heartbeat), go no further.
+static void vitoDispatch(const VitoOptoMsg& m) {
+    uint8_t id = m.id;
+    const VitoDpEntry& e = vitoDpTable[id];
+    uint32_t now = m.ms;
+    bool changed = vitoValPut(id, m.raw, m.len & ~VITO_MSG_PENDING, now);
+    vitoBatchOnRead(id);
+
+    // read-back of a queued write: publish what the controller holds now
+    if (m.aux != VITO_WRITE_NOT_OURS) {
+        const VitoDpValue& v = vitoValGet(id);
+        vitoPublishDp(id, e, v, true, now);
+        vitoPublishMark(id, v.f, now);
+        if (!mqtt.isConnected()) {
+            vitoMqPush(id, v.f, now);   // replayed after the outage (Vitocal_mqttqueue.h)
+        }
+        if (e.hook) {
+            e.hook(v);
+        }
+        vitoReportWrite(id, m.aux, m.value, m.arg, v.f);
+        return;
+    }
+    // a newer HA value is queued: do not snap HA back to the old one
+    if (m.len & VITO_MSG_PENDING) {
+        return;
+    }
+    if (!changed && !vitoPublishWantsRepeat(id, now)) {
+        return;
+    }
+
+    VitoDpValue v = vitoValGet(id);
+    if (e.kind == VitoDpKind::Temperature || e.kind == VitoDpKind::Setpoint) {
+        vitoPublishFilterValue(id, v.f);
+    }
+    uint8_t publish = vitoPublishDecide(id, v.f, now);
+    if (publish != VITO_PUBLISH_SKIP) {
+        vitoPublishDp(id, e, v, publish == VITO_PUBLISH_HEARTBEAT, now);
+        vitoPublishMark(id, v.f, now);
+        if (!mqtt.isConnected()) {
+            vitoMqPush(id, v.f, now);
+        }
+    }
+
+    // hooks publish too: run them with the entity, Raw ones on every change
+    if (e.hook && (publish != VITO_PUBLISH_SKIP || (changed && e.kind == VitoDpKind::Raw))) {
+        e.hook(v);
+    }
+}
+
+
+// One message of the Optolink task (loop() context).
+static void vitoDispatchMsg(const VitoOptoMsg& m) {
+    switch (m.kind) {
+    case VITO_MSG_VALUE:
+        if (m.id < DP_COUNT) {
+            vitoDispatch(m);
+        }
+        break;
+    case VITO_MSG_DEF_VALUE:
+        vitoDefsPublish(m.id, m.value);
+        break;
+    case VITO_MSG_ERROR:
+        vitoValOnError(m.id, vitoMetricErrorIndex(static_cast<VitoWiFi::OptolinkResult>(m.len)), m.ms);
+        break;
+    case VITO_MSG_WRITE_FAILED:
+        // restore the confirmed value in HA
+        vitoReportWrite(m.id, VITO_WRITE_FAILED, m.value, 0, 0.0f);
+        vitoRepublish(m.id);
+        break;
+    default:
+        break;
+    }
+}
+
+
+// Error counters of the Optolink task -> HA, when they changed (loop() context)
+static void vitoPublishErrorCounts() {
+    static uint32_t shownCount  = 0;
+    static uint32_t shownConsec = 0;
+    uint32_t count  = vitoErrorCount;
+    uint32_t consec = vitoConsecutiveErrors;
+    if (count != shownCount) {
+        shownCount = count;
+        vitoErrorCountSens.setValue(count);
+    }
+    if (consec != shownConsec) {
+        shownConsec = consec;
+        vitoConsecErrorSens.setValue(consec);
+    }
+}
+
+
+// Detected Optolink protocol -> HA, once (loop() context)
+static void vitoPublishProtocol() {
+    static bool shown = false;
+    if (!shown && vitoWIFI.ready()) {
+        shown = true;
+        vitoProtocolSens.setValue(vitoWIFI.protocolName());
+    }
+}
+
+
+// After a failed read: read the datapoint that answered last (Vitocal_breaker.h).
+// If it answers, the failure was the address', otherwise the link's.
+bool pollVitoProbe(uint32_t responseGapMs) {
+    uint32_t now = millis();
+    if (!vitoLinkProbePending || vitoBusy) {
+        return false;
+    }
+    if (vitoLastResponseMs != 0 &&
+        (long)(now - vitoLastResponseMs) < (long)responseGapMs) {
+        return false;
+    }
+    if (!vitoWIFI.read(vitoDpDatapoint(vitoLinkProbeDp))) {
+        return false;
+    }
+    vitoBusy = true;
+    vitoLinkProbePending  = false;
+    vitoLinkProbeInFlight = true;
+    dpLastRequestMs[vitoLinkProbeDp] = now;
+    return true;
+}
+
+
+// Serve the write queue: a due read-back first, then the next pending write.
+// Same pacing as the poller; returns true if a request was queued.
+bool pollVitoWrites(uint32_t responseGapMs) {
     uint32_t now = millis();
+    if (vitoBusy) {
+        return false;
+    }
+    if (vitoLastResponseMs != 0 &&
+        (long)(now - vitoLastResponseMs) < (long)responseGapMs) {
+        return false;
+    }
 
-    if (groupSize <= 0) {
+    uint8_t id = vitoWriteNext();
+    if (id == VITO_DP_NONE) {
         return false;
     }
+    VitoWriteSlot& s = vitoWriteSlots[id];
+    VitoWiFi::Datapoint dp = vitoDpDatapoint(id);
+    if (s.phase == VITO_WRITE_VERIFY) {
+        if (!vitoWIFI.read(dp)) {
+            return false;
+        }
+        vitoWriteReadStarted(id);
+    } else {
+        bool queued = dp.length() == 1
+                    ? vitoWIFI.write(dp, static_cast<uint8_t>(s.value))
+                    : vitoWIFI.write(dp, s.value);
+        if (!queued) {
+            return false;
+        }
+        vitoWriteStarted(id);
+    }
+    vitoBusy = true;
+    dpLastRequestMs[id] = now;
+    return true;
+}
+
+
+// Filler for GET /writes: queued writes and their command -> confirmation
+// latency per writable datapoint, whole objects as for GET /schedule.
+struct VitoWritesCursor {
+    uint16_t next;   // datapoint to look at, DP_COUNT = closing bracket
+    bool     open;   // "[" is out
+};
+
+static size_t vitoWritesFill(VitoWritesCursor& c, uint8_t* buf, size_t maxLen) {
+    static_assert(VITO_DP_NAME_LEN <= 64, "obj holds the longest object");
+    char obj[288];
+    size_t n = 0;
+    while (c.next <= DP_COUNT) {
+        int len;
+        if (c.next == DP_COUNT) {
+            len = snprintf(obj, sizeof(obj), "%s]", c.open ? "" : "[");
+        } else if (!(vitoDpSpecs[c.next].flags & VITO_DP_WRITABLE)) {
+            c.next++;
+            continue;
+        } else {
+            const VitoWriteSlot& s = vitoWriteSlots[c.next];
+            len = snprintf(obj, sizeof(obj),
+                           "%s{\"dp\":\"%s\",\"pending\":%s,\"confirmed\":%lu,\"failed\":%lu,"
+                           "\"coalesced\":%lu,\"lastMs\":%lu,\"meanMs\":%lu,\"maxMs\":%lu}",
+                           c.open ? "," : "[", vitoDpNames[c.next], vitoWritePending(c.next) ? "true" : "false",
+                           (unsigned long)s.confirmed, (unsigned long)s.failed, (unsigned long)s.coalesced,
+                           (unsigned long)s.lastLatencyMs,
+                           (unsigned long)(s.confirmed ? s.sumLatencyMs / s.confirmed : 0),
+                           (unsigned long)s.maxLatencyMs);
+        }
+        if (n + (size_t)len > maxLen) {
+            return n ? n : RESPONSE_TRY_AGAIN;
+        }
+        memcpy(buf + n, obj, (size_t)len);
+        n += (size_t)len;
+        c.open = true;
+        c.next++;
+    }
+    return n;
+}
+
+
+// Run one paced polling step.
+// - responseGapMs: minimum time after last response/error before any new request
+// - one step reads the block whose datapoint runs out of age budget first
+//   (one or more adjacent datapoints, see Vitocal_scheduler.h)
+// Returns true if a request was actually queued.
+bool pollVitoSchedule(uint32_t responseGapMs) {
+    uint32_t now = millis();
 
     // 0) Only one request in flight at any time.
     if (vitoBusy) {
@@ -355,49 +578,107 @@ bool pollVitoGroup(
         return false;
     }
 
-    // 2) Respect group start-to-start interval
-    if (state.index == 0 && state.lastRoundEndMs != 0) {
-        if ((long)(now - state.lastRoundEndMs) < (long)state.intervalMs) {
-            return false;
-        }
+    // 2) Earliest deadline among the due blocks
+    uint8_t b = vitoSchedPick(now);
+    if (b == VITO_DP_NONE) {
+        return false;
     }
 
-    // 3) Safety: keep index in range
-    if (state.index >= (uint8_t)groupSize) {
-        state.index = 0;
+    // 3) Try to queue it; if VitoWiFi refuses (busy) it is picked again later
+    if (!vitoWIFI.read(vitoBlockDatapoint(b))) {
+        return false;
     }
+    vitoBusy = true;
+    vitoSchedOnRequest(b, now);
 
-    VitoWiFi::Datapoint* dp = group[state.index];
-
-    // 4) Try to queue the next datapoint.
-    if (vitoWIFI.read(*dp)) {
-        // We successfully queued one request.
-        vitoBusy = true;
-        state.lastRequestMs = now;
+    // remember when each DP of the block was requested
+    const VitoBlock& blk = vitoBlocks[b];
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        dpLastRequestMs[vitoBlockMembers[blk.first + i]] = now;
+    }
+    return true;
+}
 
-        // remember when this particular DP was requested
-        for (size_t i = 0; i < dpTimingCount; ++i) {
-            if (isDp(*dpTiming[i].dp, *dp)) {
-                dpTiming[i].lastRequestMs = now;
-                break;
-            }
-        }
 
-        if (state.index == 0) {
-            state.lastRoundEndMs = now;  // start-of-round timestamp
-        }
+// Read the most overdue LittleFS definition (Vitocal_dpdefs.h); only called
+// when the compiled-in schedule has nothing due. Same pacing as the poller.
+bool pollVitoDefs(uint32_t responseGapMs) {
+    uint32_t now = millis();
+    if (vitoBusy) {
+        return false;
+    }
+    if (vitoLastResponseMs != 0 &&
+        (long)(now - vitoLastResponseMs) < (long)responseGapMs) {
+        return false;
+    }
+    uint8_t i = vitoDefsPick(now);
+    if (i == VITO_DP_NONE || !vitoWIFI.read(vitoDefDatapoint(i))) {
+        return false;
+    }
+    vitoBusy = true;
+    vitoDefsOnRequest(i, now);
+    return true;
+}
 
-        state.index++;
-        if (state.index >= groupSize) {
-            state.index = 0;
-        }
 
-        return true;
+// One pass of the Optolink task (Vitocal_optotask.h): HA writes and interval
+// changes from loop() first, then at most ONE new request (probe, queued
+// write, scheduled block, LittleFS definition; none while the link is being
+// recovered, see Vitocal_breaker.h) and the VitoWiFi state machine.
+void vitoOptoStep() {
+  vitoOptoTakeCommands();
+  if (!vitoWIFI.ready()) {
+    // protocol detection (Vitocal_protocol.h); polling waits for it
+    vitoWIFI.loop();
+    if (vitoWIFI.ready()) {
+      vitoLog(VITO_LOG_INFO, VITO_EV_PROTOCOL, VITO_DP_NONE, 0, static_cast<uint32_t>(vitoWIFI.protocol()),
+              vitoWIFI.detectMs());
     }
+    return;
+  }
+  if (!vitoBusy && vitoBlockReplan) {
+    vitoPlanBlocks();   // a block was split or rejoined; nothing in flight refers to it
+  }
+  if ((vitoBusy || vitoLinkService(vitoWIFI, millis())) && !pollVitoProbe(vitoResponseGapMs)) {
+    if (!pollVitoWrites(vitoResponseGapMs) && !pollVitoSchedule(vitoResponseGapMs)) {
+      pollVitoDefs(vitoResponseGapMs);
+    }
+  }
+  vitoWIFI.loop();
+}
 
-    // VitoWiFi refused the request (busy) -> keep state.index as-is
-    // so we can retry the same datapoint later.
-    return false;
+
+// Filler for GET /schedule: per-datapoint schedule and achieved ages as a
+// JSON array, whole objects up to maxLen; next counts the objects written.
+// 0 when done, RESPONSE_TRY_AGAIN while not even one object fits.
+static size_t vitoScheduleFill(uint16_t& next, uint8_t* buf, size_t maxLen) {
+    static_assert(VITO_DP_NAME_LEN <= 64, "obj holds the longest object");
+    char obj[288];
+    size_t n = 0;
+    uint32_t now = millis();
+    while (next <= DP_COUNT) {
+        int len;
+        if (next == DP_COUNT) {
+            len = snprintf(obj, sizeof(obj), "%s]", next ? "" : "[");
+        } else {
+            const VitoDpSchedule& s = vitoSchedule[next];
+            uint32_t age = vitoSchedAge(next, now);
+            len = snprintf(obj, sizeof(obj),
+                           "%s{\"dp\":\"%s\",\"period\":%lu,\"maxAge\":%lu,\"effective\":%lu,\"rate\":%.3f,"
+                           "\"age\":%ld,\"worst\":%lu,\"late\":%lu}",
+                           next ? "," : "[", vitoDpNames[next], (unsigned long)s.periodMs, (unsigned long)s.maxAgeMs,
+                           (unsigned long)vitoSchedPeriod(s), (double)vitoAdaptState[next].ratePerMin,
+                           age == UINT32_MAX ? -1L : (long)age, (unsigned long)s.worstAgeMs,
+                           (unsigned long)s.lateCount);
+        }
+        if (n + (size_t)len > maxLen) {
+            return n ? n : RESPONSE_TRY_AGAIN;
+        }
+        memcpy(buf + n, obj, (size_t)len);
+        n += (size_t)len;
+        next++;
+    }
+    return n;
 }
 
 
@@ -407,17 +688,11 @@ void setup() {
   // Initialize USB Console
   Serial.begin(SERIALBAUDRATE);
   Serial.setDebugOutput(true); // IMPORTANT: ROUTE DEBUG NOT THROUGH THE OPTOLINK SERIAL!
-  delay(2000); // Wait for USB CDC to enumerate
+  // no wait for USB CDC: lines before a host attaches are lost, the console is WebSerial
   Serial.println("Booting ESP32-C3 VitoWiFi..."); 
 
-  // add wifi AP  
-  WiFiMulti.addAP(WIFI_SSID, WIFI_PASSWORD);
- 
-  Serial.println();
-  Serial.println();
-  Serial.print("Waiting for WiFi... ");
-
- // 2. wait for connection
+  // WiFi: configure the station and start connecting; loop() brings it up and
+  // reconnects with backoff (Vitocal_wifi.h), nothing below waits for it
   WiFi.mode(WIFI_STA);
 
   // 🔒 Set static IP config BEFORE connecting
@@ -425,23 +700,35 @@ void setup() {
     Serial.println("STA Failed to configure");
   }
   WiFi.setTxPower(WIFI_POWER_8_5dBm); //  workaround for esp32 c3 as of defect antenna design
+  vitoWifiBegin(WIFI_SSID, WIFI_PASSWORD, millis());
+
+  // wall time for the history export (UTC; samples also carry uptime and boot number)
+  configTime(0, 0, "pool.ntp.org");
+  vitoHistoryInit();
+  vitoMqInit();
+  vitoDiscInit();
+  vitoValInit(vitoDpTable);
+  vitoValSubscribeAll();
+  vitoAggRender(millis());   // GET /aggregates before the first VITO_AGG_SNAPSHOT_S
+  vitoApiInit();
+  // further datapoints from /datapoints.csv, with their HA entities
+  CONSOLE_SERIAL.printf("LittleFS datapoints: %u loaded, %u bad lines\n", vitoDefsLoad(HA_PREFIX), vitoDefBadLines);
+
+  // merge adjacent addresses of each group into block reads
+  vitoPlanBlocks();
+  vitoSchedInit();
+  vitoAdaptInit();
+
+#if VITO_CAP_BOOT
+  vitoCapStart();   // Optolink trace from the protocol detection on
+#endif
+  // pick the Optolink protocol: fixed by VITO_PROTOCOL or P300 handshake with VS1
+  // fallback, which the Optolink task runs before the first request
+  vitoWIFI.select(VITO_PROTOCOL);
+  CONSOLE_SERIAL.print("Optolink protocol: ");
+  CONSOLE_SERIAL.println(vitoWIFI.protocolName());
 
-  while (WiFiMulti.run() != WL_CONNECTED) {
-    Serial.print(".");
-    delay(500);
-  }
-
-  Serial.println("");
-  Serial.println("WiFi connected");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
-
-  CONSOLE_SERIAL.println("");
-  CONSOLE_SERIAL.println("WiFi connected");
-  CONSOLE_SERIAL.print("IP address: ");
-  CONSOLE_SERIAL.println(WiFi.localIP());
-
-  // initialise optolink serial and VitoWiFi v3
+  // initialise optolink serial and VitoWiFi v3 (after the detection, if any)
   vitoWIFI.onResponse(onVitoResponse);
   vitoWIFI.onError(onVitoError);
   vitoWIFI.begin();
@@ -450,6 +737,147 @@ void setup() {
   server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
     request->send(200, "text/plain", "Bartels ESP32-C3 VitoWiFi. OTA at /update. Webserial at /webserial");
   });
+  server.on("/schedule", HTTP_GET, [](AsyncWebServerRequest* request) {
+    uint16_t next = 0;
+    request->send(request->beginChunkedResponse("application/json",
+      [next](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+        return vitoScheduleFill(next, buffer, maxLen);
+      }));
+  });
+  server.on("/writes", HTTP_GET, [](AsyncWebServerRequest* request) {
+    VitoWritesCursor cursor = {0, false};
+    request->send(request->beginChunkedResponse("application/json",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+        return vitoWritesFill(cursor, buffer, maxLen);
+      }));
+  });
+  server.on("/aggregates", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", vitoAggJson());
+  });
+  server.on("/profile", HTTP_GET, [](AsyncWebServerRequest* request) {
+    const char* json = vitoProfileJson();
+    if (json == nullptr) {
+      request->send(500, "text/plain", "profile does not fit");
+      return;
+    }
+    request->send(200, "application/json", json);
+  });
+  // Prometheus text format, streamed line by line (Vitocal_metrics.h)
+  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+    VitoMetricsCursor cursor = {};
+    request->send(request->beginChunkedResponse("text/plain; version=0.0.4",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+        return vitoMetricsFill(cursor, buffer, maxLen);
+      }));
+  });
+  // history: /history?dp=<name>&since=<s>&until=<s>&format=csv|json, streamed block by block
+  // (/history/stats first: a handler for /history also matches /history/...)
+  // live values: SSE stream at /events (Vitocal_sse.h), gzipped page at /live
+  vitoSseBegin(events);
+  server.addHandler(&events);
+  server.on("/live/stats", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", vitoSseStatsJson());
+  });
+  server.on("/live", HTTP_GET, [](AsyncWebServerRequest* request) {
+    AsyncWebServerResponse* response =
+      request->beginResponse(200, "text/html", vitoDashboardGz, sizeof(vitoDashboardGz));
+    response->addHeader("Content-Encoding", "gzip");
+    request->send(response);
+  });
+  // REST snapshot of the cached values (Vitocal_api.h), never an Optolink request;
+  // /api/datapoint/<name> ends up in the /api/datapoint handler
+  server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", vitoApiStatsJson());
+  });
+  server.on("/api/state", HTTP_GET, [](AsyncWebServerRequest* request) {
+    vitoApiServe(request, VITO_DP_NONE);
+  });
+  server.on("/api/datapoint", HTTP_GET, [](AsyncWebServerRequest* request) {
+    const char* url = request->url().c_str();
+    uint8_t dp = strncmp(url, "/api/datapoint/", 15) == 0 ? vitoDpIdByName(url + 15) : VITO_DP_NONE;
+    if (dp == VITO_DP_NONE) {
+      request->send(404, "text/plain", "unknown datapoint");
+      return;
+    }
+    vitoApiServe(request, dp);
+  });
+  // runtime definitions: GET the file, POST a new one (next boot, ?restart=1 reboots),
+  // values and RAM use at /datapoints/state (registered first, see /history)
+  server.on("/datapoints/state", HTTP_GET, [](AsyncWebServerRequest* request) {
+    VitoDefCursor cursor = {0, false};
+    request->send(request->beginChunkedResponse("application/json",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+        return vitoDefsFill(cursor, buffer, maxLen);
+      }));
+  });
+  server.on("/datapoints", HTTP_GET, [](AsyncWebServerRequest* request) {
+    if (!LittleFS.exists(VITO_DEFS_FILE)) {
+      request->send(404, "text/plain", "no " VITO_DEFS_FILE);
+      return;
+    }
+    request->send(LittleFS, VITO_DEFS_FILE, "text/csv");
+  });
+  server.on("/datapoints", HTTP_POST, [](AsyncWebServerRequest* request) {
+    const char* json;
+    int code = vitoDefsUploadDone(request->hasParam("restart"), &json);
+    request->send(code, "application/json", json);
+  }, nullptr, [](AsyncWebServerRequest*, uint8_t* data, size_t len, size_t index, size_t total) {
+    vitoDefsUploadChunk(data, len, index, total);
+  });
+  server.on("/history/stats", HTTP_GET, [](AsyncWebServerRequest* request) {
+    const char* json = vitoHistoryStatsJson();
+    if (json == nullptr) {
+      request->send(500, "text/plain", "history statistics do not fit");
+      return;
+    }
+    request->send(200, "application/json", json);
+  });
+  server.on("/history", HTTP_GET, [](AsyncWebServerRequest* request) {
+    uint8_t dp = VITO_DP_NONE;
+    if (request->hasParam("dp")) {
+      dp = vitoDpIdByName(request->getParam("dp")->value().c_str());
+      if (dp == VITO_DP_NONE) {
+        request->send(404, "text/plain", "unknown dp");
+        return;
+      }
+    }
+    uint32_t since = request->hasParam("since") ? request->getParam("since")->value().toInt() : 0;
+    uint32_t until = request->hasParam("until") ? request->getParam("until")->value().toInt() : 0;
+    bool json = request->hasParam("format") && request->getParam("format")->value() == "json";
+    // the cursor holds a copy of one block, too big to capture by value
+    std::shared_ptr<VitoHistCursor> cursor = std::make_shared<VitoHistCursor>();
+    vitoHistCursorInit(*cursor, json ? VITO_HIST_JSON : VITO_HIST_CSV, dp, since, until);
+    request->send(request->beginChunkedResponse(json ? "application/json" : "text/csv",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t) -> size_t {
+        return vitoHistFill(*cursor, buffer, maxLen);
+      }));
+  });
+
+  // Optolink trace (Vitocal_capture.h): POST /capture?run=1|0 starts (clearing the ring)
+  // and stops, GET /capture downloads the binary trace; /capture/stats registered first
+  server.on("/capture/stats", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", vitoCapStatsJson());
+  });
+  server.on("/capture", HTTP_POST, [](AsyncWebServerRequest* request) {
+    if (!request->hasParam("run")) {
+      request->send(400, "text/plain", "run=1 or run=0");
+      return;
+    }
+    if (request->getParam("run")->value() == "1") {
+      vitoCapStart();
+    } else {
+      vitoCapStop();
+    }
+    request->send(200, "application/json", vitoCapStatsJson());
+  });
+  server.on("/capture", HTTP_GET, [](AsyncWebServerRequest* request) {
+    VitoCapCursor cursor;
+    vitoCapCursorInit(cursor);
+    request->send(request->beginChunkedResponse("application/octet-stream",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+        return vitoCapFill(cursor, buffer, maxLen);
+      }));
+  });
 
   // start ota, webserial, server
   ElegantOTA.begin(&server);
@@ -460,6 +888,10 @@ void setup() {
 
   //setup home assistant *******
   setupHomeAssistant();
+
+  // from here on the Optolink side runs in its own task (Vitocal_optotask.h)
+  CONSOLE_SERIAL.println(vitoOptoStart(vitoOptoStep) ? F("Optolink task started")
+                                                      : F("Optolink polled from loop()"));
   
   CONSOLE_SERIAL.println(F("Setup finished..."));
 }
@@ -502,37 +934,92 @@ void myPrintRuntime() {
 }
 
 
+// Optolink reads/second since the last call (compare VS1 vs. VS2 on real hardware)
+void myReportReadRate() {
+  uint32_t now = millis();
+  uint32_t reads = vitoReadCount;
+  if (vitoReadWindowStartMs != 0 && now != vitoReadWindowStartMs) {
+    float rate = (float)(reads - vitoReadCountAtWindow) * 1000.0f / (float)(now - vitoReadWindowStartMs);
+    vitoReadRateSens.setValue(rate);
+    CONSOLE_SERIAL.print(F("[Optolink] "));
+    CONSOLE_SERIAL.print(vitoWIFI.protocolName());
+    CONSOLE_SERIAL.print(F(" reads/s="));
+    CONSOLE_SERIAL.println(rate, 2);
+  }
+  vitoReadCountAtWindow = reads;
+  vitoReadWindowStartMs = now;
+}
+
+
+// WiFi (re)connected: log the address
+void myWifiConnected() {
+  Serial.print("WiFi connected, IP address: ");
+  Serial.println(WiFi.localIP());
+  CONSOLE_SERIAL.print("WiFi connected, IP address: ");
+  CONSOLE_SERIAL.println(WiFi.localIP());
+}
+
+
 //** loop************************************************
 void loop() {
   myRuntimeMeasurement();
-
-  // cyclic VitoWiFi reads (v3 API, grouped for load balancing)
-  // We schedule at most ONE new request per loop iteration
-  bool queued = false;
-
-  // Priority: fast -> medium -> slow
-  if (!queued) queued = pollVitoGroup(vitoFastState,   vitoFast,   vitoFastSize,   vitoResponseGapMs);
-  if (!queued) queued = pollVitoGroup(vitoMediumState, vitoMedium, vitoMediumSize, vitoResponseGapMs);
-  if (!queued) queued = pollVitoGroup(vitoSlowState,   vitoSlow,   vitoSlowSize,   vitoResponseGapMs);
+  VITO_PROF_ITERATION();
+
+  // Optolink requests and VitoWiFi run in their own task (vitoOptoStep());
+  // only without one does loop() drive them. Their values come back here.
+  { VITO_PROF_SCOPE(VITO_PROF_OPTO);      vitoOptoService(); }
+  {
+    VITO_PROF_SCOPE(VITO_PROF_DISPATCH);
+    vitoOptoDrain(VITO_OPTO_RING, vitoDispatchMsg);
+    vitoPublishErrorCounts();
+    vitoPublishProtocol();
+  }
 
   // (If you still want the test group during debugging, put it here and
   // guard with #if / #else so you don't poll dpTempOutside twice.)
 
   EVERY_N_SECONDS(8) {
+    VITO_PROF_SCOPE(VITO_PROF_PERIODIC);
     count++;
     toggle = !toggle;
     device.publishAvailability();
-    CONSOLE_SERIAL.println("VitoWiFi read cycle running");
+    vitoLog(VITO_LOG_INFO, VITO_EV_CYCLE, VITO_DP_NONE, 0, 0, 0);
+    if (vitoDefRestartPending) {
+      ESP.restart();   // new /datapoints.csv, the POST has been answered by now
+    }
   }
 
-  // Essential: Keep the library state machine running
-  vitoWIFI.loop();
-  mqtt.loop();
-  ElegantOTA.loop();
-  WebSerial.loop();
+  { VITO_PROF_SCOPE(VITO_PROF_MQTT);      mqtt.loop(); publishDiscovery(); replayMqttQueue(); publishBatches(); }
+  { VITO_PROF_SCOPE(VITO_PROF_OTA);       ElegantOTA.loop(); }
+  { VITO_PROF_SCOPE(VITO_PROF_WEBSERIAL); WebSerial.loop(); }
+  { VITO_PROF_SCOPE(VITO_PROF_LOG);       vitoLogDrain(CONSOLE_SERIAL, VITO_LOG_DRAIN_PER_LOOP); }
+  { VITO_PROF_SCOPE(VITO_PROF_HISTORY);   vitoHistoryService(); }
+  { VITO_PROF_SCOPE(VITO_PROF_SSE);       vitoSseService(millis()); }
+  {
+    VITO_PROF_SCOPE(VITO_PROF_WIFI);
+    if (vitoWifiService(millis())) {
+      myWifiConnected();
+    }
+  }
+
+  EVERY_N_SECONDS(60) {
+    VITO_PROF_SCOPE(VITO_PROF_PERIODIC);
+    myReportReadRate();
+    publishPollIntervals();
+    publishSuppressedCount();
+    publishLoopProfile();
+    publishMqttQueue();
+    publishQuarantined();
+  }
+
+  EVERY_N_SECONDS(VITO_AGG_PUBLISH_S) {
+    VITO_PROF_SCOPE(VITO_PROF_PERIODIC);
+    publishAggregates();
+  }
 
-  EVERY_N_SECONDS(300) {
-    myCheckWIFIcyclic();
+  EVERY_N_SECONDS(VITO_AGG_SNAPSHOT_S) {
+    VITO_PROF_SCOPE(VITO_PROF_PERIODIC);
+    vitoAggRender(millis());
   }
 
   EVERY_N_SECONDS(4) {
@@ -541,208 +1028,116 @@ void loop() {
 }
 
 
-//** VitoWiFi response/error handlers (v3) ******************************
+//** VitoWiFi response/error handlers (v3), Optolink task context ********
 void onVitoResponse(const uint8_t* data, uint8_t length, const VitoWiFi::Datapoint& request) {
     vitoBusy = false;
     uint32_t nowMs = millis();
     vitoLastResponseMs = nowMs;
+    vitoReadCount++;
+
+    // the link works: ends a recovery and the run of consecutive errors
+    vitoLinkOnSuccess(nowMs);
+    vitoConsecutiveErrors = 0;
+
+    // acknowledgement of a queued write; its read-back follows
+    if (vitoWriteOnAck()) {
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_WRITE_ACK, vitoWriteActive, 0, 0, 0);
+        return;
+    }
+
+    // block read: one reply for several datapoints, timed by its first member
+    uint8_t blk = vitoBlockId(request);
+    uint8_t id  = (blk != VITO_DP_NONE) ? vitoBlockMembers[vitoBlocks[blk].first]
+                                        : vitoDpId(request);
 
     // compute time between request and this response
     uint32_t dtReqMs = 0;
-    for (size_t i = 0; i < dpTimingCount; ++i) {
-        if (isDp(request, *dpTiming[i].dp)) {
-            if (dpTiming[i].lastRequestMs != 0) {
-                dtReqMs = nowMs - dpTiming[i].lastRequestMs;
-            }
-            break;
-        }
+    if (id != VITO_DP_NONE && dpLastRequestMs[id] != 0) {
+        dtReqMs = nowMs - dpLastRequestMs[id];
     }
 
-    VitoWiFi::VariantValue value = request.decode(data, length);
-    const char* name = request.name();
-
-    CONSOLE_SERIAL.print("onVitoResponse for ");
-    CONSOLE_SERIAL.print(name);
-    CONSOLE_SERIAL.print(" (Δreq=");
-    CONSOLE_SERIAL.print(dtReqMs);
-    CONSOLE_SERIAL.println(" ms)");
-
-    if (isDp(request, dpTempOutside)) {
-        float temp = value;
-        AussenTempSens.setValue(temp);
-        logDpFloat("tmpAu (AussenTemp)", temp, lastTempOutsideMs);
-
-    } else if (isDp(request, dpWWoben)) {
-        float temp = value;
-        WWtempObenSens.setValue(temp);
-        logDpFloat("WWo (WWtempOben)", temp, lastWWobenMs);
-
-    } else if (isDp(request, dpVorlaufSoll)) {
-        float temp = value;
-        VorlaufTempSetSens.setValue(temp);
-        logDpFloat("VorlaufSoll", temp, lastVorlaufSollMs);
-
-    } else if (isDp(request, dpVorlaufIst)) {
-        float temp = value;
-        VorlaufTempSens.setValue(temp);
-        HVACwaermepumpe.setCurrentTemperature(temp);
-        logDpFloat("VorlaufIst", temp, lastVorlaufIstMs);
-
-    } else if (isDp(request, dpRuecklauf)) {
-        float temp = value;
-        RuecklaufTempSens.setValue(temp);
-        logDpFloat("Ruecklauf", temp, lastRuecklaufMs);
-
-    } else if (isDp(request, dpRelEHeizStufe1)) {
-        eHeiz1 = static_cast<uint8_t>(value);
-        logDpUint("RelEHeizStufe1 (raw)", eHeiz1, lastRelEHeiz1Ms);
-
-    } else if (isDp(request, dpRelEHeizStufe2)) {
-        uint8_t v2 = value;
-        eHeiz2 = eHeiz1 + (2 * v2);
-        RelEHeizStufeSens.setValue(static_cast<uint8_t>(eHeiz2));
-        HVACwaermepumpe.setAuxState(eHeiz2 != 0);
-        logDpUint("RelEHeizStufe2 (combined)", eHeiz2, lastRelEHeiz2Ms);
-
-    } else if (isDp(request, dpHeizkreispumpe)) {
-        uint8_t v = value;
-        heizkreispumpeSens.setState(v);
-        logDpUint("Heizkreispumpe", v, lastHeizkreispumpeMs);
-
-    } else if (isDp(request, dpWWZirkPumpe)) {
-        uint8_t v = value;
-        WWzirkulationspumpeSens.setState(v);
-        logDpUint("WWZirkulationspumpe", v, lastWWZirkPumpeMs);
-
-    } else if (isDp(request, dpRelVerdichter)) {
-        uint8_t v = value;
-        RelVerdichterSens.setState(v);
-        HVACwaermepumpe.setMode(v ? HAHVAC::HeatMode : HAHVAC::OffMode);
-        logDpUint("RelVerdichter", v, lastRelVerdichterMs);
-
-    } else if (isDp(request, dpRelPrimaerquelle)) {
-        uint8_t v = value;
-        RelPrimaerquelleSens.setState(v);
-        logDpUint("RelPrimaerquelle", v, lastRelPrimaerMs);
-
-    } else if (isDp(request, dpRelSekundaerPumpe)) {
-        uint8_t v = value;
-        RelSekundaerPumpeSens.setState(v);
-        logDpUint("RelSekundaerPumpe", v, lastRelSekundaerMs);
-
-    } else if (isDp(request, dpVentilHeizenWW)) {
-        uint8_t v = value;
-        const char* text = v ? "Warmwasser" : "Heizen";
-        ventilHeizenWWSens.setValue(text);
-        logDpMode("ventilHeizenWW", v, text, lastVentilHeizenWWMs);
-
-    } else if (isDp(request, dpOperationMode)) {
-        uint8_t v = value;
-        const char* label = labelOrFallback(
-            v, operationModeLabels, sizeof(operationModeLabels) / sizeof(operationModeLabels[0])
-        );
-        operationmodeSens.setValue(label);
-        logDpMode("operationmode", v, label, lastOperationModeMs);
-
-    } else if (isDp(request, dpManualMode)) {
-        uint8_t v = value;
-        const char* label = labelOrFallback(
-            v, manualModeLabels, sizeof(manualModeLabels) / sizeof(manualModeLabels[0])
-        );
-        manualmodeSens.setValue(label);
-        selectManualMode.setState(v);
-        logDpMode("manualmode", v, label, lastManualModeMs);
-
-    } else if (isDp(request, dpTempRaumSoll)) {
-        float t = value;
-        RaumSollTempSens.setState(t);
-        HVACwaermepumpe.setTargetTemperature(t);
-        logDpFloat("RaumSollTemp", t, lastRaumSollMs);
-
-    } else if (isDp(request, dpTempRaumSollRed)) {
-        float t = value;
-        RaumSollRedSens.setState(t);
-        logDpFloat("RaumSollRed", t, lastRaumSollRedMs);
-
-    } else if (isDp(request, dpTempWWSoll)) {
-        float t = value;
-        WWtempSollSens.setState(t);
-        logDpFloat("WWtempSoll", t, lastWWSollMs);
-
-    } else if (isDp(request, dpTempWWSoll2)) {
-        float t = value;
-        WWtempSoll2Sens.setState(t);
-        logDpFloat("WWtempSoll2", t, lastWWSoll2Ms);
-
-    } else if (isDp(request, dpTempHystWWSoll)) {
-        float t = value;
-        HystWWsollSens.setState(t);
-        logDpFloat("TempHystWWSoll", t, lastHystWWSollMs);
-
-    } else if (isDp(request, dpTempHKniveau)) {
-        float t = value;
-        HKniveauSens.setState(t);
-        logDpFloat("TempHKniveau", t, lastHKniveauMs);
-
-    } else if (isDp(request, dpTempHKNeigung)) {
-        float t = value;
-        HKneigungSens.setState(t);
-        logDpFloat("TempHKNeigung", t, lastHKneigungMs);
+    if (blk != VITO_DP_NONE) {
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_RESPONSE, id, vitoBlocks[blk].address, vitoBlocks[blk].length, dtReqMs);
+    } else {
+        vitoLog(VITO_LOG_DEBUG, VITO_EV_RESPONSE, id, 0, 0, dtReqMs);
     }
+
+    if (blk != VITO_DP_NONE) {
+        vitoBreakerBlockSuccess(blk);
+        vitoOptoBlock(blk, data, length);
+        return;
+    }
+    uint8_t def = vitoDefsId(request);
+    if (def != VITO_DP_NONE) {
+        // LittleFS definition
+        VitoOptoMsg m = {nowMs, VITO_MSG_DEF_VALUE, def, 0, 0, {0, 0, 0, 0},
+                         vitoDefsOnValue(def, request.decode(data, length), nowMs), 0};
+        vitoOptoPost(m);
+        return;
+    }
+    if (id == VITO_DP_NONE) {
+        return;  // not a polled datapoint (e.g. write confirmation)
+    }
+    vitoBreakerDpSuccess(id);
+    vitoOptoValue(id, request.decode(data, length), data, length);
 }
 
 
 void onVitoError(VitoWiFi::OptolinkResult error, const VitoWiFi::Datapoint& request) {
   vitoBusy = false;
   vitoLastResponseMs = millis();
+  uint32_t now = vitoLastResponseMs;
+
+  // Record error diagnostics; the circuit breakers and the link recovery
+  // decide what to read next (Vitocal_breaker.h), vitoOptoStep() carries it out.
+  uint8_t errBlk = vitoBlockId(request);
+  uint8_t errId  = vitoDpId(request);
+  uint8_t errDef = vitoDefsId(request);
+  if (errDef == VITO_DP_NONE && errBlk == VITO_DP_NONE && errId == VITO_DP_NONE) {
+    errId = vitoWriteActive;  // unknown name: blame the write in flight, if any
+  }
+  uint8_t first = errBlk != VITO_DP_NONE ? vitoBlockMembers[vitoBlocks[errBlk].first] : errId;
+  bool count = vitoLinkOnError(errDef != VITO_DP_NONE ? VITO_LINK_UNIT_DEF + errDef : first, now);
+  vitoMetricsOnError(errId, errBlk, error);
+
+  // loop() gets the datapoints, never a block index: vitoBlocks[] is re-planned here
+  VitoOptoMsg m = {now, VITO_MSG_ERROR, errId, 0, static_cast<uint8_t>(error), {0, 0, 0, 0}, 0.0f, 0};
+  if (errBlk != VITO_DP_NONE) {
+    const VitoBlock& blk = vitoBlocks[errBlk];
+    vitoLog(VITO_LOG_ERROR, VITO_EV_ERROR, first, blk.address, static_cast<uint32_t>(error), blk.length);
+    for (uint8_t i = 0; i < blk.count; ++i) {
+      m.id = vitoBlockMembers[blk.first + i];
+      vitoOptoPost(m);
+    }
+  } else {
+    vitoLog(VITO_LOG_ERROR, VITO_EV_ERROR, errId, 0, static_cast<uint32_t>(error), 0);
+    vitoOptoPost(m);
+  }
 
-  // Record error diagnostics and apply simple recovery/backoff if needed.
-  CONSOLE_SERIAL.print("VitoWiFi error for ");
-  CONSOLE_SERIAL.print(request.name());
-  CONSOLE_SERIAL.print(": ");
-  CONSOLE_SERIAL.println(static_cast<int>(error));
+  // failed write or read-back: loop() reports it and restores the confirmed value in HA
+  uint8_t failedWrite = vitoWriteOnError();
+  if (failedWrite != VITO_DP_NONE) {
+    m.kind  = VITO_MSG_WRITE_FAILED;
+    m.id    = failedWrite;
+    m.value = vitoWriteSlots[failedWrite].inFlight;
+    vitoOptoPost(m);
+  } else if (errDef != VITO_DP_NONE) {
+    vitoDefsOnError(errDef, now, count);
+  } else if (first < DP_COUNT) {
+    // failed poll: Optolink time lost since the request
+    uint32_t lost = dpLastRequestMs[first] ? now - dpLastRequestMs[first] : 0;
+    if (errBlk != VITO_DP_NONE) {
+      vitoBreakerBlockFailure(errBlk, lost, count);
+    } else {
+      vitoBreakerDpFailure(first, now, lost, count);
+    }
+  }
 
-  // Track errors: consecutive and within a window
-  uint32_t now = millis();
+  // Track errors: consecutive (reset by the next response) and within a window
   vitoConsecutiveErrors++;
   if (vitoErrorWindowStartMs == 0 || (now - vitoErrorWindowStartMs) > vitoErrorWindowMs) {
     vitoErrorWindowStartMs = now;
     vitoErrorCount = 0;
   }
-  vitoErrorCount++;
-
-  // Publish diagnostic counters to HA
-  vitoErrorCountSens.setValue(vitoErrorCount);
-  vitoConsecErrorSens.setValue(vitoConsecutiveErrors);
-
-  // Simple recovery -  if too many consecutive errors, briefly pause polling and try to kick VitoWiFi
-  if (vitoConsecutiveErrors >= vitoErrorThreshold) {
-    CONSOLE_SERIAL.println("Too many consecutive VitoWiFi errors; applying backoff and reinitializing VitoWiFi...");
-    // Backoff by delaying further reads for a short period via intervals increase
-    vitoFastState.intervalMs   = 30000UL;
-    vitoMediumState.intervalMs = 60000UL;
-    vitoSlowState.intervalMs   = 90000UL;
-    // Attempt a light reinit
-    vitoWIFI.end();
-    delay(200);
-    vitoWIFI.begin();
-    vitoConsecutiveErrors = 0;
-  }
-}
-
-
-//************************************************************
-
-
-void myCheckWIFIcyclic () {
-  if (WiFi.status() != WL_CONNECTED) {
-    WiFi.disconnect();
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  }
-  if (WiFi.waitForConnectResult() == WL_CONNECTED) {
-    // WIFI is connected  
-  }
-  else {
-    Serial.println("not reconnected!");
-  }
+  vitoErrorCount++;   // published to HA by loop() (vitoPublishErrorCounts)
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Change-rate-adaptive polling
+//
+// Each update feeds the datapoint's recent rate of change (EMA of |delta| per
+// minute). The effective poll period aims at one deadband of change per read:
+// period = deadband / rate, applied through vitoSchedule[id].scaleQ8 and kept
+// within the datapoint's min/max bounds. A faster target takes effect at
+// once; a slower one stretches the period by at most 1.5x per update, so an
+// idle datapoint drifts out to its max period over a few reads.
+//
+// Trigger datapoints (compressor, E-heater stages, 3-way valve) start a
+// boost: while it lasts (VITO_ADAPT_BOOST_MS after the last trigger) every
+// VITO_ADAPT_BOOST datapoint is held at its min period, so flow/return
+// temperatures and relays are sampled closely through a start-up or a
+// switch to DHW.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_json.h"
+#include "Vitocal_scheduler.h"
+
+#ifndef VITO_ADAPTIVE
+#define VITO_ADAPTIVE 1                  // 0 = fixed periods from vitoDpSpecs[]
+#endif
+#ifndef VITO_ADAPT_BOOST_MS
+#define VITO_ADAPT_BOOST_MS 600000UL     // boost length after the last trigger
+#endif
+#ifndef VITO_ADAPT_EMA_SHIFT
+#define VITO_ADAPT_EMA_SHIFT 1           // rate EMA weight 1/2^n for the newest sample
+#endif
+
+// VitoAdaptRule::flags
+#define VITO_ADAPT_BOOST       0x01  // held at min period during a boost
+#define VITO_ADAPT_TRIGGER_ON  0x02  // non-zero value starts/extends a boost
+#define VITO_ADAPT_TRIGGER_CHG 0x04  // any change of value starts a boost
+
+struct VitoAdaptRule {
+    uint32_t minPeriodMs;   // bounds at the class default interval (like vitoDpSpecs[])
+    uint32_t maxPeriodMs;
+    float    deadband;      // change per read the period aims at (units of the value)
+    uint8_t  flags;
+};
+
+// Indexed by VitoDpId, defined in the sketch
+extern const VitoAdaptRule vitoAdaptRules[DP_COUNT];
+
+struct VitoAdaptState {
+    float    last;          // previous value
+    float    ratePerMin;    // EMA of |delta| per minute
+    uint16_t minQ8;         // bounds as scaleQ8
+    uint16_t maxQ8;
+    bool     valid;         // last holds a value
+};
+
+static VitoAdaptState vitoAdaptState[DP_COUNT];
+static uint32_t       vitoAdaptBoostUntilMs = 0;   // 0 = no boost
+static uint8_t        vitoAdaptBoostBy      = VITO_DP_NONE;
+
+inline uint16_t vitoAdaptQ8(uint32_t periodMs, uint32_t basePeriodMs) {
+    if (basePeriodMs == 0) {
+        return 256;
+    }
+    uint32_t q = (uint32_t)(((uint64_t)periodMs << 8) / basePeriodMs);
+    return q < 1 ? 1 : q > 0xFFFF ? 0xFFFF : (uint16_t)q;
+}
+
+// After vitoSchedInit(): convert the bounds to scale factors.
+inline void vitoAdaptInit() {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        const VitoAdaptRule& r = vitoAdaptRules[i];
+        uint32_t base = vitoDpSpecs[i].periodMs;
+        VitoAdaptState& a = vitoAdaptState[i];
+        a.minQ8 = r.minPeriodMs ? vitoAdaptQ8(r.minPeriodMs, base) : 256;
+        a.maxQ8 = r.maxPeriodMs ? vitoAdaptQ8(r.maxPeriodMs, base) : 256;
+        if (a.minQ8 > 256) a.minQ8 = 256;
+        if (a.maxQ8 < 256) a.maxQ8 = 256;
+        a.valid = false;
+        a.ratePerMin = 0.0f;
+    }
+}
+
+inline bool vitoAdaptBoosting(uint32_t now) {
+    return vitoAdaptBoostUntilMs != 0 && (int32_t)(vitoAdaptBoostUntilMs - now) > 0;
+}
+
+// Start or extend a boost; pulls every boost datapoint down to its min period.
+inline void vitoAdaptBoost(uint8_t by, uint32_t now) {
+    vitoAdaptBoostUntilMs = (now + VITO_ADAPT_BOOST_MS) | 1;
+    vitoAdaptBoostBy = by;
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        if (vitoAdaptRules[i].flags & VITO_ADAPT_BOOST) {
+            vitoSchedule[i].scaleQ8 = vitoAdaptState[i].minQ8;
+        }
+    }
+}
+
+// Feed one decoded value; updates the datapoint's effective period.
+inline void vitoAdaptOnValue(uint8_t id, float value, uint32_t now) {
+#if VITO_ADAPTIVE
+    const VitoAdaptRule& r = vitoAdaptRules[id];
+    VitoAdaptState& a = vitoAdaptState[id];
+    VitoDpSchedule& s = vitoSchedule[id];
+
+    bool changed = a.valid && value != a.last;
+    if (a.valid && s.lastOkMs != 0 && now != s.lastOkMs) {
+        float delta = value > a.last ? value - a.last : a.last - value;
+        float rate  = delta * 60000.0f / (float)(now - s.lastOkMs);
+        a.ratePerMin += (rate - a.ratePerMin) / (float)(1 << VITO_ADAPT_EMA_SHIFT);
+    }
+    a.last  = value;
+    a.valid = true;
+
+    if (((r.flags & VITO_ADAPT_TRIGGER_ON) && value != 0.0f) ||
+        ((r.flags & VITO_ADAPT_TRIGGER_CHG) && changed)) {
+        vitoAdaptBoost(id, now);
+    }
+
+    uint16_t q;
+    if ((r.flags & VITO_ADAPT_BOOST) && vitoAdaptBoosting(now)) {
+        q = a.minQ8;
+    } else {
+        // period that sees about one deadband of change per read
+        float target = (a.ratePerMin > 0.0f && r.deadband > 0.0f)
+                     ? r.deadband * 60000.0f / a.ratePerMin
+                     : 4.0e9f;
+        uint32_t tq  = target >= 4.0e9f ? 0xFFFF : vitoAdaptQ8((uint32_t)target, s.periodMs);
+        uint32_t cap = (uint32_t)s.scaleQ8 * 3 / 2 + 1;   // stretch gradually
+        q = (uint16_t)(tq < cap ? tq : (cap > 0xFFFF ? 0xFFFF : cap));
+    }
+    if (q < a.minQ8) q = a.minQ8;
+    if (q > a.maxQ8) q = a.maxQ8;
+    s.scaleQ8 = q;
+#else
+    (void)id; (void)value; (void)now;
+#endif
+}
+
+// Longest vitoAdaptIntervalsJson(): "<name>":<10 digits>, per datapoint
+static const size_t VITO_ADAPT_JSON_MAX = DP_COUNT * (VITO_DP_NAME_LEN + 14) + 3;
+
+// {"<dp>":<effective period s>,...} for the MQTT poll interval topic; its
+// length, 0 if it does not fit into size.
+inline size_t vitoAdaptIntervalsJson(char* buf, size_t size) {
+    size_t n = 0;
+    bool ok = vitoAppendf(buf, size, n, "{");
+    for (uint8_t i = 0; i < DP_COUNT && ok; ++i) {
+        ok = vitoAppendf(buf, size, n, "%s\"%s\":%lu", i ? "," : "", vitoDpNames[i],
+                         (unsigned long)(vitoSchedPeriod(vitoSchedule[i]) / 1000UL));
+    }
+    return ok && vitoAppendf(buf, size, n, "}") ? n : 0;
+}
@@ -0,0 +1,339 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Streaming aggregation
+//
+// Derived heat-pump figures computed on the device from every read, so HA
+// gets them as sensors instead of rebuilding them from the raw samples in
+// templates and statistics: windowed min/max/mean of the temperatures, the
+// spread Vorlauf - Ruecklauf, compressor starts per hour and the duty of
+// the relays and E-heater stages.
+//
+// A channel follows one datapoint (or the difference of two) as a step
+// function: a value holds until the next read replaces it. Its window
+// (VITO_AGG_WINDOW_S) is a ring of VITO_AGG_SLOTS slots; each slot keeps
+// min, max, the time integral, the covered time, the time switched on and
+// the rising edges. A read adds the held value up to now to the slots it
+// covered and counts an edge, the slot ring rotates with the clock. Memory
+// is fixed, an update costs a handful of float operations.
+//
+// The value store feeds every changed value (vitoAggOnValue, a sink of
+// Vitocal_values.h), ahead of the publish policy; an unchanged read would
+// only extend the step the channel already holds. The sketch publishes the
+// outputs (vitoAggOutputs[], HA_mqtt_addin.h) every VITO_AGG_PUBLISH_S.
+//
+// All of the state belongs to loop(). GET /aggregates (async_tcp task) only
+// copies the JSON snapshot loop() renders every VITO_AGG_SNAPSHOT_S.
+// ---------------------------------------------------------------------------
+
+#include <ArduinoHA.h>
+#include <math.h>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_json.h"
+
+#ifndef VITO_AGG_WINDOW_S
+#define VITO_AGG_WINDOW_S  3600UL     // rolling window of the outputs
+#endif
+#ifndef VITO_AGG_SLOTS
+#define VITO_AGG_SLOTS     6          // window resolution (10 min slots)
+#endif
+#ifndef VITO_AGG_PUBLISH_S
+#define VITO_AGG_PUBLISH_S 300UL      // HA publish cadence
+#endif
+#ifndef VITO_AGG_SNAPSHOT_S
+#define VITO_AGG_SNAPSHOT_S 10        // GET /aggregates refresh
+#endif
+
+#define VITO_AGG_SLOT_MS (VITO_AGG_WINDOW_S * 1000UL / VITO_AGG_SLOTS)
+
+// Channels: what is aggregated
+enum VitoAggChannel : uint8_t {
+    VITO_AGG_AUSSEN = 0,
+    VITO_AGG_WW_OBEN,
+    VITO_AGG_VORLAUF,
+    VITO_AGG_RUECKLAUF,
+    VITO_AGG_SPREAD,        // Vorlauf - Ruecklauf
+    VITO_AGG_VERDICHTER,
+    VITO_AGG_PRIMAER,
+    VITO_AGG_SEKUNDAER,
+    VITO_AGG_EHEIZ1,
+    VITO_AGG_EHEIZ2,
+    VITO_AGG_CHANNELS
+};
+
+struct VitoAggChannelDef {
+    const char* name;       // JSON key
+    uint8_t     a;          // VitoDpId
+    uint8_t     b;          // subtracted from a, VITO_DP_NONE = a alone
+};
+
+static const VitoAggChannelDef vitoAggChannels[VITO_AGG_CHANNELS] = {
+    {"aussen",     DP_TEMP_OUTSIDE,   VITO_DP_NONE},
+    {"wwOben",     DP_WW_OBEN,        VITO_DP_NONE},
+    {"vorlauf",    DP_VORLAUF_IST,    VITO_DP_NONE},
+    {"ruecklauf",  DP_RUECKLAUF,      VITO_DP_NONE},
+    {"spread",     DP_VORLAUF_IST,    DP_RUECKLAUF},
+    {"verdichter", DP_REL_VERDICHTER, VITO_DP_NONE},
+    {"primaer",    DP_REL_PRIMAER,    VITO_DP_NONE},
+    {"sekundaer",  DP_REL_SEKUNDAER,  VITO_DP_NONE},
+    {"eHeiz1",     DP_REL_EHEIZ1,     VITO_DP_NONE},
+    {"eHeiz2",     DP_REL_EHEIZ2,     VITO_DP_NONE},
+};
+
+// Outputs: what a sensor shows of a channel
+enum VitoAggStat : uint8_t {
+    VITO_AGG_MEAN = 0,      // time-weighted over the window
+    VITO_AGG_MIN,
+    VITO_AGG_MAX,
+    VITO_AGG_DUTY,          // % of the window switched on (value >= 0.5)
+    VITO_AGG_PER_HOUR,      // rising edges per hour of the window
+    VITO_AGG_RUNTIME_H      // hours switched on since boot
+};
+
+static const char* const vitoAggStatNames[] = {"mean", "min", "max", "duty", "perHour", "runtimeH"};
+
+struct VitoAggOutput {
+    uint8_t         channel;    // VitoAggChannel
+    uint8_t         stat;       // VitoAggStat
+    HASensorNumber* entity;
+    const char*     objectId;
+    const char*     name;
+    const char*     icon;
+    const char*     unit;
+};
+
+#ifndef VITO_AGG_OUTPUTS
+#define VITO_AGG_OUTPUTS 16
+#endif
+
+// ,"<channel>.<stat>":<value> is at most 48 characters
+#define VITO_AGG_JSON_MAX (32 + VITO_AGG_OUTPUTS * 48)
+
+// Defined next to the entities (HA_mqtt_addin.h)
+extern const VitoAggOutput vitoAggOutputs[VITO_AGG_OUTPUTS];
+
+struct VitoAggSlot {            // 24 bytes
+    float    min;
+    float    max;
+    float    area;              // value * s
+    uint32_t coveredMs;
+    uint32_t onMs;
+    uint16_t edges;
+    uint8_t  used;              // min/max hold a value
+};
+
+struct VitoAggState {
+    float       a;              // last read of each source
+    float       b;
+    uint8_t     have;           // bit 0: a, bit 1: b
+    bool        on;
+    uint32_t    lastMs;         // held value counted up to here
+    uint64_t    totalOnMs;
+    VitoAggSlot slots[VITO_AGG_SLOTS];
+};
+
+static VitoAggState vitoAggState[VITO_AGG_CHANNELS];
+static uint8_t      vitoAggCur       = 0;   // slot of the current time
+static uint32_t     vitoAggSlotStart = 0;   // millis() the current slot began
+static uint32_t     vitoAggNowMs     = 0;   // latest time seen, reads arrive slightly out of order
+static bool         vitoAggStarted   = false;
+static char         vitoAggSnapshot[VITO_AGG_JSON_MAX] = "{}";
+static std::mutex   vitoAggLock;                // vitoAggSnapshot: loop() vs. the async_tcp task
+
+inline bool vitoAggHasValue(const VitoAggState& s, const VitoAggChannelDef& d) {
+    return d.b == VITO_DP_NONE ? (s.have & 1) : (s.have & 3) == 3;
+}
+
+inline float vitoAggValue(const VitoAggState& s, const VitoAggChannelDef& d) {
+    return d.b == VITO_DP_NONE ? s.a : s.a - s.b;
+}
+
+inline void vitoAggMark(VitoAggSlot& slot, float v) {
+    if (!slot.used) {
+        slot.min  = v;
+        slot.max  = v;
+        slot.used = 1;
+    } else {
+        slot.min = v < slot.min ? v : slot.min;
+        slot.max = v > slot.max ? v : slot.max;
+    }
+}
+
+// Rotate the slot ring to now; clears the slots that start a new period.
+inline uint32_t vitoAggAdvance(uint32_t now) {
+    if (!vitoAggStarted) {
+        vitoAggStarted   = true;
+        vitoAggSlotStart = now;
+        vitoAggNowMs     = now;
+        return now;
+    }
+    if ((int32_t)(now - vitoAggNowMs) < 0) {
+        now = vitoAggNowMs;
+    }
+    vitoAggNowMs = now;
+    uint32_t behind = (now - vitoAggSlotStart) / VITO_AGG_SLOT_MS;
+    if (behind == 0) {
+        return now;
+    }
+    uint32_t clears = behind < VITO_AGG_SLOTS ? behind : VITO_AGG_SLOTS;
+    for (uint32_t k = 0; k < clears; ++k) {
+        vitoAggCur = (vitoAggCur + 1) % VITO_AGG_SLOTS;
+        for (uint8_t c = 0; c < VITO_AGG_CHANNELS; ++c) {
+            memset(&vitoAggState[c].slots[vitoAggCur], 0, sizeof(VitoAggSlot));
+        }
+    }
+    vitoAggSlotStart += behind * VITO_AGG_SLOT_MS;
+    return now;
+}
+
+// Count the held value of channel c up to now, back through the slots it spans.
+inline void vitoAggHold(uint8_t c, uint32_t now) {
+    VitoAggState& s = vitoAggState[c];
+    const VitoAggChannelDef& d = vitoAggChannels[c];
+    if (!vitoAggHasValue(s, d)) {
+        s.lastMs = now;
+        return;
+    }
+    float    v    = vitoAggValue(s, d);
+    uint32_t dt   = now - s.lastMs;
+    uint32_t room = now - vitoAggSlotStart;   // part of the current slot up to now
+    uint8_t  k    = vitoAggCur;
+    if (s.on) {
+        s.totalOnMs += dt;
+    }
+    for (uint8_t n = 0; n < VITO_AGG_SLOTS && dt > 0; ++n) {
+        uint32_t part = dt < room ? dt : room;
+        if (part > 0) {
+            VitoAggSlot& slot = s.slots[k];
+            vitoAggMark(slot, v);
+            slot.area      += v * (float)part / 1000.0f;
+            slot.coveredMs += part;
+            if (s.on) {
+                slot.onMs += part;
+            }
+        }
+        dt  -= part;
+        k    = (k + VITO_AGG_SLOTS - 1) % VITO_AGG_SLOTS;
+        room = VITO_AGG_SLOT_MS;
+    }
+    s.lastMs = now;
+}
+
+// loop(): every decoded read of a polled datapoint.
+inline void vitoAggOnValue(uint8_t id, float value, uint32_t now) {
+    now = vitoAggAdvance(now);
+    for (uint8_t c = 0; c < VITO_AGG_CHANNELS; ++c) {
+        const VitoAggChannelDef& d = vitoAggChannels[c];
+        if (d.a != id && d.b != id) {
+            continue;
+        }
+        VitoAggState& s = vitoAggState[c];
+        vitoAggHold(c, now);
+        bool had = vitoAggHasValue(s, d);
+        if (d.a == id) {
+            s.a = value;
+            s.have |= 1;
+        } else {
+            s.b = value;
+            s.have |= 2;
+        }
+        if (!vitoAggHasValue(s, d)) {
+            continue;
+        }
+        float v = vitoAggValue(s, d);
+        bool on = v >= 0.5f;
+        if (on && had && !s.on) {
+            s.slots[vitoAggCur].edges++;
+        }
+        s.on = on;
+        vitoAggMark(s.slots[vitoAggCur], v);
+    }
+}
+
+// Bring every channel up to now, before the outputs are read.
+inline void vitoAggUpdate(uint32_t now) {
+    now = vitoAggAdvance(now);
+    for (uint8_t c = 0; c < VITO_AGG_CHANNELS; ++c) {
+        vitoAggHold(c, now);
+    }
+}
+
+// One output of a channel over the window; false while there is nothing to show.
+inline bool vitoAggStatValue(uint8_t c, uint8_t stat, float& out) {
+    const VitoAggState& s = vitoAggState[c];
+    float    mn = INFINITY, mx = -INFINITY, area = 0.0f;
+    uint32_t covered = 0, onMs = 0, edges = 0;
+    for (uint8_t k = 0; k < VITO_AGG_SLOTS; ++k) {
+        const VitoAggSlot& slot = s.slots[k];
+        if (!slot.used) {
+            continue;
+        }
+        mn       = slot.min < mn ? slot.min : mn;
+        mx       = slot.max > mx ? slot.max : mx;
+        area    += slot.area;
+        covered += slot.coveredMs;
+        onMs    += slot.onMs;
+        edges   += slot.edges;
+    }
+    switch (stat) {
+    case VITO_AGG_MEAN:
+        out = covered ? area * 1000.0f / (float)covered : 0.0f;
+        return covered != 0;
+    case VITO_AGG_MIN:
+        out = mn;
+        return mn <= mx;
+    case VITO_AGG_MAX:
+        out = mx;
+        return mn <= mx;
+    case VITO_AGG_DUTY:
+        out = covered ? 100.0f * (float)onMs / (float)covered : 0.0f;
+        return covered != 0;
+    case VITO_AGG_PER_HOUR:
+        // not before one slot is covered: a start right after boot is not "60 per hour"
+        out = covered ? (float)edges * 3600000.0f / (float)covered : 0.0f;
+        return covered >= VITO_AGG_SLOT_MS;
+    case VITO_AGG_RUNTIME_H:
+        out = (float)((double)s.totalOnMs / 3600000.0);
+        return vitoAggHasValue(s, vitoAggChannels[c]);
+    default:
+        return false;
+    }
+}
+
+// loop(), every VITO_AGG_SNAPSHOT_S: render every output for GET /aggregates,
+// null while it has no value. The previous snapshot stays if it does not fit.
+inline bool vitoAggRender(uint32_t now) {
+    static char buf[VITO_AGG_JSON_MAX];
+    vitoAggUpdate(now);
+    size_t n = 0;
+    bool ok = vitoAppendf(buf, sizeof(buf), n, "{\"windowS\":%lu", (unsigned long)VITO_AGG_WINDOW_S);
+    for (uint8_t i = 0; i < VITO_AGG_OUTPUTS && ok; ++i) {
+        const VitoAggOutput& o = vitoAggOutputs[i];
+        float v;
+        if (vitoAggStatValue(o.channel, o.stat, v)) {
+            ok = vitoAppendf(buf, sizeof(buf), n, ",\"%s.%s\":%.2f", vitoAggChannels[o.channel].name,
+                             vitoAggStatNames[o.stat], (double)v);
+        } else {
+            ok = vitoAppendf(buf, sizeof(buf), n, ",\"%s.%s\":null", vitoAggChannels[o.channel].name,
+                             vitoAggStatNames[o.stat]);
+        }
+    }
+    if (!ok || !vitoAppendf(buf, sizeof(buf), n, "}")) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(vitoAggLock);
+    memcpy(vitoAggSnapshot, buf, n + 1);
+    return true;
+}
+
+// GET /aggregates (async_tcp task): a copy of the last snapshot
+inline const char* vitoAggJson() {
+    static char out[VITO_AGG_JSON_MAX];
+    std::lock_guard<std::mutex> lock(vitoAggLock);
+    memcpy(out, vitoAggSnapshot, sizeof(out));
+    return out;
+}
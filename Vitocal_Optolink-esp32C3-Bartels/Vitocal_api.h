@@ -0,0 +1,198 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// REST snapshot API (GET /api/state, GET /api/datapoint/<name>)
+//
+// Served from the value store (Vitocal_values.h): last decoded value (and
+// label), the raw reply bytes, the time of the last good read and the error
+// state. A request only reads the store; it never queues an Optolink
+// transaction, however often it is polled.
+//
+//   /api/state               {"uptimeMs":..,"epoch":..,"datapoints":[{..},..]}
+//   /api/datapoint/<name>    {"name":"AussenTemp","value":4.5,"raw":"2d00",
+//                             "ageMs":1830,"errors":0,"consecutiveErrors":0,
+//                             "lastError":null,"lastErrorAgeMs":null}
+//
+// Every change of the raw bytes or of the error state bumps the store's
+// sequence number; the ETag is W/"<boot>-<salt>-<seq>" (whole state) or the
+// number of the one datapoint, so a poller that sends If-None-Match gets 304
+// until something changed. The ETag is weak because ageMs keeps moving.
+// The salt is taken at boot so the tags of two firmwares never collide.
+//
+// The JSON is written object by object into the buffer of a chunked response
+// (vitoApiFill, same scheme as vitoMetricsFill), no String is built.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <VitoWiFi.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_values.h"
+#include "Vitocal_history.h"   // boot counter, wall time
+#include "Vitocal_metrics.h"   // error codes
+
+#define VITO_API_RETRY    ((size_t)-1)
+#define VITO_API_ETAG_LEN 40
+
+static uint32_t     vitoApiSalt    = 0;
+// statistics since boot
+static uint32_t     vitoApiRequests    = 0;
+static uint32_t     vitoApiNotModified = 0;
+
+// setup(): salt for the ETags.
+inline void vitoApiInit() {
+    vitoApiSalt = (uint32_t)micros() ^ ((uint32_t)vitoHistBoot << 16);
+}
+
+// --- ETag (async_tcp task) -----------------------------------------------------------
+// ETag of the whole state (id == VITO_DP_NONE) or of one datapoint.
+inline void vitoApiEtag(uint8_t id, char* buf, size_t size) {
+    uint32_t seq = vitoValSeqOf(id);
+    snprintf(buf, size, "W/\"%u-%08lx-%lu\"", vitoHistBoot, (unsigned long)vitoApiSalt, (unsigned long)seq);
+}
+
+// If-None-Match value: true if it lists etag (or is "*").
+inline bool vitoApiEtagMatches(const char* ifNoneMatch, const char* etag) {
+    vitoApiRequests++;
+    if (ifNoneMatch == nullptr) {
+        return false;
+    }
+    bool match = strcmp(ifNoneMatch, "*") == 0 || strstr(ifNoneMatch, etag) != nullptr;
+    if (!match && strncmp(etag, "W/", 2) == 0) {
+        match = strstr(ifNoneMatch, etag + 2) != nullptr;   // weak comparison
+    }
+    if (match) {
+        vitoApiNotModified++;
+    }
+    return match;
+}
+
+// --- JSON ------------------------------------------------------------------------------
+struct VitoApiCursor {
+    uint8_t dp;     // the one datapoint, VITO_DP_NONE = whole state
+    uint8_t next;   // step: 0 = head, 1.. = datapoints, then the tail
+    bool    done;
+};
+
+inline void vitoApiCursorInit(VitoApiCursor& c, uint8_t dp) {
+    c = {dp, 0, false};
+}
+
+// One datapoint as a JSON object; 0 if it does not fit.
+inline size_t vitoApiEntryJson(uint8_t id, char* buf, size_t size, uint32_t now) {
+    VitoValView e;
+    vitoValCopy(id, e);
+    char value[24] = "null";
+    char label[48] = "";
+    char raw[2 * VITO_VAL_RAW_MAX + 3] = "null";
+    char age[12] = "null";
+    char err[16] = "null";
+    char errAge[12] = "null";
+    if (e.readMs) {
+        VitoDpValue v = vitoValDecode(id, e.raw, e.rawLen);
+        snprintf(value, sizeof(value), "%g", (double)v.f);
+        snprintf(age, sizeof(age), "%lu", (unsigned long)(now - e.readMs));
+        size_t r = 0;
+        raw[r++] = '"';
+        for (uint8_t i = 0; i < e.rawLen; ++i) {
+            r += snprintf(raw + r, sizeof(raw) - r, "%02x", e.raw[i]);
+        }
+        raw[r++] = '"';
+        raw[r] = '\0';
+        if (v.label) {
+            snprintf(label, sizeof(label), ",\"label\":\"%.31s\"", v.label);
+        }
+    }
+    if (e.lastError != VITO_VAL_NO_ERROR) {
+        snprintf(err, sizeof(err), "\"%s\"", vitoMetricErrorNames[e.lastError]);
+        snprintf(errAge, sizeof(errAge), "%lu", (unsigned long)(now - e.errorMs));
+    }
+    int n = snprintf(buf, size,
+                     "{\"name\":\"%s\",\"value\":%s%s,\"raw\":%s,\"ageMs\":%s,\"errors\":%lu,"
+                     "\"consecutiveErrors\":%u,\"lastError\":%s,\"lastErrorAgeMs\":%s}",
+                     vitoDpNames[id], value, label, raw, age, (unsigned long)e.errors, e.consecutive, err, errAge);
+    return n < 0 || (size_t)n >= size ? 0 : (size_t)n;
+}
+
+inline size_t vitoApiFormat(const VitoApiCursor& c, char* buf, size_t size, uint32_t now) {
+    if (c.dp != VITO_DP_NONE) {
+        return vitoApiEntryJson(c.dp, buf, size, now);
+    }
+    if (c.next == 0) {
+        char epoch[12] = "null";
+        uint32_t t = vitoHistEpoch();
+        if (t) {
+            snprintf(epoch, sizeof(epoch), "%lu", (unsigned long)t);
+        }
+        int n = snprintf(buf, size, "{\"uptimeMs\":%lu,\"epoch\":%s,\"datapoints\":[", (unsigned long)now, epoch);
+        return n < 0 || (size_t)n >= size ? 0 : (size_t)n;
+    }
+    if (c.next <= DP_COUNT) {
+        size_t n = 0;
+        if (c.next > 1) {
+            buf[n++] = ',';
+        }
+        size_t len = vitoApiEntryJson(c.next - 1, buf + n, size - n, now);
+        return len ? n + len : 0;
+    }
+    memcpy(buf, "]}", 2);
+    return 2;
+}
+
+inline void vitoApiAdvance(VitoApiCursor& c) {
+    if (c.dp != VITO_DP_NONE || ++c.next > DP_COUNT + 1) {
+        c.done = true;
+    }
+}
+
+// Filler for a chunked response: whole objects up to maxLen. Returns 0 when
+// the document is complete, VITO_API_RETRY if not even one object fits.
+inline size_t vitoApiFill(VitoApiCursor& c, uint8_t* buf, size_t maxLen) {
+    char obj[256];
+    size_t n = 0;
+    uint32_t now = millis();
+    while (!c.done) {
+        size_t len = vitoApiFormat(c, obj, sizeof(obj), now);
+        if (n + len > maxLen) {
+            return n ? n : VITO_API_RETRY;
+        }
+        memcpy(buf + n, obj, len);
+        n += len;
+        vitoApiAdvance(c);
+    }
+    return n;
+}
+
+// Handler body of /api/state (dp == VITO_DP_NONE) and /api/datapoint/<name>:
+// 304 if the poller holds the current version, else the JSON with its ETag.
+inline void vitoApiServe(AsyncWebServerRequest* request, uint8_t dp) {
+    char etag[VITO_API_ETAG_LEN];
+    vitoApiEtag(dp, etag, sizeof(etag));
+    const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    AsyncWebServerResponse* response;
+    if (vitoApiEtagMatches(ifNoneMatch ? ifNoneMatch->value().c_str() : nullptr, etag)) {
+        response = request->beginResponse(304);
+    } else {
+        VitoApiCursor cursor;
+        vitoApiCursorInit(cursor, dp);
+        response = request->beginChunkedResponse("application/json",
+            [cursor](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+                return vitoApiFill(cursor, buffer, maxLen);
+            });
+    }
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+// API statistics as JSON (GET /api/stats)
+inline const char* vitoApiStatsJson() {
+    static char buf[96];
+    snprintf(buf, sizeof(buf), "{\"requests\":%lu,\"notModified\":%lu,\"version\":%lu}",
+             (unsigned long)vitoApiRequests, (unsigned long)vitoApiNotModified,
+             (unsigned long)vitoValSeqOf(VITO_DP_NONE));
+    return buf;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Block-read planner
+//
+// Every VS1 transaction pays sync, framing and the response gap, while the
+// payload itself costs ~2.3 ms per byte at 4800 baud. Datapoints of a polling
+// group that sit close together in the address map are therefore read with
+// one multi-byte read of the covering range; the reply is sliced back into the
+// member datapoints, which are decoded and dispatched as if read one by one.
+//
+// vitoPlanGroup() runs once per group (setup) and appends the group's blocks
+// to vitoBlocks[]. A block with a single member is read through the member's
+// own Datapoint, so nothing changes for isolated addresses. Members are kept
+// as datapoint IDs; address and length come from vitoDpSpecs[].
+//
+// Datapoints flagged in vitoBlockSolo[] are never merged: a block that keeps
+// failing is split by the circuit breakers (Vitocal_breaker.h), which set
+// vitoBlockReplan; the sketch then plans all groups again from loop().
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <VitoWiFi.h>
+#include "Vitocal_registry.h"
+#include "Vitocal_datapoints.h"
+
+#ifndef VITO_BLOCK_MAX_SPAN
+#define VITO_BLOCK_MAX_SPAN 32   // max bytes in one block read, 0 = no coalescing
+#endif
+#ifndef VITO_BLOCK_MAX_GAP
+#define VITO_BLOCK_MAX_GAP  8    // max unused bytes between two members of a block
+#endif
+#ifndef VITO_MAX_BLOCKS
+#define VITO_MAX_BLOCKS     DP_COUNT   // blocks over all groups, at most one per datapoint
+#endif
+
+struct VitoBlock {
+    uint16_t address;   // first byte read
+    uint8_t  length;    // bytes read
+    uint8_t  first;     // first member in vitoBlockMembers[]
+    uint8_t  count;     // members served by this read
+};
+
+// Blocks of one polling group: vitoBlocks[first .. first + count)
+struct VitoBlockRange {
+    uint8_t first;
+    uint8_t count;
+};
+
+static VitoBlock            vitoBlocks[VITO_MAX_BLOCKS];
+static char                 vitoBlockNames[VITO_MAX_BLOCKS][VITO_DP_NAME_LEN];
+static uint8_t              vitoBlockMembers[DP_COUNT];         // IDs, sorted by address per block
+static uint8_t              vitoBlockCount       = 0;
+static uint8_t              vitoBlockMemberCount = 0;
+static bool                 vitoBlockSolo[DP_COUNT];            // read on its own, never merged
+static bool                 vitoBlockReplan      = false;       // vitoBlockSolo[] changed
+
+// Forget all blocks before planning the groups again.
+inline void vitoPlanReset() {
+    vitoBlockCount       = 0;
+    vitoBlockMemberCount = 0;
+    vitoBlockReplan      = false;
+}
+
+// Merge the group's datapoints into blocks of at most maxSpan bytes whose
+// members are at most maxGap unused bytes apart. Members are served in
+// address order. A datapoint that overlaps the block so far (e.g. 0x0106/2
+// after 0x0105/2) starts a new block: each member gets its own reply bytes.
+inline VitoBlockRange vitoPlanGroup(const uint8_t* group, int size,
+                                    uint8_t maxSpan = VITO_BLOCK_MAX_SPAN,
+                                    uint8_t maxGap  = VITO_BLOCK_MAX_GAP) {
+    VitoBlockRange range = {vitoBlockCount, 0};
+    if (size <= 0 || vitoBlockMemberCount + size > DP_COUNT) {
+        return range;
+    }
+
+    // insertion sort by address into the member pool
+    uint8_t* sorted = &vitoBlockMembers[vitoBlockMemberCount];
+    for (int i = 0; i < size; ++i) {
+        int j = i;
+        while (j > 0 && vitoDpSpecs[sorted[j - 1]].address > vitoDpSpecs[group[i]].address) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = group[i];
+    }
+
+    for (int i = 0; i < size && vitoBlockCount < VITO_MAX_BLOCKS; ) {
+        VitoBlock& b = vitoBlocks[vitoBlockCount];
+        b.address = vitoDpSpecs[sorted[i]].address;
+        b.length  = vitoDpSpecs[sorted[i]].length;
+        b.first   = (uint8_t)(vitoBlockMemberCount + i);
+        b.count   = 1;
+        i++;
+
+        while (i < size) {
+            uint32_t start = vitoDpSpecs[sorted[i]].address;
+            uint32_t end   = start + vitoDpSpecs[sorted[i]].length;   // exclusive
+            uint32_t bEnd  = (uint32_t)b.address + b.length;
+            uint32_t span  = (end > bEnd ? end : bEnd) - b.address;
+            uint32_t gap   = start > bEnd ? start - bEnd : 0;
+            if (start < bEnd || span > maxSpan || gap > maxGap || vitoBlockSolo[sorted[i]] ||
+                vitoBlockSolo[vitoBlockMembers[b.first]]) {
+                break;
+            }
+            b.length = (uint8_t)span;
+            b.count++;
+            i++;
+        }
+
+        snprintf(vitoBlockNames[vitoBlockCount], VITO_DP_NAME_LEN, "block 0x%04X+%u",
+                 (unsigned)b.address, (unsigned)b.length);
+        vitoBlockCount++;
+        range.count++;
+    }
+    vitoBlockMemberCount += (uint8_t)size;
+    return range;
+}
+
+// Datapoint to request for block b: the member itself for single-member
+// blocks, otherwise a raw read of the whole range named after the block.
+inline VitoWiFi::Datapoint vitoBlockDatapoint(uint8_t b) {
+    const VitoBlock& blk = vitoBlocks[b];
+    if (blk.count == 1) {
+        return vitoDpDatapoint(vitoBlockMembers[blk.first]);
+    }
+    return VitoWiFi::Datapoint(vitoBlockNames[b], blk.address, blk.length, VitoWiFi::noconv);
+}
+
+// O(1): block index of a multi-member block read, VITO_DP_NONE otherwise
+inline uint8_t vitoBlockId(const VitoWiFi::Datapoint& dp) {
+    return vitoDpIndexOf(dp.name(), vitoBlockNames, vitoBlockCount, VITO_DP_NAME_LEN);
+}
+
+// Slice of the block reply that belongs to member id; nullptr if the reply
+// is too short to cover it.
+inline const uint8_t* vitoBlockSlice(const VitoBlock& blk, uint8_t id, const uint8_t* data, uint8_t length) {
+    uint16_t offset = vitoDpSpecs[id].address - blk.address;
+    if (offset + vitoDpSpecs[id].length > length) {
+        return nullptr;
+    }
+    return data + offset;
+}
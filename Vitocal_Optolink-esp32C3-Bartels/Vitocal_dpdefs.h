@@ -0,0 +1,544 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Datapoint definitions loaded at boot from LittleFS (/datapoints.csv)
+//
+// The datapoints in Vitocal_datapoints.h stay compiled in (they carry writes,
+// hooks, block reads and the adaptive triggers). Further read-only datapoints
+// are defined in a small text file, one per line:
+//
+//   # name,address,length,converter,period,entity,unit,precision
+//   Verdichterstarts,0x0580,4,noconv,600,sensor,,0
+//   Laufzeit,0x0588,4,div3600,slow,sensor,h,1
+//   Abtauung,0x04A0,1,noconv,fast,binary,,0
+//
+//   name        up to VITO_DEFS_NAME_MAX characters [A-Za-z0-9_], unique
+//   length      1, 2 or 4 bytes
+//   converter   noconv | div10 | div2 | div3600
+//   period      seconds, or fast | medium | slow to follow that class interval
+//   entity      sensor (HASensorNumber) | binary (HABinarySensor) | none
+//   unit        empty or one of vitoDefUnits[]
+//   precision   0..3 decimals of the sensor
+//
+// vitoDefsLoad() counts the valid lines first and then allocates every table
+// once, sized to that count: 8 bytes of definition, 28 bytes of state, one
+// VITO_DEFS_ROW name row and one entity per datapoint, nothing afterwards.
+// A line that does not parse is skipped and reported at GET /datapoints/state.
+//
+// The definitions are read in the gaps of the compiled-in schedule, the most
+// overdue one first, skipping those whose circuit breaker is open
+// (Vitocal_breaker.h). Each read builds a temporary Datapoint whose name points
+// into the name table, so a response finds its row by pointer arithmetic like
+// the block reads do (vitoDpIndexOf).
+//
+// POST /datapoints replaces the file after a dry-run parse; it takes effect
+// at the next boot (?restart=1 reboots right away), since ArduinoHA cannot
+// unregister the entities of the old table.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoHA.h>
+#include <VitoWiFi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_polling.h"
+#include "Vitocal_breaker.h"
+#include "Vitocal_discovery.h"
+
+#ifndef VITO_DEFS_MAX
+#define VITO_DEFS_MAX 192              // datapoints in the file, also reserved in HAMqtt
+#endif
+#ifndef VITO_DEFS_RETRY_MS
+#define VITO_DEFS_RETRY_MS 2000UL      // min time between two attempts on the same datapoint
+#endif
+#ifndef VITO_DEFS_FILE_MAX
+#define VITO_DEFS_FILE_MAX 16384       // bytes accepted by POST /datapoints
+#endif
+
+#define VITO_DEFS_FILE     "/datapoints.csv"
+#define VITO_DEFS_UPLOAD   "/datapoints.new"
+#define VITO_DEFS_ROW      32          // "<HA_PREFIX><name>\0", the unique_id of the entity
+#define VITO_DEFS_NAME_MAX 20
+#define VITO_DEFS_LINE_MAX 128
+
+static_assert(VITO_DEFS_MAX < VITO_DP_NONE, "definition IDs are uint8_t, VITO_DP_NONE excluded");
+
+enum VitoDefEntity : uint8_t { VITO_DEF_NONE = 0, VITO_DEF_SENSOR, VITO_DEF_BINARY };
+
+static const char* const vitoDefEntityNames[] = {"none", "sensor", "binary"};
+static const char* const vitoDefClassNames[VITO_CLASS_COUNT] = {"fast", "medium", "slow"};
+static const char* const vitoDefUnits[] = {
+    "", "°C", "K", "%", "s", "min", "h", "kWh", "Wh", "W", "kW", "bar", "Hz", "rpm", "l/h", "m³/h"
+};
+
+struct VitoDefRecord {          // 8 bytes per datapoint
+    uint16_t address;
+    uint16_t periodS;           // own period, 0 = class interval
+    uint8_t  length;
+    uint8_t  conv      : 2;     // VitoDpConv
+    uint8_t  entity    : 2;     // VitoDefEntity
+    uint8_t  precision : 2;
+    uint8_t  cls;               // VitoPollClass, VITO_CLASS_COUNT = own period
+    uint8_t  unit;              // vitoDefUnits[]
+};
+
+struct VitoDefState {           // 28 bytes per datapoint
+    uint32_t lastOkMs;          // 0 = never read
+    uint32_t lastAttemptMs;
+    float    value;
+    uint16_t errors;
+    uint16_t reads;
+    VitoBreaker breaker;
+};
+
+static VitoDefRecord*      vitoDefs        = nullptr;
+static VitoDefState*       vitoDefStates   = nullptr;
+static char*               vitoDefRows     = nullptr;   // count * VITO_DEFS_ROW
+static HABaseDeviceType**  vitoDefEntities = nullptr;
+static uint8_t             vitoDefCount    = 0;
+static uint8_t             vitoDefPrefixLen = 0;        // name = row + prefix length
+static uint16_t            vitoDefBadLines = 0;         // lines skipped at boot
+static uint16_t            vitoDefFirstBad = 0;         // line number of the first one
+static const char*         vitoDefFirstError = nullptr;
+static size_t              vitoDefRamBytes = 0;
+static uint32_t            vitoDefNextDueMs = 0;        // no definition due before this
+static bool                vitoDefRestartPending = false;
+
+inline const char* vitoDefName(uint8_t i) {
+    return vitoDefRows + (size_t)i * VITO_DEFS_ROW + vitoDefPrefixLen;
+}
+
+// O(1): row of a runtime definition for a request/response, VITO_DP_NONE otherwise
+inline uint8_t vitoDefsId(const VitoWiFi::Datapoint& dp) {
+    if (vitoDefCount == 0) {
+        return VITO_DP_NONE;
+    }
+    return vitoDpIndexOf(dp.name(), vitoDefRows + vitoDefPrefixLen, vitoDefCount, VITO_DEFS_ROW);
+}
+
+// --- parsing -------------------------------------------------------------------------
+inline int8_t vitoDefLookup(const char* s, const char* const* table, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (strcmp(s, table[i]) == 0) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+// Split off the next comma-separated field of *s, trimmed.
+inline char* vitoDefField(char** s) {
+    char* f = *s;
+    if (f == nullptr) {
+        return nullptr;
+    }
+    char* comma = strchr(f, ',');
+    *s = comma ? comma + 1 : nullptr;
+    if (comma) {
+        *comma = '\0';
+    }
+    while (*f == ' ' || *f == '\t') {
+        f++;
+    }
+    for (char* e = f + strlen(f); e > f && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'); --e) {
+        e[-1] = '\0';
+    }
+    return f;
+}
+
+// One line into r and name; nullptr if fine, else what is wrong with it.
+// Blank lines and # comments give "" (skipped, not an error).
+inline const char* vitoDefParse(char* line, VitoDefRecord& r, char* name) {
+    char* s = line;
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    if (*s == '\0' || *s == '#' || *s == '\r') {
+        return "";
+    }
+    char* f[8];
+    for (char*& field : f) {
+        field = vitoDefField(&s);
+        if (field == nullptr) {
+            return "8 fields expected";
+        }
+    }
+    if (s != nullptr) {
+        return "8 fields expected";
+    }
+    static const char nameChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_";
+    size_t len = strlen(f[0]);
+    if (len == 0 || len > VITO_DEFS_NAME_MAX || strspn(f[0], nameChars) != len) {
+        return "bad name";
+    }
+    if (vitoDpIdByName(f[0]) != VITO_DP_NONE) {
+        return "name of a built-in datapoint";
+    }
+    char* end;
+    unsigned long address = strtoul(f[1], &end, 0);
+    if (*f[1] == '\0' || *end != '\0' || address > 0xFFFF) {
+        return "bad address";
+    }
+    unsigned long length = strtoul(f[2], &end, 10);
+    if (*end != '\0' || (length != 1 && length != 2 && length != 4)) {
+        return "length must be 1, 2 or 4";
+    }
+    int8_t conv = vitoDefLookup(f[3], vitoDpConvNames, sizeof(vitoDpConvNames) / sizeof(vitoDpConvNames[0]));
+    if (conv < 0) {
+        return "unknown converter";
+    }
+    int8_t cls = vitoDefLookup(f[4], vitoDefClassNames, VITO_CLASS_COUNT);
+    unsigned long period = 0;
+    if (cls < 0) {
+        period = strtoul(f[4], &end, 10);
+        if (*f[4] == '\0' || *end != '\0' || period == 0 || period > 0xFFFF) {
+            return "period must be seconds or fast/medium/slow";
+        }
+        cls = VITO_CLASS_COUNT;
+    }
+    int8_t entity = vitoDefLookup(f[5], vitoDefEntityNames, sizeof(vitoDefEntityNames) / sizeof(vitoDefEntityNames[0]));
+    if (entity < 0) {
+        return "unknown entity";
+    }
+    int8_t unit = vitoDefLookup(f[6], vitoDefUnits, sizeof(vitoDefUnits) / sizeof(vitoDefUnits[0]));
+    if (unit < 0) {
+        return "unknown unit";
+    }
+    unsigned long precision = strtoul(f[7], &end, 10);
+    if (*end != '\0' || precision > 3) {
+        return "precision must be 0..3";
+    }
+    r.address   = (uint16_t)address;
+    r.periodS   = (uint16_t)period;
+    r.length    = (uint8_t)length;
+    r.conv      = (uint8_t)conv;
+    r.entity    = (uint8_t)entity;
+    r.precision = (uint8_t)precision;
+    r.cls       = (uint8_t)cls;
+    r.unit      = (uint8_t)unit;
+    strcpy(name, f[0]);
+    return nullptr;
+}
+
+// Call fn(line, lineNo) for every line of f; lines longer than VITO_DEFS_LINE_MAX are cut.
+template <typename Fn>
+inline void vitoDefForEachLine(File& f, Fn fn) {
+    char line[VITO_DEFS_LINE_MAX];
+    uint8_t buf[64];
+    size_t len = 0;
+    uint16_t lineNo = 0;
+    size_t n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            if (buf[i] == '\n') {
+                line[len] = '\0';
+                fn(line, ++lineNo);
+                len = 0;
+            } else if (len < sizeof(line) - 1) {
+                line[len++] = (char)buf[i];
+            }
+        }
+    }
+    if (len > 0) {
+        line[len] = '\0';
+        fn(line, ++lineNo);
+    }
+}
+
+struct VitoDefCheck {
+    uint16_t    valid;
+    uint16_t    bad;
+    uint16_t    firstBad;     // line number
+    const char* firstError;
+};
+
+// Dry run over a definition file: valid lines (duplicates count as bad).
+inline VitoDefCheck vitoDefsCheck(const char* path) {
+    VitoDefCheck c = {0, 0, 0, nullptr};
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) {
+        return c;
+    }
+    // FNV-1a hashes of the names so far: duplicates without a name table
+    uint32_t seen[VITO_DEFS_MAX];
+    vitoDefForEachLine(f, [&c, &seen](char* line, uint16_t lineNo) {
+        VitoDefRecord r;
+        uint32_t hash = 0;
+        char name[VITO_DEFS_NAME_MAX + 1];
+        const char* err = vitoDefParse(line, r, name);
+        if (err == nullptr) {
+            hash = 2166136261UL;
+            for (const char* p = name; *p; ++p) {
+                hash = (hash ^ (uint8_t)*p) * 16777619UL;
+            }
+            for (uint16_t i = 0; i < c.valid && err == nullptr; ++i) {
+                if (seen[i] == hash) {
+                    err = "duplicate name";
+                }
+            }
+            if (err == nullptr && c.valid >= VITO_DEFS_MAX) {
+                err = "more than VITO_DEFS_MAX datapoints";
+            }
+        }
+        if (err == nullptr) {
+            seen[c.valid++] = hash;
+        } else if (*err != '\0') {
+            if (c.bad++ == 0) {
+                c.firstBad   = lineNo;
+                c.firstError = err;
+            }
+        }
+    });
+    return c;
+}
+
+// --- boot ------------------------------------------------------------------------------
+// setup(), after LittleFS is mounted and before mqtt.begin(): load the file,
+// allocate the tables and create one HA entity per sensor/binary datapoint.
+// prefix is HA_PREFIX; it is part of the unique_id and the object_id.
+inline uint8_t vitoDefsLoad(const char* prefix) {
+    VitoDefCheck check = vitoDefsCheck(VITO_DEFS_FILE);
+    vitoDefBadLines   = check.bad;
+    vitoDefFirstBad   = check.firstBad;
+    vitoDefFirstError = check.firstError;
+    if (check.valid == 0) {
+        return 0;
+    }
+    size_t prefixLen = strlen(prefix);
+    if (prefixLen + VITO_DEFS_NAME_MAX + 1 > VITO_DEFS_ROW) {
+        return 0;
+    }
+    uint8_t n = (uint8_t)check.valid;
+    vitoDefs        = new VitoDefRecord[n];
+    vitoDefStates   = new VitoDefState[n]();
+    vitoDefRows     = new char[(size_t)n * VITO_DEFS_ROW]();
+    vitoDefEntities = new HABaseDeviceType*[n]();
+    vitoDefPrefixLen = (uint8_t)prefixLen;
+    vitoDefRamBytes = (size_t)n * (sizeof(VitoDefRecord) + sizeof(VitoDefState) + VITO_DEFS_ROW +
+                                   sizeof(HABaseDeviceType*));
+
+    File f = LittleFS.open(VITO_DEFS_FILE, FILE_READ);
+    vitoDefForEachLine(f, [n, prefix, prefixLen](char* line, uint16_t) {
+        if (vitoDefCount >= n) {
+            return;
+        }
+        VitoDefRecord& r = vitoDefs[vitoDefCount];
+        char* row = vitoDefRows + (size_t)vitoDefCount * VITO_DEFS_ROW;
+        if (vitoDefParse(line, r, row + prefixLen) != nullptr) {
+            return;
+        }
+        for (uint8_t i = 0; i < vitoDefCount; ++i) {
+            if (strcmp(vitoDefName(i), row + prefixLen) == 0) {
+                return;   // duplicate, skipped like in the dry run
+            }
+        }
+        memcpy(row, prefix, prefixLen);
+        vitoDefCount++;
+    });
+
+    for (uint8_t i = 0; i < vitoDefCount; ++i) {
+        const VitoDefRecord& r = vitoDefs[i];
+        char* row = vitoDefRows + (size_t)i * VITO_DEFS_ROW;
+        HABaseDeviceType* e = nullptr;
+        if (r.entity == VITO_DEF_SENSOR) {
+            VitoPaced<HASensorNumber>* s =
+                new VitoPaced<HASensorNumber>(row, (HABaseDeviceType::NumberPrecision)r.precision);
+            if (r.unit) {
+                s->setUnitOfMeasurement(vitoDefUnits[r.unit]);
+            }
+            e = s;
+            vitoDefRamBytes += sizeof(VitoPaced<HASensorNumber>);
+        } else if (r.entity == VITO_DEF_BINARY) {
+            e = new VitoPaced<HABinarySensor>(row);
+            vitoDefRamBytes += sizeof(VitoPaced<HABinarySensor>);
+        }
+        if (e) {
+            e->setName(row + prefixLen);
+            e->setObjectId(row);
+        }
+        vitoDefEntities[i] = e;
+    }
+    return vitoDefCount;
+}
+
+// --- polling -------------------------------------------------------------------------
+inline uint32_t vitoDefPeriodMs(const VitoDefRecord& r) {
+    return r.cls < VITO_CLASS_COUNT ? vitoPollClasses[r.cls].intervalMs : (uint32_t)r.periodS * 1000UL;
+}
+
+// Most overdue definition, VITO_DP_NONE if none is due. A full scan only runs
+// once the earliest due time of the previous one has come.
+inline uint8_t vitoDefsPick(uint32_t now) {
+    if (vitoDefCount == 0 || (int32_t)(now - vitoDefNextDueMs) < 0) {
+        return VITO_DP_NONE;
+    }
+    uint8_t best = VITO_DP_NONE;
+    int32_t bestLate = INT32_MIN;
+    int32_t nextDue = INT32_MAX;   // relative to now
+    for (uint8_t i = 0; i < vitoDefCount; ++i) {
+        const VitoDefState& s = vitoDefStates[i];
+        int32_t late = s.lastOkMs ? (int32_t)(now - s.lastOkMs - vitoDefPeriodMs(vitoDefs[i])) : INT32_MAX / 2;
+        int32_t retry = s.lastAttemptMs ? (int32_t)(VITO_DEFS_RETRY_MS - (now - s.lastAttemptMs)) : 0;
+        int32_t due = -late > retry ? -late : retry;
+        if (vitoBreakerOpen(s.breaker, now)) {
+            int32_t open = (int32_t)(s.breaker.openUntilMs - now);
+            due = open > due ? open : due;
+        }
+        if (due > 0) {
+            if (due < nextDue) nextDue = due;
+            continue;
+        }
+        if (late > bestLate) {
+            best = i;
+            bestLate = late;
+        }
+    }
+    if (best == VITO_DP_NONE) {
+        vitoDefNextDueMs = now + (uint32_t)nextDue;
+    }
+    return best;
+}
+
+// Temporary Datapoint for a read of definition i (VitoWiFi copies it).
+inline VitoWiFi::Datapoint vitoDefDatapoint(uint8_t i) {
+    const VitoDefRecord& r = vitoDefs[i];
+    return VitoWiFi::Datapoint(vitoDefName(i), r.address, r.length, vitoDpConverter(r.conv));
+}
+
+inline void vitoDefsOnRequest(uint8_t i, uint32_t now) {
+    vitoDefStates[i].lastAttemptMs = now ? now : 1;
+}
+
+// onVitoResponse() (Optolink task): store the value; returns it for vitoDefsPublish().
+inline float vitoDefsOnValue(uint8_t i, const VitoWiFi::VariantValue& value, uint32_t now) {
+    VitoDefState& s = vitoDefStates[i];
+    s.value    = value;
+    s.lastOkMs = now ? now : 1;
+    s.reads++;
+    vitoBreakerOnSuccess(s.breaker);
+    vitoDefNextDueMs = now;   // its next due time changed: rescan
+    return s.value;
+}
+
+// loop(): update the entity of definition i.
+inline void vitoDefsPublish(uint8_t i, float value) {
+    HABaseDeviceType* e = i < vitoDefCount ? vitoDefEntities[i] : nullptr;
+    if (e == nullptr) {
+        return;
+    }
+    VitoDpEntry entry = {vitoDefName(i), vitoDefs[i].entity == VITO_DEF_BINARY ? VitoDpKind::Binary
+                                                                              : VitoDpKind::Temperature,
+                         e, nullptr, 0, nullptr};
+    VitoDpValue v = {value, (uint8_t)value, nullptr};
+    vitoPublishEntry(entry, v);
+}
+
+// onVitoError(); count = false if the link is blamed (vitoLinkOnError).
+inline void vitoDefsOnError(uint8_t i, uint32_t now, bool count) {
+    VitoDefState& s = vitoDefStates[i];
+    uint32_t lost = s.lastAttemptMs ? now - s.lastAttemptMs : 0;
+    s.errors++;
+    vitoBreakerLostMs += lost;
+    vitoBreakerOnFailure(s.breaker, now, lost, count);
+    vitoDefNextDueMs = now;
+}
+
+// --- HTTP ------------------------------------------------------------------------------
+static bool vitoDefUploadOk = false;   // every chunk of the current upload was stored
+
+// POST /datapoints body, chunk by chunk into VITO_DEFS_UPLOAD.
+inline void vitoDefsUploadChunk(const uint8_t* data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        vitoDefUploadOk = total <= VITO_DEFS_FILE_MAX;
+    }
+    if (!vitoDefUploadOk) {
+        return;
+    }
+    File f = LittleFS.open(VITO_DEFS_UPLOAD, index == 0 ? FILE_WRITE : FILE_APPEND);
+    vitoDefUploadOk = f && f.write(data, len) == len;
+}
+
+// End of POST /datapoints: replace the file if the upload is complete and the
+// dry run found no bad line. Returns the HTTP status, the JSON is in *json.
+inline int vitoDefsUploadDone(bool restart, const char** json) {
+    static char buf[160];
+    VitoDefCheck c = {0, 0, 0, nullptr};
+    bool complete = vitoDefUploadOk;
+    bool saved = false;
+    vitoDefUploadOk = false;
+    if (complete) {
+        c = vitoDefsCheck(VITO_DEFS_UPLOAD);
+        saved = c.bad == 0;
+    }
+    if (saved) {
+        LittleFS.remove(VITO_DEFS_FILE);
+        saved = LittleFS.rename(VITO_DEFS_UPLOAD, VITO_DEFS_FILE);
+        vitoDefRestartPending = saved && restart;
+    } else {
+        LittleFS.remove(VITO_DEFS_UPLOAD);
+    }
+    snprintf(buf, sizeof(buf),
+             "{\"saved\":%s,\"datapoints\":%u,\"badLines\":%u,\"firstBadLine\":%u,\"error\":\"%s\",\"restart\":%s}",
+             saved ? "true" : "false", c.valid, c.bad, c.firstBad,
+             !complete ? "upload failed or too big" : c.firstError ? c.firstError : "",
+             vitoDefRestartPending ? "true" : "false");
+    *json = buf;
+    return saved ? 200 : complete ? 400 : 413;
+}
+
+struct VitoDefCursor {
+    uint16_t next;   // 0 = head, 1..count = datapoints, then the tail
+    bool     done;
+};
+
+inline size_t vitoDefFormat(const VitoDefCursor& c, char* buf, size_t size, uint32_t now) {
+    int n;
+    if (c.next == 0) {
+        n = snprintf(buf, size, "{\"count\":%u,\"max\":%u,\"ramBytes\":%lu,\"badLines\":%u,\"firstBadLine\":%u,"
+                     "\"firstError\":\"%s\",\"restartPending\":%s,\"datapoints\":[",
+                     vitoDefCount, (unsigned)VITO_DEFS_MAX, (unsigned long)vitoDefRamBytes, vitoDefBadLines,
+                     vitoDefFirstBad, vitoDefFirstError ? vitoDefFirstError : "",
+                     vitoDefRestartPending ? "true" : "false");
+    } else if (c.next <= vitoDefCount) {
+        uint8_t i = (uint8_t)(c.next - 1);
+        const VitoDefRecord& r = vitoDefs[i];
+        const VitoDefState& s = vitoDefStates[i];
+        char value[24] = "null";
+        char age[12] = "null";
+        if (s.lastOkMs) {
+            snprintf(value, sizeof(value), "%g", (double)s.value);
+            snprintf(age, sizeof(age), "%lu", (unsigned long)(now - s.lastOkMs));
+        }
+        n = snprintf(buf, size, "%s{\"name\":\"%s\",\"address\":\"0x%04X\",\"length\":%u,\"periodMs\":%lu,"
+                     "\"value\":%s,\"ageMs\":%s,\"reads\":%u,\"errors\":%u,\"quarantined\":%s}",
+                     i ? "," : "", vitoDefName(i), r.address, r.length, (unsigned long)vitoDefPeriodMs(r), value,
+                     age, s.reads, s.errors, vitoBreakerOpen(s.breaker, now) ? "true" : "false");
+    } else {
+        n = snprintf(buf, size, "]}");
+    }
+    return n < 0 || (size_t)n >= size ? 0 : (size_t)n;
+}
+
+// Filler for GET /datapoints/state: whole objects up to maxLen, 0 when done,
+// (size_t)-1 if not even one object fits.
+inline size_t vitoDefsFill(VitoDefCursor& c, uint8_t* buf, size_t maxLen) {
+    char obj[224];
+    size_t n = 0;
+    uint32_t now = millis();
+    while (!c.done) {
+        size_t len = vitoDefFormat(c, obj, sizeof(obj), now);
+        if (n + len > maxLen) {
+            return n ? n : (size_t)-1;
+        }
+        memcpy(buf + n, obj, len);
+        n += len;
+        if (++c.next > (uint16_t)vitoDefCount + 1) {
+            c.done = true;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Generated by scripts/gen_dpspec.py from dpspec.toml - do not edit.
+// HA entities of the datapoints and the per-datapoint tables that refer to
+// them or to module types. Included by HA_mqtt_addin.h (HA_PREFIX).
+
+//*** entities ***************************************************
+VitoPaced<HASensorNumber> AussenTempSens          (HA_PREFIX "Aussentemperatur", HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> WWtempObenSens          (HA_PREFIX "WarmwasserOben", HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> VorlaufTempSetSens      (HA_PREFIX "VorlaufSoll", HANumber::PrecisionP0);
+VitoPaced<HASensorNumber> VorlaufTempSens         (HA_PREFIX "Vorlauf", HANumber::PrecisionP0);
+VitoPaced<HASensorNumber> RuecklaufTempSens       (HA_PREFIX "Ruecklauf", HANumber::PrecisionP0);
+VitoPaced<HABinarySensor> heizkreispumpeSens      (HA_PREFIX "Heizkreispumpe");
+VitoPaced<HABinarySensor> WWzirkulationspumpeSens (HA_PREFIX "WWZirkulation");
+VitoPaced<HABinarySensor> RelVerdichterSens       (HA_PREFIX "Verdichter");
+VitoPaced<HABinarySensor> RelPrimaerquelleSens    (HA_PREFIX "Grundwasserpumpe");
+VitoPaced<HABinarySensor> RelSekundaerPumpeSens   (HA_PREFIX "Sekundaerpumpe");
+VitoPaced<HASensor>       ventilHeizenWWSens      (HA_PREFIX "VentilHeizenWW");
+VitoPaced<HASensor>       operationmodeSens       (HA_PREFIX "Betriebsmodus");
+VitoPaced<HASensor>       manualmodeSens          (HA_PREFIX "ManualMode");
+VitoPaced<HANumber>       RaumSollTempSens        (HA_PREFIX "Raumtemperatur", HANumber::PrecisionP1);
+VitoPaced<HANumber>       RaumSollRedSens         (HA_PREFIX "RaumtemperaturRed", HANumber::PrecisionP1);
+VitoPaced<HANumber>       WWtempSollSens          (HA_PREFIX "WarmwasserSoll", HANumber::PrecisionP0);
+VitoPaced<HANumber>       WWtempSoll2Sens         (HA_PREFIX "WarmwasserSoll2", HANumber::PrecisionP0);
+VitoPaced<HANumber>       HystWWsollSens          (HA_PREFIX "HystereseWWsoll", HANumber::PrecisionP1);
+VitoPaced<HANumber>       HKniveauSens            (HA_PREFIX "NiveauHeizkennlinie", HANumber::PrecisionP1);
+VitoPaced<HANumber>       HKneigungSens           (HA_PREFIX "NeigungHeizkennlinie", HANumber::PrecisionP1);
+VitoPaced<HABinarySensor> Stoerung                (HA_PREFIX "WPStoerung");
+
+// Side effects beyond the datapoint's own entity, defined in the sketch
+static void onVorlaufIst(const VitoDpValue& v);
+static void onRelEHeiz(const VitoDpValue& v);
+static void onRelVerdichter(const VitoDpValue& v);
+static void onManualMode(const VitoDpValue& v);
+static void onRaumSoll(const VitoDpValue& v);
+
+// Dispatch table (Vitocal_registry.h): {log tag, kind, entity, labels, label count, hook}
+static constexpr VitoDpEntry vitoDpTable[DP_COUNT] = {
+  /* DP_TEMP_OUTSIDE     */ { "tmpAu (AussenTemp)",   VitoDpKind::Temperature, &AussenTempSens,          nullptr,              0, nullptr },
+  /* DP_WW_OBEN          */ { "WWo (WWtempOben)",     VitoDpKind::Temperature, &WWtempObenSens,          nullptr,              0, nullptr },
+  /* DP_VORLAUF_SOLL     */ { "VorlaufSoll",          VitoDpKind::Temperature, &VorlaufTempSetSens,      nullptr,              0, nullptr },
+  /* DP_VORLAUF_IST      */ { "VorlaufIst",           VitoDpKind::Temperature, &VorlaufTempSens,         nullptr,              0, onVorlaufIst },
+  /* DP_RUECKLAUF        */ { "Ruecklauf",            VitoDpKind::Temperature, &RuecklaufTempSens,       nullptr,              0, nullptr },
+  /* DP_REL_EHEIZ1       */ { "RelEHeizStufe1 (raw)", VitoDpKind::Raw,         nullptr,                  nullptr,              0, onRelEHeiz },
+  /* DP_REL_EHEIZ2       */ { "RelEHeizStufe2 (raw)", VitoDpKind::Raw,         nullptr,                  nullptr,              0, onRelEHeiz },
+  /* DP_HEIZKREISPUMPE   */ { "Heizkreispumpe",       VitoDpKind::Binary,      &heizkreispumpeSens,      nullptr,              0, nullptr },
+  /* DP_WW_ZIRKPUMPE     */ { "WWZirkulationspumpe",  VitoDpKind::Binary,      &WWzirkulationspumpeSens, nullptr,              0, nullptr },
+  /* DP_REL_VERDICHTER   */ { "RelVerdichter",        VitoDpKind::Binary,      &RelVerdichterSens,       nullptr,              0, onRelVerdichter },
+  /* DP_REL_PRIMAER      */ { "RelPrimaerquelle",     VitoDpKind::Binary,      &RelPrimaerquelleSens,    nullptr,              0, nullptr },
+  /* DP_REL_SEKUNDAER    */ { "RelSekundaerPumpe",    VitoDpKind::Binary,      &RelSekundaerPumpeSens,   nullptr,              0, nullptr },
+  /* DP_VENTIL_HEIZEN_WW */ { "ventilHeizenWW",       VitoDpKind::Label,       &ventilHeizenWWSens,      ventilHeizenWWLabels, 2, nullptr },
+  /* DP_OPERATION_MODE   */ { "operationmode",        VitoDpKind::Label,       &operationmodeSens,       operationModeLabels,  8, nullptr },
+  /* DP_MANUAL_MODE      */ { "manualmode",           VitoDpKind::Label,       &manualmodeSens,          manualModeLabels,     3, onManualMode },
+  /* DP_RAUM_SOLL        */ { "RaumSollTemp",         VitoDpKind::Setpoint,    &RaumSollTempSens,        nullptr,              0, onRaumSoll },
+  /* DP_RAUM_SOLL_RED    */ { "RaumSollRed",          VitoDpKind::Setpoint,    &RaumSollRedSens,         nullptr,              0, nullptr },
+  /* DP_WW_SOLL          */ { "WWtempSoll",           VitoDpKind::Setpoint,    &WWtempSollSens,          nullptr,              0, nullptr },
+  /* DP_WW_SOLL2         */ { "WWtempSoll2",          VitoDpKind::Setpoint,    &WWtempSoll2Sens,         nullptr,              0, nullptr },
+  /* DP_HYST_WW_SOLL     */ { "TempHystWWSoll",       VitoDpKind::Setpoint,    &HystWWsollSens,          nullptr,              0, nullptr },
+  /* DP_HK_NIVEAU        */ { "TempHKniveau",         VitoDpKind::Setpoint,    &HKniveauSens,            nullptr,              0, nullptr },
+  /* DP_HK_NEIGUNG       */ { "TempHKNeigung",        VitoDpKind::Setpoint,    &HKneigungSens,           nullptr,              0, nullptr },
+  /* DP_STOERUNG         */ { "Stoerung",             VitoDpKind::Binary,      &Stoerung,                nullptr,              0, nullptr },
+};
+
+// Discovery metadata: {object id, name, icon, unit, min, max, step (Setpoint)}
+static const VitoDpHaMeta vitoDpHaMeta[DP_COUNT] = {
+  /* DP_TEMP_OUTSIDE     */ { HA_PREFIX "Aussentemperatur",     "Aussentemperatur",         "mdi:home-thermometer-outline",    "C",     0.0f,  0.0f,  0.0f },
+  /* DP_WW_OBEN          */ { HA_PREFIX "WarmwasserOben",       "Warmwasser Oben",          "mdi:bathtub",                     "C",     0.0f,  0.0f,  0.0f },
+  /* DP_VORLAUF_SOLL     */ { HA_PREFIX "VorlaufSoll",          "Vorlauf Soll",             "mdi:thermometer-chevron-up",      "C",     0.0f,  0.0f,  0.0f },
+  /* DP_VORLAUF_IST      */ { HA_PREFIX "Vorlauf",              "Vorlauf",                  "mdi:thermometer-chevron-up",      "C",     0.0f,  0.0f,  0.0f },
+  /* DP_RUECKLAUF        */ { HA_PREFIX "Ruecklauf",            "Ruecklauf",                "mdi:thermometer-chevron-down",    "C",     0.0f,  0.0f,  0.0f },
+  /* DP_REL_EHEIZ1       */ { nullptr,                          nullptr,                    nullptr,                           nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_REL_EHEIZ2       */ { nullptr,                          nullptr,                    nullptr,                           nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_HEIZKREISPUMPE   */ { HA_PREFIX "Heizkreispumpe",       "Heizkreispumpe",           "mdi:pump",                        nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_WW_ZIRKPUMPE     */ { HA_PREFIX "WWZirkulation",        "WW Zirkulation",           "mdi:pump",                        nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_REL_VERDICHTER   */ { HA_PREFIX "Verdichter",           "Verdichter",               "mdi:filter",                      nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_REL_PRIMAER      */ { HA_PREFIX "Grundwasserpumpe",     "Grundwasserpumpe",         "mdi:pump",                        nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_REL_SEKUNDAER    */ { HA_PREFIX "Sekundaerpumpe",       "Sekundaerpumpe",           "mdi:pump",                        nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_VENTIL_HEIZEN_WW */ { HA_PREFIX "VentilHeizenWW",       "Ventil Heizen-WW",         "mdi:pipe-valve",                  nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_OPERATION_MODE   */ { HA_PREFIX "Betriebsmodus",        "Modus",                    "mdi:state-machine",               nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_MANUAL_MODE      */ { HA_PREFIX "ManualMode",           "Man.Modus",                "mdi:braille",                     nullptr, 0.0f,  0.0f,  0.0f },
+  /* DP_RAUM_SOLL        */ { HA_PREFIX "Raumtemperatur",       "Raumtemperatur Soll",      "mdi:state-machine",               "C",     10.0f, 30.0f, 0.5f },
+  /* DP_RAUM_SOLL_RED    */ { HA_PREFIX "RaumtemperaturRed",    "Raumtemperatur Red. Soll", "mdi:state-machine",               "C",     10.0f, 30.0f, 0.5f },
+  /* DP_WW_SOLL          */ { HA_PREFIX "WarmwasserSoll",       "Warmwasser Soll",          "mdi:state-machine",               "C",     20.0f, 60.0f, 1.0f },
+  /* DP_WW_SOLL2         */ { HA_PREFIX "WarmwasserSoll2",      "Warmwasser Soll2",         "mdi:state-machine",               "C",     20.0f, 60.0f, 1.0f },
+  /* DP_HYST_WW_SOLL     */ { HA_PREFIX "HystereseWWsoll",      "Hysterese WW Soll",        "mdi:state-machine",               "C",     1.0f,  20.0f, 0.5f },
+  /* DP_HK_NIVEAU        */ { HA_PREFIX "NiveauHeizkennlinie",  "Niveau Heizkennlinie",     "mdi:chart-bell-curve-cumulative", "K",     0.0f,  10.0f, 0.1f },
+  /* DP_HK_NEIGUNG       */ { HA_PREFIX "NeigungHeizkennlinie", "Neigung Heizkennlinie",    "mdi:chart-bell-curve-cumulative", "-",     0.0f,  1.0f,  0.1f },
+  /* DP_STOERUNG         */ { HA_PREFIX "WPStoerung",           "Stoerung",                 "mdi:alert-outline",               nullptr, 0.0f,  0.0f,  0.0f },
+};
+
+// Adaptive polling bounds (Vitocal_adaptive.h): {min period, max period, deadband, flags}
+const VitoAdaptRule vitoAdaptRules[DP_COUNT] = {
+  /* DP_TEMP_OUTSIDE     */ { 85000UL,  680000UL,  0.5f, 0 },
+  /* DP_WW_OBEN          */ { 21250UL,  340000UL,  0.5f, VITO_ADAPT_BOOST },
+  /* DP_VORLAUF_SOLL     */ { 85000UL,  680000UL,  1.0f, 0 },
+  /* DP_VORLAUF_IST      */ { 21250UL,  340000UL,  0.5f, VITO_ADAPT_BOOST },
+  /* DP_RUECKLAUF        */ { 21250UL,  340000UL,  0.5f, VITO_ADAPT_BOOST },
+  /* DP_REL_EHEIZ1       */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST | VITO_ADAPT_TRIGGER_ON | VITO_ADAPT_TRIGGER_CHG },
+  /* DP_REL_EHEIZ2       */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST | VITO_ADAPT_TRIGGER_ON | VITO_ADAPT_TRIGGER_CHG },
+  /* DP_HEIZKREISPUMPE   */ { 30000UL,  240000UL,  0.5f, 0 },
+  /* DP_WW_ZIRKPUMPE     */ { 30000UL,  240000UL,  0.5f, 0 },
+  /* DP_REL_VERDICHTER   */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST | VITO_ADAPT_TRIGGER_ON | VITO_ADAPT_TRIGGER_CHG },
+  /* DP_REL_PRIMAER      */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST },
+  /* DP_REL_SEKUNDAER    */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST },
+  /* DP_VENTIL_HEIZEN_WW */ { 15000UL,  240000UL,  0.5f, VITO_ADAPT_BOOST | VITO_ADAPT_TRIGGER_CHG },
+  /* DP_OPERATION_MODE   */ { 85000UL,  680000UL,  0.5f, 0 },
+  /* DP_MANUAL_MODE      */ { 85000UL,  680000UL,  0.5f, 0 },
+  /* DP_RAUM_SOLL        */ { 180000UL, 720000UL,  0.1f, 0 },
+  /* DP_RAUM_SOLL_RED    */ { 180000UL, 720000UL,  0.1f, 0 },
+  /* DP_WW_SOLL          */ { 180000UL, 720000UL,  0.1f, 0 },
+  /* DP_WW_SOLL2         */ { 180000UL, 720000UL,  0.1f, 0 },
+  /* DP_HYST_WW_SOLL     */ { 180000UL, 720000UL,  0.1f, 0 },
+  /* DP_HK_NIVEAU        */ { 360000UL, 1440000UL, 0.1f, 0 },
+  /* DP_HK_NEIGUNG       */ { 360000UL, 1440000UL, 0.1f, 0 },
+  /* DP_STOERUNG         */ { 60000UL,  120000UL,  0.5f, 0 },
+};
+
+// Publish policy (Vitocal_publish.h): {abs deadband, rel deadband, filter, min interval s, heartbeat min}
+const VitoPublishPolicy vitoPublishPolicy[DP_COUNT] = {
+  /* DP_TEMP_OUTSIDE     */ { 0.2f, 0.0f, VITO_FILTER_EMA,    60, 30 },
+  /* DP_WW_OBEN          */ { 0.3f, 0.0f, VITO_FILTER_MEDIAN, 30, 30 },
+  /* DP_VORLAUF_SOLL     */ { 0.5f, 0.0f, VITO_FILTER_NONE,   30, 30 },
+  /* DP_VORLAUF_IST      */ { 0.5f, 0.0f, VITO_FILTER_MEDIAN, 15, 30 },
+  /* DP_RUECKLAUF        */ { 0.5f, 0.0f, VITO_FILTER_MEDIAN, 15, 30 },
+  /* DP_REL_EHEIZ1       */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  0 },
+  /* DP_REL_EHEIZ2       */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  0 },
+  /* DP_HEIZKREISPUMPE   */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_WW_ZIRKPUMPE     */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_REL_VERDICHTER   */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_REL_PRIMAER      */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_REL_SEKUNDAER    */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_VENTIL_HEIZEN_WW */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  30 },
+  /* DP_OPERATION_MODE   */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_MANUAL_MODE      */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_RAUM_SOLL        */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_RAUM_SOLL_RED    */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_WW_SOLL          */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_WW_SOLL2         */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_HYST_WW_SOLL     */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_HK_NIVEAU        */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_HK_NEIGUNG       */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  60 },
+  /* DP_STOERUNG         */ { 0.0f, 0.0f, VITO_FILTER_NONE,   0,  15 },
+};
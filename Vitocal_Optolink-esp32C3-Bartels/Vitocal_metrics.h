@@ -0,0 +1,456 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Optolink link metrics for Prometheus (GET /metrics)
+//
+// Per polled datapoint, in fixed memory:
+//   - request -> response round-trip time, log2-bucketed histogram
+//   - achieved poll period (age of the value when it was refreshed), same
+//   - errors by OptolinkResult code
+// plus the current age and age budget of every value, so an alert can fire
+// on a slow or failing link before values go stale in HA, and the state of
+// the MQTT store-and-forward queue (depth, drops, replay rate), of the WiFi
+// station (connected, attempts, losses, downtime) and of the circuit breakers
+// and link recovery (Vitocal_breaker.h: quarantines, Optolink time lost on
+// failed reads, recoveries and how long they took), of the Optolink task
+// (Vitocal_optotask.h: step interval, ring high water and drops), of the
+// value store (Vitocal_values.h: replies, unchanged ones, decodes) and of the
+// batched MQTT state (Vitocal_mqttbatch.h: documents sent and skipped).
+//
+// The text is produced by a cursor that walks the export one line at a time;
+// vitoMetricsFill() writes as many whole lines as fit into the buffer of a
+// chunked response and resumes there on the next call, so the export never
+// needs more than one line of RAM.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <VitoWiFi.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_blockread.h"
+#include "Vitocal_scheduler.h"
+#include "Vitocal_mqttqueue.h"
+#include "Vitocal_wifi.h"
+#include "Vitocal_breaker.h"
+#include "Vitocal_optotask.h"
+#include "Vitocal_values.h"
+#include "Vitocal_mqttbatch.h"
+
+#ifndef VITO_HIST_BUCKETS
+#define VITO_HIST_BUCKETS 12          // finite log2 buckets + le="+Inf"
+#endif
+#ifndef VITO_RTT_BASE_MS
+#define VITO_RTT_BASE_MS 16UL         // first RTT bucket: <= 16 ms ... 16.4 s
+#endif
+#ifndef VITO_PERIOD_BASE_MS
+#define VITO_PERIOD_BASE_MS 1000UL    // first period bucket: <= 1 s ... 1024 s
+#endif
+
+// Error codes counted per datapoint (OptolinkResult, CONTINUE/PACKET never reach onError)
+#define VITO_METRIC_ERROR_CODES 5
+static const char* const vitoMetricErrorNames[VITO_METRIC_ERROR_CODES] = {
+    "timeout", "length", "nack", "crc", "error"
+};
+
+// Device-wide metrics of the MQTT queue, WiFi and the Optolink link, see
+// vitoMqMetrics[], vitoWifiMetrics[], vitoLinkMetrics[]
+#define VITO_MQ_METRICS 6
+#define VITO_WIFI_METRICS 4
+#define VITO_LINK_METRICS 6
+
+struct VitoHistogram {
+    uint32_t buckets[VITO_HIST_BUCKETS];   // non-cumulative; the last one is +Inf
+    uint32_t count;
+    uint64_t sumMs;
+};
+
+struct VitoDpMetrics {
+    VitoHistogram rtt;
+    VitoHistogram period;
+    uint32_t      errors[VITO_METRIC_ERROR_CODES];
+};
+
+static VitoDpMetrics vitoMetrics[DP_COUNT];
+
+inline uint8_t vitoHistBucket(uint32_t ms, uint32_t baseMs) {
+    uint8_t b = 0;
+    uint32_t bound = baseMs;
+    while (b < VITO_HIST_BUCKETS - 1 && ms > bound) {
+        bound <<= 1;
+        ++b;
+    }
+    return b;
+}
+
+inline void vitoHistAdd(VitoHistogram& h, uint32_t ms, uint32_t baseMs) {
+    h.buckets[vitoHistBucket(ms, baseMs)]++;
+    h.count++;
+    h.sumMs += ms;
+}
+
+// Successful read of datapoint id: rttMs since its request, ageMs of the
+// value it replaces (UINT32_MAX on the first read).
+inline void vitoMetricsOnRead(uint8_t id, uint32_t rttMs, uint32_t ageMs) {
+    if (id >= DP_COUNT) {
+        return;
+    }
+    vitoHistAdd(vitoMetrics[id].rtt, rttMs, VITO_RTT_BASE_MS);
+    if (ageMs != UINT32_MAX) {
+        vitoHistAdd(vitoMetrics[id].period, ageMs, VITO_PERIOD_BASE_MS);
+    }
+}
+
+inline uint8_t vitoMetricErrorIndex(VitoWiFi::OptolinkResult error) {
+    switch (error) {
+    case VitoWiFi::OptolinkResult::TIMEOUT: return 0;
+    case VitoWiFi::OptolinkResult::LENGTH:  return 1;
+    case VitoWiFi::OptolinkResult::NACK:    return 2;
+    case VitoWiFi::OptolinkResult::CRC:     return 3;
+    default:                                return 4;
+    }
+}
+
+// Failed request: counted for the datapoint, or every member of block blk.
+inline void vitoMetricsOnError(uint8_t id, uint8_t blk, VitoWiFi::OptolinkResult error) {
+    uint8_t code = vitoMetricErrorIndex(error);
+    if (blk != VITO_DP_NONE && blk < vitoBlockCount) {
+        const VitoBlock& b = vitoBlocks[blk];
+        for (uint8_t i = 0; i < b.count; ++i) {
+            vitoMetrics[vitoBlockMembers[b.first + i]].errors[code]++;
+        }
+    } else if (id < DP_COUNT) {
+        vitoMetrics[id].errors[code]++;
+    }
+}
+
+// --- text exposition -----------------------------------------------------------
+enum VitoMetricsSection : uint8_t {
+    VITO_MS_RTT_HEAD = 0,
+    VITO_MS_RTT,
+    VITO_MS_PERIOD_HEAD,
+    VITO_MS_PERIOD,
+    VITO_MS_ERROR_HEAD,
+    VITO_MS_ERROR,
+    VITO_MS_AGE_HEAD,
+    VITO_MS_AGE,
+    VITO_MS_MAX_AGE_HEAD,
+    VITO_MS_MAX_AGE,
+    VITO_MS_OPEN_HEAD,
+    VITO_MS_OPEN,
+    VITO_MS_QUARANTINES_HEAD,
+    VITO_MS_QUARANTINES,
+    VITO_MS_LOST_HEAD,
+    VITO_MS_LOST,
+    VITO_MS_QUEUE,        // device-wide queue metrics, HELP/TYPE/value each
+    VITO_MS_WIFI,         // WiFi station, same
+    VITO_MS_LINK,         // breakers and link recovery, same
+    VITO_MS_OPTO,         // Optolink task, same
+    VITO_MS_VALUES,       // value store, same
+    VITO_MS_BATCH,        // batched MQTT state, same
+    VITO_MS_DONE
+};
+
+struct VitoMetricsCursor {
+    uint8_t       section;
+    uint8_t       dp;
+    uint8_t       line;
+    uint32_t      cumulative;   // running bucket total of the histogram being written
+    VitoHistogram snap;         // that histogram, copied at its first line
+};
+
+inline uint8_t vitoMetricsLines(uint8_t section) {
+    switch (section) {
+    case VITO_MS_RTT:
+    case VITO_MS_PERIOD: return VITO_HIST_BUCKETS + 2;   // buckets, _sum, _count
+    case VITO_MS_ERROR:  return VITO_METRIC_ERROR_CODES;
+    case VITO_MS_AGE:
+    case VITO_MS_MAX_AGE:
+    case VITO_MS_OPEN:
+    case VITO_MS_QUARANTINES:
+    case VITO_MS_LOST:   return 1;
+    case VITO_MS_QUEUE:  return VITO_MQ_METRICS * 3;
+    case VITO_MS_WIFI:   return VITO_WIFI_METRICS * 3;
+    case VITO_MS_LINK:   return VITO_LINK_METRICS * 3;
+    case VITO_MS_OPTO:   return VITO_OPTO_METRICS * 3;
+    case VITO_MS_VALUES: return VITO_VAL_METRICS * 3;
+    case VITO_MS_BATCH:  return VITO_BATCH_METRICS * 3;
+    default:             return 2;                       // # HELP, # TYPE
+    }
+}
+
+inline bool vitoMetricsPerDp(uint8_t section) {
+    return section == VITO_MS_RTT || section == VITO_MS_PERIOD || section == VITO_MS_ERROR ||
+           section == VITO_MS_AGE || section == VITO_MS_MAX_AGE || section == VITO_MS_OPEN ||
+           section == VITO_MS_QUARANTINES || section == VITO_MS_LOST;
+}
+
+inline int vitoMetricsHead(char* buf, size_t size, uint8_t line, const char* name, const char* type,
+                           const char* help) {
+    return line == 0 ? snprintf(buf, size, "# HELP %s %s\n", name, help)
+                     : snprintf(buf, size, "# TYPE %s %s\n", name, type);
+}
+
+inline int vitoMetricsHistLine(const VitoMetricsCursor& c, char* buf, size_t size, const char* name,
+                               uint32_t baseMs) {
+    const char* dp = vitoDpNames[c.dp];
+    if (c.line < VITO_HIST_BUCKETS - 1) {
+        return snprintf(buf, size, "%s_bucket{dp=\"%s\",le=\"%g\"} %lu\n", name, dp,
+                        (double)(baseMs << c.line) / 1000.0, (unsigned long)c.cumulative);
+    }
+    if (c.line == VITO_HIST_BUCKETS - 1) {
+        return snprintf(buf, size, "%s_bucket{dp=\"%s\",le=\"+Inf\"} %lu\n", name, dp,
+                        (unsigned long)c.cumulative);
+    }
+    if (c.line == VITO_HIST_BUCKETS) {
+        return snprintf(buf, size, "%s_sum{dp=\"%s\"} %.3f\n", name, dp, (double)c.snap.sumMs / 1000.0);
+    }
+    return snprintf(buf, size, "%s_count{dp=\"%s\"} %lu\n", name, dp, (unsigned long)c.snap.count);
+}
+
+// Device-wide metrics: MQTT store-and-forward queue (Vitocal_mqttqueue.h)
+struct VitoDeviceMetric {
+    const char* name;
+    const char* type;
+    const char* help;
+};
+static const VitoDeviceMetric vitoMqMetrics[VITO_MQ_METRICS] = {
+    {"vito_mqtt_queue_depth",         "gauge",   "State updates waiting for replay."},
+    {"vito_mqtt_queue_high_water",    "gauge",   "Highest queue depth since boot."},
+    {"vito_mqtt_queued_total",        "counter", "State updates queued while the broker was down."},
+    {"vito_mqtt_queue_dropped_total", "counter", "Queued updates overwritten by newer ones (queue full)."},
+    {"vito_mqtt_replayed_total",      "counter", "Queued updates replayed after a reconnect."},
+    {"vito_mqtt_replay_rate",         "gauge",   "Replay messages per second of the current or last replay."},
+};
+
+inline double vitoMqMetricValue(uint8_t m) {
+    switch (m) {
+    case 0:  return vitoMqCount;
+    case 1:  return vitoMqHighWater;
+    case 2:  return vitoMqQueued;
+    case 3:  return vitoMqDropped;
+    case 4:  return vitoMqReplayed;
+    default: return vitoMqReplayRate;
+    }
+}
+
+// WiFi station (Vitocal_wifi.h)
+static const VitoDeviceMetric vitoWifiMetrics[VITO_WIFI_METRICS] = {
+    {"vito_wifi_up",                     "gauge",   "1 while the station is connected."},
+    {"vito_wifi_connect_attempts_total", "counter", "WiFi connection attempts, boot included."},
+    {"vito_wifi_disconnects_total",      "counter", "Established WiFi connections lost."},
+    {"vito_wifi_downtime_seconds_total", "counter", "Time without WiFi since boot."},
+};
+
+inline double vitoWifiMetricValue(uint8_t m, uint32_t now) {
+    switch (m) {
+    case 0:  return vitoWifiUp() ? 1 : 0;
+    case 1:  return vitoWifiAttempts;
+    case 2:  return vitoWifiDisconnects;
+    default: return (double)vitoWifiDowntimeTotalMs(now) / 1000.0;
+    }
+}
+
+// Circuit breakers and link recovery (Vitocal_breaker.h)
+static const VitoDeviceMetric vitoLinkMetrics[VITO_LINK_METRICS] = {
+    {"vito_breakers_open",                    "gauge",   "Datapoints and definitions in quarantine."},
+    {"vito_optolink_lost_seconds_total",      "counter", "Optolink time spent on failed reads."},
+    {"vito_link_state",                       "gauge",   "Link recovery: 0 ok, 1 reinit, 2 hold, 3 probing."},
+    {"vito_link_recoveries_total",            "counter", "Link recoveries completed by a successful read."},
+    {"vito_link_last_recovery_seconds",       "gauge",   "First error to first successful read, last recovery."},
+    {"vito_link_recovery_seconds_total",      "counter", "The same, summed over all recoveries."},
+};
+
+inline double vitoLinkMetricValue(uint8_t m) {
+    switch (m) {
+    case 0:  return vitoBreakersOpen;
+    case 1:  return (double)vitoBreakerLostMs / 1000.0;
+    case 2:  return vitoLinkState;
+    case 3:  return vitoLinkRecoveries;
+    case 4:  return (double)vitoLinkLastRecoveryMs / 1000.0;
+    default: return (double)vitoLinkRecoveryTotalMs / 1000.0;
+    }
+}
+
+// Optolink task (Vitocal_optotask.h)
+static const VitoDeviceMetric vitoOptoMetrics[VITO_OPTO_METRICS] = {
+    {"vito_opto_step_max_seconds",          "gauge",   "Longest time between two Optolink steps since boot."},
+    {"vito_opto_step_mean_seconds",         "gauge",   "Mean time between two Optolink steps."},
+    {"vito_opto_queue_high_water",          "gauge",   "Most messages waiting for loop() at once."},
+    {"vito_opto_queue_dropped_total",       "counter", "Values and errors dropped, loop() fell behind."},
+    {"vito_opto_commands_dropped_total",    "counter", "HA writes and interval changes dropped (queue full)."},
+};
+
+// Value store (Vitocal_values.h)
+static const VitoDeviceMetric vitoValMetrics[VITO_VAL_METRICS] = {
+    {"vito_values_replies_total",           "counter", "Good datapoint replies put into the value store."},
+    {"vito_values_unchanged_total",         "counter", "Replies with the stored bytes, not decoded or passed on."},
+    {"vito_values_decodes_total",           "counter", "Values decoded for a consumer."},
+};
+
+// Batched MQTT state (Vitocal_mqttbatch.h)
+static const VitoDeviceMetric vitoBatchMetrics[VITO_BATCH_METRICS] = {
+    {"vito_mqtt_batch_documents_total",     "counter", "Class documents published (VITO_MQTT_BATCH)."},
+    {"vito_mqtt_batch_skipped_total",       "counter", "Class documents not published, too large for the buffer."},
+};
+
+// Line at the cursor; returns its length (lines are well below 160 bytes).
+inline size_t vitoMetricsFormat(VitoMetricsCursor& c, char* buf, size_t size, uint32_t now) {
+    int n = 0;
+    switch (c.section) {
+    case VITO_MS_RTT_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_optolink_rtt_seconds", "histogram",
+                            "Optolink request to response time per datapoint.");
+        break;
+    case VITO_MS_PERIOD_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_poll_period_seconds", "histogram",
+                            "Achieved time between two updates of a datapoint.");
+        break;
+    case VITO_MS_RTT:
+    case VITO_MS_PERIOD: {
+        bool rtt = c.section == VITO_MS_RTT;
+        if (c.line == 0) {
+            c.snap = rtt ? vitoMetrics[c.dp].rtt : vitoMetrics[c.dp].period;
+        }
+        if (c.line < VITO_HIST_BUCKETS) {
+            // cumulative over the snapshot, so +Inf always equals _count
+            c.cumulative = 0;
+            for (uint8_t b = 0; b <= c.line; ++b) {
+                c.cumulative += c.snap.buckets[b];
+            }
+            if (c.line == VITO_HIST_BUCKETS - 1) {
+                c.snap.count = c.cumulative;
+            }
+        }
+        n = vitoMetricsHistLine(c, buf, size, rtt ? "vito_optolink_rtt_seconds" : "vito_dp_poll_period_seconds",
+                                rtt ? VITO_RTT_BASE_MS : VITO_PERIOD_BASE_MS);
+        break;
+    }
+    case VITO_MS_ERROR_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_optolink_errors_total", "counter",
+                            "Failed Optolink requests per datapoint and error code.");
+        break;
+    case VITO_MS_ERROR:
+        n = snprintf(buf, size, "vito_optolink_errors_total{dp=\"%s\",code=\"%s\"} %lu\n", vitoDpNames[c.dp],
+                     vitoMetricErrorNames[c.line], (unsigned long)vitoMetrics[c.dp].errors[c.line]);
+        break;
+    case VITO_MS_AGE_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_age_seconds", "gauge",
+                            "Age of the current value (NaN before the first read).");
+        break;
+    case VITO_MS_AGE: {
+        uint32_t age = vitoSchedAge(c.dp, now);
+        n = age == UINT32_MAX
+          ? snprintf(buf, size, "vito_dp_age_seconds{dp=\"%s\"} NaN\n", vitoDpNames[c.dp])
+          : snprintf(buf, size, "vito_dp_age_seconds{dp=\"%s\"} %.3f\n", vitoDpNames[c.dp], (double)age / 1000.0);
+        break;
+    }
+    case VITO_MS_MAX_AGE_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_max_age_seconds", "gauge",
+                            "Age budget of the value under the current poll schedule.");
+        break;
+    case VITO_MS_MAX_AGE:
+        n = snprintf(buf, size, "vito_dp_max_age_seconds{dp=\"%s\"} %.3f\n", vitoDpNames[c.dp],
+                     (double)vitoSchedMaxAge(vitoSchedule[c.dp]) / 1000.0);
+        break;
+    case VITO_MS_OPEN_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_breaker_open", "gauge",
+                            "1 while the datapoint is quarantined by its circuit breaker.");
+        break;
+    case VITO_MS_OPEN:
+        n = snprintf(buf, size, "vito_dp_breaker_open{dp=\"%s\"} %d\n", vitoDpNames[c.dp],
+                     vitoBreakerOpen(vitoDpBreakers[c.dp], now) ? 1 : 0);
+        break;
+    case VITO_MS_QUARANTINES_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_quarantines_total", "counter",
+                            "Times the circuit breaker of the datapoint opened.");
+        break;
+    case VITO_MS_QUARANTINES:
+        n = snprintf(buf, size, "vito_dp_quarantines_total{dp=\"%s\"} %u\n", vitoDpNames[c.dp],
+                     (unsigned)vitoDpBreakers[c.dp].quarantines);
+        break;
+    case VITO_MS_LOST_HEAD:
+        n = vitoMetricsHead(buf, size, c.line, "vito_dp_lost_seconds_total", "counter",
+                            "Optolink time spent on failed reads of the datapoint (block reads shared).");
+        break;
+    case VITO_MS_LOST:
+        n = snprintf(buf, size, "vito_dp_lost_seconds_total{dp=\"%s\"} %.3f\n", vitoDpNames[c.dp],
+                     (double)vitoDpBreakers[c.dp].lostMs / 1000.0);
+        break;
+    case VITO_MS_QUEUE: {
+        const VitoDeviceMetric& m = vitoMqMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoMqMetricValue(c.line / 3));
+        break;
+    }
+    case VITO_MS_WIFI: {
+        const VitoDeviceMetric& m = vitoWifiMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoWifiMetricValue(c.line / 3, now));
+        break;
+    }
+    case VITO_MS_LINK: {
+        const VitoDeviceMetric& m = vitoLinkMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoLinkMetricValue(c.line / 3));
+        break;
+    }
+    case VITO_MS_OPTO: {
+        const VitoDeviceMetric& m = vitoOptoMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoOptoMetricValue(c.line / 3));
+        break;
+    }
+    case VITO_MS_VALUES: {
+        const VitoDeviceMetric& m = vitoValMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoValMetricValue(c.line / 3));
+        break;
+    }
+    case VITO_MS_BATCH: {
+        const VitoDeviceMetric& m = vitoBatchMetrics[c.line / 3];
+        n = c.line % 3 < 2 ? vitoMetricsHead(buf, size, c.line % 3, m.name, m.type, m.help)
+                           : snprintf(buf, size, "%s %g\n", m.name, vitoBatchMetricValue(c.line / 3));
+        break;
+    }
+    default:
+        break;
+    }
+    if (n < 0) {
+        return 0;
+    }
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
+
+inline void vitoMetricsAdvance(VitoMetricsCursor& c) {
+    if (++c.line < vitoMetricsLines(c.section)) {
+        return;
+    }
+    c.line = 0;
+    if (vitoMetricsPerDp(c.section) && ++c.dp < DP_COUNT) {
+        return;
+    }
+    c.dp = 0;
+    c.section++;
+}
+
+// ESPAsyncWebServer's RESPONSE_TRY_AGAIN (0xFFFFFFFF, size_t on the ESP32)
+#define VITO_METRICS_RETRY ((size_t)-1)
+
+// Filler for a chunked response: whole lines up to maxLen. Returns 0 when
+// the export is complete, VITO_METRICS_RETRY if not even one line fits.
+inline size_t vitoMetricsFill(VitoMetricsCursor& c, uint8_t* buf, size_t maxLen) {
+    char line[160];
+    size_t n = 0;
+    uint32_t now = millis();
+    while (c.section < VITO_MS_DONE) {
+        size_t len = vitoMetricsFormat(c, line, sizeof(line), now);
+        if (n + len > maxLen) {
+            return n ? n : VITO_METRICS_RETRY;
+        }
+        memcpy(buf + n, line, len);
+        n += len;
+        vitoMetricsAdvance(c);
+    }
+    return n;
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Batched MQTT state (VITO_MQTT_BATCH 1)
+//
+// Normally every value that passes the publish policy is its own ArduinoHA
+// publish: one MQTT packet per entity, topic and TCP write included. In
+// batch mode the read-only datapoint entities (Temperature, Binary, Label)
+// are collected per poll class instead: the values the publish policy let
+// through go out together as one JSON document,
+//   <data prefix>/<HA_PREFIX>state/<class>   {"AussenTemp":5.3,"RelVerdichter":"ON",...}
+// when every member of the class has been read since the last document
+// (round complete) or VITO_BATCH_DEADLINE_MS after the first change, which
+// covers datapoints stretched by adaptive polling or quarantined. A class
+// whose values were all held back sends nothing; after a (re)connect the
+// next documents carry every value.
+//
+// The entities stay what they were (unique_id, object_id, name, icon,
+// unit): on every connect the sketch publishes their discovery config in
+// place of ArduinoHA's (Vitocal_discovery.h passes over them), with stat_t
+// set to the class topic and a value_template that picks the key and keeps
+// the state when the key is absent. Setpoints, HVAC and the diagnostic
+// entities keep their ArduinoHA topics.
+//
+// The document buffer holds every member of a class with a value of up to
+// VITO_BATCH_VALUE_MAX characters. A document that still does not fit (a
+// longer label) is never sent cut: the class is skipped until its next
+// change and GET /metrics counts it (vito_mqtt_batch_skipped_total).
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_json.h"
+#include "Vitocal_polling.h"
+#include "Vitocal_registry.h"
+
+#ifndef VITO_MQTT_BATCH
+#define VITO_MQTT_BATCH 0
+#endif
+#ifndef VITO_BATCH_DEADLINE_MS
+#define VITO_BATCH_DEADLINE_MS 10000UL   // first change -> document at the latest
+#endif
+#ifndef VITO_BATCH_VALUE_MAX
+#define VITO_BATCH_VALUE_MAX 32          // a value with its quotes: %.1f, "ON", a label
+#endif
+
+// {} and ,"<name>":<value> per datapoint
+#define VITO_BATCH_DOC_MAX (3 + DP_COUNT * (VITO_DP_NAME_LEN + 4 + VITO_BATCH_VALUE_MAX))
+
+static const char* const vitoBatchClassNames[VITO_CLASS_COUNT] = {"fast", "medium", "slow"};
+
+struct VitoBatchValue {
+    float       f;
+    const char* label;   // Label kind
+    bool        has;
+};
+
+static VitoBatchValue vitoBatchValues[DP_COUNT];
+static VitoDpSet      vitoBatchMembers[VITO_CLASS_COUNT];   // batched datapoints per class
+static VitoDpSet      vitoBatchSeen[VITO_CLASS_COUNT];      // read since the last document
+static VitoDpSet      vitoBatchDirty[VITO_CLASS_COUNT];     // changed since the last document
+static uint32_t       vitoBatchDueMs[VITO_CLASS_COUNT];     // deadline, valid while dirty
+static uint32_t       vitoBatchRounds    = 0;   // documents sent on a complete round
+static uint32_t       vitoBatchDeadlines = 0;   // ... on the deadline
+static uint32_t       vitoBatchBytes     = 0;   // document bytes sent
+static uint32_t       vitoBatchSkipped   = 0;   // documents too large for the buffer, not sent
+
+inline bool vitoBatchKind(VitoDpKind k) {
+    return k == VitoDpKind::Temperature || k == VitoDpKind::Binary || k == VitoDpKind::Label;
+}
+
+inline void vitoBatchInit(const VitoDpEntry* table) {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        if (table[i].entity != nullptr && vitoBatchKind(table[i].kind)) {
+            vitoDpSetAdd(vitoBatchMembers[vitoDpSpecs[i].cls], i);
+        }
+    }
+}
+
+inline bool vitoBatchMember(uint8_t id) {
+    return VITO_MQTT_BATCH && id < DP_COUNT && vitoDpSetHas(vitoBatchMembers[vitoDpSpecs[id].cls], id);
+}
+
+// Every read of a datapoint, published or not: counts towards the round.
+inline void vitoBatchOnRead(uint8_t id) {
+    if (vitoBatchMember(id)) {
+        vitoDpSetAdd(vitoBatchSeen[vitoDpSpecs[id].cls], id);
+    }
+}
+
+// A value the publish policy let through: into the next document.
+inline void vitoBatchSet(uint8_t id, const VitoDpValue& v, uint32_t now) {
+    uint8_t cls = vitoDpSpecs[id].cls;
+    vitoBatchValues[id] = {v.f, v.label, true};
+    if (vitoDpSetEmpty(vitoBatchDirty[cls])) {
+        vitoBatchDueMs[cls] = now + VITO_BATCH_DEADLINE_MS;
+    }
+    vitoDpSetAdd(vitoBatchDirty[cls], id);
+}
+
+// Decoded value -> its ArduinoHA entity, or the batch of its class.
+inline void vitoPublishDp(uint8_t id, const VitoDpEntry& e, const VitoDpValue& v, bool force, uint32_t now) {
+    if (vitoBatchMember(id)) {
+        vitoBatchSet(id, v, now);
+    } else {
+        vitoPublishEntry(e, v, force);
+    }
+}
+
+// Broker (re)connected: resend every class that has values, without waiting.
+inline void vitoBatchOnConnected(uint32_t now) {
+    for (uint8_t c = 0; c < VITO_CLASS_COUNT; ++c) {
+        for (uint8_t i = 0; i < DP_COUNT; ++i) {
+            if (vitoDpSetHas(vitoBatchMembers[c], i) && vitoBatchValues[i].has) {
+                vitoDpSetAdd(vitoBatchDirty[c], i);
+            }
+        }
+        vitoBatchDueMs[c] = now;
+    }
+}
+
+// Class whose document is due, VITO_CLASS_COUNT if none.
+inline uint8_t vitoBatchDue(uint32_t now) {
+    for (uint8_t c = 0; c < VITO_CLASS_COUNT; ++c) {
+        if (vitoDpSetEmpty(vitoBatchDirty[c])) {
+            continue;
+        }
+        if (vitoDpSetCovers(vitoBatchSeen[c], vitoBatchMembers[c]) ||
+            (int32_t)(now - vitoBatchDueMs[c]) >= 0) {
+            return c;
+        }
+    }
+    return VITO_CLASS_COUNT;
+}
+
+// Document of a class: the members changed since the last one; returns its
+// length, 0 if it does not fit.
+inline size_t vitoBatchJson(uint8_t cls, const VitoDpEntry* table, char* buf, size_t size) {
+    size_t n = 0;
+    bool ok = vitoAppendf(buf, size, n, "{");
+    bool first = true;
+    for (uint8_t i = 0; i < DP_COUNT && ok; ++i) {
+        const VitoBatchValue& v = vitoBatchValues[i];
+        if (!vitoDpSetHas(vitoBatchDirty[cls], i) || !v.has) {
+            continue;
+        }
+        const char* sep = first ? "" : ",";
+        switch (table[i].kind) {
+        case VitoDpKind::Binary:
+            ok = vitoAppendf(buf, size, n, "%s\"%s\":\"%s\"", sep, vitoDpNames[i], v.f != 0.0f ? "ON" : "OFF");
+            break;
+        case VitoDpKind::Label:
+            ok = vitoAppendf(buf, size, n, "%s\"%s\":\"%s\"", sep, vitoDpNames[i], v.label ? v.label : "");
+            break;
+        default:
+            ok = vitoAppendf(buf, size, n, "%s\"%s\":%.1f", sep, vitoDpNames[i], (double)v.f);
+            break;
+        }
+        first = false;
+    }
+    return ok && vitoAppendf(buf, size, n, "}") ? n : 0;
+}
+
+// The document of cls went out.
+inline void vitoBatchSent(uint8_t cls, size_t bytes) {
+    if (vitoDpSetCovers(vitoBatchSeen[cls], vitoBatchMembers[cls])) {
+        vitoBatchRounds++;
+    } else {
+        vitoBatchDeadlines++;
+    }
+    vitoBatchBytes += bytes;
+    vitoDpSetClear(vitoBatchSeen[cls]);
+    vitoDpSetClear(vitoBatchDirty[cls]);
+}
+
+// The document of cls did not fit: dropped, the next change starts a new one.
+inline void vitoBatchSkip(uint8_t cls) {
+    vitoBatchSkipped++;
+    vitoDpSetClear(vitoBatchSeen[cls]);
+    vitoDpSetClear(vitoBatchDirty[cls]);
+}
+
+// --- metrics (Vitocal_metrics.h) ---------------------------------------------------------
+#define VITO_BATCH_METRICS 2
+
+inline double vitoBatchMetricValue(uint8_t m) {
+    switch (m) {
+    case 0:  return vitoBatchRounds + vitoBatchDeadlines;
+    default: return vitoBatchSkipped;
+    }
+}
+
+// Discovery config of a batched entity: ArduinoHA's attributes, state from
+// the class document (a binary sensor's own state reads "on", its payload
+// is "ON"). The key is subscripted, value_json.<name> breaks on names that
+// are not identifiers (RelPrimärquelle). Returns its length, 0 if it did
+// not fit.
+inline size_t vitoBatchConfig(uint8_t id, bool binary, const VitoDpHaMeta& m, const char* uniqueId,
+                              const char* stateTopic, const char* availabilityTopic, const char* deviceId,
+                              char* buf, size_t size) {
+    const char* name = vitoDpNames[id];
+    int n = snprintf(buf, size,
+                     "{\"name\":\"%s\",\"obj_id\":\"%s\",\"uniq_id\":\"%s\",\"ic\":\"%s\"%s%s%s,"
+                     "\"stat_t\":\"%s\",\"val_tpl\":\"{{ value_json['%s'] if '%s' in value_json else this.state%s }}\","
+                     "\"avty_t\":\"%s\",\"dev\":{\"ids\":\"%s\"}}",
+                     m.name ? m.name : name, m.objectId ? m.objectId : uniqueId, uniqueId,
+                     m.icon ? m.icon : "", m.unit ? ",\"unit_of_meas\":\"" : "", m.unit ? m.unit : "",
+                     m.unit ? "\"" : "", stateTopic, name, name, binary ? " | upper" : "", availabilityTopic,
+                     deviceId);
+    return n > 0 && (size_t)n < size ? (size_t)n : 0;
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Store-and-forward for state updates during broker outages
+//
+// While MQTT is down, every value the publish policy lets through (and every
+// write read-back) is queued with its time instead of being dropped by the
+// entity. The queue is a fixed ring of VITO_MQ_SIZE records; when it is full
+// the oldest record is overwritten and counted as dropped.
+//
+// After onMQTTConnected() and a settle time for discovery, the backlog is
+// replayed oldest first as JSON on <data prefix>/<HA_PREFIX>replay, one
+// message per loop() iteration and at most VITO_MQ_REPLAY_PER_S per second,
+// so the Optolink poller keeps its share of the loop. The entities themselves
+// already hold the latest values, which ArduinoHA republishes on connect;
+// the replay carries what happened in between, with the original timestamps,
+// for recorders that can backfill (InfluxDB, Node-RED, ...).
+//
+// With VITO_MQ_PERSIST the ring is saved to LittleFS every VITO_MQ_SYNC_MS
+// while it changes, so a reboot during an outage does not lose it.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_history.h"   // boot counter, wall time
+
+#ifndef VITO_MQ_SIZE
+#define VITO_MQ_SIZE 256                 // records (16 B each)
+#endif
+#ifndef VITO_MQ_REPLAY_PER_S
+#define VITO_MQ_REPLAY_PER_S 10UL        // replay messages per second
+#endif
+#ifndef VITO_MQ_SETTLE_MS
+#define VITO_MQ_SETTLE_MS 3000UL         // after connect, before the replay starts
+#endif
+#ifndef VITO_MQ_PERSIST
+#define VITO_MQ_PERSIST 1
+#endif
+#ifndef VITO_MQ_SYNC_MS
+#define VITO_MQ_SYNC_MS 60000UL          // min time between two saves of the ring
+#endif
+
+#define VITO_MQ_FILE  "/mqtt_queue.bin"
+#define VITO_MQ_MAGIC 0x31514D56UL       // "VMQ1"
+
+struct VitoMqRecord {
+    uint32_t ms;       // uptime of the read
+    uint32_t epoch;    // unix time of the read, 0 = clock not set
+    uint16_t boot;
+    uint8_t  dp;
+    uint8_t  reserved;
+    float    value;
+};
+
+static VitoMqRecord vitoMqRing[VITO_MQ_SIZE];
+static uint16_t     vitoMqHead      = 0;   // next record to write
+static uint16_t     vitoMqCount     = 0;
+static uint16_t     vitoMqHighWater = 0;
+static uint32_t     vitoMqQueued    = 0;   // totals since boot
+static uint32_t     vitoMqDropped   = 0;
+static uint32_t     vitoMqReplayed  = 0;
+static uint32_t     vitoMqConnectMs = 0;
+static uint32_t     vitoMqNextMs    = 0;   // earliest time of the next replay message
+static uint32_t     vitoMqBurstStartMs = 0;   // current replay, 0 = none
+static uint32_t     vitoMqBurstCount   = 0;
+static float        vitoMqReplayRate   = 0.0f;   // messages/s of the current or last replay
+static bool         vitoMqDirty     = false;
+static uint32_t     vitoMqSyncMs    = 0;
+static bool         vitoMqFsReady   = false;
+
+// Queue the value of datapoint id read at nowMs (the broker is down).
+inline void vitoMqPush(uint8_t id, float value, uint32_t nowMs) {
+    if (vitoMqCount == VITO_MQ_SIZE) {
+        vitoMqCount--;   // the oldest record is overwritten
+        vitoMqDropped++;
+    }
+    VitoMqRecord& r = vitoMqRing[vitoMqHead];
+    r.ms       = nowMs;
+    r.epoch    = vitoHistEpoch();
+    r.boot     = vitoHistBoot;
+    r.dp       = id;
+    r.reserved = 0;
+    r.value    = value;
+    vitoMqHead = (uint16_t)((vitoMqHead + 1) % VITO_MQ_SIZE);
+    vitoMqCount++;
+    if (vitoMqCount > vitoMqHighWater) {
+        vitoMqHighWater = vitoMqCount;
+    }
+    vitoMqQueued++;
+    vitoMqDirty = true;
+}
+
+inline const VitoMqRecord& vitoMqOldest() {
+    return vitoMqRing[(vitoMqHead + VITO_MQ_SIZE - vitoMqCount) % VITO_MQ_SIZE];
+}
+
+// onMQTTConnected(): start the replay after the settle time.
+inline void vitoMqOnConnected(uint32_t nowMs) {
+    vitoMqConnectMs = nowMs;
+    vitoMqNextMs    = nowMs + VITO_MQ_SETTLE_MS;
+    vitoMqBurstStartMs = 0;
+}
+
+// Replay payload of the oldest record if one is due at nowMs, else 0.
+// The record stays queued until vitoMqReplayed() confirms the publish.
+inline size_t vitoMqNextReplay(uint32_t nowMs, char* buf, size_t size) {
+    if (vitoMqCount == 0 || (int32_t)(nowMs - vitoMqNextMs) < 0) {
+        return 0;
+    }
+    const VitoMqRecord& r = vitoMqOldest();
+    char ts[16] = "null";
+    if (r.epoch) {
+        snprintf(ts, sizeof(ts), "%lu", (unsigned long)r.epoch);
+    }
+    int n = snprintf(buf, size, "{\"dp\":\"%s\",\"v\":%g,\"ts\":%s,\"boot\":%u,\"uptimeMs\":%lu}",
+                     r.dp < DP_COUNT ? vitoDpNames[r.dp] : "?", (double)r.value, ts, r.boot,
+                     (unsigned long)r.ms);
+    return n < 0 || (size_t)n >= size ? 0 : (size_t)n;
+}
+
+inline void vitoMqReplayedOne(uint32_t nowMs) {
+    if (vitoMqCount == 0) {
+        return;
+    }
+    vitoMqCount--;
+    vitoMqReplayed++;
+    vitoMqDirty  = true;
+    vitoMqNextMs = nowMs + 1000UL / VITO_MQ_REPLAY_PER_S;
+    if (vitoMqBurstStartMs == 0) {
+        vitoMqBurstStartMs = nowMs;
+        vitoMqBurstCount   = 0;
+    }
+    vitoMqBurstCount++;
+    uint32_t span = nowMs - vitoMqBurstStartMs;
+    if (span > 0) {
+        vitoMqReplayRate = (float)(vitoMqBurstCount - 1) * 1000.0f / (float)span;
+    }
+    if (vitoMqCount == 0) {
+        vitoMqBurstStartMs = 0;
+    }
+}
+
+// --- persistence -------------------------------------------------------------------
+// setup(), after vitoHistoryInit(): reload a ring saved before a reboot.
+inline void vitoMqInit() {
+#if VITO_MQ_PERSIST
+    if (!LittleFS.begin(true)) {
+        return;
+    }
+    vitoMqFsReady = true;
+    File f = LittleFS.open(VITO_MQ_FILE, FILE_READ);
+    if (!f) {
+        return;
+    }
+    uint32_t head[2] = {0, 0};   // magic, count
+    if (f.read(reinterpret_cast<uint8_t*>(head), sizeof(head)) != sizeof(head) || head[0] != VITO_MQ_MAGIC) {
+        return;
+    }
+    VitoMqRecord r;
+    for (uint32_t i = 0; i < head[1] && f.read(reinterpret_cast<uint8_t*>(&r), sizeof(r)) == sizeof(r); ++i) {
+        vitoMqRing[vitoMqHead] = r;
+        vitoMqHead = (uint16_t)((vitoMqHead + 1) % VITO_MQ_SIZE);
+        if (vitoMqCount < VITO_MQ_SIZE) {
+            vitoMqCount++;
+        }
+    }
+    vitoMqHighWater = vitoMqCount;
+#endif
+}
+
+// loop(): save the ring (oldest first) if it changed, at most every VITO_MQ_SYNC_MS;
+// an empty queue removes the file.
+inline void vitoMqPersist(uint32_t nowMs) {
+#if VITO_MQ_PERSIST
+    if (!vitoMqFsReady || !vitoMqDirty || nowMs - vitoMqSyncMs < VITO_MQ_SYNC_MS) {
+        return;
+    }
+    vitoMqSyncMs = nowMs;
+    vitoMqDirty  = false;
+    if (vitoMqCount == 0) {
+        LittleFS.remove(VITO_MQ_FILE);
+        return;
+    }
+    File f = LittleFS.open(VITO_MQ_FILE, FILE_WRITE);
+    if (!f) {
+        return;
+    }
+    uint32_t head[2] = {VITO_MQ_MAGIC, vitoMqCount};
+    f.write(reinterpret_cast<const uint8_t*>(head), sizeof(head));
+    uint16_t first = (uint16_t)((vitoMqHead + VITO_MQ_SIZE - vitoMqCount) % VITO_MQ_SIZE);
+    uint16_t tail  = (uint16_t)(VITO_MQ_SIZE - first);   // records up to the end of the array
+    if (tail >= vitoMqCount) {
+        f.write(reinterpret_cast<const uint8_t*>(&vitoMqRing[first]), vitoMqCount * sizeof(VitoMqRecord));
+    } else {
+        f.write(reinterpret_cast<const uint8_t*>(&vitoMqRing[first]), tail * sizeof(VitoMqRecord));
+        f.write(reinterpret_cast<const uint8_t*>(&vitoMqRing[0]), (vitoMqCount - tail) * sizeof(VitoMqRecord));
+    }
+#else
+    (void)nowMs;
+#endif
+}
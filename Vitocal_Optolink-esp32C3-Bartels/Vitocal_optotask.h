@@ -0,0 +1,231 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Optolink task
+//
+// The request scheduler and the VitoWiFi state machine run in a FreeRTOS task
+// of their own, above loop() in priority, so a slow broker write, a WebSerial
+// flush or an OTA chunk in loop() no longer delays vitoWIFI.loop() and the
+// response gap. One pass of that task (vitoOptoStep() in the sketch) takes
+// the commands, services the link recovery, queues at most one request and
+// runs vitoWIFI.loop(); then the task sleeps one tick.
+//
+// The two sides share no lock. Everything crosses in a lock-free SPSC ring
+// (Vitocal_spsc.h):
+//   - Optolink -> loop(): every decoded value, read-back result, LittleFS
+//     value and error as a 20-byte VitoOptoMsg. loop() drains the ring and
+//     does the value store, HA publishing, history, live stream, hooks and
+//     the text log from there (vitoOptoDrain()).
+//   - loop() -> Optolink: HA writes and class interval changes as a
+//     VitoOptoCmd; the task applies them before it picks the next request.
+// State only one side writes (scheduler, write queue, breakers, counters) is
+// read by the other for statistics only, like the async_tcp handlers did
+// before.
+//
+// A full ring drops the new element and counts it (vito_opto_* metrics);
+// a dropped value is refreshed by the next read of its datapoint. The last
+// VITO_OPTO_RESERVE slots only take write results (read-back value, failed
+// write): no later read reports those again.
+//
+// VITO_OPTO_TASK 0 (the default without FreeRTOS, e.g. ESP8266) keeps the
+// same rings but calls vitoOptoRunStep() from loop(). The host build gets
+// xTaskCreate() from the Arduino shim, on a std::thread.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_polling.h"
+#include "Vitocal_scheduler.h"
+#include "Vitocal_writequeue.h"
+#include "Vitocal_log.h"
+#include "Vitocal_spsc.h"
+
+#ifndef VITO_OPTO_TASK
+#if defined(ESP32)
+#define VITO_OPTO_TASK 1
+#else
+#define VITO_OPTO_TASK 0
+#endif
+#endif
+#ifndef VITO_OPTO_TASK_PRIO
+#define VITO_OPTO_TASK_PRIO  5         // loopTask runs at 1, async_tcp at 3
+#endif
+#ifndef VITO_OPTO_TASK_STACK
+#define VITO_OPTO_TASK_STACK 4096
+#endif
+#ifndef VITO_OPTO_RING
+#define VITO_OPTO_RING 64              // messages to loop(), power of two (20 B each)
+#endif
+#ifndef VITO_OPTO_RESERVE
+#define VITO_OPTO_RESERVE 4            // ring slots kept for write results
+#endif
+static_assert(VITO_OPTO_RESERVE < VITO_OPTO_RING, "VITO_OPTO_RESERVE must leave room for values");
+#ifndef VITO_OPTO_CMDS
+#define VITO_OPTO_CMDS 16              // commands to the task, power of two
+#endif
+
+enum VitoOptoMsgKind : uint8_t {
+    VITO_MSG_VALUE = 0,   // polled datapoint or its write read-back
+    VITO_MSG_DEF_VALUE,   // LittleFS definition (Vitocal_dpdefs.h)
+    VITO_MSG_ERROR,       // failed read, one per member of a failed block
+    VITO_MSG_WRITE_FAILED // failed write or read-back
+};
+
+#define VITO_MSG_RAW_MAX     4
+#define VITO_MSG_PENDING     0x80      // len flag: a newer write waits, do not publish the read
+
+struct VitoOptoMsg {
+    uint32_t ms;                       // millis() of the response
+    uint8_t  kind;                     // VitoOptoMsgKind
+    uint8_t  id;                       // VitoDpId, definition index or VITO_DP_NONE
+    uint8_t  aux;                      // VALUE: VitoWriteResult of a read-back
+    uint8_t  len;                      // VALUE: bytes in raw[], | VITO_MSG_PENDING; ERROR: OptolinkResult
+    uint8_t  raw[VITO_MSG_RAW_MAX];    // VALUE: reply bytes of the datapoint
+    float    value;                    // DEF_VALUE: the value; read-back / WRITE_FAILED: value written
+    uint32_t arg;                      // read-back: command -> confirmation ms
+};
+
+enum VitoOptoCmdKind : uint8_t {
+    VITO_CMD_WRITE = 0,   // id, value, priority, ms = command time
+    VITO_CMD_CLASS        // id = VitoPollClass, ms = interval
+};
+
+struct VitoOptoCmd {
+    uint8_t  kind;
+    uint8_t  id;
+    uint8_t  priority;
+    float    value;
+    uint32_t ms;
+};
+
+static VitoSpsc<VitoOptoMsg, VITO_OPTO_RING> vitoOptoOut;   // task -> loop()
+static VitoSpsc<VitoOptoCmd, VITO_OPTO_CMDS> vitoOptoIn;    // loop() -> task
+
+// Step timing (start to start), written by the task
+static uint32_t vitoOptoSteps        = 0;
+static uint32_t vitoOptoLastStepUs   = 0;
+static uint32_t vitoOptoStepMaxUs    = 0;   // since boot
+static uint64_t vitoOptoStepSumUs    = 0;
+
+typedef void (*VitoOptoStepFn)();
+static VitoOptoStepFn    vitoOptoStepFn = nullptr;
+static std::atomic<bool> vitoOptoRunning{false};
+static std::atomic<bool> vitoOptoStopped{false};
+
+// --- loop() side ------------------------------------------------------------------
+// Queue an HA write for the task (vitoWriteEnqueue there).
+inline void vitoOptoWrite(uint8_t id, float value, uint8_t priority, uint32_t now) {
+    VitoOptoCmd c = {VITO_CMD_WRITE, id, priority, value, now};
+    vitoOptoIn.push(c);
+}
+
+// New class interval: the scheduler is rescaled by the task.
+inline void vitoOptoClassInterval(uint8_t cls, uint32_t intervalMs) {
+    VitoOptoCmd c = {VITO_CMD_CLASS, cls, 0, 0.0f, intervalMs};
+    vitoOptoIn.push(c);
+}
+
+// Hand up to max messages to fn(msg); returns how many.
+template <typename Fn>
+inline uint16_t vitoOptoDrain(uint16_t max, Fn fn) {
+    VitoOptoMsg m;
+    uint16_t n = 0;
+    while (n < max && vitoOptoOut.pop(m)) {
+        fn(m);
+        n++;
+    }
+    return n;
+}
+
+// --- task side ----------------------------------------------------------------------
+inline void vitoOptoPost(const VitoOptoMsg& m) {
+    bool writeResult = m.kind == VITO_MSG_WRITE_FAILED || (m.kind == VITO_MSG_VALUE && m.aux != VITO_WRITE_NOT_OURS);
+    vitoOptoOut.push(m, writeResult ? VITO_OPTO_RING : VITO_OPTO_RING - VITO_OPTO_RESERVE);
+}
+
+// Apply the commands from loop() (first thing of every step).
+inline void vitoOptoTakeCommands() {
+    VitoOptoCmd c;
+    while (vitoOptoIn.pop(c)) {
+        if (c.kind == VITO_CMD_WRITE) {
+            vitoWriteEnqueue(c.id, c.value, c.priority, c.ms);
+        } else if (c.kind == VITO_CMD_CLASS && c.id < VITO_CLASS_COUNT) {
+            vitoSchedScaleClass(c.id, c.ms, vitoPollClasses[c.id].defaultIntervalMs);
+        }
+    }
+}
+
+// One step with its timing; the task body, or loop() with VITO_OPTO_TASK 0.
+inline void vitoOptoRunStep() {
+    uint32_t now = micros();
+    if (vitoOptoLastStepUs != 0) {
+        uint32_t gap = now - vitoOptoLastStepUs;
+        vitoOptoStepSumUs += gap;
+        if (gap > vitoOptoStepMaxUs) {
+            vitoOptoStepMaxUs = gap;
+        }
+    }
+    vitoOptoLastStepUs = now;
+    vitoOptoSteps++;
+    vitoOptoStepFn();
+}
+
+#if VITO_OPTO_TASK
+inline void vitoOptoTask(void*) {
+    vitoLogProducer = VITO_LOG_OPTO;
+    while (vitoOptoRunning.load(std::memory_order_acquire)) {
+        vitoOptoRunStep();
+        vTaskDelay(1);   // one tick, 1 ms on the Arduino core
+    }
+    vitoOptoStopped.store(true, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+#endif
+
+// End of setup(): from here on step runs in the Optolink task. Returns false
+// if the task could not be created (step then runs from loop(), see below).
+inline bool vitoOptoStart(VitoOptoStepFn step) {
+    vitoOptoStepFn = step;
+#if VITO_OPTO_TASK
+    vitoOptoRunning.store(true, std::memory_order_release);
+    if (xTaskCreate(vitoOptoTask, "optolink", VITO_OPTO_TASK_STACK, nullptr, VITO_OPTO_TASK_PRIO, nullptr) == pdPASS) {
+        return true;
+    }
+    vitoOptoRunning.store(false, std::memory_order_release);
+#endif
+    return false;
+}
+
+// loop(): runs the step itself when there is no task.
+inline void vitoOptoService() {
+    if (!vitoOptoRunning.load(std::memory_order_acquire) && vitoOptoStepFn != nullptr) {
+        vitoOptoRunStep();
+    }
+}
+
+// Stop the task after its current step and wait for it (host bench before it
+// reads the results, or before a restart). loop() does not take over either.
+inline void vitoOptoStop() {
+    if (vitoOptoRunning.exchange(false, std::memory_order_acq_rel)) {
+        while (!vitoOptoStopped.load(std::memory_order_acquire)) {
+            delay(1);
+        }
+    }
+    vitoOptoStepFn = nullptr;
+}
+
+// --- metrics (Vitocal_metrics.h) ---------------------------------------------------------
+#define VITO_OPTO_METRICS 5
+
+inline double vitoOptoMetricValue(uint8_t m) {
+    switch (m) {
+    case 0:  return (double)vitoOptoStepMaxUs / 1e6;
+    case 1:  return vitoOptoSteps > 1 ? (double)vitoOptoStepSumUs / (vitoOptoSteps - 1) / 1e6 : 0.0;
+    case 2:  return vitoOptoOut.highWater;
+    case 3:  return vitoOptoOut.dropped.load(std::memory_order_relaxed);
+    default: return vitoOptoIn.dropped.load(std::memory_order_relaxed);
+    }
+}
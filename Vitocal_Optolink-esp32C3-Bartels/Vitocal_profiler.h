@@ -0,0 +1,195 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Loop profiler and stall detector
+//
+// loop() wraps each subsystem (dispatch of the Optolink values, mqtt.loop(),
+// ElegantOTA, WebSerial, log drain, history spill, live stream, WiFi check,
+// periodic publishing) in a VITO_PROF_SCOPE(). The Optolink side itself runs
+// in its own task (Vitocal_optotask.h); only without one is it a section. Every section keeps a log2
+// histogram of its run times, its worst run and when that happened. Time
+// spent outside any probe is booked to "other".
+//
+// vitoProfIteration() closes a loop() iteration: if it took longer than
+// VITO_STALL_US, the section that ran the longest in it is recorded as the
+// cause (count per section, plus the last stall in detail).
+//
+// With VITO_PROFILE 0 the probes and the iteration hook compile to nothing.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Vitocal_json.h"
+#include "Vitocal_metrics.h"   // vitoHistBucket()
+
+#ifndef VITO_PROFILE
+#define VITO_PROFILE 1
+#endif
+#ifndef VITO_STALL_US
+#define VITO_STALL_US 50000UL          // loop() iteration counted as a stall above this
+#endif
+#ifndef VITO_PROF_BASE_US
+#define VITO_PROF_BASE_US 8UL          // first histogram bucket: <= 8 us ... 16 ms, +Inf
+#endif
+
+enum VitoProfSection : uint8_t {
+    VITO_PROF_OPTO = 0,   // Optolink step in loop() (VITO_OPTO_TASK 0 only)
+    VITO_PROF_DISPATCH,   // Optolink messages -> value store, HA, history, live stream
+    VITO_PROF_MQTT,
+    VITO_PROF_OTA,
+    VITO_PROF_WEBSERIAL,
+    VITO_PROF_LOG,        // log drain
+    VITO_PROF_HISTORY,    // history spill to LittleFS
+    VITO_PROF_SSE,        // live stream frames
+    VITO_PROF_WIFI,       // vitoWifiService()
+    VITO_PROF_PERIODIC,   // EVERY_N_SECONDS blocks
+    VITO_PROF_OTHER,      // iteration time outside the probes
+    VITO_PROF_COUNT
+};
+
+static const char* const vitoProfNames[VITO_PROF_COUNT] = {
+    "optolink", "dispatch", "mqtt", "ota", "webserial", "log", "history", "sse", "wifi", "periodic", "other"
+};
+
+struct VitoProfStats {
+    uint32_t buckets[VITO_HIST_BUCKETS];   // non-cumulative, last one is +Inf
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+    uint32_t maxAtMs;                      // millis() of the worst run
+    uint32_t stalls;                       // stalled iterations this section dominated
+};
+
+struct VitoStall {
+    uint8_t  section;
+    uint32_t sectionUs;   // time of that section in the iteration
+    uint32_t loopUs;      // whole iteration
+    uint32_t atMs;
+};
+
+static VitoProfStats vitoProf[VITO_PROF_COUNT];
+static uint32_t      vitoProfIterUs[VITO_PROF_COUNT];   // current iteration
+static uint32_t      vitoProfIterStartUs = 0;
+static uint32_t      vitoProfWindowMaxUs = 0;           // longest iteration since the last HA publish
+static uint32_t      vitoStallCount      = 0;
+static VitoStall     vitoLastStall       = {VITO_PROF_OTHER, 0, 0, 0};
+
+inline void vitoProfAdd(uint8_t section, uint32_t us) {
+    VitoProfStats& p = vitoProf[section];
+    p.buckets[vitoHistBucket(us, VITO_PROF_BASE_US)]++;
+    p.count++;
+    p.sumUs += us;
+    if (us > p.maxUs) {
+        p.maxUs   = us;
+        p.maxAtMs = millis();
+    }
+}
+
+// Times one section from construction to the end of the scope.
+class VitoProfScope {
+public:
+    explicit VitoProfScope(uint8_t section) : mSection(section), mStartUs(micros()) {}
+    ~VitoProfScope() {
+        uint32_t us = micros() - mStartUs;
+        vitoProfIterUs[mSection] += us;
+        vitoProfAdd(mSection, us);
+    }
+
+private:
+    uint8_t  mSection;
+    uint32_t mStartUs;
+};
+
+// First thing in loop(): closes the previous iteration and checks for a stall.
+inline void vitoProfIteration() {
+    uint32_t now = micros();
+    if (vitoProfIterStartUs != 0) {
+        uint32_t loopUs = now - vitoProfIterStartUs;
+        uint32_t probed = 0;
+        uint8_t  worst  = VITO_PROF_OTHER;
+        for (uint8_t s = 0; s < VITO_PROF_OTHER; ++s) {
+            probed += vitoProfIterUs[s];
+            if (vitoProfIterUs[s] > vitoProfIterUs[worst]) {
+                worst = s;
+            }
+        }
+        uint32_t other = loopUs > probed ? loopUs - probed : 0;
+        vitoProfIterUs[VITO_PROF_OTHER] = other;
+        vitoProfAdd(VITO_PROF_OTHER, other);
+        if (other > vitoProfIterUs[worst]) {
+            worst = VITO_PROF_OTHER;
+        }
+        if (loopUs > vitoProfWindowMaxUs) {
+            vitoProfWindowMaxUs = loopUs;
+        }
+        if (loopUs > VITO_STALL_US) {
+            vitoStallCount++;
+            vitoProf[worst].stalls++;
+            vitoLastStall = {worst, vitoProfIterUs[worst], loopUs, millis()};
+        }
+    }
+    for (uint8_t s = 0; s < VITO_PROF_COUNT; ++s) {
+        vitoProfIterUs[s] = 0;
+    }
+    vitoProfIterStartUs = micros();
+}
+
+// Longest iteration since the last call (for the HA sensor).
+inline uint32_t vitoProfTakeWindowMax() {
+    uint32_t us = vitoProfWindowMaxUs;
+    vitoProfWindowMaxUs = 0;
+    return us;
+}
+
+// "mqtt 312.4 ms @ 123456 s" or "-" (for the HA sensor)
+inline const char* vitoLastStallText() {
+    static char buf[48];
+    if (vitoStallCount == 0) {
+        return "-";
+    }
+    snprintf(buf, sizeof(buf), "%s %.1f ms @ %lu s", vitoProfNames[vitoLastStall.section],
+             (double)vitoLastStall.sectionUs / 1000.0, (unsigned long)(vitoLastStall.atMs / 1000UL));
+    return buf;
+}
+
+// Longest vitoProfileJson(): the stall part, then per section its fields and
+// histogram (section names are short literals, counts at most 10 digits).
+static const size_t VITO_PROF_JSON_MAX = 192 + VITO_PROF_COUNT * (176 + VITO_HIST_BUCKETS * 11);
+
+// Per-section statistics as JSON (GET /profile); nullptr if it does not fit.
+inline const char* vitoProfileJson() {
+    static char buf[VITO_PROF_JSON_MAX];
+    size_t n = 0;
+    bool ok = vitoAppendf(buf, sizeof(buf), n,
+                          "{\"enabled\":%s,\"stallUs\":%lu,\"stalls\":%lu,\"lastStall\":{\"section\":\"%s\","
+                          "\"us\":%lu,\"loopUs\":%lu,\"atMs\":%lu},\"sections\":[",
+                          VITO_PROFILE ? "true" : "false", (unsigned long)VITO_STALL_US,
+                          (unsigned long)vitoStallCount, vitoProfNames[vitoLastStall.section],
+                          (unsigned long)vitoLastStall.sectionUs, (unsigned long)vitoLastStall.loopUs,
+                          (unsigned long)vitoLastStall.atMs);
+    for (uint8_t s = 0; s < VITO_PROF_COUNT && ok; ++s) {
+        const VitoProfStats& p = vitoProf[s];
+        ok = vitoAppendf(buf, sizeof(buf), n,
+                         "%s{\"name\":\"%s\",\"count\":%lu,\"meanUs\":%.1f,\"maxUs\":%lu,\"maxAtMs\":%lu,"
+                         "\"stalls\":%lu,\"hist\":[",
+                         s ? "," : "", vitoProfNames[s], (unsigned long)p.count,
+                         p.count ? (double)p.sumUs / (double)p.count : 0.0, (unsigned long)p.maxUs,
+                         (unsigned long)p.maxAtMs, (unsigned long)p.stalls);
+        for (uint8_t b = 0; b < VITO_HIST_BUCKETS && ok; ++b) {
+            ok = vitoAppendf(buf, sizeof(buf), n, "%s%lu", b ? "," : "", (unsigned long)p.buckets[b]);
+        }
+        ok = ok && vitoAppendf(buf, sizeof(buf), n, "]}");
+    }
+    return ok && vitoAppendf(buf, sizeof(buf), n, "]}") ? buf : nullptr;
+}
+
+#if VITO_PROFILE
+#define VITO_PROF_CONCAT2(a, b) a##b
+#define VITO_PROF_CONCAT(a, b)  VITO_PROF_CONCAT2(a, b)
+#define VITO_PROF_SCOPE(section) VitoProfScope VITO_PROF_CONCAT(vitoProfScope_, __LINE__)(section)
+#define VITO_PROF_ITERATION()    vitoProfIteration()
+#else
+#define VITO_PROF_SCOPE(section)
+#define VITO_PROF_ITERATION()
+#endif
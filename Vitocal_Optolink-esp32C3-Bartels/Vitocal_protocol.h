@@ -0,0 +1,244 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Optolink protocol backend: VS1 (KW) or VS2 (P300)
+//
+// VS1 waits for the controller's 0x05 sync before every request and has no
+// checksum. VS2 opens a session once (0x04, 0x05, 16 00 00 -> 0x06) and then
+// exchanges acknowledged, checksummed telegrams without any sync wait.
+//
+// VITO_PROTOCOL selects the backend at build time; with VITO_PROTOCOL_AUTO
+// (default) the P300 init is tried once at boot and VS1 is the fallback if
+// the controller does not acknowledge it. The handshake runs step by step in
+// the Optolink task (VitoOptolink::loop()), so setup() does not wait for it;
+// polling starts once it is done. VitoOptolink exposes the VitoWiFi calls the
+// sketch uses and forwards them to the active backend, so the poller,
+// callbacks and error counters do not care which one runs.
+// It also reports begin/end and every accepted request to a running capture
+// (Vitocal_capture.h).
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <atomic>
+#include <VitoWiFi.h>
+#include "Vitocal_capture.h"
+
+#define VITO_PROTOCOL_AUTO 0
+#define VITO_PROTOCOL_VS1  1
+#define VITO_PROTOCOL_VS2  2
+
+#ifndef VITO_PROTOCOL
+#define VITO_PROTOCOL VITO_PROTOCOL_AUTO
+#endif
+#ifndef VITO_DETECT_SYNC_MS
+#define VITO_DETECT_SYNC_MS 3000UL   // max wait for 0x05 after the reset (sync period ~2 s)
+#endif
+#ifndef VITO_DETECT_ACK_MS
+#define VITO_DETECT_ACK_MS  300UL    // max wait for 0x06 after 16 00 00
+#endif
+#ifndef VITO_DETECT_ATTEMPTS
+#define VITO_DETECT_ATTEMPTS 2
+#endif
+
+enum class VitoProtocol : uint8_t {
+    VS1,
+    VS2
+};
+
+inline const char* vitoProtocolName(VitoProtocol p) {
+    return p == VitoProtocol::VS2 ? "VS2 (P300)" : "VS1 (KW)";
+}
+
+// P300 handshake on the raw UART, run step by step from the Optolink task:
+// 0x04, wait for the 0x05 sync, 16 00 00, wait for 0x06. A sync without the
+// ACK is a KW-only controller, no sync at all after VITO_DETECT_ATTEMPTS
+// tries is a dead link (VS1 as well). Leaves the port closed; the selected
+// backend reopens it in begin().
+class VitoProtocolDetect {
+public:
+    void start(HardwareSerial* serial, uint32_t now) {
+        _serial  = serial;
+        _attempt = 0;
+        _startMs = now;
+        _serial->begin(4800, SERIAL_8E2);
+        sendReset(now);
+    }
+
+    // true once the result is known
+    bool step(uint32_t now) {
+        if (_state == State::DONE) {
+            return true;
+        }
+        while (_serial->available()) {
+            int c = _serial->read();
+            if (_state == State::SYNC && c == 0x05) {
+                const uint8_t start[] = {0x16, 0x00, 0x00};
+                _serial->write(start, sizeof(start));
+                _state   = State::ACK;
+                _stateMs = now;
+            } else if (_state == State::ACK && c == 0x06) {
+                finish(VitoProtocol::VS2, now);
+                return true;
+            }
+        }
+        if (_state == State::ACK && now - _stateMs >= VITO_DETECT_ACK_MS) {
+            finish(VitoProtocol::VS1, now);   // synced, no ACK: KW-only controller
+        } else if (_state == State::SYNC && now - _stateMs >= VITO_DETECT_SYNC_MS) {
+            if (++_attempt < VITO_DETECT_ATTEMPTS) {
+                sendReset(now);               // no sync at all: link down, try again
+            } else {
+                finish(VitoProtocol::VS1, now);
+            }
+        }
+        return _state == State::DONE;
+    }
+
+    VitoProtocol result() const { return _result; }
+    uint32_t     tookMs() const { return _tookMs; }
+
+private:
+    enum class State : uint8_t { SYNC, ACK, DONE };
+
+    void sendReset(uint32_t now) {
+        while (_serial->available()) {
+            _serial->read();
+        }
+        const uint8_t reset = 0x04;
+        _serial->write(&reset, 1);
+        _state   = State::SYNC;
+        _stateMs = now;
+    }
+
+    void finish(VitoProtocol result, uint32_t now) {
+        // leave the controller in KW mode; VS2::begin() runs its own init
+        const uint8_t reset = 0x04;
+        _serial->write(&reset, 1);
+        _serial->end();
+        _result = result;
+        _tookMs = now - _startMs;
+        _state  = State::DONE;
+    }
+
+    HardwareSerial* _serial  = nullptr;
+    State           _state   = State::DONE;
+    VitoProtocol    _result  = VitoProtocol::VS1;
+    uint8_t         _attempt = 0;
+    uint32_t        _startMs = 0;
+    uint32_t        _stateMs = 0;
+    uint32_t        _tookMs  = 0;
+};
+
+class VitoOptolink {
+public:
+    typedef void (*ResponseCallback)(const uint8_t* data, uint8_t length, const VitoWiFi::Datapoint& request);
+    typedef void (*ErrorCallback)(VitoWiFi::OptolinkResult error, const VitoWiFi::Datapoint& request);
+
+    explicit VitoOptolink(HardwareSerial* serial)
+        : _serial(serial), _vs1(serial), _vs2(serial) {}
+
+    // Pick the backend; call before begin(). AUTO starts the handshake, which
+    // loop() runs to the end before the backend begins; until then ready() is
+    // false and requests are refused.
+    void select(int mode) {
+        if (mode == VITO_PROTOCOL_VS2) {
+            _protocol = VitoProtocol::VS2;
+        } else if (mode == VITO_PROTOCOL_VS1) {
+            _protocol = VitoProtocol::VS1;
+        } else {
+            _beginPending = false;
+            _detect.start(_serial, millis());
+            _detecting = true;
+        }
+    }
+
+    bool ready() const { return !_detecting; }
+    // valid once ready()
+    VitoProtocol protocol() const { return _protocol; }
+    const char*  protocolName() const { return _detecting ? "detecting" : vitoProtocolName(_protocol); }
+    uint32_t     detectMs() const { return _detect.tookMs(); }
+
+    void onResponse(ResponseCallback cb) { _vs1.onResponse(cb); _vs2.onResponse(cb); }
+    void onError(ErrorCallback cb) { _vs1.onError(cb); _vs2.onError(cb); }
+
+    bool begin() {
+        if (_detecting) {
+            _beginPending = true;   // once the protocol is known
+            return true;
+        }
+        vitoCapBegin(static_cast<uint8_t>(_protocol));
+        return _protocol == VitoProtocol::VS2 ? _vs2.begin() : _vs1.begin();
+    }
+    void end() {
+        if (_detecting) {
+            _beginPending = false;
+            return;
+        }
+        vitoCapEnd();
+        if (_protocol == VitoProtocol::VS2) _vs2.end(); else _vs1.end();
+    }
+    void loop() {
+        if (_detecting) {
+            if (_detect.step(millis())) {
+                _protocol = _detect.result();
+                _detecting = false;
+                if (_beginPending) {
+                    _beginPending = false;
+                    begin();
+                }
+            }
+            return;
+        }
+        if (_protocol == VitoProtocol::VS2) _vs2.loop(); else _vs1.loop();
+    }
+
+    bool read(const VitoWiFi::Datapoint& dp) {
+        if (_detecting) {
+            return false;
+        }
+        vitoCapCall();
+        bool ok = _protocol == VitoProtocol::VS2 ? _vs2.read(dp) : _vs1.read(dp);
+        if (ok) {
+            vitoCapRequest(dp.address(), dp.length(), nullptr, 0);
+        }
+        return ok;
+    }
+
+    template <typename T>
+    bool write(const VitoWiFi::Datapoint& dp, T value) {
+        if (_detecting) {
+            return false;
+        }
+        vitoCapCall();
+        bool ok = _protocol == VitoProtocol::VS2 ? _vs2.write(dp, value) : _vs1.write(dp, value);
+        if (ok && vitoCapRunning) {
+            // the bytes VitoWiFi encoded, for the replay to send the same
+            uint8_t buf[VITO_CAP_MAX_N];
+            uint8_t len = dp.length() <= sizeof(buf) ? dp.length() : sizeof(buf);
+            dp.encode(buf, len, VitoWiFi::VariantValue(value));
+            vitoCapRequest(dp.address(), dp.length(), buf, len);
+        }
+        return ok;
+    }
+
+    // Encoded value (trace replay).
+    bool write(const VitoWiFi::Datapoint& dp, const uint8_t* data, uint8_t length) {
+        if (_detecting) {
+            return false;
+        }
+        vitoCapCall();
+        bool ok = _protocol == VitoProtocol::VS2 ? _vs2.write(dp, data, length) : _vs1.write(dp, data, length);
+        if (ok) {
+            vitoCapRequest(dp.address(), dp.length(), data, length);
+        }
+        return ok;
+    }
+
+private:
+    HardwareSerial*                   _serial;
+    VitoProtocol                      _protocol = VitoProtocol::VS1;
+    VitoProtocolDetect                _detect;
+    std::atomic<bool>                 _detecting{false};   // written by the Optolink task, read by loop()
+    bool                              _beginPending = false;
+    VitoWiFi::VitoWiFi<VitoWiFi::VS1> _vs1;
+    VitoWiFi::VitoWiFi<VitoWiFi::VS2> _vs2;
+};
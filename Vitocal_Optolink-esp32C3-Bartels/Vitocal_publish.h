@@ -0,0 +1,139 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Report-by-exception publish policy
+//
+// Every decoded value passes through the policy of its datapoint before it
+// reaches the HA entity: an optional filter (EMA or median of the last three
+// reads) smooths sensor noise, then the value is published only if it moved
+// by the deadband (absolute, or relative to the last published value) and
+// the minimum publish interval has passed. An unchanged value is republished
+// after the heartbeat time so HA and the broker see the device is alive.
+//
+// The policies live in one table next to the entities (HA_mqtt_addin.h);
+// suppressed publishes are counted per datapoint and in total.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "Vitocal_datapoints.h"
+
+#ifndef VITO_PUBLISH_EMA_ALPHA
+#define VITO_PUBLISH_EMA_ALPHA 0.3f   // weight of the newest read for VITO_FILTER_EMA
+#endif
+
+// VitoPublishPolicy::filter
+#define VITO_FILTER_NONE   0
+#define VITO_FILTER_EMA    1
+#define VITO_FILTER_MEDIAN 2   // median of the last 3 reads
+
+struct VitoPublishPolicy {
+    float    absDeadband;    // min change to publish, 0 = any change
+    float    relDeadband;    // ... or this fraction of the published value, 0 = off
+    uint8_t  filter;
+    uint16_t minIntervalS;   // min time between two publishes, 0 = off
+    uint16_t heartbeatMin;   // republish an unchanged value after N minutes, 0 = never
+};
+
+// Indexed by VitoDpId, defined in HA_mqtt_addin.h
+extern const VitoPublishPolicy vitoPublishPolicy[DP_COUNT];
+
+enum VitoPublishDecision : uint8_t {
+    VITO_PUBLISH_SKIP = 0,
+    VITO_PUBLISH_CHANGE,
+    VITO_PUBLISH_HEARTBEAT
+};
+
+struct VitoPublishState {
+    float    published;      // last value sent to the entity
+    float    ema;
+    float    window[3];      // last reads for the median, oldest first
+    uint8_t  samples;        // reads seen by the filter (saturates at 3)
+    bool     hasPublished;
+    uint32_t lastPublishMs;
+    uint32_t suppressed;     // publishes the policy held back
+};
+
+static VitoPublishState vitoPublishState[DP_COUNT];
+static uint32_t         vitoPublishCount    = 0;
+static uint32_t         vitoSuppressedCount = 0;
+
+inline float vitoMedian3(float a, float b, float c) {
+    if (a > b) { float t = a; a = b; b = t; }
+    if (b > c) { b = c; }
+    return a > b ? a : b;
+}
+
+// Apply the filter of datapoint id to value (in place).
+inline void vitoPublishFilterValue(uint8_t id, float& value) {
+    const VitoPublishPolicy& p = vitoPublishPolicy[id];
+    VitoPublishState& st = vitoPublishState[id];
+
+    switch (p.filter) {
+    case VITO_FILTER_EMA:
+        st.ema = st.samples ? st.ema + VITO_PUBLISH_EMA_ALPHA * (value - st.ema) : value;
+        if (st.samples < 3) st.samples++;
+        value = st.ema;
+        break;
+    case VITO_FILTER_MEDIAN:
+        st.window[0] = st.window[1];
+        st.window[1] = st.window[2];
+        st.window[2] = value;
+        if (st.samples < 3) st.samples++;
+        if (st.samples == 3) {
+            value = vitoMedian3(st.window[0], st.window[1], st.window[2]);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Decide whether the (filtered) value of datapoint id goes out now.
+inline uint8_t vitoPublishDecide(uint8_t id, float value, uint32_t now) {
+    const VitoPublishPolicy& p = vitoPublishPolicy[id];
+    VitoPublishState& st = vitoPublishState[id];
+
+    if (!st.hasPublished) {
+        return VITO_PUBLISH_CHANGE;
+    }
+    uint32_t since = now - st.lastPublishMs;
+    float moved = value > st.published ? value - st.published : st.published - value;
+    float base  = st.published < 0.0f ? -st.published : st.published;
+    float band  = p.absDeadband;
+    if (p.relDeadband > 0.0f && p.relDeadband * base > band) {
+        band = p.relDeadband * base;
+    }
+    bool changed = band > 0.0f ? moved >= band : moved != 0.0f;
+
+    if (changed && (uint64_t)since >= (uint64_t)p.minIntervalS * 1000ULL) {
+        return VITO_PUBLISH_CHANGE;
+    }
+    if (p.heartbeatMin != 0 && (uint64_t)since >= (uint64_t)p.heartbeatMin * 60000ULL) {
+        return VITO_PUBLISH_HEARTBEAT;
+    }
+    if (moved != 0.0f) {
+        // without the policy this would have been a publish
+        st.suppressed++;
+        vitoSuppressedCount++;
+    }
+    return VITO_PUBLISH_SKIP;
+}
+
+// A read with the bytes of the last one (Vitocal_values.h) still matters to a
+// filter, which has not caught up with the value yet, and to a due heartbeat.
+inline bool vitoPublishWantsRepeat(uint8_t id, uint32_t now) {
+    const VitoPublishPolicy& p = vitoPublishPolicy[id];
+    const VitoPublishState& st = vitoPublishState[id];
+    if (p.filter != VITO_FILTER_NONE || !st.hasPublished) {
+        return true;
+    }
+    return p.heartbeatMin != 0 && (uint64_t)(now - st.lastPublishMs) >= (uint64_t)p.heartbeatMin * 60000ULL;
+}
+
+inline void vitoPublishMark(uint8_t id, float value, uint32_t now) {
+    VitoPublishState& st = vitoPublishState[id];
+    st.published     = value;
+    st.hasPublished  = true;
+    st.lastPublishMs = now;
+    vitoPublishCount++;
+}
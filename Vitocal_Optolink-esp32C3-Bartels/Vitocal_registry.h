@@ -0,0 +1,169 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Datapoint dispatch registry
+//
+// Every polled datapoint has a small integer ID. The ID is carried by the
+// VitoWiFi::Datapoint itself: its name is stored in a fixed-stride name
+// table, so the name pointer (which VitoWiFi copies along with the request)
+// encodes the table row. vitoDpIndexOf() recovers it with one subtraction
+// instead of strcmp() scans, and the row in a constexpr VitoDpEntry table
+// tells the response handler what to do with the decoded value.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoHA.h>
+#include <VitoWiFi.h>
+
+static const uint8_t VITO_DP_NONE = 0xFF;
+
+// Row of a fixed-stride name table -> index, VITO_DP_NONE if the name is not
+// one of its rows (e.g. the set* datapoints used for writes).
+inline uint8_t vitoDpIndexOf(const char* name, const void* table, size_t count, size_t stride) {
+    uintptr_t off = reinterpret_cast<uintptr_t>(name) - reinterpret_cast<uintptr_t>(table);
+    if (off >= count * stride || (off % stride) != 0) {
+        return VITO_DP_NONE;
+    }
+    return (uint8_t)(off / stride);
+}
+
+// How a decoded value reaches Home Assistant
+enum class VitoDpKind : uint8_t {
+    Temperature,  // float  -> HASensorNumber::setValue()
+    Setpoint,     // float  -> HANumber::setState()
+    Binary,       // uint8  -> HABinarySensor::setState()
+    Label,        // uint8  -> HASensor::setValue(labels[v])
+    Raw           // uint8  -> no entity, hook only
+};
+
+// Decoded value handed to the per-datapoint hook
+struct VitoDpValue {
+    float       f;
+    uint8_t     u8;
+    const char* label;
+};
+
+struct VitoDpEntry {
+    const char*        tag;         // log tag
+    VitoDpKind         kind;
+    HABaseDeviceType*  entity;      // type depends on kind, nullptr for Raw
+    const char* const* labels;      // Label only
+    uint8_t            labelCount;
+    void             (*hook)(const VitoDpValue& v);  // optional extra side effects
+};
+
+// Discovery attributes of a datapoint's entity (nullptr = not set)
+struct VitoDpHaMeta {
+    const char* objectId;
+    const char* name;
+    const char* icon;
+    const char* unit;
+    float       min;                // Setpoint only
+    float       max;
+    float       step;
+};
+
+inline const char* vitoLabelOrFallback(uint8_t index, const char* const* table, size_t tableSize) {
+    if (tableSize == 0) {
+        return "n/a";
+    }
+    if (index < tableSize) {
+        return table[index];
+    }
+    return "Unknown";
+}
+
+// Decode per kind (v.f is set for every kind, the label for Label)
+inline VitoDpValue vitoDecodeEntry(const VitoDpEntry& e, const VitoWiFi::VariantValue& value) {
+    VitoDpValue v = {0.0f, 0, nullptr};
+    switch (e.kind) {
+    case VitoDpKind::Temperature:
+    case VitoDpKind::Setpoint:
+        v.f = value;
+        break;
+    case VitoDpKind::Label:
+        v.u8    = value;
+        v.f     = v.u8;
+        v.label = vitoLabelOrFallback(v.u8, e.labels, e.labelCount);
+        break;
+    default:
+        v.u8 = value;
+        v.f  = v.u8;
+        break;
+    }
+    return v;
+}
+
+// Push a decoded value to the entity; force republishes an unchanged value.
+inline void vitoPublishEntry(const VitoDpEntry& e, const VitoDpValue& v, bool force = false) {
+    switch (e.kind) {
+    case VitoDpKind::Temperature:
+        static_cast<HASensorNumber*>(e.entity)->setValue(v.f, force);
+        break;
+    case VitoDpKind::Setpoint:
+        static_cast<HANumber*>(e.entity)->setState(v.f, force);
+        break;
+    case VitoDpKind::Binary:
+        static_cast<HABinarySensor*>(e.entity)->setState(v.u8, force);
+        break;
+    case VitoDpKind::Label:
+        static_cast<HASensor*>(e.entity)->setValue(v.label);
+        break;
+    case VitoDpKind::Raw:
+        break;
+    }
+}
+
+// setupHomeAssistant(): discovery attributes per kind; a Setpoint Number
+// becomes a box that writes through onCommand.
+inline void vitoSetupEntity(const VitoDpEntry& e, const VitoDpHaMeta& m,
+                            void (*onCommand)(HANumeric number, HANumber* sender)) {
+    switch (e.kind) {
+    case VitoDpKind::Temperature: {
+        HASensorNumber* s = static_cast<HASensorNumber*>(e.entity);
+        s->setObjectId(m.objectId);
+        s->setName(m.name);
+        s->setIcon(m.icon);
+        s->setUnitOfMeasurement(m.unit);
+        break;
+    }
+    case VitoDpKind::Setpoint: {
+        HANumber* n = static_cast<HANumber*>(e.entity);
+        n->setObjectId(m.objectId);
+        n->setName(m.name);
+        n->setIcon(m.icon);
+        n->setUnitOfMeasurement(m.unit);
+        n->setMin(m.min);
+        n->setMax(m.max);
+        n->setStep(m.step);
+        n->setMode(HANumber::ModeBox);
+        n->onCommand(onCommand);
+        break;
+    }
+    case VitoDpKind::Binary: {
+        HABinarySensor* b = static_cast<HABinarySensor*>(e.entity);
+        b->setObjectId(m.objectId);
+        b->setName(m.name);
+        b->setIcon(m.icon);
+        break;
+    }
+    case VitoDpKind::Label: {
+        HASensor* s = static_cast<HASensor*>(e.entity);
+        s->setObjectId(m.objectId);
+        s->setName(m.name);
+        s->setIcon(m.icon);
+        break;
+    }
+    case VitoDpKind::Raw:
+        break;
+    }
+}
+
+// Decode per kind and update the entity; returns the value for logging and
+// the hook (the caller runs e.hook after logging).
+inline VitoDpValue vitoApplyEntry(const VitoDpEntry& e, const VitoWiFi::VariantValue& value) {
+    VitoDpValue v = vitoDecodeEntry(e, value);
+    vitoPublishEntry(e, v);
+    return v;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Per-datapoint poll scheduler (earliest deadline first)
+//
+// Every polled datapoint has a target period and a maximum allowed age. A
+// block read (Vitocal_blockread.h) is due as soon as one of its members is
+// older than its period; among the due blocks the one whose member runs out
+// of age budget first is read next. A block that was due but passed over
+// VITO_SCHED_MAX_SKIPS times in a row goes first (fairness guard), so a long
+// period cannot be starved by a string of short ones under overload.
+//
+// Achieved ages are recorded per datapoint (current, worst, late updates).
+// scaleQ8 stretches or shrinks period and age budget together (256 = as
+// configured); Vitocal_adaptive.h drives it from the observed change rate.
+// Blocks with a quarantined member (Vitocal_breaker.h) are not picked.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_blockread.h"
+#include "Vitocal_breaker.h"
+#include "Vitocal_polling.h"
+
+#ifndef VITO_SCHED_MAX_SKIPS
+#define VITO_SCHED_MAX_SKIPS 8        // due picks lost before a block jumps the queue
+#endif
+#ifndef VITO_SCHED_RETRY_MS
+#define VITO_SCHED_RETRY_MS  2000UL   // min time between two attempts on the same block
+#endif
+
+// Runtime state; class, period and age budget at the class default interval
+// are in vitoDpSpecs[] (flash).
+struct VitoDpSchedule {
+    uint32_t periodMs;       // current target period
+    uint32_t maxAgeMs;       // current age budget
+    uint32_t lastOkMs;       // last successful update, 0 = never
+    uint32_t worstAgeMs;     // largest age seen at an update
+    uint32_t lateCount;      // updates that arrived after the effective max age
+    uint16_t scaleQ8;        // effective = current * scaleQ8 / 256
+};
+
+// Indexed by VitoDpId
+static VitoDpSchedule vitoSchedule[DP_COUNT];
+
+struct VitoBlockSchedule {
+    uint32_t lastAttemptMs;
+    uint8_t  skips;          // consecutive picks lost while due
+};
+
+static VitoBlockSchedule vitoBlockSchedule[VITO_MAX_BLOCKS];
+
+inline void vitoSchedInit() {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        vitoSchedule[i].periodMs = vitoDpSpecs[i].periodMs;
+        vitoSchedule[i].maxAgeMs = vitoDpSpecs[i].maxAgeMs;
+        vitoSchedule[i].scaleQ8  = 256;
+    }
+}
+
+inline uint32_t vitoSchedPeriod(const VitoDpSchedule& s) {
+    return (uint32_t)(((uint64_t)s.periodMs * s.scaleQ8) >> 8);
+}
+
+inline uint32_t vitoSchedMaxAge(const VitoDpSchedule& s) {
+    return (uint32_t)(((uint64_t)s.maxAgeMs * s.scaleQ8) >> 8);
+}
+
+// Rescale the members of a class to a new class interval.
+inline void vitoSchedScaleClass(uint8_t cls, uint32_t intervalMs, uint32_t defaultIntervalMs) {
+    if (defaultIntervalMs == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        const VitoDpSpec& spec = vitoDpSpecs[i];
+        if (spec.cls == cls) {
+            vitoSchedule[i].periodMs = (uint32_t)((uint64_t)spec.periodMs * intervalMs / defaultIntervalMs);
+            vitoSchedule[i].maxAgeMs = (uint32_t)((uint64_t)spec.maxAgeMs * intervalMs / defaultIntervalMs);
+        }
+    }
+}
+
+// Earliest "due" (period) and "deadline" (max age) over the block members.
+inline void vitoSchedBlockTimes(uint8_t b, uint32_t now, int32_t& due, int32_t& deadline) {
+    const VitoBlock& blk = vitoBlocks[b];
+    due = INT32_MAX;
+    deadline = INT32_MAX;
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        const VitoDpSchedule& s = vitoSchedule[vitoBlockMembers[blk.first + i]];
+        // relative to now: <= 0 means due / over budget; never read -> due now
+        int32_t age = s.lastOkMs ? (int32_t)(now - s.lastOkMs) : INT32_MAX / 2;
+        int32_t d   = (int32_t)vitoSchedPeriod(s) - age;
+        int32_t dl  = (int32_t)vitoSchedMaxAge(s) - age;
+        if (d < due) due = d;
+        if (dl < deadline) deadline = dl;
+    }
+}
+
+// Next block to read, VITO_DP_NONE if nothing is due.
+inline uint8_t vitoSchedPick(uint32_t now) {
+    uint8_t best = VITO_DP_NONE;
+    int32_t bestDeadline = INT32_MAX;
+    uint8_t starved = VITO_DP_NONE;
+
+    for (uint8_t b = 0; b < vitoBlockCount; ++b) {
+        VitoBlockSchedule& bs = vitoBlockSchedule[b];
+        if ((bs.lastAttemptMs != 0 && now - bs.lastAttemptMs < VITO_SCHED_RETRY_MS) ||
+            vitoBlockQuarantined(b, now)) {
+            continue;
+        }
+        int32_t due, deadline;
+        vitoSchedBlockTimes(b, now, due, deadline);
+        if (due > 0) {
+            continue;
+        }
+        if (bs.skips >= VITO_SCHED_MAX_SKIPS &&
+            (starved == VITO_DP_NONE || bs.skips > vitoBlockSchedule[starved].skips)) {
+            starved = b;
+        }
+        if (best == VITO_DP_NONE || deadline < bestDeadline) {
+            best = b;
+            bestDeadline = deadline;
+        }
+    }
+    return starved != VITO_DP_NONE ? starved : best;
+}
+
+// Block b was queued: every other due block lost this pick.
+inline void vitoSchedOnRequest(uint8_t b, uint32_t now) {
+    for (uint8_t o = 0; o < vitoBlockCount; ++o) {
+        if (o == b) {
+            continue;
+        }
+        int32_t due, deadline;
+        vitoSchedBlockTimes(o, now, due, deadline);
+        if (due <= 0 && vitoBlockSchedule[o].skips < 0xFF) {
+            vitoBlockSchedule[o].skips++;
+        }
+    }
+    vitoBlockSchedule[b].skips = 0;
+    vitoBlockSchedule[b].lastAttemptMs = now ? now : 1;
+}
+
+// Record a successful update of datapoint id.
+inline void vitoSchedOnUpdate(uint8_t id, uint32_t now) {
+    VitoDpSchedule& s = vitoSchedule[id];
+    if (s.lastOkMs != 0) {
+        uint32_t age = now - s.lastOkMs;
+        if (age > s.worstAgeMs) s.worstAgeMs = age;
+        if (age > vitoSchedMaxAge(s)) s.lateCount++;
+    }
+    s.lastOkMs = now ? now : 1;
+}
+
+// Current age of datapoint id, UINT32_MAX if never read.
+inline uint32_t vitoSchedAge(uint8_t id, uint32_t now) {
+    const VitoDpSchedule& s = vitoSchedule[id];
+    return s.lastOkMs ? now - s.lastOkMs : UINT32_MAX;
+}
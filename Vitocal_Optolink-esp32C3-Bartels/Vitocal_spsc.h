@@ -0,0 +1,74 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Lock-free single-producer/single-consumer ring
+//
+// The building block between the Optolink task and loop() (Vitocal_optotask.h)
+// and of the deferred log (Vitocal_log.h): one side only pushes, the other
+// only pops, so head and tail each have a single writer and two atomics are
+// all the synchronisation there is. Neither side ever waits for the other; a
+// full ring refuses the new element and counts it.
+//
+// N is a power of two; head and tail run freely and wrap with uint32_t.
+// ---------------------------------------------------------------------------
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, uint32_t N>
+struct VitoSpsc {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "VitoSpsc size must be a power of two");
+
+    T                     slots[N];
+    std::atomic<uint32_t> head{0};      // written by the producer only
+    std::atomic<uint32_t> tail{0};      // written by the consumer only
+    std::atomic<uint32_t> dropped{0};   // pushes refused because the ring was full
+    uint32_t              highWater = 0;   // producer side
+
+    // Producer: append v; false (and counted) if the ring is full. A limit
+    // below N keeps the slots above it for pushes with a higher one.
+    bool push(const T& v, uint32_t limit = N) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t used = h - tail.load(std::memory_order_acquire);
+        if (used >= limit || used >= N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        if (used + 1 > highWater) {
+            highWater = used + 1;
+        }
+        return true;
+    }
+
+    // Consumer: oldest element, nullptr if empty. Valid until pop().
+    const T* peek() const {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[t & (N - 1)];
+    }
+
+    // Consumer: take the oldest element; false if empty.
+    bool pop(T& out) {
+        const T* p = peek();
+        if (p == nullptr) {
+            return false;
+        }
+        out = *p;
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: drop the element peek() returned.
+    void skip() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Either side; a snapshot.
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Live datapoint stream over Server-Sent Events (GET /events)
+//
+// A changed value only sets its dirty bit (vitoSseMark, a sink of the value
+// store, no allocation, no network). loop() turns the dirty values into one
+// frame every VITO_SSE_TICK_MS, read from the store, and hands it to each
+// client:
+//
+//   event "meta"  once per client: ["AussenTemp","WWtempOben",...]
+//   event "v"     {"t":<uptime ms>,"d":[[<dp index>,<value>],...]}
+//
+// A new client, and one that missed frames, gets every known value instead
+// of the changes (snapshot), so it never shows a stale value for long.
+//
+// Backpressure is per client: while more than VITO_SSE_MAX_WAITING messages
+// wait in its queue, frames for it are skipped; a client that stays backed
+// up for VITO_SSE_EVICT_MS is closed. At most VITO_SSE_MAX_CLIENTS clients
+// are served, further ones are closed right away.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_values.h"
+
+#ifndef VITO_SSE_TICK_MS
+#define VITO_SSE_TICK_MS 250UL         // one frame per tick with the values changed in it
+#endif
+#ifndef VITO_SSE_MAX_CLIENTS
+#define VITO_SSE_MAX_CLIENTS 4
+#endif
+#ifndef VITO_SSE_MAX_WAITING
+#define VITO_SSE_MAX_WAITING 4         // queued messages before frames are skipped
+#endif
+#ifndef VITO_SSE_EVICT_MS
+#define VITO_SSE_EVICT_MS 10000UL      // backed up this long: client is closed
+#endif
+
+struct VitoSseClient {
+    AsyncEventSourceClient* client;       // nullptr = free slot
+    uint32_t                backedUpMs;   // since when frames are skipped, 0 = keeping up
+    bool                    needMeta;
+    bool                    needSnapshot;
+};
+
+static VitoDpSet     vitoSseDirty   = {};  // changed since the last frame
+static VitoSseClient vitoSseClients[VITO_SSE_MAX_CLIENTS];
+static std::mutex    vitoSseLock;          // client table: loop() vs. the async_tcp task
+static uint32_t      vitoSseLastTickMs = 0;
+// statistics since boot
+static uint32_t      vitoSseFrames   = 0;  // frames handed to clients
+static uint32_t      vitoSseBytes    = 0;
+static uint32_t      vitoSseSkipped  = 0;  // frames not sent because of backpressure
+static uint32_t      vitoSseEvicted  = 0;
+static uint32_t      vitoSseRejected = 0;  // clients over VITO_SSE_MAX_CLIENTS
+
+// Value store sink: the value goes into the next frame.
+inline void vitoSseMark(uint8_t id) {
+    if (id < DP_COUNT) {
+        vitoDpSetAdd(vitoSseDirty, id);
+    }
+}
+
+// --- client table (callbacks run in the async_tcp task) ----------------------------
+inline void vitoSseOnConnect(AsyncEventSourceClient* client) {
+    {
+        std::lock_guard<std::mutex> lock(vitoSseLock);
+        for (VitoSseClient& c : vitoSseClients) {
+            if (c.client == nullptr) {
+                c = {client, 0, true, true};
+                return;
+            }
+        }
+        vitoSseRejected++;
+    }
+    client->close();   // unlocked: reports back through vitoSseOnDisconnect
+}
+
+inline void vitoSseOnDisconnect(AsyncEventSourceClient* client) {
+    std::lock_guard<std::mutex> lock(vitoSseLock);
+    for (VitoSseClient& c : vitoSseClients) {
+        if (c.client == client) {
+            c.client = nullptr;
+        }
+    }
+}
+
+// setup(): attach the stream to the event source.
+inline void vitoSseBegin(AsyncEventSource& events) {
+    events.onConnect(vitoSseOnConnect);
+    events.onDisconnect(vitoSseOnDisconnect);
+}
+
+// --- frames -------------------------------------------------------------------------
+inline size_t vitoSseFrame(char* buf, size_t size, const VitoDpSet& mask, uint32_t now) {
+    int n = snprintf(buf, size, "{\"t\":%lu,\"d\":[", (unsigned long)now);
+    bool first = true;
+    for (uint8_t i = 0; i < DP_COUNT && n > 0 && (size_t)n < size; ++i) {
+        if (vitoDpSetHas(mask, i)) {
+            n += snprintf(buf + n, size - n, "%s[%u,%g]", first ? "" : ",", i, (double)vitoValGet(i).f);
+            first = false;
+        }
+    }
+    if (n < 0 || (size_t)n + 3 > size) {
+        return 0;
+    }
+    buf[n++] = ']';
+    buf[n++] = '}';
+    buf[n] = '\0';
+    return (size_t)n;
+}
+
+inline size_t vitoSseMeta(char* buf, size_t size) {
+    size_t n = 0;
+    buf[n++] = '[';
+    for (uint8_t i = 0; i < DP_COUNT && n < size; ++i) {
+        n += snprintf(buf + n, size - n, "%s\"%s\"", i ? "," : "", vitoDpNames[i]);
+    }
+    if (n + 2 > size) {
+        return 0;
+    }
+    buf[n++] = ']';
+    buf[n] = '\0';
+    return n;
+}
+
+// loop(): one frame per tick to every client that keeps up.
+inline void vitoSseService(uint32_t now) {
+    if (now - vitoSseLastTickMs < VITO_SSE_TICK_MS) {
+        return;
+    }
+    vitoSseLastTickMs = now;
+
+    static char delta[24 * DP_COUNT + 32];
+    static char snapshot[24 * DP_COUNT + 32];
+    static char meta[(VITO_DP_NAME_LEN + 3) * DP_COUNT + 4];
+    VitoDpSet dirty = vitoSseDirty;
+    bool changed = !vitoDpSetEmpty(dirty);
+    vitoDpSetClear(vitoSseDirty);
+    size_t deltaLen = 0, snapshotLen = 0;
+    AsyncEventSourceClient* evict[VITO_SSE_MAX_CLIENTS];
+    uint8_t evictCount = 0;
+
+    std::unique_lock<std::mutex> lock(vitoSseLock);
+    for (VitoSseClient& c : vitoSseClients) {
+        if (c.client == nullptr) {
+            continue;
+        }
+        if (c.client->packetsWaiting() > VITO_SSE_MAX_WAITING) {
+            if (changed) {
+                vitoSseSkipped++;
+                c.needSnapshot = true;
+            }
+            if (c.backedUpMs == 0) {
+                c.backedUpMs = now ? now : 1;
+            } else if (now - c.backedUpMs >= VITO_SSE_EVICT_MS) {
+                vitoSseEvicted++;
+                evict[evictCount++] = c.client;
+                c.client = nullptr;
+            }
+            continue;
+        }
+        c.backedUpMs = 0;
+        if (c.needMeta) {
+            size_t len = vitoSseMeta(meta, sizeof(meta));
+            if (len && c.client->send(meta, "meta", 0)) {
+                c.needMeta = false;
+                vitoSseBytes += len;
+            }
+        }
+        const char* frame = nullptr;
+        size_t len = 0;
+        if (c.needSnapshot) {
+            if (vitoDpSetEmpty(vitoValKnown)) {
+                continue;
+            }
+            if (snapshotLen == 0) {
+                snapshotLen = vitoSseFrame(snapshot, sizeof(snapshot), vitoValKnown, now);
+            }
+            frame = snapshot;
+            len = snapshotLen;
+        } else if (changed) {
+            if (deltaLen == 0) {
+                deltaLen = vitoSseFrame(delta, sizeof(delta), dirty, now);
+            }
+            frame = delta;
+            len = deltaLen;
+        }
+        if (frame && len && c.client->send(frame, "v", now)) {
+            c.needSnapshot = false;
+            vitoSseFrames++;
+            vitoSseBytes += len;
+        }
+    }
+    // outside the lock: close() reports the disconnect to vitoSseOnDisconnect
+    lock.unlock();
+    for (uint8_t i = 0; i < evictCount; ++i) {
+        evict[i]->close();
+    }
+}
+
+inline uint8_t vitoSseClientCount() {
+    uint8_t n = 0;
+    for (const VitoSseClient& c : vitoSseClients) {
+        n += c.client != nullptr;
+    }
+    return n;
+}
+
+// Stream statistics as JSON (GET /live/stats)
+inline const char* vitoSseStatsJson() {
+    static char buf[192];
+    snprintf(buf, sizeof(buf),
+             "{\"clients\":%u,\"maxClients\":%u,\"tickMs\":%lu,\"frames\":%lu,\"bytes\":%lu,\"skipped\":%lu,"
+             "\"evicted\":%lu,\"rejected\":%lu}",
+             vitoSseClientCount(), (unsigned)VITO_SSE_MAX_CLIENTS, (unsigned long)VITO_SSE_TICK_MS,
+             (unsigned long)vitoSseFrames, (unsigned long)vitoSseBytes, (unsigned long)vitoSseSkipped,
+             (unsigned long)vitoSseEvicted, (unsigned long)vitoSseRejected);
+    return buf;
+}
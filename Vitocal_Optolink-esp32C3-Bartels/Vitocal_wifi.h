@@ -0,0 +1,157 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// WiFi station state machine
+//
+// Nothing here waits for the network. setup() starts the station with
+// vitoWifiBegin() and carries on, so Optolink polling runs from the first
+// loop(); vitoWifiService() is called every loop() and only looks at flags.
+//
+//   CONNECTING --GOT_IP--> UP --DISCONNECTED--> BACKOFF --delay--> CONNECTING
+//        \------ no AP / auth failed / timeout ------^
+//
+// The WiFi events arrive on the WiFi task and only set atomic flags; the
+// transitions happen in loop() context. The ESP32's own auto-reconnect is
+// switched off so retries follow one schedule: 1 s after a loss, then
+// doubling per failed attempt up to VITO_WIFI_BACKOFF_MAX_MS, back to 1 s
+// once connected. While the network is down values keep going into the
+// caches (REST API, history, MQTT store-and-forward queue); MQTT reconnects
+// by itself once the station is up again.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include "Vitocal_log.h"
+
+#ifndef VITO_WIFI_CONNECT_TIMEOUT_MS
+#define VITO_WIFI_CONNECT_TIMEOUT_MS 15000UL   // attempt without an IP counts as failed
+#endif
+#ifndef VITO_WIFI_BACKOFF_MIN_MS
+#define VITO_WIFI_BACKOFF_MIN_MS 1000UL
+#endif
+#ifndef VITO_WIFI_BACKOFF_MAX_MS
+#define VITO_WIFI_BACKOFF_MAX_MS 32000UL
+#endif
+
+enum VitoWifiState : uint8_t {
+    VITO_WIFI_IDLE = 0,    // vitoWifiBegin() not called yet
+    VITO_WIFI_CONNECTING,
+    VITO_WIFI_UP,
+    VITO_WIFI_BACKOFF      // waiting to retry
+};
+
+static std::atomic<bool> vitoWifiGotIpFlag(false);   // set by the WiFi task
+static std::atomic<bool> vitoWifiLostFlag(false);
+
+static const char* vitoWifiSsid     = nullptr;
+static const char* vitoWifiPassword = nullptr;
+static uint8_t     vitoWifiState    = VITO_WIFI_IDLE;
+static uint32_t    vitoWifiSinceMs  = 0;   // entered the current state
+static uint32_t    vitoWifiDownMs   = 0;   // network lost (or boot), for vitoWifiDowntimeMs
+static uint32_t    vitoWifiBackoffMs = VITO_WIFI_BACKOFF_MIN_MS;
+
+// statistics (GET /metrics)
+static uint32_t vitoWifiAttempts    = 0;   // WiFi.begin() calls
+static uint32_t vitoWifiDisconnects = 0;   // losses of an established connection
+static uint64_t vitoWifiDowntimeMs  = 0;   // completed outages, boot included
+
+// WiFi task context: flags only
+inline void vitoWifiOnEvent(arduino_event_id_t event) {
+    switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        vitoWifiGotIpFlag.store(true, std::memory_order_release);
+        break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        vitoWifiLostFlag.store(true, std::memory_order_release);
+        break;
+    default:
+        break;
+    }
+}
+
+inline void vitoWifiSetState(uint8_t state, uint32_t now) {
+    vitoWifiState   = state;
+    vitoWifiSinceMs = now;
+}
+
+inline void vitoWifiConnect(uint32_t now) {
+    vitoWifiLostFlag.store(false, std::memory_order_relaxed);
+    vitoWifiAttempts++;
+    vitoWifiSetState(VITO_WIFI_CONNECTING, now);
+    WiFi.begin(vitoWifiSsid, vitoWifiPassword);
+}
+
+// Start the station; WiFi.mode()/config()/setTxPower() are done by the caller.
+inline void vitoWifiBegin(const char* ssid, const char* password, uint32_t now) {
+    vitoWifiSsid     = ssid;
+    vitoWifiPassword = password;
+    vitoWifiDownMs   = now;
+    WiFi.onEvent(vitoWifiOnEvent);
+    WiFi.setAutoReconnect(false);
+    vitoWifiConnect(now);
+}
+
+// Connection lost or attempt failed: retry after the current backoff.
+inline void vitoWifiFail(uint32_t now) {
+    bool wasUp = vitoWifiState == VITO_WIFI_UP;
+    if (wasUp) {
+        vitoWifiDisconnects++;
+        vitoWifiDownMs    = now;
+        vitoWifiBackoffMs = VITO_WIFI_BACKOFF_MIN_MS;
+    } else {
+        vitoWifiBackoffMs = vitoWifiBackoffMs * 2 > VITO_WIFI_BACKOFF_MAX_MS
+                          ? VITO_WIFI_BACKOFF_MAX_MS : vitoWifiBackoffMs * 2;
+    }
+    vitoWifiSetState(VITO_WIFI_BACKOFF, now);
+    vitoLog(VITO_LOG_INFO, VITO_EV_WIFI_DOWN, VITO_DP_NONE, 0, wasUp ? 0 : 1, vitoWifiBackoffMs);
+}
+
+// loop(): never blocks. Returns true when the station has just come up.
+inline bool vitoWifiService(uint32_t now) {
+    bool lost  = vitoWifiLostFlag.exchange(false, std::memory_order_acquire);
+    bool gotIp = vitoWifiGotIpFlag.exchange(false, std::memory_order_acquire);
+
+    switch (vitoWifiState) {
+    case VITO_WIFI_CONNECTING: {
+        // a DISCONNECTED while connecting can be the station dropping the old
+        // association; only a definite failure or the timeout ends the attempt
+        wl_status_t status = WiFi.status();
+        if (gotIp || status == WL_CONNECTED) {
+            vitoWifiDowntimeMs += now - vitoWifiDownMs;
+            vitoWifiBackoffMs = VITO_WIFI_BACKOFF_MIN_MS;
+            vitoWifiSetState(VITO_WIFI_UP, now);
+            vitoLog(VITO_LOG_INFO, VITO_EV_WIFI_UP, VITO_DP_NONE, 0, 0, now - vitoWifiDownMs);
+            return true;
+        }
+        if ((lost && (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED)) ||
+            now - vitoWifiSinceMs >= VITO_WIFI_CONNECT_TIMEOUT_MS) {
+            vitoWifiFail(now);
+        }
+        break;
+    }
+    case VITO_WIFI_UP:
+        if (lost && WiFi.status() != WL_CONNECTED) {
+            vitoWifiFail(now);
+        }
+        break;
+    case VITO_WIFI_BACKOFF:
+        if (now - vitoWifiSinceMs >= vitoWifiBackoffMs) {
+            vitoWifiConnect(now);
+        }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+inline bool vitoWifiUp() {
+    return vitoWifiState == VITO_WIFI_UP;
+}
+
+// Downtime so far, the current outage included.
+inline uint64_t vitoWifiDowntimeTotalMs(uint32_t now) {
+    return vitoWifiDowntimeMs + (vitoWifiUp() || vitoWifiState == VITO_WIFI_IDLE ? 0 : now - vitoWifiDownMs);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Write queue with read-back confirmation
+//
+// HA commands do not write from the MQTT callback any more: they queue the
+// value in the slot of the datapoint it changes (one slot per VitoDpId, so
+// repeated commands for the same address collapse and the last value wins).
+// The poller serves the queue before any scheduled read, one transaction at
+// a time like every other request:
+//
+//   PENDING -> WRITING -> VERIFY -> READING -> done (confirmed / mismatch)
+//                 \___________________\______-> failed (error or timeout)
+//
+// After the write is acknowledged the address is read back at once; only
+// that read-back (or a failure) is published to HA, and the time from the
+// first command to the confirmation is recorded per entity. A value queued
+// while an earlier one is in flight is written after it completes. Write and
+// read-back use the datapoint's own record (vitoDpDatapoint), so only
+// datapoints flagged VITO_DP_WRITABLE in dpspec.toml take commands.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <VitoWiFi.h>
+#include "Vitocal_datapoints.h"
+
+#ifndef VITO_WRITE_TOLERANCE
+#define VITO_WRITE_TOLERANCE 0.05f   // read-back vs. written value (div10 rounding)
+#endif
+
+#define VITO_WRITE_PRIO_NORMAL 0
+#define VITO_WRITE_PRIO_HIGH   1     // served before normal writes (e.g. manual mode)
+
+enum VitoWritePhase : uint8_t {
+    VITO_WRITE_IDLE = 0,
+    VITO_WRITE_WRITING,   // write request in flight
+    VITO_WRITE_VERIFY,    // acknowledged, read-back due
+    VITO_WRITE_READING    // read-back in flight
+};
+
+enum VitoWriteResult : uint8_t {
+    VITO_WRITE_NOT_OURS = 0,
+    VITO_WRITE_CONFIRMED,
+    VITO_WRITE_MISMATCH,  // controller kept (or clamped to) another value
+    VITO_WRITE_FAILED     // write or read-back error
+};
+
+struct VitoWriteSlot {
+    float    value;            // latest requested value
+    float    inFlight;         // value being written / verified
+    uint32_t commandMs;        // first command of the pending value
+    uint32_t inFlightCmdMs;    // ... of the value in flight
+    uint8_t  priority;
+    uint8_t  phase;            // VitoWritePhase
+    bool     pending;          // value waits to be written
+    // statistics
+    uint32_t confirmed;
+    uint32_t failed;
+    uint32_t coalesced;        // commands merged into a pending one
+    uint32_t lastLatencyMs;    // command -> confirmation
+    uint32_t maxLatencyMs;
+    uint64_t sumLatencyMs;
+};
+
+static VitoWriteSlot vitoWriteSlots[DP_COUNT];
+static uint8_t       vitoWriteActive = VITO_DP_NONE;   // slot with a transaction in flight
+
+// Queue value for datapoint id (Optolink task, HA commands via vitoOptoWrite()).
+inline void vitoWriteEnqueue(uint8_t id, float value, uint8_t priority, uint32_t now) {
+    if (id >= DP_COUNT || !(vitoDpSpecs[id].flags & VITO_DP_WRITABLE)) {
+        return;
+    }
+    VitoWriteSlot& s = vitoWriteSlots[id];
+    if (s.pending) {
+        s.coalesced++;
+    } else {
+        s.commandMs = now;
+    }
+    s.value    = value;
+    s.priority = priority;
+    s.pending  = true;
+}
+
+// A newer value for id waits to be written (polled reads are stale then).
+inline bool vitoWritePending(uint8_t id) {
+    return id < DP_COUNT && (vitoWriteSlots[id].pending || vitoWriteActive == id);
+}
+
+// Next slot to serve: the active one if its read-back is due, else the
+// pending slot with the highest priority and the oldest command.
+inline uint8_t vitoWriteNext() {
+    if (vitoWriteActive != VITO_DP_NONE) {
+        return vitoWriteSlots[vitoWriteActive].phase == VITO_WRITE_VERIFY ? vitoWriteActive : VITO_DP_NONE;
+    }
+    uint8_t best = VITO_DP_NONE;
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        const VitoWriteSlot& s = vitoWriteSlots[i];
+        if (!s.pending) {
+            continue;
+        }
+        if (best == VITO_DP_NONE || s.priority > vitoWriteSlots[best].priority ||
+            (s.priority == vitoWriteSlots[best].priority &&
+             (int32_t)(s.commandMs - vitoWriteSlots[best].commandMs) < 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// The write for id was queued in VitoWiFi.
+inline void vitoWriteStarted(uint8_t id) {
+    VitoWriteSlot& s = vitoWriteSlots[id];
+    s.inFlight      = s.value;
+    s.inFlightCmdMs = s.commandMs;
+    s.pending       = false;
+    s.phase         = VITO_WRITE_WRITING;
+    vitoWriteActive = id;
+}
+
+// The read-back for id was queued in VitoWiFi.
+inline void vitoWriteReadStarted(uint8_t id) {
+    vitoWriteSlots[id].phase = VITO_WRITE_READING;
+}
+
+inline void vitoWriteFinish(VitoWriteSlot& s) {
+    s.phase = VITO_WRITE_IDLE;
+    vitoWriteActive = VITO_DP_NONE;
+}
+
+// Any response while a write is in flight is its acknowledgement.
+inline bool vitoWriteOnAck() {
+    if (vitoWriteActive == VITO_DP_NONE || vitoWriteSlots[vitoWriteActive].phase != VITO_WRITE_WRITING) {
+        return false;
+    }
+    vitoWriteSlots[vitoWriteActive].phase = VITO_WRITE_VERIFY;
+    return true;
+}
+
+// Error while writing or reading back; returns the failed slot or VITO_DP_NONE.
+inline uint8_t vitoWriteOnError() {
+    uint8_t id = vitoWriteActive;
+    if (id == VITO_DP_NONE) {
+        return VITO_DP_NONE;
+    }
+    VitoWriteSlot& s = vitoWriteSlots[id];
+    if (s.phase != VITO_WRITE_WRITING && s.phase != VITO_WRITE_READING) {
+        return VITO_DP_NONE;
+    }
+    s.failed++;
+    vitoWriteFinish(s);
+    return id;
+}
+
+// Decoded read of datapoint id: completes the write if it is the read-back.
+inline uint8_t vitoWriteOnRead(uint8_t id, float value, uint32_t now) {
+    if (id != vitoWriteActive || vitoWriteSlots[id].phase != VITO_WRITE_READING) {
+        return VITO_WRITE_NOT_OURS;
+    }
+    VitoWriteSlot& s = vitoWriteSlots[id];
+    float diff = value > s.inFlight ? value - s.inFlight : s.inFlight - value;
+    uint32_t latency = now - s.inFlightCmdMs;
+    s.lastLatencyMs = latency;
+    if (latency > s.maxLatencyMs) s.maxLatencyMs = latency;
+    vitoWriteFinish(s);
+    if (diff > VITO_WRITE_TOLERANCE) {
+        s.failed++;
+        return VITO_WRITE_MISMATCH;
+    }
+    s.confirmed++;
+    s.sumLatencyMs += latency;
+    return VITO_WRITE_CONFIRMED;
+}
@@ -10,6 +10,12 @@
 #endif
 #include "Vitocal_datapoints.h"
 #include "Vitocal_polling.h"
+#include "Vitocal_adaptive.h"
+#include "Vitocal_publish.h"
+#include "Vitocal_writequeue.h"
+#include "Vitocal_aggregate.h"
+#include "Vitocal_mqttbatch.h"
+#include "Vitocal_discovery.h"
 extern volatile uint32_t vitoErrorThreshold; // from main sketch
 
 // prefix to have unique IDs
@@ -24,64 +30,84 @@ extern volatile uint32_t vitoErrorThreshold; // from main sketch
 //*** forward declararions ***************************************************
 void onMQTTConnected(void);
 void onMQTTMessage(const char* topic, const uint8_t* payload, uint16_t length);
-void setRaumSoll (HANumeric number, HANumber* sender);
-void setRaumSollRed (HANumeric number, HANumber* sender);
-void setWWSoll (HANumeric number, HANumber* sender);
-void setWWSoll2 (HANumeric number, HANumber* sender);
-void setHystWWsoll (HANumeric number, HANumber* sender);
-
-void setHKniveau (HANumeric number, HANumber* sender);
-void setHKneigung (HANumeric number, HANumber* sender);
+void onSetpointCommand(HANumeric number, HANumber* sender);
 
 void onTargetTemperatureCommand(HANumeric temperature, HAHVAC* sender);
 void onPowerCommand(bool state, HAHVAC* sender);
 void onModeCommand(HAHVAC::Mode mode, HAHVAC* sender);
 void onManualModeCommand(int8_t index, HASelect* sender);
 
+//*** datapoint entities and tables, generated from dpspec.toml ***********
+#include "Vitocal_dpentities.h"
+
 //*** sensor definitions ***************************************************
-HASensorNumber RelEHeizStufeSens    (HA_PREFIX "EHeizstufe",        HANumber::PrecisionP0);   //working
-HASensorNumber AussenTempSens       (HA_PREFIX "Aussentemperatur",  HANumber::PrecisionP1);   //working
-HASensorNumber WWtempObenSens       (HA_PREFIX "WarmwasserOben",    HANumber::PrecisionP1);   //working
-HASensorNumber VorlaufTempSetSens   (HA_PREFIX "VorlaufSoll",       HANumber::PrecisionP0);   //working
-HASensorNumber VorlaufTempSens      (HA_PREFIX "Vorlauf",           HANumber::PrecisionP0);   //working
-HASensorNumber RuecklaufTempSens    (HA_PREFIX "Ruecklauf",         HANumber::PrecisionP0);   //working
-
-HABinarySensor heizkreispumpeSens       (HA_PREFIX "Heizkreispumpe");
-HABinarySensor WWzirkulationspumpeSens  (HA_PREFIX "WWZirkulation");
-HASensor       ventilHeizenWWSens       (HA_PREFIX "VentilHeizenWW");
-HABinarySensor RelVerdichterSens        (HA_PREFIX "Verdichter");
-HABinarySensor RelPrimaerquelleSens      (HA_PREFIX "Grundwasserpumpe");
-HABinarySensor RelSekundaerPumpeSens    (HA_PREFIX "Sekundaerpumpe");
-
-HABinarySensor Stoerung         (HA_PREFIX "WPStoerung");
-
-HAHVAC HVACwaermepumpe(
+VitoPaced<HASensorNumber> RelEHeizStufeSens    (HA_PREFIX "EHeizstufe",        HANumber::PrecisionP0);   // from the two heater stage relays
+
+VitoPaced<HAHVAC> HVACwaermepumpe(
     HA_PREFIX "Waermepumpe",
   HAHVAC::TargetTemperatureFeature | HAHVAC::PowerFeature | HAHVAC::ModesFeature
 );
 
 //*** set values ***************************************************
-HANumber  WWtempSollSens       (HA_PREFIX "WarmwasserSoll",     HANumber::PrecisionP0);
-HANumber  WWtempSoll2Sens      (HA_PREFIX "WarmwasserSoll2",    HANumber::PrecisionP0);
-HANumber  RaumSollTempSens     (HA_PREFIX "Raumtemperatur",     HANumber::PrecisionP1);
-HANumber  HystWWsollSens       (HA_PREFIX "HystereseWWsoll",    HANumber::PrecisionP1);
+VitoPaced<HASelect>  selectManualMode     (HA_PREFIX "setManualMode");
 
-HANumber  HKneigungSens       (HA_PREFIX "NeigungHeizkennlinie",    HANumber::PrecisionP1);
-HANumber  HKniveauSens        (HA_PREFIX "NiveauHeizkennlinie",    HANumber::PrecisionP1);
-
-HANumber  RaumSollRedSens      (HA_PREFIX "RaumtemperaturRed",  HANumber::PrecisionP1);
-HASensor  operationmodeSens    (HA_PREFIX "Betriebsmodus"); 
-HASensor  manualmodeSens       (HA_PREFIX "ManualMode");
-HASelect  selectManualMode     (HA_PREFIX "setManualMode");
-
-HANumber fastPollInterval(HA_PREFIX "fastPollInterval");
-HANumber mediumPollInterval(HA_PREFIX "mediumPollInterval");
-HANumber slowPollInterval(HA_PREFIX "slowPollInterval");
+VitoPaced<HANumber> fastPollInterval(HA_PREFIX "fastPollInterval");
+VitoPaced<HANumber> mediumPollInterval(HA_PREFIX "mediumPollInterval");
+VitoPaced<HANumber> slowPollInterval(HA_PREFIX "slowPollInterval");
 
 // Diagnostics: error counters and threshold
-HASensorNumber vitoErrorCountSens(HA_PREFIX "vito_error_count", HANumber::PrecisionP0);
-HASensorNumber vitoConsecErrorSens(HA_PREFIX "vito_consecutive_errors", HANumber::PrecisionP0);
-HANumber errorThresholdNumber(HA_PREFIX "vito_error_threshold", HANumber::PrecisionP0);
+VitoPaced<HASensorNumber> vitoErrorCountSens(HA_PREFIX "vito_error_count", HANumber::PrecisionP0);
+VitoPaced<HASensorNumber> vitoConsecErrorSens(HA_PREFIX "vito_consecutive_errors", HANumber::PrecisionP0);
+VitoPaced<HANumber> errorThresholdNumber(HA_PREFIX "vito_error_threshold", HANumber::PrecisionP0);
+VitoPaced<HASensor>       vitoProtocolSens(HA_PREFIX "vito_protocol");
+VitoPaced<HASensorNumber> vitoReadRateSens(HA_PREFIX "vito_reads_per_s", HANumber::PrecisionP2);
+VitoPaced<HABinarySensor> vitoPollBoostSens(HA_PREFIX "vito_poll_boost");
+VitoPaced<HASensorNumber> vitoSuppressedSens(HA_PREFIX "vito_publish_suppressed", HANumber::PrecisionP0);
+VitoPaced<HASensor>       vitoWriteStatusSens(HA_PREFIX "vito_write_status");
+static char vitoWriteStatusText[64] = "";   // its last text, vitoReportWrite()
+VitoPaced<HASensorNumber> vitoLoopMaxSens(HA_PREFIX "vito_loop_max_ms", HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> vitoLoopStallsSens(HA_PREFIX "vito_loop_stalls", HANumber::PrecisionP0);
+VitoPaced<HASensor>       vitoLastStallSens(HA_PREFIX "vito_last_stall");
+VitoPaced<HASensorNumber> vitoMqDepthSens(HA_PREFIX "vito_mqtt_queue", HANumber::PrecisionP0);
+VitoPaced<HASensorNumber> vitoQuarantineSens(HA_PREFIX "vito_quarantined", HANumber::PrecisionP0);
+
+// Derived figures over the last VITO_AGG_WINDOW_S (Vitocal_aggregate.h)
+VitoPaced<HASensorNumber> aggAussenMeanSens    (HA_PREFIX "agg_aussen_mean",      HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggAussenMinSens     (HA_PREFIX "agg_aussen_min",       HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggAussenMaxSens     (HA_PREFIX "agg_aussen_max",       HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggVorlaufMeanSens   (HA_PREFIX "agg_vorlauf_mean",     HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggVorlaufMaxSens    (HA_PREFIX "agg_vorlauf_max",      HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggRuecklaufMeanSens (HA_PREFIX "agg_ruecklauf_mean",   HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggWWobenMinSens     (HA_PREFIX "agg_ww_oben_min",      HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggWWobenMaxSens     (HA_PREFIX "agg_ww_oben_max",      HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggSpreadMeanSens    (HA_PREFIX "agg_spreizung_mean",   HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggSpreadMaxSens     (HA_PREFIX "agg_spreizung_max",    HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggVerdichterStartsSens(HA_PREFIX "agg_verdichter_starts", HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggVerdichterDutySens(HA_PREFIX "agg_verdichter_duty",  HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggVerdichterHoursSens(HA_PREFIX "agg_verdichter_hours", HANumber::PrecisionP2);
+VitoPaced<HASensorNumber> aggPrimaerDutySens   (HA_PREFIX "agg_grundwasser_duty", HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggEHeiz1DutySens    (HA_PREFIX "agg_eheiz1_duty",      HANumber::PrecisionP1);
+VitoPaced<HASensorNumber> aggEHeiz2DutySens    (HA_PREFIX "agg_eheiz2_duty",      HANumber::PrecisionP1);
+
+// {channel, statistic, entity, object id, name, icon, unit}
+const VitoAggOutput vitoAggOutputs[VITO_AGG_OUTPUTS] = {
+    { VITO_AGG_AUSSEN,     VITO_AGG_MEAN,      &aggAussenMeanSens,       HA_PREFIX "agg_aussen_mean",       "Aussentemperatur Mittel 1h",   "mdi:home-thermometer-outline", "C"   },
+    { VITO_AGG_AUSSEN,     VITO_AGG_MIN,       &aggAussenMinSens,        HA_PREFIX "agg_aussen_min",        "Aussentemperatur Min 1h",      "mdi:thermometer-low",          "C"   },
+    { VITO_AGG_AUSSEN,     VITO_AGG_MAX,       &aggAussenMaxSens,        HA_PREFIX "agg_aussen_max",        "Aussentemperatur Max 1h",      "mdi:thermometer-high",         "C"   },
+    { VITO_AGG_VORLAUF,    VITO_AGG_MEAN,      &aggVorlaufMeanSens,      HA_PREFIX "agg_vorlauf_mean",      "Vorlauf Mittel 1h",            "mdi:thermometer-chevron-up",   "C"   },
+    { VITO_AGG_VORLAUF,    VITO_AGG_MAX,       &aggVorlaufMaxSens,       HA_PREFIX "agg_vorlauf_max",       "Vorlauf Max 1h",               "mdi:thermometer-chevron-up",   "C"   },
+    { VITO_AGG_RUECKLAUF,  VITO_AGG_MEAN,      &aggRuecklaufMeanSens,    HA_PREFIX "agg_ruecklauf_mean",    "Ruecklauf Mittel 1h",          "mdi:thermometer-chevron-down", "C"   },
+    { VITO_AGG_WW_OBEN,    VITO_AGG_MIN,       &aggWWobenMinSens,        HA_PREFIX "agg_ww_oben_min",       "Warmwasser Oben Min 1h",       "mdi:bathtub",                  "C"   },
+    { VITO_AGG_WW_OBEN,    VITO_AGG_MAX,       &aggWWobenMaxSens,        HA_PREFIX "agg_ww_oben_max",       "Warmwasser Oben Max 1h",       "mdi:bathtub",                  "C"   },
+    { VITO_AGG_SPREAD,     VITO_AGG_MEAN,      &aggSpreadMeanSens,       HA_PREFIX "agg_spreizung_mean",    "Spreizung Mittel 1h",          "mdi:arrow-expand-vertical",    "K"   },
+    { VITO_AGG_SPREAD,     VITO_AGG_MAX,       &aggSpreadMaxSens,        HA_PREFIX "agg_spreizung_max",     "Spreizung Max 1h",             "mdi:arrow-expand-vertical",    "K"   },
+    { VITO_AGG_VERDICHTER, VITO_AGG_PER_HOUR,  &aggVerdichterStartsSens, HA_PREFIX "agg_verdichter_starts", "Verdichter Starts pro Stunde", "mdi:restart",                  "1/h" },
+    { VITO_AGG_VERDICHTER, VITO_AGG_DUTY,      &aggVerdichterDutySens,   HA_PREFIX "agg_verdichter_duty",   "Verdichter Laufzeit 1h",       "mdi:filter",                   "%"   },
+    { VITO_AGG_VERDICHTER, VITO_AGG_RUNTIME_H, &aggVerdichterHoursSens,  HA_PREFIX "agg_verdichter_hours",  "Verdichter Betriebsstunden",   "mdi:timer-outline",            "h"   },
+    { VITO_AGG_PRIMAER,    VITO_AGG_DUTY,      &aggPrimaerDutySens,      HA_PREFIX "agg_grundwasser_duty",  "Grundwasserpumpe Laufzeit 1h", "mdi:pump",                     "%"   },
+    { VITO_AGG_EHEIZ1,     VITO_AGG_DUTY,      &aggEHeiz1DutySens,       HA_PREFIX "agg_eheiz1_duty",       "EHeizstufe 1 Laufzeit 1h",     "mdi:radiator",                 "%"   },
+    { VITO_AGG_EHEIZ2,     VITO_AGG_DUTY,      &aggEHeiz2DutySens,       HA_PREFIX "agg_eheiz2_duty",       "EHeizstufe 2 Laufzeit 1h",     "mdi:radiator",                 "%"   },
+};
 
 //###########################################################################
 // setup home assistant integration##########################################
@@ -108,35 +134,22 @@ void setupHomeAssistant() {
     device.enableSharedAvailability();
     device.enableLastWill();
 
+    // paced discovery (Vitocal_discovery.h): a new build, device or prefix
+    // invalidates every stored config hash
+    vitoDiscSaltMix(DEVICE_SWVERSION);
+    vitoDiscSaltMix(DEVICE_NAME);
+    vitoDiscSaltMix(DEVICE_MANUFACTURER);
+    vitoDiscSaltMix(DEVICE_MODEL);
+    vitoDiscSaltMix(device.getUniqueId());
+    vitoDiscSaltMix(MQTT_DATAPREFIX);
+    vitoDiscSaltMix(MQTT_DISCOVERYPREFIX);
+
     // Force stable entity_ids in Home Assistant.
     // HA generates entity_id primarily from MQTT discovery "object_id".
     // Without this, HA may generate entity_ids based on the device name
     // when entities are recreated.
     RelEHeizStufeSens.setObjectId(HA_PREFIX "EHeizstufe");
-    AussenTempSens.setObjectId(HA_PREFIX "Aussentemperatur");
-    WWtempObenSens.setObjectId(HA_PREFIX "Warmwasser_Oben");
-    VorlaufTempSetSens.setObjectId(HA_PREFIX "Vorlauf_Soll");
-    VorlaufTempSens.setObjectId(HA_PREFIX "Vorlauf");
-    RuecklaufTempSens.setObjectId(HA_PREFIX "Ruecklauf");
-
-    heizkreispumpeSens.setObjectId(HA_PREFIX "Heizkreispumpe");
-    WWzirkulationspumpeSens.setObjectId(HA_PREFIX "WW_Zirkulation");
-    ventilHeizenWWSens.setObjectId(HA_PREFIX "ventil_heizen_ww");
-    RelVerdichterSens.setObjectId(HA_PREFIX "Verdichter");
-    RelPrimaerquelleSens.setObjectId(HA_PREFIX "Grundwasserpumpe");
-    RelSekundaerPumpeSens.setObjectId(HA_PREFIX "Sekundaerpumpe");
-    Stoerung.setObjectId(HA_PREFIX "Stoerung");
     HVACwaermepumpe.setObjectId(HA_PREFIX "Waermepumpe");
-
-    WWtempSollSens.setObjectId(HA_PREFIX "Warmwasser_Soll");
-    WWtempSoll2Sens.setObjectId(HA_PREFIX "Warmwasser_Soll2");
-    RaumSollTempSens.setObjectId(HA_PREFIX "Raumtemperatur");
-    RaumSollRedSens.setObjectId(HA_PREFIX "Raumtemperatur_Red_soll");
-    HystWWsollSens.setObjectId(HA_PREFIX "Hysterese_WW_soll");
-    HKneigungSens.setObjectId(HA_PREFIX "NeigungHeizkennlinie");
-    HKniveauSens.setObjectId(HA_PREFIX "NiveauHeizkennlinie");
-    operationmodeSens.setObjectId(HA_PREFIX "modus");
-    manualmodeSens.setObjectId(HA_PREFIX "man_modus");
     selectManualMode.setObjectId(HA_PREFIX "setManualMode");
 
     fastPollInterval.setObjectId(HA_PREFIX "fastPollInterval");
@@ -146,58 +159,42 @@ void setupHomeAssistant() {
     vitoErrorCountSens.setObjectId(HA_PREFIX "vito_error_count");
     vitoConsecErrorSens.setObjectId(HA_PREFIX "vito_consecutive_errors");
     errorThresholdNumber.setObjectId(HA_PREFIX "vito_error_threshold");
+    vitoProtocolSens.setObjectId(HA_PREFIX "vito_protocol");
+    vitoReadRateSens.setObjectId(HA_PREFIX "vito_reads_per_s");
+    vitoPollBoostSens.setObjectId(HA_PREFIX "vito_poll_boost");
+    vitoSuppressedSens.setObjectId(HA_PREFIX "vito_publish_suppressed");
+    vitoWriteStatusSens.setObjectId(HA_PREFIX "vito_write_status");
+    vitoLoopMaxSens.setObjectId(HA_PREFIX "vito_loop_max_ms");
+    vitoLoopStallsSens.setObjectId(HA_PREFIX "vito_loop_stalls");
+    vitoLastStallSens.setObjectId(HA_PREFIX "vito_last_stall");
+    vitoMqDepthSens.setObjectId(HA_PREFIX "vito_mqtt_queue");
+    vitoQuarantineSens.setObjectId(HA_PREFIX "vito_quarantined");
 
     //*** setup sensors ***********************************************
-    AussenTempSens.setIcon("mdi:home-thermometer-outline");     AussenTempSens.setName("Aussentemperatur");    AussenTempSens.setUnitOfMeasurement("C");
-    WWtempObenSens.setIcon("mdi:bathtub");                      WWtempObenSens.setName("Warmwasser Oben");     WWtempObenSens.setUnitOfMeasurement("C");
-    VorlaufTempSetSens.setIcon("mdi:thermometer-chevron-up");   VorlaufTempSetSens.setName("Vorlauf Soll");    VorlaufTempSetSens.setUnitOfMeasurement("C");  
-    VorlaufTempSens.setIcon("mdi:thermometer-chevron-up");      VorlaufTempSens.setName("Vorlauf");            VorlaufTempSens.setUnitOfMeasurement("C");
-    RuecklaufTempSens.setIcon("mdi:thermometer-chevron-down");  RuecklaufTempSens.setName("Ruecklauf");        RuecklaufTempSens.setUnitOfMeasurement("C");      
-
-    heizkreispumpeSens.setIcon("mdi:pump");                  heizkreispumpeSens.setName("Heizkreispumpe");     
-    WWzirkulationspumpeSens.setIcon("mdi:pump");             WWzirkulationspumpeSens.setName("WW Zirkulation");     
-    ventilHeizenWWSens.setIcon("mdi:pipe-valve");             ventilHeizenWWSens.setName("Ventil Heizen-WW");   
-    
-    ventilHeizenWWSens.setForceUpdate(false);
+    // datapoint entities: object id, name, icon, unit, Number limits (dpspec.toml)
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        vitoSetupEntity(vitoDpTable[i], vitoDpHaMeta[i], onSetpointCommand);
+        vitoDiscDescribe(vitoDpTable[i].entity, vitoDpHaMeta[i].icon);
+        vitoDiscDescribe(vitoDpTable[i].entity, vitoDpHaMeta[i].unit);
+    }
+    vitoBatchInit(vitoDpTable);
+    // derived figures: object id, name, icon, unit (vitoAggOutputs[])
+    for (uint8_t i = 0; i < VITO_AGG_OUTPUTS; ++i) {
+        const VitoAggOutput& o = vitoAggOutputs[i];
+        o.entity->setObjectId(o.objectId);
+        o.entity->setName(o.name);
+        o.entity->setIcon(o.icon);
+        o.entity->setUnitOfMeasurement(o.unit);
+        vitoDiscDescribe(o.entity, o.icon);
+        vitoDiscDescribe(o.entity, o.unit);
+    }
 
     RelEHeizStufeSens.setIcon("mdi:radiator");                  RelEHeizStufeSens.setName("EHeizstufe");     
-    RelVerdichterSens.setIcon("mdi:filter");                 RelVerdichterSens.setName("Verdichter");         
-    RelPrimaerquelleSens.setIcon("mdi:pump");                RelPrimaerquelleSens.setName("Grundwasserpumpe");    
-    RelSekundaerPumpeSens.setIcon("mdi:pump");              RelSekundaerPumpeSens.setName("Sekundaerpumpe"); 
-
-    Stoerung.setIcon("mdi:alert-outline");                   Stoerung.setName("Stoerung");
 
-    operationmodeSens.setIcon("mdi:state-machine");          operationmodeSens.setName("Modus"); 
-    manualmodeSens.setIcon("mdi:braille");                   manualmodeSens.setName("Man.Modus"); 
     selectManualMode.setIcon("mdi:braille");                 selectManualMode.setName("set Man.Modus");
     selectManualMode.setOptions("normal;manuel;WW auf Temp2"); // use semicolons as separator of options
     selectManualMode.onCommand(onManualModeCommand); 
 
-    WWtempSollSens.setIcon("mdi:state-machine");             WWtempSollSens.setName("Warmwasser Soll");             WWtempSollSens.setUnitOfMeasurement("C");         
-    WWtempSollSens.setMin(20);  WWtempSollSens.setMax(60);   WWtempSollSens.setStep(1);                             WWtempSollSens.onCommand(setWWSoll);            WWtempSollSens.setMode(HANumber::ModeBox);  
-    WWtempSoll2Sens.setIcon("mdi:state-machine");             WWtempSoll2Sens.setName("Warmwasser Soll2");             WWtempSoll2Sens.setUnitOfMeasurement("C");         
-    WWtempSoll2Sens.setMin(20);  WWtempSoll2Sens.setMax(60);   WWtempSoll2Sens.setStep(1);                             WWtempSoll2Sens.onCommand(setWWSoll2);       WWtempSoll2Sens.setMode(HANumber::ModeBox);
-
-    HKneigungSens.setIcon("mdi:chart-bell-curve-cumulative");             HKneigungSens.setName("Neigung Heizkennlinie");       HKneigungSens.setUnitOfMeasurement("-");         
-    HKneigungSens.setMin(0);  HKneigungSens.setMax(1);      HKneigungSens.setStep(0.1);                           HKneigungSens.onCommand(setHKneigung);
-    HKneigungSens.setMode(HANumber::ModeBox);
-    
-    HKniveauSens.setIcon("mdi:chart-bell-curve-cumulative");              HKniveauSens.setName("Niveau Heizkennlinie");         HKniveauSens.setUnitOfMeasurement("K");         
-    HKniveauSens.setMin(0);   HKniveauSens.setMax(10);     HKniveauSens.setStep(0.1);                             HKniveauSens.onCommand(setHKniveau);
-    HKniveauSens.setMode(HANumber::ModeBox);
-
-    HystWWsollSens.setIcon("mdi:state-machine");               HystWWsollSens.setName("Hysterese WW Soll");       HystWWsollSens.setUnitOfMeasurement("C"); 
-    HystWWsollSens.setMin(1);  HystWWsollSens.setMax(20);      HystWWsollSens.setStep(0.5);                       HystWWsollSens.onCommand(setHystWWsoll); 
-    HystWWsollSens.setMode(HANumber::ModeBox);
-
-    RaumSollTempSens.setIcon("mdi:state-machine");               RaumSollTempSens.setName("Raumtemperatur Soll");     RaumSollTempSens.setUnitOfMeasurement("C"); 
-    RaumSollTempSens.setMin(10);  RaumSollTempSens.setMax(30);   RaumSollTempSens.setStep(0.5);                       RaumSollTempSens.onCommand(setRaumSoll);    
-    RaumSollTempSens.setMode(HANumber::ModeBox);
-    
-    RaumSollRedSens.setIcon("mdi:state-machine");                RaumSollRedSens.setName("Raumtemperatur Red. Soll");     RaumSollRedSens.setUnitOfMeasurement("C");  
-    RaumSollRedSens.setMin(10);   RaumSollRedSens.setMax(30);    RaumSollRedSens.setStep(0.5);                            RaumSollRedSens.onCommand(setRaumSollRed);  
-    RaumSollRedSens.setMode(HANumber::ModeBox);
-
     // polling interval controls (seconds) - allow tuning from Home Assistant
     fastPollInterval.setIcon("mdi:timer-sand");
     fastPollInterval.setName("Vito Fast Poll Interval");
@@ -213,7 +210,7 @@ void setupHomeAssistant() {
         }
         float requested = number.toFloat();
         float applied = requested < 5.0f ? 5.0f : requested;
-        vitoFastState.intervalMs = (uint32_t)(applied * 1000.0f);
+        vitoSetClassInterval(VITO_CLASS_FAST, (uint32_t)(applied * 1000.0f));
         sender->setState(applied);
     });
 
@@ -231,7 +228,7 @@ void setupHomeAssistant() {
         }
         float requested = number.toFloat();
         float applied = requested < 5.0f ? 5.0f : requested;
-        vitoMediumState.intervalMs = (uint32_t)(applied * 1000.0f);
+        vitoSetClassInterval(VITO_CLASS_MEDIUM, (uint32_t)(applied * 1000.0f));
         sender->setState(applied);
     });
 
@@ -249,7 +246,7 @@ void setupHomeAssistant() {
         }
         float requested = number.toFloat();
         float applied = requested < 5.0f ? 5.0f : requested;
-        vitoSlowState.intervalMs = (uint32_t)(applied * 1000.0f);
+        vitoSetClassInterval(VITO_CLASS_SLOW, (uint32_t)(applied * 1000.0f));
         sender->setState(applied);
     });
 
@@ -270,9 +267,9 @@ void setupHomeAssistant() {
     mqtt.begin(BROKER_ADDR, BROKER_PORT, BROKER_USERNAME, BROKER_PASSWORD);
 
     // publish default polling intervals so HA sees initial state (seconds)
-    fastPollInterval.setState((float)(vitoFastState.intervalMs / 1000UL));
-    mediumPollInterval.setState((float)(vitoMediumState.intervalMs / 1000UL));
-    slowPollInterval.setState((float)(vitoSlowState.intervalMs / 1000UL));
+    fastPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_FAST].intervalMs / 1000UL));
+    mediumPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_MEDIUM].intervalMs / 1000UL));
+    slowPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_SLOW].intervalMs / 1000UL));
     
 
     // diagnostics setup
@@ -280,6 +277,28 @@ void setupHomeAssistant() {
     vitoErrorCountSens.setName("VitoWiFi Error Count");
     vitoConsecErrorSens.setIcon("mdi:counter");
     vitoConsecErrorSens.setName("VitoWiFi Consecutive Errors");
+    vitoProtocolSens.setIcon("mdi:swap-horizontal");
+    vitoProtocolSens.setName("Optolink Protocol");
+    vitoReadRateSens.setIcon("mdi:speedometer");
+    vitoReadRateSens.setName("Optolink Reads per Second");
+    vitoReadRateSens.setUnitOfMeasurement("1/s");
+    vitoPollBoostSens.setIcon("mdi:rocket-launch-outline");
+    vitoPollBoostSens.setName("Vito Poll Boost");
+    vitoSuppressedSens.setIcon("mdi:filter-outline");
+    vitoSuppressedSens.setName("Vito Publishes Suppressed");
+    vitoWriteStatusSens.setIcon("mdi:pencil-circle-outline");
+    vitoWriteStatusSens.setName("Vito Last Write");
+    vitoLoopMaxSens.setIcon("mdi:timer-alert-outline");
+    vitoLoopMaxSens.setName("Loop Max Time");
+    vitoLoopMaxSens.setUnitOfMeasurement("ms");
+    vitoLoopStallsSens.setIcon("mdi:timer-sand-complete");
+    vitoLoopStallsSens.setName("Loop Stalls");
+    vitoLastStallSens.setIcon("mdi:timer-alert");
+    vitoLastStallSens.setName("Loop Last Stall");
+    vitoMqDepthSens.setIcon("mdi:tray-full");
+    vitoMqDepthSens.setName("MQTT Queue");
+    vitoQuarantineSens.setIcon("mdi:shield-off-outline");
+    vitoQuarantineSens.setName("Optolink Quarantined");
 
     errorThresholdNumber.setIcon("mdi:alert-decagram-outline");
     errorThresholdNumber.setName("VitoWiFi Error Threshold");
@@ -303,78 +322,28 @@ void setupHomeAssistant() {
 }
 
 
-// VitoWiFi v3 instance and datapoints (defined elsewhere)
-extern VitoWiFi::VitoWiFi<VitoWiFi::VS1> vitoWIFI;
-extern VitoWiFi::Datapoint setTempRaumSoll;
-extern VitoWiFi::Datapoint setTempRaumSollRed;
-extern VitoWiFi::Datapoint setTempHystWWsoll;
-extern VitoWiFi::Datapoint setTempHKneigung;
-extern VitoWiFi::Datapoint setTempHKniveau;
-extern VitoWiFi::Datapoint setTempWWsoll;
-extern VitoWiFi::Datapoint setTempWWsoll2;
-extern VitoWiFi::Datapoint setManualMode;
-
-void setRaumSoll (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempRaumSoll, val);
-    }
-    sender->setState(number); // report the selected option back to the HA panel
-}
-
-void setRaumSollRed (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempRaumSollRed, val);
-    }
-    sender->setState(number); // report the selected option back to the HA panel
-}
+// VitoWiFi v3 instance (defined elsewhere)
+extern VitoOptolink vitoWIFI;
 
-void setHystWWsoll (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempHystWWsoll, val);
-    }
-    sender->setState(number); // report the selected option back to the HA panel
-}
-
-void setHKneigung (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempHKneigung, val);
-    }
-    sender->setState(number); // report the selected option back to the HA panel
-}
-
-void setHKniveau (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempHKniveau, val);
-    }
-    sender->setState(number); // report the selected option back to the HA panel
-}
-
-void setWWSoll (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempWWsoll, val);
+// HA Number of a Setpoint datapoint: queue the value for its datapoint.
+void onSetpointCommand(HANumeric number, HANumber* sender) {
+    if (!number.isSet()) {
+        return;
     }
-    sender->setState(number); // report the selected option back to the HA panel
-}
-
-void setWWSoll2 (HANumeric number, HANumber* sender) {
-    if (number.isSet()) {
-        float val = number.toFloat();
-        vitoWIFI.write(setTempWWsoll2, val);
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        if (vitoDpTable[i].entity == sender) {
+            vitoOptoWrite(i, number.toFloat(), VITO_WRITE_PRIO_NORMAL, millis());
+            break;
+        }
     }
-    sender->setState(number); // report the selected option back to the HA panel
+    // the state is reported back after the read-back confirms it (Vitocal_writequeue.h)
 }
 
 void onTargetTemperatureCommand(HANumeric temperature, HAHVAC* sender) {
-    float val = temperature.toFloat();
-    vitoWIFI.write(setTempRaumSoll, val);
-
-    sender->setTargetTemperature(temperature); // report target temperature back to the HA panel
+    if (temperature.isSet()) {
+        vitoOptoWrite(DP_RAUM_SOLL, temperature.toFloat(), VITO_WRITE_PRIO_NORMAL, millis());
+    }
+    // target temperature follows RaumSollTemp once the write is read back
 }
 
 void onPowerCommand(bool state, HAHVAC* sender) {
@@ -406,27 +375,169 @@ void onModeCommand(HAHVAC::Mode mode, HAHVAC* sender) {
 void onManualModeCommand(int8_t index, HASelect* sender)
 {
     switch (index) {
-    case 0:
-        // Option "Normal" was selected
-        vitoWIFI.write(setManualMode, static_cast<uint8_t>(index));
-        break;
-
-    case 1:
-        // Option "Manueller Heizbetrieb" was selected
-        vitoWIFI.write(setManualMode, static_cast<uint8_t>(index));
-        break;
-
-    case 2:
-        // Option "1x WW auf Temp2" was selected
-        vitoWIFI.write(setManualMode, static_cast<uint8_t>(index));
+    case 0:   // Option "Normal" was selected
+    case 1:   // Option "Manueller Heizbetrieb" was selected
+    case 2:   // Option "1x WW auf Temp2" was selected
+        vitoOptoWrite(DP_MANUAL_MODE, (float)index, VITO_WRITE_PRIO_HIGH, millis());
         break;
 
     default:
         // unknown option
         return;
     }
+    // the selection is reported back after the read-back (onManualMode hook)
+}
 
-    sender->setState(index); // report the selected option back to the HA panel
+// Effective poll period per datapoint in s (adaptive polling), retained JSON
+// on <data prefix>/<HA_PREFIX>poll_intervals, plus the boost state.
+void publishPollIntervals() {
+    static char topic[64];
+    static char payload[VITO_ADAPT_JSON_MAX];
+    vitoPollBoostSens.setState(vitoAdaptBoosting(millis()));
+    if (!mqtt.isConnected() || vitoAdaptIntervalsJson(payload, sizeof(payload)) == 0) {
+        return;
+    }
+    snprintf(topic, sizeof(topic), "%s/%spoll_intervals", MQTT_DATAPREFIX, HA_PREFIX);
+    mqtt.publish(topic, payload, true);
+}
+
+// Publishes held back by the publish policy since boot
+void publishSuppressedCount() {
+    vitoSuppressedSens.setValue(vitoSuppressedCount);
+}
+
+// Loop profiler (Vitocal_profiler.h): worst iteration of the last minute, stalls
+void publishLoopProfile() {
+    vitoLoopMaxSens.setValue((float)vitoProfTakeWindowMax() / 1000.0f);
+    vitoLoopStallsSens.setValue(vitoStallCount);
+    vitoLastStallSens.setValue(vitoLastStallText());
+}
+
+// Store-and-forward queue (Vitocal_mqttqueue.h): updates waiting for replay
+void publishMqttQueue() {
+    vitoMqDepthSens.setValue(vitoMqCount);
+}
+
+// Circuit breakers (Vitocal_breaker.h): datapoints not read at the moment
+void publishQuarantined() {
+    vitoQuarantineSens.setValue(vitoBreakersOpen);
+}
+
+// Derived figures (Vitocal_aggregate.h), every VITO_AGG_PUBLISH_S; an output
+// without data yet is left alone.
+void publishAggregates() {
+    vitoAggUpdate(millis());
+    for (uint8_t i = 0; i < VITO_AGG_OUTPUTS; ++i) {
+        const VitoAggOutput& o = vitoAggOutputs[i];
+        float v;
+        if (vitoAggStatValue(o.channel, o.stat, v)) {
+            o.entity->setValue(v);
+        }
+    }
+}
+
+// Discovery (Vitocal_discovery.h), loop() after mqtt.loop(): a few entities
+// per call; the batched ones get their config from publishBatches() instead.
+static bool vitoDiscBatched(const HABaseDeviceType* entity) {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        if (vitoDpTable[i].entity == entity) {
+            return vitoBatchMember(i);
+        }
+    }
+    return false;
+}
+
+// An unchanged HASensor config was skipped: put its text back, ArduinoHA
+// keeps no copy of it.
+static void vitoDiscRestate(HABaseDeviceType* entity) {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        if (vitoDpTable[i].entity == entity) {
+            if (vitoDpTable[i].kind == VitoDpKind::Label && vitoValHas(i)) {
+                vitoPublishEntry(vitoDpTable[i], vitoValGet(i), true);
+            }
+            return;
+        }
+    }
+    if (entity == &vitoLastStallSens) {
+        vitoLastStallSens.setValue(vitoLastStallText());
+    } else if (entity == &vitoWriteStatusSens && vitoWriteStatusText[0]) {
+        vitoWriteStatusSens.setValue(vitoWriteStatusText);
+    }
+}
+
+void publishDiscovery() {
+    vitoDiscService(mqtt.isConnected(), millis(), vitoDiscBatched, vitoDiscRestate);
+    vitoDiscPersist();
+}
+
+// Batched state (Vitocal_mqttbatch.h), loop() after mqtt.loop(): a due class
+// document, and one discovery config per call after a connect.
+static uint8_t vitoBatchConfigNext = DP_COUNT;
+
+void publishBatches() {
+#if VITO_MQTT_BATCH
+    static char topic[128];
+    static char stateTopic[64];
+    static char availability[64];
+    static char payload[VITO_BATCH_DOC_MAX];
+    if (!mqtt.isConnected()) {
+        return;
+    }
+    uint32_t now = millis();
+    uint8_t cls = vitoBatchDue(now);
+    if (cls != VITO_CLASS_COUNT) {
+        snprintf(topic, sizeof(topic), "%s/%sstate/%s", MQTT_DATAPREFIX, HA_PREFIX, vitoBatchClassNames[cls]);
+        size_t len = vitoBatchJson(cls, vitoDpTable, payload, sizeof(payload));
+        if (len == 0) {
+            vitoBatchSkip(cls);
+        } else if (mqtt.publish(topic, payload, false)) {
+            vitoBatchSent(cls, len);
+        }
+    }
+    // in place of ArduinoHA's configs (publishDiscovery() passes over these
+    // entities): the same entities, state from the class document
+    while (vitoBatchConfigNext < DP_COUNT && !vitoBatchMember(vitoBatchConfigNext)) {
+        vitoBatchConfigNext++;
+    }
+    if (vitoBatchConfigNext < DP_COUNT) {
+        uint8_t id = vitoBatchConfigNext;
+        const VitoDpEntry& e = vitoDpTable[id];
+        bool binary = e.kind == VitoDpKind::Binary;
+        snprintf(stateTopic, sizeof(stateTopic), "%s/%sstate/%s", MQTT_DATAPREFIX, HA_PREFIX,
+                 vitoBatchClassNames[vitoDpSpecs[id].cls]);
+        snprintf(availability, sizeof(availability), "%s/%s/avty_t", MQTT_DATAPREFIX, device.getUniqueId());
+        snprintf(topic, sizeof(topic), "%s/%s/%s/%s/config", MQTT_DISCOVERYPREFIX,
+                 binary ? "binary_sensor" : "sensor", device.getUniqueId(),
+                 e.entity->uniqueId());
+        if (vitoBatchConfig(id, binary, vitoDpHaMeta[id], e.entity->uniqueId(), stateTopic, availability,
+                            device.getUniqueId(), payload, sizeof(payload))) {
+            uint32_t key = vitoDiscId(e.entity->uniqueId());
+            uint32_t config = vitoDiscFnv(vitoDiscFnv(vitoDiscSalt, topic), payload);
+            if (vitoDiscKnown(key, config)) {
+                vitoDiscSkipped++;
+                vitoBatchConfigNext++;
+            } else if (mqtt.publish(topic, payload, true)) {
+                vitoDiscRemember(key, config);
+                vitoDiscSent++;
+                vitoBatchConfigNext++;
+            }
+        }
+    }
+#endif
+}
+
+// loop(), after mqtt.loop(): replay at most one queued update, save the queue.
+void replayMqttQueue() {
+    static char topic[64];
+    static char payload[128];
+    uint32_t now = millis();
+    if (mqtt.isConnected() && vitoMqNextReplay(now, payload, sizeof(payload))) {
+        snprintf(topic, sizeof(topic), "%s/%sreplay", MQTT_DATAPREFIX, HA_PREFIX);
+        if (mqtt.publish(topic, payload, false)) {
+            vitoMqReplayedOne(now);
+        }
+    }
+    vitoMqPersist(now);
 }
 
 void onMQTTMessage(const char* topic, const uint8_t* payload, uint16_t length) {
@@ -440,8 +551,19 @@ void onMQTTConnected() {
     // Publish initial states for HA "Number" entities.
     // If setState() runs before MQTT is connected, ArduinoHA may not publish it later,
     // which makes the value appear empty/unknown in Home Assistant.
-    fastPollInterval.setState((float)(vitoFastState.intervalMs / 1000UL));
-    mediumPollInterval.setState((float)(vitoMediumState.intervalMs / 1000UL));
-    slowPollInterval.setState((float)(vitoSlowState.intervalMs / 1000UL));
+    fastPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_FAST].intervalMs / 1000UL));
+    mediumPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_MEDIUM].intervalMs / 1000UL));
+    slowPollInterval.setState((float)(vitoPollClasses[VITO_CLASS_SLOW].intervalMs / 1000UL));
     errorThresholdNumber.setState((float)vitoErrorThreshold);
+    vitoProtocolSens.setValue(vitoWIFI.protocolName());
+
+    // replay what was queued during the outage, after discovery has gone out
+    vitoMqOnConnected(millis());
+
+    // discovery goes out from loop(), a few entities at a time
+    vitoDiscOnConnected(millis());
+
+    // batched state: repoint the entities, then resend the class documents
+    vitoBatchConfigNext = 0;
+    vitoBatchOnConnected(millis());
 }
@@ -0,0 +1,301 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Circuit breakers and Optolink link recovery
+//
+// A datapoint whose reads keep failing while the link itself works (e.g. an
+// address this controller does not support) must neither eat the Optolink
+// time of the others nor reset the link. Every polled datapoint and every
+// LittleFS definition has a breaker:
+//   closed     read as scheduled; VITO_BREAKER_FAILS failures in a row open it
+//   open       quarantined, not read until openUntilMs; the quarantine starts
+//              at VITO_BREAKER_BASE_MS and doubles per trip up to _MAX_MS
+//   half-open  quarantine over: the next read is a probe, success closes the
+//              breaker, failure opens it again for twice as long
+// A block read fails as a whole, so a failing multi-member block is split
+// first: its members are planned as single reads (vitoBlockSolo) and each
+// gets its own breaker. A member goes back into a block once it has read
+// successfully, so only the faulty address stays on its own.
+//
+// Only a failure right after a successful read is held against the
+// datapoint. It is followed by a probe: one read of the datapoint that
+// answered last. If the probe answers too, the next failure of the datapoint
+// counts again; if it fails, the link is blamed (as after
+// VITO_LINK_SUSPECT_UNITS different datapoints or vitoErrorThreshold errors
+// in a row) and the link recovery starts:
+//
+//   OK --suspect--> REINIT --VITO_LINK_REINIT_MS--> HOLD --backoff--> PROBING
+//   PROBING --first success--> OK        PROBING --suspect--> REINIT
+//
+// REINIT stops VitoWiFi, HOLD has restarted it and keeps polling paused
+// (VITO_LINK_HOLD_MIN_MS doubling to _MAX_MS per failed recovery). The poll
+// intervals are left alone. The VitoWiFi callbacks only record results;
+// vitoLinkService() runs the transitions from loop().
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_blockread.h"
+#include "Vitocal_protocol.h"
+#include "Vitocal_log.h"
+
+#ifndef VITO_BREAKER_FAILS
+#define VITO_BREAKER_FAILS 3                // failures in a row that open a breaker
+#endif
+#ifndef VITO_BREAKER_BASE_MS
+#define VITO_BREAKER_BASE_MS 60000UL        // first quarantine
+#endif
+#ifndef VITO_BREAKER_MAX_MS
+#define VITO_BREAKER_MAX_MS 3600000UL       // longest quarantine
+#endif
+#ifndef VITO_LINK_SUSPECT_UNITS
+#define VITO_LINK_SUSPECT_UNITS 3           // different datapoints failing in a row
+#endif
+#ifndef VITO_LINK_REINIT_MS
+#define VITO_LINK_REINIT_MS 200UL           // VitoWiFi stopped before the restart
+#endif
+#ifndef VITO_LINK_HOLD_MIN_MS
+#define VITO_LINK_HOLD_MIN_MS 2000UL
+#endif
+#ifndef VITO_LINK_HOLD_MAX_MS
+#define VITO_LINK_HOLD_MAX_MS 32000UL
+#endif
+
+extern volatile uint32_t vitoErrorThreshold;   // errors in a row, configurable via HA
+
+enum VitoBreakerEvent : uint8_t { VITO_BREAKER_CLOSED = 0, VITO_BREAKER_OPENED, VITO_BREAKER_SPLIT };
+
+struct VitoBreaker {            // 12 bytes
+    uint32_t openUntilMs;       // 0 = closed; in the past = half-open
+    uint32_t lostMs;            // Optolink time spent on failed reads
+    uint8_t  fails;             // failures in a row
+    uint8_t  trips;             // quarantines in a row, backoff exponent
+    uint16_t quarantines;       // since boot
+};
+
+// Polled datapoints, indexed by VitoDpId (LittleFS definitions: VitoDefState)
+static VitoBreaker vitoDpBreakers[DP_COUNT];
+static uint8_t     vitoBreakersOpen   = 0;   // open right now, all breakers
+static uint64_t    vitoBreakerLostMs  = 0;   // all failed reads since boot
+
+inline bool vitoBreakerOpen(const VitoBreaker& b, uint32_t now) {
+    return b.openUntilMs != 0 && (int32_t)(b.openUntilMs - now) > 0;
+}
+
+// Successful read. Returns true if the breaker was open or half-open.
+inline bool vitoBreakerOnSuccess(VitoBreaker& b) {
+    bool wasOpen = b.openUntilMs != 0;
+    if (wasOpen && vitoBreakersOpen) {
+        vitoBreakersOpen--;
+    }
+    b.openUntilMs = 0;
+    b.fails = 0;
+    b.trips = 0;
+    return wasOpen;
+}
+
+// Failed read that took lostMs of link time; count = false if the failure is
+// blamed on the link. Returns true if the breaker (re)opened.
+inline bool vitoBreakerOnFailure(VitoBreaker& b, uint32_t now, uint32_t lostMs, bool count) {
+    b.lostMs += lostMs;
+    if (!count) {
+        return false;
+    }
+    bool halfOpen = b.openUntilMs != 0;
+    if (!halfOpen && ++b.fails < VITO_BREAKER_FAILS) {
+        return false;
+    }
+    uint32_t quarantine = VITO_BREAKER_BASE_MS;
+    for (uint8_t i = 0; i < b.trips && quarantine < VITO_BREAKER_MAX_MS; ++i) {
+        quarantine *= 2;
+    }
+    if (quarantine > VITO_BREAKER_MAX_MS) {
+        quarantine = VITO_BREAKER_MAX_MS;
+    }
+    if (!halfOpen) {
+        vitoBreakersOpen++;
+    }
+    b.openUntilMs = (now + quarantine) | 1;
+    b.fails = 0;
+    if (b.trips < 0xFF) b.trips++;
+    b.quarantines++;
+    return true;
+}
+
+// --- link recovery ---------------------------------------------------------
+enum VitoLinkState : uint8_t { VITO_LINK_OK = 0, VITO_LINK_REINIT, VITO_LINK_HOLD, VITO_LINK_PROBING };
+
+static const char* const vitoLinkStateNames[] = {"ok", "reinit", "hold", "probing"};
+
+static uint8_t  vitoLinkState       = VITO_LINK_OK;
+static uint32_t vitoLinkSinceMs     = 0;
+static uint32_t vitoLinkHoldMs      = VITO_LINK_HOLD_MIN_MS;
+static bool     vitoLinkSuspect     = false;   // set by the error callback, acted on in loop()
+static uint32_t vitoLinkErrorsInRow = 0;       // errors since the last success
+static uint32_t vitoLinkFirstErrorMs = 0;      // first of them
+static uint32_t vitoLinkDownMs      = 0;       // first error before the current recovery
+static uint16_t vitoLinkFailUnits[VITO_LINK_SUSPECT_UNITS];   // different units among them
+static uint8_t  vitoLinkFailUnitCount = 0;
+static uint8_t  vitoLinkProbeDp     = VITO_DP_NONE;   // answered last
+static bool     vitoLinkProbePending = false;         // read vitoLinkProbeDp next
+static bool     vitoLinkProbeInFlight = false;
+
+// statistics (GET /metrics)
+static uint32_t vitoLinkRecoveries      = 0;
+static uint32_t vitoLinkLastRecoveryMs  = 0;   // first error -> first success again
+static uint64_t vitoLinkRecoveryTotalMs = 0;
+
+// Unit of a failed read: a datapoint ID (a block by its first member) or
+// 0x100 + index of a LittleFS definition.
+#define VITO_LINK_UNIT_DEF 0x100
+
+// Error callback: may the failure be held against unit? Only the first
+// error after a success, while the link is not suspect or being recovered.
+inline bool vitoLinkOnError(uint16_t unit, uint32_t now) {
+    bool probe = vitoLinkProbeInFlight;
+    vitoLinkProbeInFlight = false;
+    vitoLinkProbePending  = false;
+    if (vitoLinkErrorsInRow++ == 0) {
+        vitoLinkFirstErrorMs = now;
+    }
+    bool known = false;
+    for (uint8_t i = 0; i < vitoLinkFailUnitCount; ++i) {
+        known |= vitoLinkFailUnits[i] == unit;
+    }
+    if (!known && vitoLinkFailUnitCount < VITO_LINK_SUSPECT_UNITS) {
+        vitoLinkFailUnits[vitoLinkFailUnitCount++] = unit;
+    }
+    if (probe || vitoLinkState == VITO_LINK_PROBING || vitoLinkFailUnitCount >= VITO_LINK_SUSPECT_UNITS ||
+        vitoLinkErrorsInRow >= vitoErrorThreshold) {
+        vitoLinkSuspect = true;
+    }
+    bool count = !vitoLinkSuspect && vitoLinkState == VITO_LINK_OK && vitoLinkErrorsInRow == 1;
+    vitoLinkProbePending = count && vitoLinkProbeDp != VITO_DP_NONE;
+    return count;
+}
+
+// Response callback: the link works; ends a recovery.
+inline void vitoLinkOnSuccess(uint32_t now) {
+    if (vitoLinkState == VITO_LINK_PROBING) {
+        vitoLinkLastRecoveryMs   = now - vitoLinkDownMs;
+        vitoLinkRecoveryTotalMs += vitoLinkLastRecoveryMs;
+        vitoLinkRecoveries++;
+        vitoLinkHoldMs = VITO_LINK_HOLD_MIN_MS;
+        vitoLinkState  = VITO_LINK_OK;
+        vitoLog(VITO_LOG_INFO, VITO_EV_LINK_UP, VITO_DP_NONE, 0, 0, vitoLinkLastRecoveryMs);
+    }
+    vitoLinkErrorsInRow   = 0;
+    vitoLinkFailUnitCount = 0;
+    vitoLinkSuspect       = false;
+    vitoLinkProbePending  = false;
+    vitoLinkProbeInFlight = false;
+}
+
+// loop(), before polling; never blocks. Returns true if requests may be queued.
+inline bool vitoLinkService(VitoOptolink& link, uint32_t now) {
+    switch (vitoLinkState) {
+    case VITO_LINK_OK:
+    case VITO_LINK_PROBING:
+        if (!vitoLinkSuspect) {
+            return true;
+        }
+        if (vitoLinkState == VITO_LINK_OK) {
+            vitoLinkDownMs = vitoLinkFirstErrorMs;
+        } else {
+            vitoLinkHoldMs = vitoLinkHoldMs * 2 > VITO_LINK_HOLD_MAX_MS ? VITO_LINK_HOLD_MAX_MS
+                                                                        : vitoLinkHoldMs * 2;
+        }
+        vitoLog(VITO_LOG_ERROR, VITO_EV_BACKOFF, VITO_DP_NONE, 0, VITO_LINK_REINIT_MS + vitoLinkHoldMs,
+                vitoLinkErrorsInRow);
+        vitoLinkSuspect       = false;
+        vitoLinkErrorsInRow   = 0;
+        vitoLinkFailUnitCount = 0;
+        link.end();
+        vitoLinkState   = VITO_LINK_REINIT;
+        vitoLinkSinceMs = now;
+        return false;
+    case VITO_LINK_REINIT:
+        if (now - vitoLinkSinceMs >= VITO_LINK_REINIT_MS) {
+            link.begin();
+            vitoLinkState   = VITO_LINK_HOLD;
+            vitoLinkSinceMs = now;
+        }
+        return false;
+    case VITO_LINK_HOLD:
+        if (now - vitoLinkSinceMs < vitoLinkHoldMs) {
+            return false;
+        }
+        vitoLinkState   = VITO_LINK_PROBING;
+        vitoLinkSinceMs = now;
+        return true;
+    default:
+        return true;
+    }
+}
+
+// --- polled datapoints -------------------------------------------------------
+// A block is not read while one of its members is quarantined.
+inline bool vitoBlockQuarantined(uint8_t b, uint32_t now) {
+    const VitoBlock& blk = vitoBlocks[b];
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        if (vitoBreakerOpen(vitoDpBreakers[vitoBlockMembers[blk.first + i]], now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Datapoint id read successfully; a split member goes back into its block.
+inline void vitoBreakerDpSuccess(uint8_t id) {
+    vitoLinkProbeDp = id;
+    if (vitoBreakerOnSuccess(vitoDpBreakers[id])) {
+        vitoLog(VITO_LOG_INFO, VITO_EV_BREAKER, id, 0, VITO_BREAKER_CLOSED, 0);
+    }
+    if (vitoBlockSolo[id]) {
+        vitoBlockSolo[id] = false;
+        vitoBlockReplan   = true;
+    }
+}
+
+// Datapoint id failed after lostMs on the link (count: see vitoLinkOnError).
+inline void vitoBreakerDpFailure(uint8_t id, uint32_t now, uint32_t lostMs, bool count) {
+    VitoBreaker& b = vitoDpBreakers[id];
+    vitoBreakerLostMs += lostMs;
+    if (vitoBreakerOnFailure(b, now, lostMs, count)) {
+        vitoLog(VITO_LOG_ERROR, VITO_EV_BREAKER, id, 0, VITO_BREAKER_OPENED, b.openUntilMs - now);
+    }
+}
+
+inline void vitoBreakerBlockSuccess(uint8_t b) {
+    const VitoBlock& blk = vitoBlocks[b];
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        vitoBreakerDpSuccess(vitoBlockMembers[blk.first + i]);
+    }
+}
+
+// Multi-member block b failed after lostMs on the link. It is split once a
+// member reaches VITO_BREAKER_FAILS, without quarantining anyone yet; the
+// lost time is shared among the members.
+inline void vitoBreakerBlockFailure(uint8_t b, uint32_t lostMs, bool count) {
+    const VitoBlock& blk = vitoBlocks[b];
+    vitoBreakerLostMs += lostMs;
+    bool split = false;
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        VitoBreaker& br = vitoDpBreakers[vitoBlockMembers[blk.first + i]];
+        br.lostMs += lostMs / blk.count;
+        if (count && ++br.fails >= VITO_BREAKER_FAILS) {
+            split = true;
+        }
+    }
+    if (!split) {
+        return;
+    }
+    for (uint8_t i = 0; i < blk.count; ++i) {
+        uint8_t id = vitoBlockMembers[blk.first + i];
+        vitoDpBreakers[id].fails = 0;
+        vitoBlockSolo[id] = true;
+    }
+    vitoBlockReplan = true;
+    vitoLog(VITO_LOG_INFO, VITO_EV_BREAKER, vitoBlockMembers[blk.first], 0, VITO_BREAKER_SPLIT, 0);
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Optolink traffic capture
+//
+// VitoCaptureSerial sits between VitoWiFi and the Optolink UART. While a
+// capture runs it records every byte VitoWiFi writes (TX) and reads (RX),
+// with the requests VitoOptolink hands to the protocol (Vitocal_protocol.h),
+// into a RAM ring. GET /capture downloads it as a trace file; the host build
+// replays a trace through the same VitoWiFi parser and onVitoResponse()
+// (host/bench/trace_replay.cpp), for regression tests and benchmarks.
+//
+// RX is recorded when VitoWiFi reads it, not when it arrives on the wire, so
+// a replay can hand the parser the same bytes at the same points of its
+// state machine. A request is recorded after the protocol took it, behind
+// the bytes it already moved; a CALL before it marks where the parser was
+// idle. A full ring drops its oldest records; a replay starts at the first
+// BEGIN, or CALL of an accepted request, that is left.
+//
+// Trace file, little endian:
+//   header   "VOT1", version, protocol (VitoProtocol), flags, 0,
+//            start (micros() the first delta counts from), record bytes
+//   record   kind << 6 | n (n = 1..63 payload bytes), µs since the previous
+//            record (LEB128), payload
+//     TX/RX  the bytes; bytes of one direction less than VITO_CAP_MERGE_US
+//            apart share a record
+//     EVENT  type, then BEGIN: protocol; READ: addr hi, addr lo, length;
+//            WRITE: addr hi, addr lo, length, data; END, CALL: nothing
+//
+// POST /capture?run=1 clears the ring and starts, ?run=0 stops. With
+// VITO_CAP_BOOT 1 setup() starts it before the protocol detection.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef VITO_CAPTURE
+#define VITO_CAPTURE 1                 // 0: VitoCaptureSerial is a plain HardwareSerial
+#endif
+#ifndef VITO_CAP_BYTES
+#define VITO_CAP_BYTES (VITO_CAPTURE ? 16384 : 64)   // RAM ring, power of two
+#endif
+#ifndef VITO_CAP_MERGE_US
+#define VITO_CAP_MERGE_US 5000UL       // two byte times at 4800 baud
+#endif
+#ifndef VITO_CAP_BOOT
+#define VITO_CAP_BOOT 0                // 1: capture from setup() on
+#endif
+
+static_assert((VITO_CAP_BYTES & (VITO_CAP_BYTES - 1)) == 0, "VITO_CAP_BYTES must be a power of two");
+
+#define VITO_CAP_MAGIC        0x31544F56UL   // "VOT1"
+#define VITO_CAP_VERSION      1
+#define VITO_CAP_HEADER       16
+#define VITO_CAP_MAX_N        63             // payload bytes per record
+#define VITO_CAP_FLAG_WRAPPED 0x01           // the ring dropped records
+#define VITO_CAP_NONE         UINT32_MAX
+
+enum VitoCapKind : uint8_t {
+    VITO_CAP_TX = 0,
+    VITO_CAP_RX,
+    VITO_CAP_EVENT
+};
+
+enum VitoCapEventType : uint8_t {
+    VITO_CAP_EV_BEGIN = 1,
+    VITO_CAP_EV_READ,
+    VITO_CAP_EV_WRITE,
+    VITO_CAP_EV_END,
+    VITO_CAP_EV_CALL
+};
+
+static uint8_t           vitoCapRing[VITO_CAP_BYTES];
+static uint32_t          vitoCapHead     = 0;               // running byte counts, ring index & (size - 1)
+static uint32_t          vitoCapTail     = 0;               // first byte of the oldest record
+static uint32_t          vitoCapOpen     = VITO_CAP_NONE;   // newest record, still takes bytes
+static uint8_t           vitoCapOpenKind = VITO_CAP_EVENT;
+static uint32_t          vitoCapLastUs   = 0;               // start of the newest record
+static uint32_t          vitoCapByteUs   = 0;               // last byte of the newest record
+static uint32_t          vitoCapBaseUs   = 0;               // the oldest record's delta counts from here
+static uint32_t          vitoCapGen      = 0;               // bumped by every start
+static uint32_t          vitoCapStartMs  = 0;
+static uint8_t           vitoCapProtocol = 0;               // VitoProtocol of the last begin()
+// since the start
+static uint32_t          vitoCapRecords  = 0;
+static uint32_t          vitoCapDropped  = 0;               // records the full ring gave up
+static uint32_t          vitoCapBytes[3] = {0, 0, 0};       // payload by VitoCapKind
+static std::atomic<bool> vitoCapRunning{false};
+static std::mutex        vitoCapLock;                       // Optolink task vs. async_tcp (start, stop, download)
+
+// --- ring (vitoCapLock held) ------------------------------------------------------------
+inline uint8_t& vitoCapAt(uint32_t pos) {
+    return vitoCapRing[pos & (VITO_CAP_BYTES - 1)];
+}
+
+inline void vitoCapDropOldest() {
+    uint32_t p = vitoCapTail;
+    uint8_t n = vitoCapAt(p++) & VITO_CAP_MAX_N;
+    uint32_t dt = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        uint8_t b = vitoCapAt(p++);
+        dt |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            break;
+        }
+    }
+    if (vitoCapOpen == vitoCapTail) {
+        vitoCapOpen = VITO_CAP_NONE;
+    }
+    vitoCapTail = p + n;
+    vitoCapBaseUs += dt;
+    vitoCapDropped++;
+}
+
+// Room for bytes more, at the cost of the oldest records.
+inline void vitoCapReserve(uint32_t bytes) {
+    while (vitoCapHead - vitoCapTail + bytes > VITO_CAP_BYTES) {
+        vitoCapDropOldest();
+    }
+}
+
+inline void vitoCapRecord(uint8_t kind, const uint8_t* data, uint8_t n, uint32_t us) {
+    vitoCapReserve(1 + 5 + n);
+    vitoCapOpen = vitoCapHead;
+    vitoCapOpenKind = kind;
+    vitoCapAt(vitoCapHead++) = (uint8_t)(kind << 6 | n);
+    uint32_t dt = us - vitoCapLastUs;
+    do {
+        uint8_t b = dt & 0x7F;
+        dt >>= 7;
+        vitoCapAt(vitoCapHead++) = dt ? (b | 0x80) : b;
+    } while (dt);
+    for (uint8_t i = 0; i < n; ++i) {
+        vitoCapAt(vitoCapHead++) = data[i];
+    }
+    vitoCapLastUs = us;
+    vitoCapByteUs = us;
+    vitoCapRecords++;
+    vitoCapBytes[kind] += n;
+}
+
+// --- Optolink task ------------------------------------------------------------------------
+// Bytes VitoWiFi wrote (VITO_CAP_TX) or read (VITO_CAP_RX).
+inline void vitoCapTraffic(uint8_t kind, const uint8_t* data, size_t len) {
+    if (!vitoCapRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    uint32_t us = micros();
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    if (!vitoCapRunning) {
+        return;   // stopped meanwhile
+    }
+    while (len > 0) {
+        uint8_t room = 0;
+        if (vitoCapOpen != VITO_CAP_NONE && vitoCapOpenKind == kind && us - vitoCapByteUs < VITO_CAP_MERGE_US) {
+            room = VITO_CAP_MAX_N - (vitoCapAt(vitoCapOpen) & VITO_CAP_MAX_N);
+        }
+        uint8_t n = len < room ? (uint8_t)len : room;
+        if (n > 0) {
+            vitoCapReserve(n);
+        }
+        if (n > 0 && vitoCapOpen != VITO_CAP_NONE) {
+            vitoCapAt(vitoCapOpen) += n;
+            for (uint8_t i = 0; i < n; ++i) {
+                vitoCapAt(vitoCapHead++) = data[i];
+            }
+            vitoCapByteUs = us;
+            vitoCapBytes[kind] += n;
+        } else {
+            n = len < VITO_CAP_MAX_N ? (uint8_t)len : VITO_CAP_MAX_N;
+            vitoCapRecord(kind, data, n, us);
+        }
+        data += n;
+        len  -= n;
+    }
+}
+
+inline void vitoCapEvent(const uint8_t* payload, uint8_t n) {
+    if (!vitoCapRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    uint32_t us = micros();
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    if (vitoCapRunning) {
+        vitoCapRecord(VITO_CAP_EVENT, payload, n, us);
+    }
+}
+
+// VitoOptolink::begin() / end()
+inline void vitoCapBegin(uint8_t protocol) {
+    {
+        std::lock_guard<std::mutex> lock(vitoCapLock);
+        vitoCapProtocol = protocol;
+    }
+    const uint8_t ev[] = {VITO_CAP_EV_BEGIN, protocol};
+    vitoCapEvent(ev, sizeof(ev));
+}
+
+inline void vitoCapEnd() {
+    const uint8_t ev[] = {VITO_CAP_EV_END};
+    vitoCapEvent(ev, sizeof(ev));
+}
+
+// VitoOptolink::read() / write(), before the protocol sees the request.
+inline void vitoCapCall() {
+    const uint8_t ev[] = {VITO_CAP_EV_CALL};
+    vitoCapEvent(ev, sizeof(ev));
+}
+
+// A request the protocol accepted; data is the encoded value of a write.
+inline void vitoCapRequest(uint16_t address, uint8_t length, const uint8_t* data, uint8_t n) {
+    uint8_t ev[4 + VITO_CAP_MAX_N];
+    if (n > VITO_CAP_MAX_N - 4) {
+        n = VITO_CAP_MAX_N - 4;
+    }
+    ev[0] = data ? VITO_CAP_EV_WRITE : VITO_CAP_EV_READ;
+    ev[1] = (uint8_t)(address >> 8);
+    ev[2] = (uint8_t)(address & 0xFF);
+    ev[3] = length;
+    if (data) {
+        memcpy(&ev[4], data, n);
+    }
+    vitoCapEvent(ev, 4 + (data ? n : 0));
+}
+
+// --- control (any task) ------------------------------------------------------------------
+// Empty ring, recording from now on.
+inline void vitoCapStart() {
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    vitoCapHead = vitoCapTail = 0;
+    vitoCapOpen = VITO_CAP_NONE;
+    vitoCapBaseUs = vitoCapLastUs = micros();
+    vitoCapStartMs = millis() ? millis() : 1;
+    vitoCapRecords = vitoCapDropped = 0;
+    memset(vitoCapBytes, 0, sizeof(vitoCapBytes));
+    vitoCapGen++;
+    vitoCapRunning = VITO_CAPTURE != 0;
+}
+
+// The ring is kept for download.
+inline void vitoCapStop() {
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    vitoCapRunning = false;
+    vitoCapOpen = VITO_CAP_NONE;
+}
+
+// --- download (async_tcp task) -----------------------------------------------------------
+struct VitoCapCursor {
+    uint8_t  header[VITO_CAP_HEADER];
+    uint8_t  headerSent;
+    uint32_t gen;
+    uint32_t pos;   // next ring byte
+    uint32_t end;
+};
+
+inline void vitoCapPut32(uint8_t* p, uint32_t v) {
+    for (uint8_t i = 0; i < 4; ++i) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+// GET /capture: header and the records present now. The newest record is
+// closed, so nothing the cursor has to send grows meanwhile.
+inline void vitoCapCursorInit(VitoCapCursor& c) {
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    vitoCapOpen = VITO_CAP_NONE;
+    c.headerSent = 0;
+    c.gen = vitoCapGen;
+    c.pos = vitoCapTail;
+    c.end = vitoCapHead;
+    vitoCapPut32(&c.header[0], VITO_CAP_MAGIC);
+    c.header[4] = VITO_CAP_VERSION;
+    c.header[5] = vitoCapProtocol;
+    c.header[6] = vitoCapDropped ? VITO_CAP_FLAG_WRAPPED : 0;
+    c.header[7] = 0;
+    vitoCapPut32(&c.header[8], vitoCapBaseUs);
+    vitoCapPut32(&c.header[12], c.end - c.pos);
+}
+
+// Chunked response filler. Ends early if the ring has overwritten or a new
+// start has cleared what is left to send; the header's byte count then tells
+// the reader the trace is cut short.
+inline size_t vitoCapFill(VitoCapCursor& c, uint8_t* buf, size_t maxLen) {
+    size_t n = 0;
+    while (c.headerSent < VITO_CAP_HEADER && n < maxLen) {
+        buf[n++] = c.header[c.headerSent++];
+    }
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    if (c.gen != vitoCapGen || (int32_t)(c.pos - vitoCapTail) < 0) {
+        return n;
+    }
+    while (n < maxLen && c.pos != c.end) {
+        buf[n++] = vitoCapAt(c.pos++);
+    }
+    return n;
+}
+
+// GET /capture/stats
+inline const char* vitoCapStatsJson() {
+    static char buf[256];
+    std::lock_guard<std::mutex> lock(vitoCapLock);
+    snprintf(buf, sizeof(buf),
+             "{\"running\":%s,\"seconds\":%lu,\"bytes\":%lu,\"capacity\":%u,\"records\":%lu,\"dropped\":%lu,"
+             "\"tx\":%lu,\"rx\":%lu,\"events\":%lu}",
+             vitoCapRunning ? "true" : "false",
+             vitoCapStartMs ? (unsigned long)((millis() - vitoCapStartMs) / 1000) : 0UL,
+             (unsigned long)(vitoCapHead - vitoCapTail), (unsigned)VITO_CAP_BYTES, (unsigned long)vitoCapRecords,
+             (unsigned long)vitoCapDropped, (unsigned long)vitoCapBytes[VITO_CAP_TX],
+             (unsigned long)vitoCapBytes[VITO_CAP_RX], (unsigned long)vitoCapBytes[VITO_CAP_EVENT]);
+    return buf;
+}
+
+// --- tap -----------------------------------------------------------------------------------
+#if VITO_CAPTURE
+// The Optolink UART, seen by VitoWiFi through read() and write().
+class VitoCaptureSerial : public HardwareSerial {
+public:
+    explicit VitoCaptureSerial(int uartNr) : HardwareSerial(uartNr) {}
+
+    int read() override {
+        int c = HardwareSerial::read();
+        if (c >= 0) {
+            uint8_t b = (uint8_t)c;
+            vitoCapTraffic(VITO_CAP_RX, &b, 1);
+        }
+        return c;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        vitoCapTraffic(VITO_CAP_TX, buffer, size);
+        return HardwareSerial::write(buffer, size);
+    }
+
+    using HardwareSerial::write;
+};
+#else
+typedef HardwareSerial VitoCaptureSerial;
+#endif
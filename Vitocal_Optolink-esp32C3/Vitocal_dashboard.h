@@ -0,0 +1,59 @@
+#pragma once
+
+// Generated by scripts/gen_dashboard.py from scripts/live.html - do not edit.
+// Live datapoint page (GET /live), gzipped: 785 bytes, 1494 uncompressed.
+
+#include <Arduino.h>
+
+static const uint8_t vitoDashboardGz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x54, 0x4d, 0x8f, 0xdb, 0x36,
+    0x10, 0xbd, 0xfb, 0x57, 0x28, 0xde, 0x83, 0x24, 0x54, 0x92, 0xd7, 0x9b, 0x1c, 0x5c, 0x7d, 0xf8,
+    0x90, 0x74, 0x81, 0xa6, 0xc8, 0x07, 0x90, 0x04, 0xbd, 0x2c, 0x7c, 0xa0, 0xc5, 0x91, 0x4d, 0x84,
+    0x22, 0x05, 0x72, 0x24, 0xc7, 0x30, 0xfc, 0xdf, 0x3b, 0xa4, 0xe4, 0xad, 0x9d, 0x6d, 0x0a, 0x1d,
+    0x28, 0x52, 0xf3, 0x86, 0xef, 0xbd, 0x99, 0x51, 0xf9, 0x8a, 0xeb, 0x1a, 0x8f, 0x1d, 0x04, 0x7b,
+    0x6c, 0xe5, 0x7a, 0x56, 0xfa, 0xa5, 0xdc, 0x03, 0xe3, 0xeb, 0xb2, 0x05, 0x64, 0x41, 0xbd, 0x67,
+    0xc6, 0x02, 0x56, 0xf3, 0x1e, 0x9b, 0x74, 0x35, 0x9f, 0x4e, 0x15, 0x6b, 0xa1, 0x9a, 0x0f, 0x02,
+    0x0e, 0x9d, 0x36, 0x38, 0x0f, 0x6a, 0xad, 0x10, 0x14, 0x45, 0x1d, 0x04, 0xc7, 0x7d, 0xc5, 0x61,
+    0x10, 0x35, 0xa4, 0x7e, 0x93, 0x08, 0x25, 0x50, 0x30, 0x99, 0xda, 0x9a, 0x49, 0xa8, 0x96, 0x73,
+    0xba, 0x05, 0x05, 0x4a, 0x58, 0xff, 0x2d, 0x50, 0xd3, 0x59, 0x20, 0xc5, 0x00, 0xe5, 0x62, 0x3c,
+    0x9b, 0x95, 0x16, 0x8f, 0x6e, 0xdd, 0x6a, 0x7e, 0x3c, 0x35, 0x94, 0x36, 0x5f, 0xbe, 0xe9, 0x7e,
+    0x04, 0xf6, 0x68, 0x11, 0xda, 0xb4, 0x17, 0x89, 0x65, 0xca, 0xa6, 0x16, 0x8c, 0x68, 0x8a, 0x96,
+    0x99, 0x9d, 0x50, 0xf9, 0x12, 0xda, 0x62, 0xcb, 0xea, 0xef, 0x3b, 0xa3, 0x7b, 0xc5, 0xf3, 0xbb,
+    0x86, 0xb9, 0xe7, 0x3c, 0x43, 0xb6, 0x95, 0x70, 0xda, 0x6a, 0xc3, 0xc1, 0xa4, 0xb5, 0x96, 0x92,
+    0x75, 0x16, 0xf2, 0xcb, 0x4b, 0xd1, 0x0a, 0x35, 0x32, 0xcc, 0x1f, 0x1e, 0xa0, 0xa5, 0x70, 0x7e,
+    0xea, 0x18, 0xe7, 0x42, 0xed, 0xf2, 0x8c, 0x0e, 0x82, 0x6c, 0xe5, 0xf2, 0x8e, 0xe8, 0xad, 0x46,
+    0xd4, 0x6d, 0xbe, 0x74, 0x4c, 0xb4, 0x14, 0x3c, 0xb8, 0xe3, 0x9c, 0x3b, 0x48, 0x36, 0x9c, 0x10,
+    0x7e, 0x60, 0xca, 0xa4, 0xd8, 0xa9, 0xdc, 0x88, 0xdd, 0x1e, 0x0b, 0xc7, 0x3a, 0x1d, 0x98, 0x11,
+    0x8c, 0x56, 0xd5, 0xb7, 0xc4, 0xb5, 0xce, 0x89, 0x4c, 0x2f, 0x99, 0x71, 0x7b, 0xeb, 0x81, 0xec,
+    0x44, 0x4c, 0xb4, 0xc9, 0xef, 0x56, 0xab, 0x55, 0xf1, 0x73, 0x0e, 0x8a, 0x30, 0x59, 0x13, 0xf8,
+    0xfc, 0x37, 0xd2, 0x1a, 0xf8, 0x9d, 0xad, 0xce, 0xb3, 0x3b, 0x7b, 0x85, 0x3e, 0xcf, 0xca, 0xc5,
+    0xe8, 0x5a, 0xb9, 0x18, 0x2b, 0xe7, 0xcc, 0x73, 0xc5, 0x7c, 0x7d, 0xe3, 0x71, 0x50, 0xda, 0x96,
+    0x49, 0x19, 0x08, 0x5e, 0xcd, 0xed, 0x7c, 0x4d, 0x35, 0x53, 0x50, 0x23, 0xe9, 0x25, 0xb8, 0xfb,
+    0xe0, 0xe0, 0xaf, 0x5d, 0x75, 0x9c, 0x6f, 0x3e, 0x0a, 0xa9, 0xde, 0x0b, 0xbf, 0x75, 0x85, 0xa9,
+    0x8d, 0xe8, 0x70, 0x3d, 0x23, 0x65, 0xbe, 0xfe, 0xb6, 0x7a, 0xda, 0x24, 0x46, 0x1f, 0xfc, 0x6a,
+    0x01, 0x94, 0x5b, 0xb1, 0xa2, 0x86, 0x22, 0xc9, 0x0a, 0xb3, 0x1d, 0xe0, 0xa3, 0x04, 0xf7, 0xfa,
+    0xf6, 0xf8, 0x9e, 0x47, 0x21, 0x86, 0x71, 0x62, 0x7f, 0xfd, 0xd9, 0x86, 0x71, 0xe1, 0x73, 0x53,
+    0x62, 0x05, 0x87, 0xe0, 0x71, 0xa0, 0x4f, 0x5f, 0x75, 0x6f, 0x6a, 0x88, 0xc2, 0x05, 0xb8, 0x9d,
+    0x0f, 0x01, 0x9b, 0x69, 0xa5, 0x3b, 0xba, 0xae, 0xe9, 0x15, 0xd1, 0xd7, 0x2a, 0x8a, 0x4f, 0x36,
+    0x73, 0x0e, 0xbe, 0x9b, 0xba, 0x30, 0x9c, 0xa4, 0x01, 0x0f, 0xcf, 0x13, 0x00, 0x8c, 0xd1, 0xe6,
+    0x7f, 0x10, 0x06, 0xfe, 0xb5, 0x63, 0x02, 0x51, 0x2f, 0x78, 0x0e, 0x1f, 0x04, 0xb5, 0x1e, 0x25,
+    0x88, 0x42, 0xd7, 0xfa, 0x61, 0xf2, 0x9c, 0x04, 0xe2, 0xd3, 0x2c, 0x98, 0xac, 0xf8, 0xeb, 0xeb,
+    0xe7, 0x4f, 0x59, 0xe7, 0x46, 0x25, 0x82, 0x8c, 0x33, 0x64, 0x71, 0x81, 0x99, 0xa0, 0x8c, 0xe6,
+    0xcf, 0x6f, 0x1f, 0x3f, 0x54, 0x61, 0x58, 0x4c, 0x4e, 0x15, 0x17, 0x48, 0xd6, 0x68, 0xf3, 0xc8,
+    0xea, 0x7d, 0xf4, 0x9c, 0x4f, 0x25, 0x22, 0x3e, 0x39, 0x07, 0x4c, 0xe5, 0xb0, 0xd4, 0xe3, 0xf8,
+    0x45, 0x1f, 0xa2, 0xb8, 0x30, 0xd3, 0xee, 0x1d, 0x48, 0x19, 0xc5, 0x37, 0xc4, 0x95, 0xcb, 0x17,
+    0x04, 0x0e, 0x35, 0x54, 0xb7, 0x71, 0xc5, 0x90, 0xd5, 0x92, 0x59, 0xfb, 0xc9, 0xcd, 0x6a, 0x38,
+    0x84, 0x85, 0x0b, 0x62, 0x3f, 0x07, 0xb1, 0xeb, 0x20, 0x36, 0xd2, 0x7c, 0x12, 0x9b, 0xca, 0x14,
+    0x67, 0x32, 0xfb, 0x1c, 0xff, 0xc2, 0x8a, 0xe1, 0x85, 0x0f, 0x2e, 0x7b, 0xfb, 0x1f, 0x3e, 0x24,
+    0x4a, 0x1f, 0xaa, 0x3f, 0x18, 0x42, 0xa6, 0xbc, 0x18, 0x0a, 0x6d, 0x33, 0xfe, 0x52, 0x7d, 0x77,
+    0xd1, 0xee, 0x19, 0x74, 0x4f, 0xf7, 0x9b, 0x4d, 0x21, 0x9a, 0xe8, 0x95, 0x89, 0x0d, 0x60, 0x6f,
+    0x26, 0xa1, 0x26, 0xab, 0x89, 0xb7, 0x7d, 0x5a, 0x6e, 0x6e, 0x6c, 0xe8, 0xe8, 0xa0, 0x70, 0x3d,
+    0x38, 0x02, 0x2b, 0xba, 0x8a, 0x5c, 0xbb, 0x52, 0xd6, 0x84, 0x23, 0x9e, 0x7e, 0x65, 0xdf, 0x44,
+    0x0b, 0xba, 0xc7, 0xe8, 0xaa, 0x19, 0x6e, 0x42, 0xc3, 0x73, 0xf2, 0xe6, 0xfe, 0x3e, 0x7e, 0xd6,
+    0x4f, 0x90, 0xf7, 0x74, 0x8b, 0x19, 0x98, 0xbc, 0xc6, 0xf8, 0x31, 0xb8, 0x95, 0xe6, 0x98, 0xbf,
+    0x14, 0x66, 0x5c, 0x59, 0xe9, 0x72, 0x12, 0xe3, 0x19, 0x8a, 0x4d, 0x7c, 0x51, 0xf1, 0x70, 0xab,
+    0xe2, 0x23, 0xc3, 0x7d, 0xe6, 0x27, 0x3d, 0x8a, 0x28, 0x63, 0x7a, 0x09, 0x5f, 0x2c, 0xef, 0x89,
+    0xd0, 0x6f, 0x61, 0x60, 0x43, 0xc7, 0xea, 0x9c, 0xf8, 0x7d, 0xe1, 0xc6, 0x7e, 0x9c, 0xc9, 0x72,
+    0xe1, 0x27, 0x9e, 0xe6, 0xd7, 0xff, 0xc5, 0xff, 0x01, 0x93, 0x29, 0x5e, 0x64, 0xd6, 0x05, 0x00,
+    0x00,
+};
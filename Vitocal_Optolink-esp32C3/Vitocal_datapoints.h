@@ -1,50 +1,109 @@
 #pragma once
 
+// ---------------------------------------------------------------------------
+// Polled datapoints
+//
+// Everything about a datapoint that does not change at runtime (ID, name,
+// address, converter, poll class and period) comes from dpspec.toml through
+// scripts/gen_dpspec.py as constexpr tables in Vitocal_dpspec.h, so it stays
+// in flash. A VitoWiFi::Datapoint is built from its record when a request is
+// queued (vitoDpDatapoint), the same way block and LittleFS reads do it.
+// ---------------------------------------------------------------------------
+
 #include <VitoWiFi.h>
+#include <string.h>
+#include "Vitocal_registry.h"
+#include "Vitocal_polling.h"
+
+// Value converters of a datapoint record (dpspec.toml "conv", datapoints.csv)
+enum VitoDpConv : uint8_t { VITO_CONV_NOCONV = 0, VITO_CONV_DIV10, VITO_CONV_DIV2, VITO_CONV_DIV3600 };
+
+static const char* const vitoDpConvNames[] = {"noconv", "div10", "div2", "div3600"};
+
+inline const VitoWiFi::Converter& vitoDpConverter(uint8_t conv) {
+  switch (conv) {
+  case VITO_CONV_DIV10:   return VitoWiFi::div10;
+  case VITO_CONV_DIV2:    return VitoWiFi::div2;
+  case VITO_CONV_DIV3600: return VitoWiFi::div3600;
+  default:                return VitoWiFi::noconv;
+  }
+}
+
+static const uint8_t VITO_DP_WRITABLE = 0x01;   // HA can write it (Vitocal_writequeue.h)
+
+struct VitoDpSpec {              // 16 bytes per datapoint, flash
+  uint16_t address;
+  uint8_t  length;
+  uint8_t  conv;                 // VitoDpConv
+  uint8_t  cls;                  // VitoPollClass
+  uint8_t  flags;                // VITO_DP_*
+  uint32_t periodMs;             // target period at the class default interval
+  uint32_t maxAgeMs;             // age budget at the class default interval
+};
+
+#include "Vitocal_dpspec.h"
+
+// O(1): ID of a polled datapoint (or of VitoWiFi's copy of it), VITO_DP_NONE otherwise
+inline uint8_t vitoDpId(const VitoWiFi::Datapoint& dp) {
+  return vitoDpIndexOf(dp.name(), vitoDpNames, DP_COUNT, VITO_DP_NAME_LEN);
+}
+
+// ID of a datapoint by its name (HTTP parameters), VITO_DP_NONE if unknown
+inline uint8_t vitoDpIdByName(const char* name) {
+  for (uint8_t i = 0; i < DP_COUNT; ++i) {
+    if (strcmp(vitoDpNames[i], name) == 0) {
+      return i;
+    }
+  }
+  return VITO_DP_NONE;
+}
+
+// The datapoint of an ID, for read(), write() and the block planner
+inline VitoWiFi::Datapoint vitoDpDatapoint(uint8_t id) {
+  const VitoDpSpec& s = vitoDpSpecs[id];
+  return VitoWiFi::Datapoint(vitoDpNames[id], s.address, s.length, vitoDpConverter(s.conv));
+}
+
+// Set of polled datapoints, one bit per ID and sized from DP_COUNT: the flags
+// of the value store, the live stream and the MQTT batches. IDs must be below
+// DP_COUNT; not atomic, owned by loop() like the tables it indexes.
+#define VITO_DP_SET_WORDS ((DP_COUNT + 31) / 32)
+
+struct VitoDpSet {
+  uint32_t words[VITO_DP_SET_WORDS];
+};
+
+inline bool vitoDpSetHas(const VitoDpSet& s, uint8_t id) {
+  return (s.words[id / 32] & (1UL << (id % 32))) != 0;
+}
+
+inline void vitoDpSetAdd(VitoDpSet& s, uint8_t id) {
+  s.words[id / 32] |= 1UL << (id % 32);
+}
+
+inline void vitoDpSetRemove(VitoDpSet& s, uint8_t id) {
+  s.words[id / 32] &= ~(1UL << (id % 32));
+}
+
+inline void vitoDpSetClear(VitoDpSet& s) {
+  memset(s.words, 0, sizeof(s.words));
+}
+
+inline bool vitoDpSetEmpty(const VitoDpSet& s) {
+  for (uint8_t w = 0; w < VITO_DP_SET_WORDS; ++w) {
+    if (s.words[w]) {
+      return false;
+    }
+  }
+  return true;
+}
 
-// Temperatures (2 bytes, div10 -> float)
-VitoWiFi::Datapoint dpTempOutside    ("AussenTemp",     0x0101, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpWWoben        ("WWtempOben",    0x010D, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpVorlaufSoll   ("VorlaufTempSet",0x1800, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpVorlaufIst    ("VorlaufTemp",   0x0105, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpRuecklauf     ("RuecklaufTemp", 0x0106, 2, VitoWiFi::div10);
-
-// Compressor frequency (mode / short temp)
-VitoWiFi::Datapoint dpCompFrequency ("compressorFreq", 0x1A54, 1, VitoWiFi::noconv);
-
-// Raum / WW set + get
-VitoWiFi::Datapoint dpTempRaumSoll      ("RaumSollTemp",     0x2000, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempRaumSoll     ("SetRaumSollTemp",  0x2000, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpTempRaumSollRed   ("RaumSollRed",      0x2001, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempRaumSollRed  ("SetRaumSollRed",   0x2001, 2, VitoWiFi::div10);
-
-VitoWiFi::Datapoint dpTempWWSoll        ("WWtempSoll",       0x6000, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempWWsoll       ("SetWWtempSoll",    0x6000, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpTempWWSoll2       ("WWtempSoll2",      0x600C, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempWWsoll2      ("SetWWtempSoll2",   0x600C, 2, VitoWiFi::div10);
-
-VitoWiFi::Datapoint dpTempHystWWSoll    ("HystWWsoll",       0x6007, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempHystWWsoll   ("SetTempHystWWsoll",0x6007, 2, VitoWiFi::div10);
-
-VitoWiFi::Datapoint dpTempHKniveau      ("HKniveau",         0x2006, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempHKniveau     ("SetHKniveau",      0x2006, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint dpTempHKNeigung     ("HKneigung",        0x2007, 2, VitoWiFi::div10);
-VitoWiFi::Datapoint setTempHKneigung    ("SetHKneigung",     0x2007, 2, VitoWiFi::div10);
-
-// Status / modes (1 byte noconv -> uint8_t)
-VitoWiFi::Datapoint dpOperationMode     ("operationmode",    0xB000, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint setOperationMode    ("setOperationmode", 0xB000, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpManualMode        ("manualmode",       0xB020, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint setManualMode       ("setManualmode",    0xB020, 1, VitoWiFi::noconv);
-
-// Relays
-VitoWiFi::Datapoint dpHeizkreispumpe    ("heizkreispumpe",       0x048D, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpWWZirkPumpe       ("WWzirkulationspumpe",  0x0490, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpVentilHeizenWW    ("ventilHeizenWW",       0x0494, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpRelVerdichter     ("RelVerdichter",        0x0480, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpRelPrimaerquelle  ("RelPrimärquelle",      0x0482, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpRelSekundaerPumpe ("RelSekundaerPumpe",    0x0484, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpRelEHeizStufe1    ("RelEHeizStufe1",       0x0488, 1, VitoWiFi::noconv);
-VitoWiFi::Datapoint dpRelEHeizStufe2    ("RelEHeizStufe2",       0x0489, 1, VitoWiFi::noconv);
-
-VitoWiFi::Datapoint dpStoerung          ("stoerung",             0x0491, 1, VitoWiFi::noconv);
+// Every datapoint of sub is in s.
+inline bool vitoDpSetCovers(const VitoDpSet& s, const VitoDpSet& sub) {
+  for (uint8_t w = 0; w < VITO_DP_SET_WORDS; ++w) {
+    if ((s.words[w] & sub.words[w]) != sub.words[w]) {
+      return false;
+    }
+  }
+  return true;
+}
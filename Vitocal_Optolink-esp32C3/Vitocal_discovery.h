@@ -0,0 +1,373 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Paced Home Assistant discovery
+//
+// ArduinoHA sends the discovery config of every entity from mqtt.loop() the
+// moment the broker connects: the fixed entities, the derived figures and up
+// to VITO_DEFS_MAX LittleFS definitions in one go, each a retained JSON
+// document of 200-400 bytes. On the C3 the whole burst sits in the TCP send
+// buffers at once and holds loop() until it is written, right when the link
+// has just come back.
+//
+// Entities declared as VitoPaced<T> instead of T leave the connect alone:
+// their onMqttConnected() only queues them, and vitoDiscService() in loop()
+// hands at most VITO_DISC_PER_LOOP of them per iteration back to ArduinoHA
+// (config, availability, current state, command subscription).
+//
+// Sensors and binary sensors subscribe to nothing, so besides the config they
+// only send their current state. A FNV-1a hash of the config inputs
+// (component, unique id, name, object id, constructor arguments such as the
+// precision, icon, unit, device class, and a salt of firmware build and
+// prefixes) is kept per entity in /discovery.bin; a sensor
+// whose hash is unchanged only republishes its state, the broker still holds
+// its retained config. Availability is the device's shared topic, published
+// by the sketch on connect.
+// Every VITO_DISC_REFRESH_S the next connect sends everything again, in case
+// the broker lost its retained messages. Configs the sketch builds itself
+// (batched state, Vitocal_mqttbatch.h) use the same store.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <ArduinoHA.h>
+#include <LittleFS.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef VITO_DISC_MAX
+#define VITO_DISC_MAX 256             // queued entities and stored hashes
+#endif
+#ifndef VITO_DISC_PER_LOOP
+#define VITO_DISC_PER_LOOP 2          // entities handed to ArduinoHA per loop()
+#endif
+#ifndef VITO_DISC_SCAN_PER_LOOP
+#define VITO_DISC_SCAN_PER_LOOP 16    // queued entities looked at per loop()
+#endif
+#ifndef VITO_DISC_CACHE
+#define VITO_DISC_CACHE 1             // 0: every connect sends every config
+#endif
+#ifndef VITO_DISC_REFRESH_S
+#define VITO_DISC_REFRESH_S 86400UL   // full discovery at least this often
+#endif
+
+#define VITO_DISC_FILE  "/discovery.bin"
+#define VITO_DISC_MAGIC 0x31534456UL   // "VDS1"
+#define VITO_DISC_FNV   2166136261UL
+
+class VitoDiscEntity;
+static VitoDiscEntity* vitoDiscEntities = nullptr;   // every paced entity, newest first
+
+// Queue entry: an entity whose on-connect work waits for loop().
+class VitoDiscEntity {
+public:
+    VitoDiscEntity(HABaseDeviceType* entity, bool cacheable) : entity(entity), cacheable(cacheable) {
+        next = vitoDiscEntities;
+        vitoDiscEntities = this;
+    }
+    virtual void discover() = 0;    // ArduinoHA's own on-connect work
+    virtual void republish() = 0;   // ... without the config
+
+    HABaseDeviceType* const entity;
+    const bool              cacheable;   // no command topic: config and state are all it sends
+    bool                    pending = false;
+    uint32_t                described = VITO_DISC_FNV;   // config inputs ArduinoHA cannot read back
+    VitoDiscEntity*         next = nullptr;
+
+protected:
+    ~VitoDiscEntity() {}
+};
+
+struct VitoDiscRecord {
+    uint32_t id;       // hash of the unique id
+    uint32_t config;   // hash of the config inputs
+};
+
+static VitoDiscEntity* vitoDiscQueue[VITO_DISC_MAX];
+static uint16_t        vitoDiscHead    = 0;
+static uint16_t        vitoDiscCount   = 0;
+static VitoDiscRecord  vitoDiscStore[VITO_DISC_MAX];
+static uint16_t        vitoDiscStored  = 0;
+static uint32_t        vitoDiscSalt    = VITO_DISC_FNV;
+static bool            vitoDiscTrusted = true;    // the broker holds what the store says
+static bool            vitoDiscDirty   = false;
+static bool            vitoDiscFsReady = false;
+static uint32_t        vitoDiscFullMs  = 0;       // last pass that trusted nothing
+static uint32_t        vitoDiscPassStartMs = 0;   // connect of the running pass, 0 = none
+static uint32_t        vitoDiscLastPassMs  = 0;   // connect -> queue empty, last pass
+static uint32_t        vitoDiscSent    = 0;       // totals since boot
+static uint32_t        vitoDiscSkipped = 0;
+
+inline uint32_t vitoDiscFnv(uint32_t h, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+// string including its terminator, so "ab","c" and "a","bc" differ
+inline uint32_t vitoDiscFnv(uint32_t h, const char* s) {
+    return s ? vitoDiscFnv(h, s, strlen(s) + 1) : vitoDiscFnv(h, "", 1);
+}
+
+// setup(): anything that changes configs without changing the entities'
+// names (firmware build, prefixes).
+inline void vitoDiscSaltMix(const void* data, size_t len) {
+    vitoDiscSalt = vitoDiscFnv(vitoDiscSalt, data, len);
+}
+
+inline void vitoDiscSaltMix(const char* s) {
+    vitoDiscSalt = vitoDiscFnv(vitoDiscSalt, s);
+}
+
+inline uint32_t vitoDiscId(const char* uniqueId) {
+    return vitoDiscFnv(VITO_DISC_FNV, uniqueId);
+}
+
+inline uint32_t vitoDiscConfigHash(const VitoDiscEntity* d) {
+    const HABaseDeviceType* e = d->entity;
+    uint32_t h = vitoDiscFnv(vitoDiscSalt, e->componentName());
+    h = vitoDiscFnv(h, e->uniqueId());
+    h = vitoDiscFnv(h, e->getName());
+    h = vitoDiscFnv(h, e->getObjectId());
+    return vitoDiscFnv(h, &d->described, sizeof(d->described));
+}
+
+// Constructor arguments of a VitoPaced entity: strings by content, the rest
+// (precision, feature flags) by value.
+inline uint32_t vitoDiscMixArg(uint32_t h, const char* s) {
+    return vitoDiscFnv(h, s);
+}
+
+template <typename A>
+inline uint32_t vitoDiscMixArg(uint32_t h, A a) {
+    return vitoDiscFnv(h, &a, sizeof(a));
+}
+
+inline uint32_t vitoDiscMixArgs(uint32_t h) {
+    return h;
+}
+
+template <typename A, typename... Rest>
+inline uint32_t vitoDiscMixArgs(uint32_t h, A a, Rest... rest) {
+    return vitoDiscMixArgs(vitoDiscMixArg(h, a), rest...);
+}
+
+// --- hash store ----------------------------------------------------------------------
+inline VitoDiscRecord* vitoDiscFind(uint32_t id) {
+    for (uint16_t i = 0; i < vitoDiscStored; ++i) {
+        if (vitoDiscStore[i].id == id) {
+            return &vitoDiscStore[i];
+        }
+    }
+    return nullptr;
+}
+
+// The broker has this config retained (as far as the store knows).
+inline bool vitoDiscKnown(uint32_t id, uint32_t config) {
+    if (!VITO_DISC_CACHE || !vitoDiscTrusted) {
+        return false;
+    }
+    const VitoDiscRecord* r = vitoDiscFind(id);
+    return r != nullptr && r->config == config;
+}
+
+// A config went out; a full store just stops caching new entities.
+inline void vitoDiscRemember(uint32_t id, uint32_t config) {
+    VitoDiscRecord* r = vitoDiscFind(id);
+    if (r == nullptr) {
+        if (vitoDiscStored >= VITO_DISC_MAX) {
+            return;
+        }
+        r = &vitoDiscStore[vitoDiscStored++];
+        r->id = id;
+        r->config = ~config;
+    }
+    if (r->config != config) {
+        r->config = config;
+        vitoDiscDirty = true;
+    }
+}
+
+// setup(): a config input the hash cannot read from the entity, set through
+// a base pointer (datapoint table, derived figures); no-op for an entity
+// that is not paced.
+inline void vitoDiscDescribe(const HABaseDeviceType* entity, const char* s) {
+    for (VitoDiscEntity* e = vitoDiscEntities; e != nullptr; e = e->next) {
+        if (e->entity == entity) {
+            e->described = vitoDiscFnv(e->described, s);
+            return;
+        }
+    }
+}
+
+// --- pacing ----------------------------------------------------------------------------
+// ArduinoHA's connect, per entity: queue it. false if the queue is full, the
+// caller then does the work right away as before.
+inline bool vitoDiscDefer(VitoDiscEntity* e) {
+    if (e->pending) {
+        return true;   // still queued from the last connect
+    }
+    if (vitoDiscCount >= VITO_DISC_MAX) {
+        return false;
+    }
+    vitoDiscQueue[(vitoDiscHead + vitoDiscCount) % VITO_DISC_MAX] = e;
+    vitoDiscCount++;
+    e->pending = true;
+    return true;
+}
+
+// onMQTTConnected(): start timing the pass; once per VITO_DISC_REFRESH_S the
+// store is not trusted and everything goes out.
+inline void vitoDiscOnConnected(uint32_t now) {
+    vitoDiscPassStartMs = now ? now : 1;
+    vitoDiscTrusted = now - vitoDiscFullMs < VITO_DISC_REFRESH_S * 1000UL;
+    if (!vitoDiscTrusted) {
+        vitoDiscFullMs = now;
+    }
+}
+
+// loop(), after mqtt.loop(): hand at most VITO_DISC_PER_LOOP queued entities
+// to ArduinoHA. Entities for which skip() says the sketch sends the config
+// itself are dropped from the queue unsent. A sensor with an unchanged config
+// only republishes its state, and restate() puts back what ArduinoHA keeps no
+// copy of (the text of an HASensor).
+inline void vitoDiscService(bool connected, uint32_t now, bool (*skip)(const HABaseDeviceType*),
+                            void (*restate)(HABaseDeviceType*)) {
+    if (!connected) {
+        return;
+    }
+    uint8_t sent = 0;
+    for (uint8_t scanned = 0; vitoDiscCount > 0 && sent < VITO_DISC_PER_LOOP && scanned < VITO_DISC_SCAN_PER_LOOP;
+         ++scanned) {
+        VitoDiscEntity* e = vitoDiscQueue[vitoDiscHead];
+        vitoDiscHead = (uint16_t)((vitoDiscHead + 1) % VITO_DISC_MAX);
+        vitoDiscCount--;
+        e->pending = false;
+        if (skip && skip(e->entity)) {
+            continue;
+        }
+        if (e->cacheable) {
+            uint32_t id = vitoDiscId(e->entity->uniqueId());
+            uint32_t config = vitoDiscConfigHash(e);
+            if (vitoDiscKnown(id, config)) {
+                e->republish();
+                if (restate) {
+                    restate(e->entity);
+                }
+                vitoDiscSkipped++;
+                continue;
+            }
+            e->discover();
+            vitoDiscRemember(id, config);
+        } else {
+            e->discover();
+        }
+        vitoDiscSent++;
+        sent++;
+    }
+    if (vitoDiscCount == 0 && vitoDiscPassStartMs != 0) {
+        vitoDiscLastPassMs  = now - vitoDiscPassStartMs;
+        vitoDiscPassStartMs = 0;
+    }
+}
+
+// --- persistence ---------------------------------------------------------------------
+// setup(), after vitoMqInit(): the hashes of the configs sent before the reboot.
+inline void vitoDiscInit() {
+#if VITO_DISC_CACHE
+    if (!LittleFS.begin(true)) {
+        return;
+    }
+    vitoDiscFsReady = true;
+    File f = LittleFS.open(VITO_DISC_FILE, FILE_READ);
+    if (!f) {
+        return;
+    }
+    uint32_t head[2] = {0, 0};   // magic, count
+    if (f.read(reinterpret_cast<uint8_t*>(head), sizeof(head)) != sizeof(head) || head[0] != VITO_DISC_MAGIC) {
+        return;
+    }
+    VitoDiscRecord r;
+    while (vitoDiscStored < head[1] && vitoDiscStored < VITO_DISC_MAX &&
+           f.read(reinterpret_cast<uint8_t*>(&r), sizeof(r)) == sizeof(r)) {
+        vitoDiscStore[vitoDiscStored++] = r;
+    }
+#endif
+}
+
+// loop(): save the store once a pass has finished and changed it.
+inline void vitoDiscPersist() {
+#if VITO_DISC_CACHE
+    if (!vitoDiscFsReady || !vitoDiscDirty || vitoDiscCount != 0) {
+        return;
+    }
+    vitoDiscDirty = false;
+    File f = LittleFS.open(VITO_DISC_FILE, FILE_WRITE);
+    if (!f) {
+        return;
+    }
+    uint32_t head[2] = {VITO_DISC_MAGIC, vitoDiscStored};
+    f.write(reinterpret_cast<const uint8_t*>(head), sizeof(head));
+    f.write(reinterpret_cast<const uint8_t*>(vitoDiscStore), vitoDiscStored * sizeof(VitoDiscRecord));
+#endif
+}
+
+// --- entities --------------------------------------------------------------------------
+// Entity types whose config may be skipped (nothing to subscribe on connect).
+template <class T> struct VitoDiscCacheable { static const bool value = false; };
+template <> struct VitoDiscCacheable<HASensor> { static const bool value = true; };
+template <> struct VitoDiscCacheable<HASensorNumber> { static const bool value = true; };
+template <> struct VitoDiscCacheable<HABinarySensor> { static const bool value = true; };
+
+// What T::onMqttConnected() sends after the config: the current value of a
+// number sensor, the state of a binary sensor. An HASensor keeps no copy of
+// its text; vitoDiscService()'s restate() covers it.
+template <class T> struct VitoDiscState {
+    static void publish(T&) {}
+};
+template <> struct VitoDiscState<HASensorNumber> {
+    static void publish(HASensorNumber& e) {
+        if (e.getCurrentValue().isSet()) {
+            e.setValue(e.getCurrentValue(), true);
+        }
+    }
+};
+template <> struct VitoDiscState<HABinarySensor> {
+    static void publish(HABinarySensor& e) { e.setState(e.getCurrentState(), true); }
+};
+
+// An ArduinoHA entity T whose discovery runs from vitoDiscService().
+template <class T>
+class VitoPaced : public T, public VitoDiscEntity {
+public:
+    template <typename... Args>
+    explicit VitoPaced(Args... args) : T(args...), VitoDiscEntity(this, VitoDiscCacheable<T>::value) {
+        described = vitoDiscMixArgs(described, args...);
+    }
+
+    void discover() override { T::onMqttConnected(); }
+    void republish() override { VitoDiscState<T>::publish(*this); }
+
+    // config inputs ArduinoHA has no getter for; calls through a base pointer
+    // go through vitoDiscDescribe()
+    void setIcon(const char* icon) {
+        described = vitoDiscFnv(described, icon);
+        T::setIcon(icon);
+    }
+    void setUnitOfMeasurement(const char* unit) {
+        described = vitoDiscFnv(described, unit);
+        T::setUnitOfMeasurement(unit);
+    }
+    void setDeviceClass(const char* deviceClass) {
+        described = vitoDiscFnv(described, deviceClass);
+        T::setDeviceClass(deviceClass);
+    }
+
+protected:
+    void onMqttConnected() override {
+        if (!vitoDiscDefer(this)) {
+            T::onMqttConnected();
+        }
+    }
+};
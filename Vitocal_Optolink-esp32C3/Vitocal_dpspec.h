@@ -0,0 +1,150 @@
+#pragma once
+
+// Generated by scripts/gen_dpspec.py from dpspec.toml - do not edit.
+// 23 datapoints (fast 9, medium 7, slow 7); constant data only, the compiler
+// keeps all of it in flash. Included by Vitocal_datapoints.h.
+
+// Default interval of each poll class (ms); the periods below are written for these
+static constexpr uint32_t vitoClassDefaultMs[VITO_CLASS_COUNT] = {40000UL, 64000UL, 180000UL};
+
+// Polled datapoint IDs (row in vitoDpNames / vitoDpSpecs / per-DP tables)
+enum VitoDpId : uint8_t {
+  DP_TEMP_OUTSIDE = 0,
+  DP_WW_OBEN,
+  DP_VORLAUF_SOLL,
+  DP_VORLAUF_IST,
+  DP_RUECKLAUF,
+  DP_REL_EHEIZ1,
+  DP_REL_EHEIZ2,
+  DP_HEIZKREISPUMPE,
+  DP_WW_ZIRKPUMPE,
+  DP_REL_VERDICHTER,
+  DP_REL_PRIMAER,
+  DP_REL_SEKUNDAER,
+  DP_VENTIL_HEIZEN_WW,
+  DP_OPERATION_MODE,
+  DP_MANUAL_MODE,
+  DP_RAUM_SOLL,
+  DP_RAUM_SOLL_RED,
+  DP_WW_SOLL,
+  DP_WW_SOLL2,
+  DP_HYST_WW_SOLL,
+  DP_HK_NIVEAU,
+  DP_HK_NEIGUNG,
+  DP_STOERUNG,
+  DP_COUNT
+};
+
+// Names of the polled datapoints, one fixed-size row per ID. A request's
+// Datapoint points into this table, which is how the ID travels with it.
+static const size_t VITO_DP_NAME_LEN = 24;
+static const char vitoDpNames[DP_COUNT][VITO_DP_NAME_LEN] = {
+  "AussenTemp",
+  "WWtempOben",
+  "VorlaufTempSet",
+  "VorlaufTemp",
+  "RuecklaufTemp",
+  "RelEHeizStufe1",
+  "RelEHeizStufe2",
+  "heizkreispumpe",
+  "WWzirkulationspumpe",
+  "RelVerdichter",
+  "RelPrimärquelle",
+  "RelSekundaerPumpe",
+  "ventilHeizenWW",
+  "operationmode",
+  "manualmode",
+  "RaumSollTemp",
+  "RaumSollRed",
+  "WWtempSoll",
+  "WWtempSoll2",
+  "HystWWsoll",
+  "HKniveau",
+  "HKneigung",
+  "stoerung"
+};
+
+// Value texts of the Label datapoints
+static const char* const operationModeLabels[] = {
+  "Abschaltbetrieb",
+  "Warmwasser",
+  "Heizen und Warmwasser",
+  "undefiniert",
+  "dauernd reduziert",
+  "dauernd normal",
+  "normal Abschalt",
+  "nur kuehlen"
+};
+
+static const char* const manualModeLabels[] = {
+  "normal",
+  "manuell",
+  "WW auf Temp2"
+};
+
+static const char* const ventilHeizenWWLabels[] = {
+  "Heizen",
+  "Warmwasser"
+};
+
+// {address, length, converter, class, flags, period, max age}; period and age
+// budget at the class default interval, scaled with it (Vitocal_scheduler.h)
+static constexpr VitoDpSpec vitoDpSpecs[DP_COUNT] = {
+  /* DP_TEMP_OUTSIDE     */ { 0x0101, 2, VITO_CONV_DIV10,  VITO_CLASS_MEDIUM, 0,                128000UL, 256000UL },
+  /* DP_WW_OBEN          */ { 0x010D, 2, VITO_CONV_DIV10,  VITO_CLASS_MEDIUM, 0,                64000UL,  128000UL },
+  /* DP_VORLAUF_SOLL     */ { 0x1800, 2, VITO_CONV_DIV10,  VITO_CLASS_MEDIUM, 0,                128000UL, 256000UL },
+  /* DP_VORLAUF_IST      */ { 0x0105, 2, VITO_CONV_DIV10,  VITO_CLASS_MEDIUM, 0,                64000UL,  128000UL },
+  /* DP_RUECKLAUF        */ { 0x0106, 2, VITO_CONV_DIV10,  VITO_CLASS_MEDIUM, 0,                64000UL,  128000UL },
+  /* DP_REL_EHEIZ1       */ { 0x0488, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_REL_EHEIZ2       */ { 0x0489, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_HEIZKREISPUMPE   */ { 0x048D, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_WW_ZIRKPUMPE     */ { 0x0490, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_REL_VERDICHTER   */ { 0x0480, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_REL_PRIMAER      */ { 0x0482, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_REL_SEKUNDAER    */ { 0x0484, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_VENTIL_HEIZEN_WW */ { 0x0494, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+  /* DP_OPERATION_MODE   */ { 0xB000, 1, VITO_CONV_NOCONV, VITO_CLASS_MEDIUM, 0,                128000UL, 256000UL },
+  /* DP_MANUAL_MODE      */ { 0xB020, 1, VITO_CONV_NOCONV, VITO_CLASS_MEDIUM, VITO_DP_WRITABLE, 128000UL, 256000UL },
+  /* DP_RAUM_SOLL        */ { 0x2000, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 180000UL, 360000UL },
+  /* DP_RAUM_SOLL_RED    */ { 0x2001, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 180000UL, 360000UL },
+  /* DP_WW_SOLL          */ { 0x6000, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 180000UL, 360000UL },
+  /* DP_WW_SOLL2         */ { 0x600C, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 180000UL, 360000UL },
+  /* DP_HYST_WW_SOLL     */ { 0x6007, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 180000UL, 360000UL },
+  /* DP_HK_NIVEAU        */ { 0x2006, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 360000UL, 720000UL },
+  /* DP_HK_NEIGUNG       */ { 0x2007, 2, VITO_CONV_DIV10,  VITO_CLASS_SLOW,   VITO_DP_WRITABLE, 360000UL, 720000UL },
+  /* DP_STOERUNG         */ { 0x0491, 1, VITO_CONV_NOCONV, VITO_CLASS_FAST,   0,                40000UL,  80000UL },
+};
+
+// Poll groups: only members of the same group are merged into one block read
+static constexpr uint8_t vitoFast[] = {
+  DP_REL_EHEIZ1,
+  DP_REL_EHEIZ2,
+  DP_HEIZKREISPUMPE,
+  DP_WW_ZIRKPUMPE,
+  DP_REL_VERDICHTER,
+  DP_REL_PRIMAER,
+  DP_REL_SEKUNDAER,
+  DP_VENTIL_HEIZEN_WW,
+  DP_STOERUNG
+};
+static constexpr int vitoFastSize = sizeof(vitoFast);
+static constexpr uint8_t vitoMedium[] = {
+  DP_TEMP_OUTSIDE,
+  DP_WW_OBEN,
+  DP_VORLAUF_SOLL,
+  DP_VORLAUF_IST,
+  DP_RUECKLAUF,
+  DP_OPERATION_MODE,
+  DP_MANUAL_MODE
+};
+static constexpr int vitoMediumSize = sizeof(vitoMedium);
+static constexpr uint8_t vitoSlow[] = {
+  DP_RAUM_SOLL,
+  DP_RAUM_SOLL_RED,
+  DP_WW_SOLL,
+  DP_WW_SOLL2,
+  DP_HYST_WW_SOLL,
+  DP_HK_NIVEAU,
+  DP_HK_NEIGUNG
+};
+static constexpr int vitoSlowSize = sizeof(vitoSlow);
@@ -0,0 +1,646 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// On-device history (Gorilla-style compression)
+//
+// Every changed value is appended to the open block of its datapoint (a
+// sink of the value store, Vitocal_values.h): the series holds a value until
+// the next sample, a read with the same reply bytes adds nothing.
+// Blocks are VITO_HIST_BLOCK_BYTES each, taken from a RAM pool that is used
+// as a ring (the oldest sealed block is reused). Inside a block:
+//
+//   timestamps  delta-of-delta in VITO_HIST_TICK_MS ticks:
+//               '0' | '10'+7 bits | '110'+9 bits | '1110'+12 bits | '1111'+32 bits
+//   values      float bits XOR the previous value:
+//               '0' same | '10' + bits inside the previous window
+//               | '11' + 5 bits leading zeros + 6 bits length + bits
+//
+// The first sample of a block is its header time plus 32 raw value bits.
+// A temperature changing on every read costs about 15-25 bits per sample.
+//
+// Sealed blocks are spilled to LittleFS (VITO_HIST_SPILL) from loop() by
+// vitoHistoryService(), into a fixed-size ring file, so history survives a
+// reboot and reaches further back than RAM. GET /history streams samples as
+// CSV or JSON, block by block, through a chunked response: in time order per
+// datapoint, interleaved between datapoints.
+//
+// Wall time: blocks carry the SNTP time of their first sample (0 if the
+// clock was not set yet); uptime and a boot counter are always recorded.
+//
+// loop() appends and spills; the export and the statistics run in the
+// async_tcp task. vitoHistLock covers every change of the RAM pool and the
+// ring file position and the export's reads of them (a block is copied out
+// under it), so the handler never sees a block half written or reused.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <memory>      // std::shared_ptr for the export cursor
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_json.h"
+
+#ifndef VITO_HIST_BLOCK_BYTES
+#define VITO_HIST_BLOCK_BYTES 256       // header + bit stream
+#endif
+#ifndef VITO_HIST_RAM_BLOCKS
+#define VITO_HIST_RAM_BLOCKS 64         // 16 kB with 256-byte blocks
+#endif
+#ifndef VITO_HIST_TICK_MS
+#define VITO_HIST_TICK_MS 100UL         // timestamp resolution
+#endif
+#ifndef VITO_HIST_SPILL
+#define VITO_HIST_SPILL 1               // 0 = RAM only
+#endif
+#ifndef VITO_HIST_FS_BLOCKS
+#define VITO_HIST_FS_BLOCKS 1024        // ring file size in blocks (256 kB)
+#endif
+
+#define VITO_HIST_FILE      "/history.bin"
+#define VITO_HIST_BOOT_FILE "/history.boot"
+
+// VitoHistBlockHeader::flags
+#define VITO_HIST_OPEN    0x01   // still appended to
+#define VITO_HIST_SPILLED 0x02   // copy is on LittleFS
+
+struct VitoHistBlockHeader {
+    uint32_t seq;       // allocation order (continues across boots), 0 = unused
+    uint32_t stored;    // write order on LittleFS, 0 = not spilled yet
+    uint32_t t0Ms;      // uptime of the first sample
+    uint32_t epoch0;    // unix time of the first sample, 0 = clock not set
+    uint16_t boot;      // boot counter (0 without LittleFS)
+    uint16_t count;     // samples
+    uint16_t bits;      // used bits of data[]
+    uint8_t  dp;
+    uint8_t  flags;
+};
+
+struct VitoHistBlock {
+    VitoHistBlockHeader h;
+    uint8_t data[VITO_HIST_BLOCK_BYTES - sizeof(VitoHistBlockHeader)];
+};
+
+static_assert(sizeof(VitoHistBlock) == VITO_HIST_BLOCK_BYTES, "history block must not be padded");
+static_assert(VITO_HIST_RAM_BLOCKS < VITO_DP_NONE, "RAM block index must fit below VITO_DP_NONE");
+
+// worst case of one sample: '1111' + 32 time bits, '11' + 5 + 6 + 32 value bits
+#define VITO_HIST_MAX_SAMPLE_BITS 81U
+#define VITO_HIST_DATA_BITS       ((uint32_t)(sizeof(((VitoHistBlock*)0)->data) * 8))
+
+// Encoder state of the open block of one datapoint
+struct VitoHistWriter {
+    uint8_t  block;       // index in vitoHistRam, VITO_DP_NONE = none
+    uint32_t prevTick;    // ticks since the block's t0Ms
+    int32_t  prevDelta;
+    uint32_t prevBits;    // float bits of the previous value
+    uint8_t  leading;     // XOR window of the previous value, 0xFF = none yet
+    uint8_t  trailing;
+    // statistics since boot
+    uint32_t samples;
+    uint64_t payloadBits;
+};
+
+static VitoHistBlock  vitoHistRam[VITO_HIST_RAM_BLOCKS];
+static VitoHistWriter vitoHistWriters[DP_COUNT];
+static uint32_t       vitoHistSeq         = 0;
+static uint16_t       vitoHistBoot        = 0;
+static uint32_t       vitoHistBlocksOpened = 0;
+static uint32_t       vitoHistLostBlocks  = 0;   // evicted before they were spilled
+static bool           vitoHistFsReady     = false;
+static uint16_t       vitoHistFsBlocks    = 0;   // valid slots in the ring file
+static uint16_t       vitoHistFsNext      = 0;   // next slot to write
+static uint32_t       vitoHistStored      = 0;   // last VitoHistBlockHeader::stored
+static std::mutex     vitoHistLock;                // loop() writes vs. reads of the async_tcp task
+
+inline uint32_t vitoHistEpoch() {
+    time_t t = time(nullptr);
+    return t > 1600000000 ? (uint32_t)t : 0;   // before SNTP sync time() is near 0
+}
+
+// --- bit stream ------------------------------------------------------------------
+inline void vitoHistPutBits(VitoHistBlock& b, uint32_t value, uint8_t n) {
+    for (int8_t i = (int8_t)n - 1; i >= 0; --i) {
+        if ((value >> i) & 1u) {
+            b.data[b.h.bits >> 3] |= (uint8_t)(0x80u >> (b.h.bits & 7));
+        }
+        b.h.bits++;
+    }
+}
+
+inline uint32_t vitoHistGetBits(const VitoHistBlock& b, uint16_t& pos, uint8_t n) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < n; ++i, ++pos) {
+        v = (v << 1) | ((b.data[pos >> 3] >> (7 - (pos & 7))) & 1u);
+    }
+    return v;
+}
+
+inline uint32_t vitoHistFloatBits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// --- RAM pool ----------------------------------------------------------------------
+// Free block, else the oldest sealed one (preferably already spilled).
+inline uint8_t vitoHistAllocate() {
+    uint8_t best = VITO_DP_NONE;
+    for (uint8_t i = 0; i < VITO_HIST_RAM_BLOCKS; ++i) {
+        const VitoHistBlockHeader& h = vitoHistRam[i].h;
+        if (h.seq == 0) {
+            return i;
+        }
+        if (h.flags & VITO_HIST_OPEN) {
+            continue;
+        }
+        if (best == VITO_DP_NONE) {
+            best = i;
+            continue;
+        }
+        const VitoHistBlockHeader& bh = vitoHistRam[best].h;
+        bool spilled = h.flags & VITO_HIST_SPILLED, bestSpilled = bh.flags & VITO_HIST_SPILLED;
+        if ((spilled && !bestSpilled) || (spilled == bestSpilled && h.seq < bh.seq)) {
+            best = i;
+        }
+    }
+    if (best != VITO_DP_NONE && vitoHistFsReady && !(vitoHistRam[best].h.flags & VITO_HIST_SPILLED)) {
+        vitoHistLostBlocks++;
+    }
+    return best;
+}
+
+inline void vitoHistSeal(uint8_t id) {
+    VitoHistWriter& w = vitoHistWriters[id];
+    if (w.block != VITO_DP_NONE) {
+        vitoHistRam[w.block].h.flags &= (uint8_t)~VITO_HIST_OPEN;
+        w.block = VITO_DP_NONE;
+    }
+}
+
+inline bool vitoHistOpenBlock(uint8_t id, uint32_t nowMs, uint32_t bits) {
+    uint8_t i = vitoHistAllocate();
+    if (i == VITO_DP_NONE) {
+        return false;
+    }
+    VitoHistBlock& b = vitoHistRam[i];
+    memset(&b, 0, sizeof(b));
+    b.h.seq    = ++vitoHistSeq;
+    b.h.t0Ms   = nowMs;
+    b.h.epoch0 = vitoHistEpoch();
+    b.h.boot   = vitoHistBoot;
+    b.h.dp     = id;
+    b.h.flags  = VITO_HIST_OPEN;
+    b.h.count  = 1;
+    vitoHistPutBits(b, bits, 32);
+
+    VitoHistWriter& w = vitoHistWriters[id];
+    w.block     = i;
+    w.prevTick  = 0;
+    w.prevDelta = 0;
+    w.prevBits  = bits;
+    w.leading   = 0xFF;
+    w.trailing  = 0;
+    w.payloadBits += 32;
+    vitoHistBlocksOpened++;
+    return true;
+}
+
+// Append one sample of datapoint id (decoded value, before any publish filter).
+inline void vitoHistoryAppend(uint8_t id, uint32_t nowMs, float value) {
+    if (id >= DP_COUNT) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(vitoHistLock);
+    VitoHistWriter& w = vitoHistWriters[id];
+    uint32_t bits = vitoHistFloatBits(value);
+    w.samples++;
+
+    if (w.block != VITO_DP_NONE) {
+        VitoHistBlock& b = vitoHistRam[w.block];
+        uint32_t tick = (nowMs - b.h.t0Ms) / VITO_HIST_TICK_MS;
+        if ((uint32_t)b.h.bits + VITO_HIST_MAX_SAMPLE_BITS > VITO_HIST_DATA_BITS || b.h.count == 0xFFFF ||
+            tick > 0x7FFFFFFFUL) {
+            vitoHistSeal(id);
+        } else {
+            uint16_t before = b.h.bits;
+            int32_t delta = (int32_t)(tick - w.prevTick);
+            int32_t dod   = delta - w.prevDelta;
+            if (dod == 0) {
+                vitoHistPutBits(b, 0x0, 1);
+            } else if (dod >= -63 && dod <= 64) {
+                vitoHistPutBits(b, 0x2, 2);
+                vitoHistPutBits(b, (uint32_t)(dod + 63), 7);
+            } else if (dod >= -255 && dod <= 256) {
+                vitoHistPutBits(b, 0x6, 3);
+                vitoHistPutBits(b, (uint32_t)(dod + 255), 9);
+            } else if (dod >= -2047 && dod <= 2048) {
+                vitoHistPutBits(b, 0xE, 4);
+                vitoHistPutBits(b, (uint32_t)(dod + 2047), 12);
+            } else {
+                vitoHistPutBits(b, 0xF, 4);
+                vitoHistPutBits(b, (uint32_t)dod, 32);
+            }
+
+            uint32_t x = bits ^ w.prevBits;
+            if (x == 0) {
+                vitoHistPutBits(b, 0x0, 1);
+            } else {
+                uint8_t leading  = (uint8_t)__builtin_clz(x);
+                uint8_t trailing = (uint8_t)__builtin_ctz(x);
+                if (leading > 31) leading = 31;
+                if (w.leading != 0xFF && leading >= w.leading && trailing >= w.trailing) {
+                    vitoHistPutBits(b, 0x2, 2);
+                    vitoHistPutBits(b, x >> w.trailing, (uint8_t)(32 - w.leading - w.trailing));
+                } else {
+                    uint8_t len = (uint8_t)(32 - leading - trailing);
+                    vitoHistPutBits(b, 0x3, 2);
+                    vitoHistPutBits(b, leading, 5);
+                    vitoHistPutBits(b, len, 6);
+                    vitoHistPutBits(b, x >> trailing, len);
+                    w.leading  = leading;
+                    w.trailing = trailing;
+                }
+            }
+            w.prevTick  = tick;
+            w.prevDelta = delta;
+            w.prevBits  = bits;
+            w.payloadBits += (uint16_t)(b.h.bits - before);
+            b.h.count++;
+            return;
+        }
+    }
+    vitoHistOpenBlock(id, nowMs, bits);
+}
+
+// --- decoding ----------------------------------------------------------------------
+struct VitoHistReader {
+    uint16_t pos;
+    uint16_t index;      // samples returned so far
+    uint32_t tick;
+    int32_t  delta;
+    uint32_t bits;
+    uint8_t  leading;
+    uint8_t  trailing;
+};
+
+inline void vitoHistReaderInit(VitoHistReader& r) {
+    memset(&r, 0, sizeof(r));
+}
+
+// Next sample of block b: uptime ms and value; false at the end.
+inline bool vitoHistNext(const VitoHistBlock& b, VitoHistReader& r, uint32_t& tMs, float& value) {
+    if (r.index >= b.h.count) {
+        return false;
+    }
+    if (r.index == 0) {
+        r.bits = vitoHistGetBits(b, r.pos, 32);
+    } else {
+        int32_t dod;
+        if (vitoHistGetBits(b, r.pos, 1) == 0) {
+            dod = 0;
+        } else if (vitoHistGetBits(b, r.pos, 1) == 0) {
+            dod = (int32_t)vitoHistGetBits(b, r.pos, 7) - 63;
+        } else if (vitoHistGetBits(b, r.pos, 1) == 0) {
+            dod = (int32_t)vitoHistGetBits(b, r.pos, 9) - 255;
+        } else if (vitoHistGetBits(b, r.pos, 1) == 0) {
+            dod = (int32_t)vitoHistGetBits(b, r.pos, 12) - 2047;
+        } else {
+            dod = (int32_t)vitoHistGetBits(b, r.pos, 32);
+        }
+        r.delta += dod;
+        r.tick  += (uint32_t)r.delta;
+
+        if (vitoHistGetBits(b, r.pos, 1) != 0) {
+            if (vitoHistGetBits(b, r.pos, 1) != 0) {
+                r.leading = (uint8_t)vitoHistGetBits(b, r.pos, 5);
+                uint8_t len = (uint8_t)vitoHistGetBits(b, r.pos, 6);
+                r.trailing = (uint8_t)(32 - r.leading - len);
+            }
+            uint8_t len = (uint8_t)(32 - r.leading - r.trailing);
+            r.bits ^= vitoHistGetBits(b, r.pos, len) << r.trailing;
+        }
+    }
+    r.index++;
+    tMs = b.h.t0Ms + r.tick * VITO_HIST_TICK_MS;
+    memcpy(&value, &r.bits, sizeof(value));
+    return true;
+}
+
+// --- LittleFS spill ------------------------------------------------------------------
+inline bool vitoHistFsRead(uint16_t slot, VitoHistBlock& b) {
+    File f = LittleFS.open(VITO_HIST_FILE, FILE_READ);
+    if (!f || !f.seek((uint32_t)slot * sizeof(VitoHistBlock))) {
+        return false;
+    }
+    return f.read(reinterpret_cast<uint8_t*>(&b), sizeof(b)) == sizeof(b);
+}
+
+// setup(): mount LittleFS, count the boot and find the write position of the ring file.
+inline void vitoHistoryInit() {
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        vitoHistWriters[i].block = VITO_DP_NONE;
+    }
+#if VITO_HIST_SPILL
+    if (!LittleFS.begin(true)) {
+        return;
+    }
+    File bf = LittleFS.open(VITO_HIST_BOOT_FILE, FILE_READ);
+    if (bf) {
+        bf.read(reinterpret_cast<uint8_t*>(&vitoHistBoot), sizeof(vitoHistBoot));
+        bf.close();
+    }
+    vitoHistBoot++;
+    bf = LittleFS.open(VITO_HIST_BOOT_FILE, FILE_WRITE);
+    if (bf) {
+        bf.write(reinterpret_cast<const uint8_t*>(&vitoHistBoot), sizeof(vitoHistBoot));
+        bf.close();
+    }
+
+    File f = LittleFS.open(VITO_HIST_FILE, FILE_READ);
+    if (!f) {
+        f = LittleFS.open(VITO_HIST_FILE, FILE_WRITE);   // create
+    }
+    if (!f) {
+        return;
+    }
+    size_t slots = f.size() / sizeof(VitoHistBlock);
+    vitoHistFsBlocks = (uint16_t)(slots < VITO_HIST_FS_BLOCKS ? slots : VITO_HIST_FS_BLOCKS);
+    // continue after the block written last; seq keeps counting so the export stays ordered
+    VitoHistBlockHeader h;
+    for (uint16_t s = 0; s < vitoHistFsBlocks; ++s) {
+        f.seek((uint32_t)s * sizeof(VitoHistBlock));
+        if (f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) != sizeof(h)) {
+            break;
+        }
+        if (h.stored > vitoHistStored) {
+            vitoHistStored = h.stored;
+            vitoHistFsNext = (uint16_t)((s + 1) % VITO_HIST_FS_BLOCKS);
+        }
+        if (h.seq > vitoHistSeq) {
+            vitoHistSeq = h.seq;
+        }
+    }
+    f.close();
+    vitoHistFsReady = true;
+#endif
+}
+
+// loop(): write at most one sealed, not yet spilled block to LittleFS.
+inline void vitoHistoryService() {
+#if VITO_HIST_SPILL
+    if (!vitoHistFsReady) {
+        return;
+    }
+    uint8_t pick = VITO_DP_NONE;
+    for (uint8_t i = 0; i < VITO_HIST_RAM_BLOCKS; ++i) {
+        const VitoHistBlockHeader& h = vitoHistRam[i].h;
+        if (h.seq != 0 && !(h.flags & (VITO_HIST_OPEN | VITO_HIST_SPILLED)) &&
+            (pick == VITO_DP_NONE || h.seq < vitoHistRam[pick].h.seq)) {
+            pick = i;
+        }
+    }
+    if (pick == VITO_DP_NONE) {
+        return;
+    }
+    File f = LittleFS.open(VITO_HIST_FILE, "r+");
+    if (!f || !f.seek((uint32_t)vitoHistFsNext * sizeof(VitoHistBlock))) {
+        return;
+    }
+    // sealed: only loop() changes the block, it is written without the lock
+    VitoHistBlock& b = vitoHistRam[pick];
+    {
+        std::lock_guard<std::mutex> lock(vitoHistLock);
+        b.h.stored = vitoHistStored + 1;
+        b.h.flags |= VITO_HIST_SPILLED;
+    }
+    bool written = f.write(reinterpret_cast<const uint8_t*>(&b), sizeof(b)) == sizeof(b);
+    f.close();
+    std::lock_guard<std::mutex> lock(vitoHistLock);
+    if (!written) {
+        b.h.stored = 0;
+        b.h.flags &= (uint8_t)~VITO_HIST_SPILLED;
+        return;
+    }
+    vitoHistStored++;
+    if (vitoHistFsNext >= vitoHistFsBlocks) {
+        vitoHistFsBlocks = vitoHistFsNext + 1;
+    }
+    vitoHistFsNext = (uint16_t)((vitoHistFsNext + 1) % VITO_HIST_FS_BLOCKS);
+#endif
+}
+
+// --- export --------------------------------------------------------------------------
+#define VITO_HIST_CSV  0
+#define VITO_HIST_JSON 1
+
+enum VitoHistPhase : uint8_t {
+    VITO_HP_HEAD = 0,
+    VITO_HP_FS,       // spilled blocks, oldest slot first
+    VITO_HP_RAM,      // RAM blocks not on LittleFS, by seq
+    VITO_HP_TAIL,
+    VITO_HP_DONE
+};
+
+struct VitoHistCursor {
+    uint8_t        phase;
+    uint8_t        format;     // VITO_HIST_CSV / VITO_HIST_JSON
+    uint8_t        dp;         // filter, VITO_DP_NONE = all
+    uint32_t       sinceS;     // range as age in seconds: sinceS >= age >= untilS
+    uint32_t       untilS;
+    uint32_t       nowMs;
+    uint32_t       nowEpoch;
+    uint16_t       fsBlocks;   // LittleFS ring at the start of the export
+    uint16_t       fsNext;
+    uint32_t       fsStored;
+    uint16_t       next;       // FS: slots visited
+    uint32_t       lastSeq;    // RAM: seq of the block written last
+    bool           haveBlock;
+    bool           haveSample; // sample in tMs/value still to be written
+    bool           first;      // JSON: no comma before the first row
+    uint32_t       tMs;
+    float          value;
+    VitoHistBlock  block;      // copy of the block being written
+    VitoHistReader reader;
+};
+
+// sinceS = 0: no lower bound
+inline void vitoHistCursorInit(VitoHistCursor& c, uint8_t format, uint8_t dp, uint32_t sinceS, uint32_t untilS) {
+    memset(&c, 0, sizeof(c));
+    c.format   = format;
+    c.dp       = dp;
+    c.sinceS   = sinceS ? sinceS : UINT32_MAX;
+    c.untilS   = untilS;
+    c.nowMs    = millis();
+    c.nowEpoch = vitoHistEpoch();
+    std::lock_guard<std::mutex> lock(vitoHistLock);
+    c.fsBlocks = vitoHistFsBlocks;
+    c.fsNext   = vitoHistFsNext;
+    c.fsStored = vitoHistStored;
+    c.first    = true;
+}
+
+// Load the next block that passes the dp filter; false when the phase is exhausted.
+inline bool vitoHistNextBlock(VitoHistCursor& c) {
+    if (c.phase == VITO_HP_FS) {
+        while (c.next < c.fsBlocks) {
+            uint16_t slot = c.fsBlocks < VITO_HIST_FS_BLOCKS
+                          ? c.next : (uint16_t)((c.fsNext + c.next) % VITO_HIST_FS_BLOCKS);
+            c.next++;
+            // slots overwritten since the start are still in RAM and come in that phase
+            if (vitoHistFsRead(slot, c.block) && c.block.h.seq != 0 && c.block.h.stored <= c.fsStored &&
+                c.block.h.dp < DP_COUNT && (c.dp == VITO_DP_NONE || c.block.h.dp == c.dp)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // RAM: next seq above the last one written
+    std::lock_guard<std::mutex> lock(vitoHistLock);
+    uint8_t pick = VITO_DP_NONE;
+    for (uint8_t i = 0; i < VITO_HIST_RAM_BLOCKS; ++i) {
+        const VitoHistBlockHeader& h = vitoHistRam[i].h;
+        if (h.seq > c.lastSeq && (pick == VITO_DP_NONE || h.seq < vitoHistRam[pick].h.seq)) {
+            pick = i;
+        }
+    }
+    while (pick != VITO_DP_NONE) {
+        const VitoHistBlock& b = vitoHistRam[pick];
+        c.lastSeq = b.h.seq;
+        bool onFs = vitoHistFsReady && b.h.stored != 0 && b.h.stored <= c.fsStored;
+        if (!onFs && (c.dp == VITO_DP_NONE || b.h.dp == c.dp)) {
+            memcpy(&c.block, &b, sizeof(c.block));
+            return true;
+        }
+        pick = VITO_DP_NONE;
+        for (uint8_t i = 0; i < VITO_HIST_RAM_BLOCKS; ++i) {
+            const VitoHistBlockHeader& h = vitoHistRam[i].h;
+            if (h.seq > c.lastSeq && (pick == VITO_DP_NONE || h.seq < vitoHistRam[pick].h.seq)) {
+                pick = i;
+            }
+        }
+    }
+    return false;
+}
+
+// Age of a sample in seconds, UINT32_MAX if unknown (earlier boot, no clock).
+inline uint32_t vitoHistAgeS(const VitoHistCursor& c, uint32_t tMs) {
+    const VitoHistBlockHeader& h = c.block.h;
+    if (h.boot == vitoHistBoot) {
+        return (c.nowMs - tMs) / 1000UL;
+    }
+    if (h.epoch0 != 0 && c.nowEpoch != 0) {
+        uint32_t e = h.epoch0 + (tMs - h.t0Ms) / 1000UL;
+        return c.nowEpoch > e ? c.nowEpoch - e : 0;
+    }
+    return UINT32_MAX;
+}
+
+inline size_t vitoHistFormatSample(const VitoHistCursor& c, char* buf, size_t size) {
+    const VitoHistBlockHeader& h = c.block.h;
+    uint64_t unixMs = h.epoch0 ? (uint64_t)h.epoch0 * 1000ULL + (c.tMs - h.t0Ms) : 0;
+    char unixBuf[24] = "";
+    if (unixMs) {
+        snprintf(unixBuf, sizeof(unixBuf), "%llu", (unsigned long long)unixMs);
+    }
+    int n = c.format == VITO_HIST_JSON
+          ? snprintf(buf, size, "%s{\"dp\":\"%s\",\"boot\":%u,\"uptimeMs\":%lu,\"unixMs\":%s,\"v\":%g}",
+                     c.first ? "\n" : ",\n", vitoDpNames[h.dp], h.boot, (unsigned long)c.tMs,
+                     unixMs ? unixBuf : "null", (double)c.value)
+          : snprintf(buf, size, "%s,%u,%lu,%s,%g\n", vitoDpNames[h.dp], h.boot, (unsigned long)c.tMs,
+                     unixBuf, (double)c.value);
+    return n < 0 ? 0 : (size_t)n < size ? (size_t)n : size - 1;
+}
+
+// ESPAsyncWebServer's RESPONSE_TRY_AGAIN (0xFFFFFFFF, size_t on the ESP32)
+#define VITO_HIST_RETRY ((size_t)-1)
+
+// Filler for a chunked response: whole lines up to maxLen, 0 when done.
+inline size_t vitoHistFill(VitoHistCursor& c, uint8_t* buf, size_t maxLen) {
+    char line[128];
+    size_t n = 0;
+    while (c.phase != VITO_HP_DONE) {
+        size_t len = 0;
+        if (c.phase == VITO_HP_HEAD) {
+            len = (size_t)snprintf(line, sizeof(line), c.format == VITO_HIST_JSON
+                                   ? "{\"boot\":%u,\"uptimeMs\":%lu,\"samples\":["
+                                   : "# boot %u, uptime %lu ms\ndp,boot,uptime_ms,unix_ms,value\n",
+                                   vitoHistBoot, (unsigned long)c.nowMs);
+        } else if (c.phase == VITO_HP_TAIL) {
+            len = c.format == VITO_HIST_JSON ? (size_t)snprintf(line, sizeof(line), "\n]}\n") : 0;
+        } else {
+            // next sample that passes the time filter
+            while (!c.haveSample) {
+                if (!c.haveBlock) {
+                    if (!vitoHistNextBlock(c)) {
+                        break;
+                    }
+                    c.haveBlock = true;
+                    vitoHistReaderInit(c.reader);
+                }
+                if (!vitoHistNext(c.block, c.reader, c.tMs, c.value)) {
+                    c.haveBlock = false;
+                    continue;
+                }
+                uint32_t age = vitoHistAgeS(c, c.tMs);
+                c.haveSample = (age <= c.sinceS && age >= c.untilS) || (age == UINT32_MAX && c.sinceS == UINT32_MAX);
+            }
+            if (!c.haveSample) {
+                c.phase++;
+                continue;
+            }
+            len = vitoHistFormatSample(c, line, sizeof(line));
+        }
+        if (n + len > maxLen) {
+            return n ? n : VITO_HIST_RETRY;
+        }
+        memcpy(buf + n, line, len);
+        n += len;
+        if (c.phase == VITO_HP_FS || c.phase == VITO_HP_RAM) {
+            c.haveSample = false;
+            c.first = false;
+        } else {
+            c.phase++;
+            if (c.phase == VITO_HP_FS && !vitoHistFsReady) {
+                c.phase = VITO_HP_RAM;
+            }
+        }
+    }
+    return n;
+}
+
+// Longest vitoHistoryStatsJson(): totals, then name, samples and bytes per datapoint
+static const size_t VITO_HIST_STATS_JSON_MAX = 320 + DP_COUNT * (VITO_DP_NAME_LEN + 64);
+
+// Compression statistics as JSON (GET /history/stats); nullptr if it does not fit.
+inline const char* vitoHistoryStatsJson() {
+    static char buf[VITO_HIST_STATS_JSON_MAX];
+    std::lock_guard<std::mutex> lock(vitoHistLock);
+    uint32_t samples = 0;
+    uint64_t bits = 0;
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        samples += vitoHistWriters[i].samples;
+        bits    += vitoHistWriters[i].payloadBits;
+    }
+    double payload = samples ? (double)bits / 8.0 / samples : 0.0;
+    double stored  = samples ? ((double)bits / 8.0 + (double)vitoHistBlocksOpened * sizeof(VitoHistBlockHeader)) / samples : 0.0;
+    size_t n = 0;
+    bool ok = vitoAppendf(buf, sizeof(buf), n,
+                          "{\"boot\":%u,\"samples\":%lu,\"bytesPerSample\":%.2f,\"bytesPerSampleWithHeaders\":%.2f,"
+                          "\"blocks\":%lu,\"ramBlocks\":%u,\"blockBytes\":%u,\"fs\":%s,\"fsBlocks\":%u,"
+                          "\"stored\":%lu,\"lostBlocks\":%lu,\"dps\":[",
+                          vitoHistBoot, (unsigned long)samples, payload, stored,
+                          (unsigned long)vitoHistBlocksOpened, (unsigned)VITO_HIST_RAM_BLOCKS,
+                          (unsigned)VITO_HIST_BLOCK_BYTES, vitoHistFsReady ? "true" : "false",
+                          vitoHistFsBlocks, (unsigned long)vitoHistStored, (unsigned long)vitoHistLostBlocks);
+    for (uint8_t i = 0; i < DP_COUNT && ok; ++i) {
+        const VitoHistWriter& w = vitoHistWriters[i];
+        ok = vitoAppendf(buf, sizeof(buf), n, "%s{\"dp\":\"%s\",\"samples\":%lu,\"bytesPerSample\":%.2f}",
+                         i ? "," : "", vitoDpNames[i], (unsigned long)w.samples,
+                         w.samples ? (double)w.payloadBits / 8.0 / w.samples : 0.0);
+    }
+    return ok && vitoAppendf(buf, sizeof(buf), n, "]}") ? buf : nullptr;
+}
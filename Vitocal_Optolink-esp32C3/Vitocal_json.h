@@ -0,0 +1,35 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Bounded JSON building
+//
+// The HTTP handlers and MQTT topics build their documents with snprintf()
+// into fixed buffers. vitoAppendf() appends one piece only if it fits
+// completely and reports whether it did, so a builder can stop and send an
+// error (or skip the publish) instead of a document cut in the middle.
+// ---------------------------------------------------------------------------
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Append to buf (size bytes, n of them used). false, with buf and n as they
+// were, if the piece does not fit.
+inline bool vitoAppendf(char* buf, size_t size, size_t& n, const char* fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+inline bool vitoAppendf(char* buf, size_t size, size_t& n, const char* fmt, ...) {
+    if (n >= size) {
+        return false;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    int w = vsnprintf(buf + n, size - n, fmt, ap);
+    va_end(ap);
+    if (w < 0 || (size_t)w >= size - n) {
+        buf[n] = '\0';
+        return false;
+    }
+    n += (size_t)w;
+    return true;
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Deferred binary log
+//
+// The VitoWiFi callbacks used to print every value with a handful of
+// CONSOLE_SERIAL.print() calls, each one a WebSerial frame, from inside
+// vitoWIFI.loop(). Now they append a 16-byte record (time, event, datapoint,
+// raw value) to a single-producer/single-consumer ring (Vitocal_spsc.h). Text
+// is only made in loop(), which drains a few records per iteration
+// (vitoLogDrain) and writes each as one line with a single write.
+//
+// There is one ring per producer: loop() and the Optolink task
+// (Vitocal_optotask.h), which marks its thread with vitoLogProducer. The drain
+// takes the older head of the two, so lines come out in time order.
+//
+// Events below VITO_LOG_LEVEL compile to nothing. A full ring drops the new
+// record and counts it; the drain reports the count once per burst.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_blockread.h"
+#include "Vitocal_writequeue.h"
+#include "Vitocal_spsc.h"
+
+#define VITO_LOG_NONE  0
+#define VITO_LOG_ERROR 1
+#define VITO_LOG_INFO  2
+#define VITO_LOG_DEBUG 3   // every value and response
+
+#ifndef VITO_LOG_LEVEL
+#define VITO_LOG_LEVEL VITO_LOG_DEBUG
+#endif
+#ifndef VITO_LOG_SIZE
+#define VITO_LOG_SIZE 128              // records per producer, power of two (16 B each)
+#endif
+#ifndef VITO_LOG_DRAIN_PER_LOOP
+#define VITO_LOG_DRAIN_PER_LOOP 2      // lines formatted per loop() iteration
+#endif
+
+
+enum VitoLogEvent : uint8_t {
+    VITO_EV_VALUE_F = 0,   // dp, value = float bits, arg = ms since previous update
+    VITO_EV_VALUE_U,       // dp, value = uint8, arg = dt
+    VITO_EV_VALUE_LABEL,   // dp, value = uint8 (label looked up when formatted), arg = dt
+    VITO_EV_COMBINED,      // dp, value = derived uint8 (e.g. combined E-heater stage), arg = dt
+    VITO_EV_RESPONSE,      // dp, block: aux = address, value = length; arg = ms since request
+    VITO_EV_WRITE_ACK,     // dp
+    VITO_EV_WRITE,         // dp, aux = VitoWriteResult, value = written float, arg = latency / read-back bits
+    VITO_EV_ERROR,         // dp, block: aux = address, arg = length; value = OptolinkResult
+    VITO_EV_BACKOFF,       // link recovery started, value = polling pause, arg = errors in a row
+    VITO_EV_CYCLE,         // periodic "read cycle running"
+    VITO_EV_WIFI_UP,       // arg = ms without network
+    VITO_EV_WIFI_DOWN,     // value = 1 attempt failed / 0 connection lost, arg = retry delay
+    VITO_EV_BREAKER,       // dp, value = VitoBreakerEvent, arg = quarantine ms
+    VITO_EV_LINK_UP,       // link recovered, arg = ms since the first error
+    VITO_EV_PLAN,          // block reads planned, aux = fast, value = medium, arg = slow
+    VITO_EV_PROTOCOL       // protocol detected, value = VitoProtocol (1 = VS2), arg = ms it took
+};
+
+enum VitoLogProducer : uint8_t {
+    VITO_LOG_LOOP = 0,     // loop(), setup() and the MQTT callbacks
+    VITO_LOG_OPTO,         // the Optolink task
+    VITO_LOG_PRODUCERS
+};
+
+struct VitoLogRecord {
+    uint32_t ms;
+    uint8_t  event;
+    uint8_t  dp;       // VitoDpId or VITO_DP_NONE
+    uint16_t aux;
+    uint32_t value;
+    uint32_t arg;
+};
+
+static VitoSpsc<VitoLogRecord, VITO_LOG_SIZE> vitoLogRings[VITO_LOG_PRODUCERS];
+static thread_local uint8_t vitoLogProducer = VITO_LOG_LOOP;   // ring of the calling thread
+static uint32_t             vitoLogDroppedReported = 0;
+
+// Formatting helpers, defined in the sketch next to vitoDpTable
+const char* vitoLogTag(uint8_t id);
+const char* vitoLogLabel(uint8_t id, uint8_t value);
+
+inline uint32_t vitoLogFloatBits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float vitoLogBitsFloat(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Append one record (producer side). Compiles away below VITO_LOG_LEVEL.
+inline void vitoLog(uint8_t level, uint8_t event, uint8_t dp, uint16_t aux, uint32_t value, uint32_t arg) {
+    if (level > VITO_LOG_LEVEL) {
+        return;
+    }
+    VitoLogRecord r = {millis(), event, dp, aux, value, arg};
+    vitoLogRings[vitoLogProducer].push(r);
+}
+
+// Value of datapoint id; takes over the Δt bookkeeping of the old logDp*().
+inline void vitoLogValue(uint8_t event, uint8_t id, uint32_t value, uint32_t& lastMs) {
+    if (VITO_LOG_DEBUG > VITO_LOG_LEVEL) {
+        return;
+    }
+    uint32_t now = millis();
+    uint32_t dt  = lastMs ? (now - lastMs) : 0;
+    lastMs = now;
+    vitoLog(VITO_LOG_DEBUG, event, id, 0, value, dt);
+}
+
+inline const char* vitoLogRequestName(uint8_t dp) {
+    return dp < DP_COUNT ? vitoDpNames[dp] : "?";
+}
+
+// A block read is logged by address and length, not by its index: the task
+// re-plans vitoBlocks[] while loop() formats older records.
+inline const char* vitoLogRequestName(uint8_t dp, uint16_t address, uint32_t length,
+                                      char* buf, size_t size) {
+    if (length == 0) {
+        return vitoLogRequestName(dp);
+    }
+    snprintf(buf, size, "block 0x%04X+%u", address, (unsigned)length);
+    return buf;
+}
+
+// One record as a text line (with newline); returns its length.
+inline size_t vitoLogFormat(const VitoLogRecord& r, char* buf, size_t size) {
+    int n = snprintf(buf, size, "[%lu] ", (unsigned long)r.ms);
+    if (n < 0 || (size_t)n >= size) {
+        return 0;
+    }
+    char* p = buf + n;
+    size_t left = size - n;
+    char dtBuf[24] = "";
+    if (r.arg) {
+        snprintf(dtBuf, sizeof(dtBuf), " (Δt=%lu ms)", (unsigned long)r.arg);
+    }
+    char name[VITO_DP_NAME_LEN];
+
+    switch (r.event) {
+    case VITO_EV_VALUE_F:
+        n = snprintf(p, left, "%s: %.1f%s\n", vitoLogTag(r.dp), (double)vitoLogBitsFloat(r.value), dtBuf);
+        break;
+    case VITO_EV_VALUE_U:
+        n = snprintf(p, left, "%s: %lu%s\n", vitoLogTag(r.dp), (unsigned long)r.value, dtBuf);
+        break;
+    case VITO_EV_VALUE_LABEL:
+        n = snprintf(p, left, "%s: %lu -> %s%s\n", vitoLogTag(r.dp), (unsigned long)r.value,
+                     vitoLogLabel(r.dp, (uint8_t)r.value), dtBuf);
+        break;
+    case VITO_EV_COMBINED:
+        n = snprintf(p, left, "%s (combined): %lu%s\n", vitoDpNames[r.dp], (unsigned long)r.value, dtBuf);
+        break;
+    case VITO_EV_RESPONSE:
+        n = snprintf(p, left, "onVitoResponse for %s (Δreq=%lu ms)\n",
+                     vitoLogRequestName(r.dp, r.aux, r.value, name, sizeof(name)), (unsigned long)r.arg);
+        break;
+    case VITO_EV_WRITE_ACK:
+        n = snprintf(p, left, "onVitoResponse for %s (write ack)\n", vitoLogRequestName(r.dp));
+        break;
+    case VITO_EV_WRITE:
+        if (r.aux == VITO_WRITE_CONFIRMED) {
+            n = snprintf(p, left, "[write] %s=%.1f ok (%lu ms)\n", vitoLogRequestName(r.dp),
+                         (double)vitoLogBitsFloat(r.value), (unsigned long)r.arg);
+        } else if (r.aux == VITO_WRITE_MISMATCH) {
+            n = snprintf(p, left, "[write] %s=%.1f rejected, is %.1f\n", vitoLogRequestName(r.dp),
+                         (double)vitoLogBitsFloat(r.value), (double)vitoLogBitsFloat(r.arg));
+        } else {
+            n = snprintf(p, left, "[write] %s=%.1f failed\n", vitoLogRequestName(r.dp),
+                         (double)vitoLogBitsFloat(r.value));
+        }
+        break;
+    case VITO_EV_ERROR:
+        n = snprintf(p, left, "VitoWiFi error for %s: %lu\n",
+                     vitoLogRequestName(r.dp, r.aux, r.arg, name, sizeof(name)), (unsigned long)r.value);
+        break;
+    case VITO_EV_BACKOFF:
+        n = snprintf(p, left, "Too many consecutive VitoWiFi errors (%lu); reinitializing VitoWiFi, "
+                     "polling paused for %lu ms\n", (unsigned long)r.arg, (unsigned long)r.value);
+        break;
+    case VITO_EV_CYCLE:
+        n = snprintf(p, left, "VitoWiFi read cycle running\n");
+        break;
+    case VITO_EV_WIFI_UP:
+        n = snprintf(p, left, "WiFi connected after %lu ms\n", (unsigned long)r.arg);
+        break;
+    case VITO_EV_WIFI_DOWN:
+        n = snprintf(p, left, "WiFi %s, retry in %lu ms\n", r.value ? "connect failed" : "connection lost",
+                     (unsigned long)r.arg);
+        break;
+    case VITO_EV_BREAKER:
+        if (r.value == 2) {
+            n = snprintf(p, left, "Block read with %s keeps failing; reading its members one by one\n",
+                         vitoLogRequestName(r.dp));
+        } else if (r.value == 1) {
+            n = snprintf(p, left, "%s keeps failing; quarantined for %lu s\n",
+                         vitoLogRequestName(r.dp), (unsigned long)(r.arg / 1000));
+        } else {
+            n = snprintf(p, left, "%s reads again; quarantine lifted\n", vitoLogRequestName(r.dp));
+        }
+        break;
+    case VITO_EV_LINK_UP:
+        n = snprintf(p, left, "Optolink recovered %lu ms after the first error\n", (unsigned long)r.arg);
+        break;
+    case VITO_EV_PLAN:
+        n = snprintf(p, left, "Block reads: fast %u, medium %lu, slow %lu\n", r.aux, (unsigned long)r.value,
+                     (unsigned long)r.arg);
+        break;
+    case VITO_EV_PROTOCOL:
+        n = snprintf(p, left, "Optolink protocol: %s (detected in %lu ms)\n", r.value ? "VS2 (P300)" : "VS1 (KW)",
+                     (unsigned long)r.arg);
+        break;
+    default:
+        n = snprintf(p, left, "event %u dp %u: %lu %lu\n", r.event, r.dp, (unsigned long)r.value,
+                     (unsigned long)r.arg);
+        break;
+    }
+    if (n < 0) {
+        return 0;
+    }
+    return size - left + ((size_t)n < left ? (size_t)n : left - 1);
+}
+
+// Format and write up to max records, oldest first over all producers
+// (consumer side, loop() context).
+inline void vitoLogDrain(Print& out, uint8_t max) {
+    char line[128];
+    uint32_t dropped = 0;
+    for (const auto& ring : vitoLogRings) {
+        dropped += ring.dropped.load(std::memory_order_relaxed);
+    }
+    if (dropped != vitoLogDroppedReported) {
+        int n = snprintf(line, sizeof(line), "[log] %lu records dropped\n",
+                         (unsigned long)(dropped - vitoLogDroppedReported));
+        out.write(reinterpret_cast<const uint8_t*>(line), (size_t)n);
+        vitoLogDroppedReported = dropped;
+    }
+    for (; max > 0; --max) {
+        const VitoLogRecord* oldest = nullptr;
+        uint8_t from = 0;
+        for (uint8_t i = 0; i < VITO_LOG_PRODUCERS; ++i) {
+            const VitoLogRecord* r = vitoLogRings[i].peek();
+            if (r != nullptr && (oldest == nullptr || (int32_t)(r->ms - oldest->ms) < 0)) {
+                oldest = r;
+                from = i;
+            }
+        }
+        if (oldest == nullptr) {
+            return;
+        }
+        VitoLogRecord r = *oldest;
+        vitoLogRings[from].skip();
+        size_t n = vitoLogFormat(r, line, sizeof(line));
+        if (n) {
+            out.write(reinterpret_cast<const uint8_t*>(line), n);
+        }
+    }
+}
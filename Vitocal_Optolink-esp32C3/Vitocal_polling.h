@@ -2,13 +2,21 @@
 
 #include <stdint.h>
 
-struct VitoPollGroupState {
-  uint8_t index;            // next datapoint index within the group
-  uint32_t lastRequestMs;   // time of the last successful read() queue
-  uint32_t  lastRoundEndMs; // we now treat this as "lastRoundStartMs"
-  uint32_t intervalMs;      // minimum delay between full rounds
+// Poll classes: the former fast/medium/slow groups. A class interval (HA
+// Number entities) scales the periods and age budgets of its datapoints.
+enum VitoPollClass : uint8_t {
+  VITO_CLASS_FAST = 0,
+  VITO_CLASS_MEDIUM,
+  VITO_CLASS_SLOW,
+  VITO_CLASS_COUNT
 };
 
-extern VitoPollGroupState vitoFastState;
-extern VitoPollGroupState vitoMediumState;
-extern VitoPollGroupState vitoSlowState;
+struct VitoPollClassState {
+  uint32_t defaultIntervalMs; // interval the per-DP defaults are written for
+  uint32_t intervalMs;        // current interval
+};
+
+extern VitoPollClassState vitoPollClasses[VITO_CLASS_COUNT];
+
+// Set a class interval and rescale the period/max age of its datapoints.
+void vitoSetClassInterval(uint8_t cls, uint32_t intervalMs);
@@ -0,0 +1,200 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Datapoint value store
+//
+// The state of every polled datapoint in one place, as parallel arrays
+// indexed by VitoDpId: raw reply bytes, decoded value, time of the last read
+// and of the last change, a sequence number and the error state. loop()
+// owns it; vitoDispatch() puts every reply in with vitoValPut().
+//
+// A reply with the same bytes as the stored one (memcmp) only refreshes the
+// read time: it is not decoded and reaches no consumer. New bytes bump the
+// sequence number, drop the decoded value and go to the subscribed sinks
+// (text log, history, live stream, derived figures), which read the value
+// back with vitoValGet(). The first of them decodes it, the others get the
+// decoded copy until the bytes change again.
+//
+// The REST API reads the store from the async_tcp task: vitoValCopy() takes
+// the fields it shows under vitoValLock and the API decodes its copy itself
+// (vitoValDecode), so the decoded values stay loop() state.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <VitoWiFi.h>
+#include "Vitocal_datapoints.h"
+#include "Vitocal_blockread.h"
+
+#ifndef VITO_VAL_RAW_MAX
+#define VITO_VAL_RAW_MAX 4             // raw reply bytes kept per datapoint
+#endif
+#ifndef VITO_VAL_SINKS
+#define VITO_VAL_SINKS 8
+#endif
+
+#define VITO_VAL_NO_ERROR 0xFF
+
+// Consumer of changed values: datapoint, time of the reply, ms since the
+// previous change (0 for the first value).
+typedef void (*VitoValSink)(uint8_t id, uint32_t now, uint32_t sinceMs);
+
+static uint8_t      vitoValRaw[DP_COUNT][VITO_VAL_RAW_MAX];
+static uint8_t      vitoValRawLen[DP_COUNT];
+static VitoDpValue  vitoValDecoded[DP_COUNT];     // current while the vitoValFresh bit is set
+static uint32_t     vitoValReadMs[DP_COUNT];      // last good read, 0 = none yet
+static uint32_t     vitoValChangedMs[DP_COUNT];   // last read with new bytes
+static uint32_t     vitoValSeq[DP_COUNT];         // vitoValSeqAll of the last change (value or error)
+static uint32_t     vitoValErrors[DP_COUNT];      // since boot
+static uint32_t     vitoValErrorMs[DP_COUNT];     // last error
+static uint16_t     vitoValConsecutive[DP_COUNT]; // errors since the last good read
+static uint8_t      vitoValLastError[DP_COUNT];   // vitoMetricErrorIndex(), VITO_VAL_NO_ERROR = none
+static VitoDpSet    vitoValKnown  = {};           // bytes stored
+static VitoDpSet    vitoValFresh  = {};           // vitoValDecoded is current
+static uint32_t     vitoValSeqAll = 0;            // bumped on every change of the store
+static std::mutex   vitoValLock;                  // writes of loop() vs. reads of the async_tcp task
+static const VitoDpEntry* vitoValTable = nullptr;
+static VitoValSink  vitoValSinks[VITO_VAL_SINKS];
+static uint8_t      vitoValSinkCount = 0;
+// statistics since boot
+static uint32_t     vitoValPuts      = 0;   // good replies
+static uint32_t     vitoValUnchanged = 0;   // ... with the stored bytes: no decode, no sinks
+static uint32_t     vitoValDecodes   = 0;
+
+// setup(): empty store; table gives kind and labels for the decode.
+inline void vitoValInit(const VitoDpEntry* table) {
+    vitoValTable = table;
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        vitoValLastError[i] = VITO_VAL_NO_ERROR;
+    }
+}
+
+// setup(): fn runs on every change, in the order of subscription.
+inline bool vitoValSubscribe(VitoValSink fn) {
+    if (vitoValSinkCount >= VITO_VAL_SINKS) {
+        return false;
+    }
+    vitoValSinks[vitoValSinkCount++] = fn;
+    return true;
+}
+
+inline VitoDpValue vitoValDecode(uint8_t id, const uint8_t* raw, uint8_t len) {
+    return vitoDecodeEntry(vitoValTable[id], vitoDpDatapoint(id).decode(raw, len));
+}
+
+// --- loop() ----------------------------------------------------------------------------
+// vitoDispatch(): a good reply of datapoint id. true if its bytes changed;
+// only then have the sinks run.
+inline bool vitoValPut(uint8_t id, const uint8_t* raw, uint8_t len, uint32_t now) {
+    if (len > VITO_VAL_RAW_MAX) {
+        len = VITO_VAL_RAW_MAX;
+    }
+    bool known = vitoDpSetHas(vitoValKnown, id);
+    bool same = known && vitoValRawLen[id] == len && memcmp(vitoValRaw[id], raw, len) == 0;
+    uint32_t since = known ? now - vitoValChangedMs[id] : 0;
+    vitoValPuts++;
+    {
+        std::lock_guard<std::mutex> lock(vitoValLock);
+        vitoValReadMs[id] = now ? now : 1;
+        if (!same) {
+            memcpy(vitoValRaw[id], raw, len);
+            vitoValRawLen[id]    = len;
+            vitoValChangedMs[id] = vitoValReadMs[id];
+        }
+        if (!same || vitoValConsecutive[id] != 0) {
+            vitoValConsecutive[id] = 0;
+            vitoValSeq[id] = ++vitoValSeqAll;
+        }
+    }
+    if (same) {
+        vitoValUnchanged++;
+        return false;
+    }
+    vitoDpSetAdd(vitoValKnown, id);
+    vitoDpSetRemove(vitoValFresh, id);
+    for (uint8_t i = 0; i < vitoValSinkCount; ++i) {
+        vitoValSinks[i](id, now, since);
+    }
+    return true;
+}
+
+// Decoded value of datapoint id, decoded on the first call after a change;
+// zero (no label) until the first reply. loop() only.
+inline const VitoDpValue& vitoValGet(uint8_t id) {
+    if (!vitoDpSetHas(vitoValFresh, id)) {
+        if (vitoDpSetHas(vitoValKnown, id)) {
+            vitoValDecoded[id] = vitoValDecode(id, vitoValRaw[id], vitoValRawLen[id]);
+            vitoValDecodes++;
+        } else {
+            vitoValDecoded[id] = {0.0f, 0, nullptr};
+        }
+        vitoDpSetAdd(vitoValFresh, id);
+    }
+    return vitoValDecoded[id];
+}
+
+inline bool vitoValHas(uint8_t id) {
+    return vitoDpSetHas(vitoValKnown, id);
+}
+
+inline void vitoValMarkError(uint8_t id, uint8_t code, uint32_t now) {
+    vitoValErrors[id]++;
+    vitoValErrorMs[id]   = now ? now : 1;
+    vitoValLastError[id] = code;
+    if (vitoValConsecutive[id] < UINT16_MAX) {
+        vitoValConsecutive[id]++;
+    }
+    vitoValSeq[id] = ++vitoValSeqAll;
+}
+
+// A failed read of datapoint id (a failed block read arrives once per member);
+// code is vitoMetricErrorIndex() of the result. The last good value stays.
+inline void vitoValOnError(uint8_t id, uint8_t code, uint32_t now) {
+    std::lock_guard<std::mutex> lock(vitoValLock);
+    if (id < DP_COUNT) {
+        vitoValMarkError(id, code, now);
+    }
+}
+
+// --- other tasks -----------------------------------------------------------------------
+struct VitoValView {
+    uint32_t readMs;        // 0 = no value yet
+    uint32_t seq;
+    uint32_t errors;
+    uint32_t errorMs;
+    uint16_t consecutive;
+    uint8_t  lastError;
+    uint8_t  rawLen;
+    uint8_t  raw[VITO_VAL_RAW_MAX];
+};
+
+inline void vitoValCopy(uint8_t id, VitoValView& v) {
+    std::lock_guard<std::mutex> lock(vitoValLock);
+    v.readMs      = vitoValReadMs[id];
+    v.seq         = vitoValSeq[id];
+    v.errors      = vitoValErrors[id];
+    v.errorMs     = vitoValErrorMs[id];
+    v.consecutive = vitoValConsecutive[id];
+    v.lastError   = vitoValLastError[id];
+    v.rawLen      = vitoValRawLen[id];
+    memcpy(v.raw, vitoValRaw[id], sizeof(v.raw));
+}
+
+// Sequence number of one datapoint, or of the whole store (VITO_DP_NONE).
+inline uint32_t vitoValSeqOf(uint8_t id) {
+    std::lock_guard<std::mutex> lock(vitoValLock);
+    return id < DP_COUNT ? vitoValSeq[id] : vitoValSeqAll;
+}
+
+// --- metrics (Vitocal_metrics.h) ---------------------------------------------------------
+#define VITO_VAL_METRICS 3
+
+inline double vitoValMetricValue(uint8_t m) {
+    switch (m) {
+    case 0:  return vitoValPuts;
+    case 1:  return vitoValUnchanged;
+    default: return vitoValDecodes;
+    }
+}
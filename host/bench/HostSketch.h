@@ -0,0 +1,157 @@
+// Interface between the host benches and a sketch compiled by sketch_main.cpp.
+#pragma once
+
+#include <Arduino.h>
+#include <VitoWiFi.h>
+#include <ESPAsyncWebServer.h>
+
+// The sketch's own entry points
+void setup();
+void loop();
+
+struct HostPollGroup {
+    const char*                name;
+    const VitoWiFi::Datapoint* members;       // in poll order
+    int                        size;
+    int                        transactions;  // Optolink reads per round
+};
+
+struct HostWriteStats {
+    uint32_t confirmed;
+    uint32_t failed;
+    uint32_t coalesced;
+    double   meanLatencyMs;   // command -> read-back confirmation
+    uint32_t maxLatencyMs;
+};
+
+struct HostMqttQueueStats {
+    uint32_t depth;
+    uint32_t highWater;
+    uint32_t queued;
+    uint32_t dropped;
+    uint32_t replayed;
+    float    replayRate;   // messages/s of the last replay
+};
+
+struct HostDefsStats {
+    uint32_t count;      // definitions loaded from /datapoints.csv
+    uint32_t badLines;
+    uint32_t ramBytes;   // tables + entities
+    uint32_t reads;
+    uint32_t errors;
+    uint32_t neverRead;
+    uint32_t maxAgeMs;   // oldest value at the end (never read ones excluded)
+};
+
+struct HostBreakerStats {
+    uint32_t quarantines;      // circuit breaker trips, datapoints and definitions
+    uint32_t open;             // breakers open at the end
+    double   lostS;            // Optolink time spent on failed reads
+    uint32_t recoveries;       // link recoveries completed
+    uint32_t lastRecoveryMs;
+    const char* linkState;
+};
+
+struct HostOptoStats {
+    bool     task;             // false: the Optolink step ran from loop()
+    uint32_t steps;
+    uint32_t stepMaxUs;        // start to start
+    double   stepMeanUs;
+    uint32_t ringHighWater;    // messages waiting for loop()
+    uint32_t ringDropped;
+};
+
+struct HostDiscoveryStats {
+    uint32_t sent;             // configs handed to ArduinoHA or published by the sketch
+    uint32_t skipped;          // unchanged, retained by the broker
+    uint32_t queued;           // still waiting
+    uint32_t lastPassMs;       // connect -> queue empty, last completed pass
+};
+
+struct HostValueStats {
+    uint32_t replies;          // good replies put into the value store
+    uint32_t unchanged;        // ... with the stored bytes: not decoded, not passed on
+    uint32_t decodes;
+};
+
+struct HostTemperature {
+    const char* name;          // log tag
+    float       value;         // decoded, degrees C
+};
+
+struct HostDispatchCost {
+    double unchangedNs;        // loop() side of one reply, same bytes as the last one
+    double changedNs;          // ... new bytes
+    uint32_t messages;         // per variant
+};
+
+struct HostReplayStats {
+    bool     valid;            // the header is a trace of this version
+    bool     truncated;        // fewer record bytes than the header announces
+    uint8_t  protocol;         // VitoProtocol
+    uint32_t records;
+    uint32_t skipped;          // records before the first event (detection, wrapped ring)
+    uint32_t requests;         // reads and writes handed to the parser
+    uint32_t unresolved;       // ... of an address/length the sketch does not read
+    uint32_t rejected;         // ... the parser refused (busy): the replay went out of step
+    uint32_t rxBytes;
+    uint32_t txBytes;          // written by the parser
+    uint32_t txMismatches;     // ... other than recorded, or more
+    uint32_t stalled;          // RX bytes the parser left unread
+    uint32_t responses;
+    uint32_t errors;
+    uint32_t messages;         // VitoOptoMsg dispatched on the loop() side
+    uint32_t digest;           // FNV-1a of those messages without their times
+    double   traceS;           // recorded time span
+    double   wallS;            // replay time
+};
+
+struct HostLoopStats {
+    uint32_t minUs;
+    uint32_t maxUs;
+    float    meanUs;
+    uint32_t samples;
+};
+
+// Polling groups as configured in the sketch (fast/medium/slow).
+size_t hostPollGroups(HostPollGroup* out, size_t max);
+// Override the group intervals after setup(); 0 keeps the sketch default.
+void hostSetPollIntervals(uint32_t fastMs, uint32_t mediumMs, uint32_t slowMs);
+// Optolink protocol the sketch selected in setup(), e.g. "VS2 (P300)".
+const char* hostProtocolName();
+// Loop-to-loop timing as collected by myRuntimeMeasurement(); resets the window.
+HostLoopStats hostTakeLoopStats();
+// Room setpoint command as if sent from the HA Number entity.
+void hostRaumSollCommand(float value);
+// Write queue totals over all entities.
+HostWriteStats hostWriteStats();
+// Store-and-forward queue of the sketch (Vitocal_mqttqueue.h).
+HostMqttQueueStats hostMqttQueueStats();
+// LittleFS datapoint definitions (Vitocal_dpdefs.h).
+HostDefsStats hostDefsStats();
+// Circuit breakers and link recovery (Vitocal_breaker.h).
+HostBreakerStats hostBreakerStats();
+// Optolink task (Vitocal_optotask.h).
+HostOptoStats hostOptoStats();
+// Paced discovery (Vitocal_discovery.h).
+HostDiscoveryStats hostDiscoveryStats();
+// Value store (Vitocal_values.h).
+HostValueStats hostValueStats();
+// Decoded value of every temperature datapoint that has had a reply; call
+// after hostStopOptolink().
+size_t hostTemperatures(HostTemperature* out, size_t max);
+// Replays every stored reply rounds times through the sketch's dispatch, once
+// with the same bytes and once with new ones; call after hostStopOptolink().
+HostDispatchCost hostDispatchCost(uint32_t rounds);
+// Feeds a trace (GET /capture, Vitocal_capture.h) through a VitoWiFi parser
+// with the sketch's callbacks on a manual clock and dispatches what they
+// post; call after hostStopOptolink().
+HostReplayStats hostReplayTrace(const uint8_t* trace, size_t len);
+// Stop the Optolink task; call before reading the results or stopping the emulator.
+void hostStopOptolink();
+// The sketch's SSE endpoint (/events).
+AsyncEventSource& hostEvents();
+// GET url on the sketch's web server, in-process.
+HostHttpResponse hostHttpGet(const char* url, const HostHttpHeaders& headers = {});
+// POST body to url, in-process.
+HostHttpResponse hostHttpPost(const char* url, const std::string& body);
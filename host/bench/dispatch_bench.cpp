@@ -0,0 +1,129 @@
+// ---------------------------------------------------------------------------
+// Dispatch microbenchmark: cost of routing one Optolink response to its
+// datapoint handler, old vs. new, for N polled datapoints.
+//
+//   strcmp   - the former onVitoResponse(): linear strcmp() scan of the
+//              dpTiming[] table for the request time, then an if/else
+//              ladder of isDp() (strcmp) checks to find the handler
+//   registry - vitoDpIndexOf() on the name pointer + VitoDpEntry table
+//              (Vitocal_registry.h)
+//
+// Both variants decode the value and update a HASensorNumber, so the
+// difference is the lookup itself. Responses arrive in a pseudo-random order.
+//
+// Usage: vito_dispatch_bench [--iterations N]
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <ArduinoHA.h>
+#include <VitoWiFi.h>
+#include "Vitocal_registry.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const size_t NAME_LEN = 24;
+
+struct Fixture {
+    size_t                                        count;
+    std::vector<char>                             names;      // count rows of NAME_LEN
+    std::vector<VitoWiFi::Datapoint>              dps;
+    std::vector<std::unique_ptr<HASensorNumber>>  sensors;
+    std::vector<VitoDpEntry>                      table;
+    std::vector<uint32_t>                         lastRequestMs;
+    std::vector<uint16_t>                         order;      // response sequence
+
+    explicit Fixture(size_t n) : count(n), names(n * NAME_LEN), lastRequestMs(n, 1) {
+        for (size_t i = 0; i < n; ++i) {
+            // same prefix everywhere, like the real names share "Temp", "Rel", ...
+            snprintf(&names[i * NAME_LEN], NAME_LEN, "Datapoint%03u", (unsigned)i);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            dps.emplace_back(&names[i * NAME_LEN], (uint16_t)(0x0100 + i), 2, VitoWiFi::div10);
+            sensors.emplace_back(new HASensorNumber(&names[i * NAME_LEN], HASensorNumber::PrecisionP1));
+            table.push_back({ &names[i * NAME_LEN], VitoDpKind::Temperature, sensors.back().get(),
+                              nullptr, 0, nullptr });
+        }
+        uint32_t rng = 12345;
+        order.resize(4096);
+        for (uint16_t& o : order) {
+            rng = rng * 1103515245u + 12345u;
+            o = (uint16_t)((rng >> 16) % n);
+        }
+    }
+};
+
+volatile uint32_t gSink = 0;
+
+// Former onVitoResponse(): timing scan + ladder, both by strcmp
+void dispatchStrcmp(Fixture& f, const VitoWiFi::Datapoint& request, const uint8_t* data, uint8_t length) {
+    uint32_t now = millis();
+    uint32_t dtReqMs = 0;
+    for (size_t i = 0; i < f.count; ++i) {
+        if (strcmp(request.name(), f.dps[i].name()) == 0) {
+            dtReqMs = now - f.lastRequestMs[i];
+            break;
+        }
+    }
+    VitoWiFi::VariantValue value = request.decode(data, length);
+    for (size_t i = 0; i < f.count; ++i) {
+        if (strcmp(request.name(), f.dps[i].name()) == 0) {
+            float temp = value;
+            f.sensors[i]->setValue(temp);
+            break;
+        }
+    }
+    gSink += dtReqMs;
+}
+
+void dispatchRegistry(Fixture& f, const VitoWiFi::Datapoint& request, const uint8_t* data, uint8_t length) {
+    uint32_t now = millis();
+    uint8_t id = vitoDpIndexOf(request.name(), f.names.data(), f.count, NAME_LEN);
+    if (id == VITO_DP_NONE) {
+        return;
+    }
+    uint32_t dtReqMs = now - f.lastRequestMs[id];
+    vitoApplyEntry(f.table[id], request.decode(data, length));
+    gSink += dtReqMs;
+}
+
+template <typename Fn>
+double measureNs(Fixture& f, uint32_t iterations, Fn fn) {
+    uint8_t data[2] = {0xD2, 0x00};
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        const VitoWiFi::Datapoint& dp = f.dps[f.order[i & 4095]];
+        data[0] = (uint8_t)i;  // keep setValue() from short-circuiting on equal values
+        fn(f, dp, data, 2);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    uint32_t iterations = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && !strcmp(argv[i], "--iterations")) {
+            iterations = (uint32_t)atoi(argv[++i]);
+            continue;
+        }
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    printf("== dispatch bench: ns per response, %u iterations ==\n", iterations);
+    printf("%6s %12s %12s %9s\n", "N", "strcmp", "registry", "speedup");
+    const size_t sizes[] = {23, 50, 100, 200};
+    for (size_t n : sizes) {
+        Fixture f(n);
+        measureNs(f, iterations / 10, dispatchStrcmp);  // warm-up
+        double oldNs = measureNs(f, iterations, dispatchStrcmp);
+        double newNs = measureNs(f, iterations, dispatchRegistry);
+        printf("%6zu %12.1f %12.1f %8.1fx\n", n, oldNs, newNs, newNs > 0 ? oldNs / newNs : 0.0);
+    }
+    return 0;
+}
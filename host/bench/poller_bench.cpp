@@ -0,0 +1,766 @@
+// ---------------------------------------------------------------------------
+// Poller benchmark: runs the real sketch (setup()/loop()) against the
+// software Vitotronic on a pty and reports
+//   - reads/second (Optolink transactions and datapoint updates) and
+//     request->response round-trip time
+//   - round completion time per polling group
+//   - per-datapoint update period and staleness (max gap, age at end)
+//   - loop-to-loop timing as seen by myRuntimeMeasurement()
+//   - with --slider-every-ms: HA room setpoint "slider drags" (5 commands,
+//     100 ms apart) and the write queue's command -> confirmation latency
+//   - with --console-cost-us: each WebSerial write costs that long (one
+//     websocket frame on the device), to see console output in loop timing
+//   - with --mqtt-cost-us: each MQTT publish blocks that long (slow broker)
+//   - Optolink timing: request gap (response -> next request, the sketch's
+//     response gap plus whatever held the poller up) and round trip as
+//     p50/p99/max, and the Optolink task's step interval
+//   - MQTT packets and bytes per hour without discovery (compare
+//     VITO_MQTT_BATCH 0 and 1)
+//   - derived figures: GET /aggregates at the end (windowed temperatures,
+//     spread, compressor starts, relay duty; the window runs in real time),
+//     each checked against a plausible range
+//   - with --metrics-out: GET /metrics at the end, written to FILE
+//   - with --profile: GET /profile at the end (loop profiler, stalls)
+//   - with --broker-outage S:L: the MQTT broker is down from S to S+L seconds;
+//     reports the store-and-forward queue and how long the replay took
+//   - with --wifi-outage S:L: the access point is gone from S to S+L seconds;
+//     reports the longest loop() call and the Optolink reads during the
+//     outage and how long MQTT took to come back
+//   - boot: time spent in setup() and until the first Optolink value
+//   - every MQTT connect (boot, --broker-outage, --wifi-outage): time to the
+//     first state, longest loop() call, most MQTT bytes written in one
+//     loop() and the discovery configs sent/skipped until the pass is done
+//   - after any Optolink error: circuit breaker quarantines, time lost on
+//     failed reads and link recoveries (e.g. with --unsupported or stalls)
+//   - with --sse-clients N[:K]: N browsers on /events, K of them never read
+//     (slow clients); reports frames per client and evictions
+//   - with --api-rps N: N REST pollers' requests per second, alternating
+//     /api/state and /api/datapoint/<name> with If-None-Match; reports the
+//     handler time, the 304 share and Optolink requests caused (must be 0)
+//   - with --defs FILE|N: FILE (or N generated sensors) as /datapoints.csv;
+//     reports the loaded count, their RAM, reads and ages, and re-posts the
+//     file to POST /datapoints
+//   - history: GET /history/stats at the end (bytes per sample); with
+//     --history-out the CSV export is written to FILE. LittleFS lives in a
+//     fresh temporary directory, or in --fs-dir DIR to keep it across runs
+//   - value store: replies, the share with unchanged bytes and decodes; then
+//     every stored reply is dispatched --dispatch-rounds times again, with
+//     the same and with new bytes, for the loop() cost of one reply
+//   - with --trace-out FILE: an Optolink capture from the end of setup() on
+//     (POST /capture?run=1; with VITO_CAP_BOOT from boot), GET /capture
+//     written to FILE for vito_trace_replay
+//
+// Usage: vito_poller_bench [--duration S] [--fast-ms N] [--medium-ms N]
+//                          [--slow-ms N] [--slider-every-ms N]
+//                          [--console-cost-us N] [--mqtt-cost-us N] [--metrics-out FILE] [--profile]
+//                          [--history-out FILE] [--fs-dir DIR] [--broker-outage S:L]
+//                          [--wifi-outage S:L] [--sse-clients N[:K]] [--api-rps N] [--defs FILE|N]
+//                          [--dispatch-rounds N] [--trace-out FILE] [--csv FILE]
+//                          [--verbose] [emulator options]
+// ---------------------------------------------------------------------------
+#include "HostSketch.h"
+#include "../emulator/EmulatorOptions.h"
+
+#include <ArduinoHA.h>
+#include <LittleFS.h>
+#include <WebSerial.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct DpStats {
+    uint16_t address    = 0;
+    uint32_t requests   = 0;
+    uint32_t updates    = 0;
+    uint32_t errors     = 0;
+    uint32_t lastReqMs  = 0;
+    uint32_t lastOkMs   = 0;
+    uint64_t gapSumMs   = 0;
+    uint32_t gapMaxMs   = 0;
+    uint32_t gapSamples = 0;
+};
+
+struct GroupStats {
+    HostPollGroup group;
+    bool          inRound    = false;
+    uint32_t      startMs    = 0;
+    uint32_t      rounds     = 0;
+    uint32_t      minMs      = UINT32_MAX;
+    uint32_t      maxMs      = 0;
+    uint64_t      sumMs      = 0;
+};
+
+// One MQTT connect, followed until its discovery pass is done (at most
+// CONNECT_WINDOW_MS): the bytes written in one loop() are what the TCP send
+// buffers have to hold at once on the device.
+struct ConnectStats {
+    uint32_t atMs;
+    bool     open         = true;
+    double   firstStateMs = -1.0;   // connect -> first state or data topic publish
+    uint32_t passMs       = 0;      // connect -> discovery queue empty
+    uint64_t maxLoopUs    = 0;
+    uint64_t maxLoopBytes = 0;
+    uint64_t bytes        = 0;
+};
+const uint32_t CONNECT_WINDOW_MS = 10000;
+
+// A transaction (single datapoint or block read) covers every polled
+// datapoint whose bytes lie inside its address range.
+bool covers(const VitoWiFi::Datapoint& request, const VitoWiFi::Datapoint& dp) {
+    return dp.address() >= request.address() &&
+           dp.address() + dp.length() <= request.address() + request.length();
+}
+
+// Called from the sketch's Optolink task; the main thread reads the atomics
+// while running and everything else after hostStopOptolink().
+class BenchObserver : public VitoWiFi::HostObserver {
+public:
+    std::map<std::string, DpStats> dps;
+    std::vector<GroupStats>        groups;
+    std::atomic<uint32_t> requests{0}, responses{0};
+    std::atomic<uint32_t> loopRequests{0};      // issued from the main thread (loop())
+    std::atomic<bool>     measuring{false};
+    uint32_t writes = 0, updates = 0;
+    uint32_t errorsByCode[8] = {0};
+    uint64_t rttSumMs = 0;
+    uint32_t rttMaxMs = 0;
+    uint32_t firstResponseMs = 0;   // since boot, also before measuring
+    std::thread::id       mainThread = std::this_thread::get_id();
+    uint32_t              doneUs = 0, requestUs = 0;
+    std::vector<uint32_t> gapUs, rttUs;         // response -> next request, request -> response
+
+    void onRequest(const VitoWiFi::Datapoint& dp, bool isWrite) override {
+        if (!measuring) return;
+        uint32_t now = millis();
+        uint32_t us = micros();
+        if (doneUs) {
+            gapUs.push_back(us - doneUs);
+            doneUs = 0;
+        }
+        requestUs = us;
+        requests++;
+        if (std::this_thread::get_id() == mainThread) {
+            loopRequests++;
+        }
+        if (isWrite) {
+            writes++;
+            return;
+        }
+        forEachMember(dp, [&](DpStats& s) {
+            s.requests++;
+            s.lastReqMs = now;
+        });
+        for (GroupStats& g : groups) {
+            if (!g.inRound && g.group.size > 0 && covers(dp, g.group.members[0])) {
+                g.inRound = true;
+                g.startMs = now;
+            }
+        }
+    }
+
+    void onResponse(const VitoWiFi::Datapoint& dp, const uint8_t*, uint8_t) override {
+        uint32_t now = millis();
+        if (firstResponseMs == 0) firstResponseMs = now;
+        if (!measuring) return;
+        doneUs = micros();
+        if (requestUs) {
+            rttUs.push_back(doneUs - requestUs);
+        }
+        responses++;
+        bool first = true;
+        forEachMember(dp, [&](DpStats& s) {
+            if (first) {
+                uint32_t rtt = now - s.lastReqMs;
+                rttSumMs += rtt;
+                if (rtt > rttMaxMs) rttMaxMs = rtt;
+                first = false;
+            }
+            if (s.lastOkMs) {
+                uint32_t gap = now - s.lastOkMs;
+                s.gapSumMs += gap;
+                s.gapSamples++;
+                if (gap > s.gapMaxMs) s.gapMaxMs = gap;
+            }
+            s.lastOkMs = now;
+            s.updates++;
+            updates++;
+        });
+        endOfRound(dp, now);
+    }
+
+    void onError(VitoWiFi::OptolinkResult error, const VitoWiFi::Datapoint& dp) override {
+        if (!measuring) return;
+        doneUs = micros();
+        errorsByCode[(int)error & 7]++;
+        forEachMember(dp, [&](DpStats& s) { s.errors++; });
+        endOfRound(dp, millis());
+    }
+
+private:
+    template <typename Fn>
+    void forEachMember(const VitoWiFi::Datapoint& request, Fn fn) {
+        for (const GroupStats& g : groups) {
+            for (int i = 0; i < g.group.size; ++i) {
+                const VitoWiFi::Datapoint& m = g.group.members[i];
+                if (covers(request, m)) {
+                    DpStats& s = dps[m.name()];
+                    s.address = m.address();
+                    fn(s);
+                }
+            }
+        }
+    }
+
+    void endOfRound(const VitoWiFi::Datapoint& dp, uint32_t now) {
+        for (GroupStats& g : groups) {
+            if (g.inRound && covers(dp, g.group.members[g.group.size - 1])) {
+                uint32_t d = now - g.startMs;
+                g.inRound = false;
+                g.rounds++;
+                g.sumMs += d;
+                if (d < g.minMs) g.minMs = d;
+                if (d > g.maxMs) g.maxMs = d;
+            }
+        }
+    }
+};
+
+// p-th percentile of v in ms (sorts v)
+double percentileMs(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (double)(v.size() - 1) + 0.5);
+    return v[i] / 1000.0;
+}
+
+// --defs: a file, or N generated sensors on free addresses with mixed periods
+std::string readDefinitions(const char* arg) {
+    std::string out;
+    char* end;
+    unsigned long n = strtoul(arg, &end, 10);
+    if (*end == '\0') {
+        static const char* const periods[] = {"fast", "medium", "slow", "120", "300", "600"};
+        out = "# name,address,length,converter,period,entity,unit,precision\n";
+        for (unsigned long i = 0; i < n; ++i) {
+            char line[96];
+            snprintf(line, sizeof(line), "Gen%03lu,0x%04lX,%u,%s,%s,%s,%s,%u\n", i, 0x7000UL + 4 * i,
+                     i % 3 == 0 ? 4 : 2, i % 3 == 0 ? "noconv" : "div10", periods[i % 6],
+                     i % 10 == 9 ? "binary" : "sensor", i % 3 == 0 ? "" : "°C", i % 3 == 0 ? 0 : 1);
+            out += line;
+        }
+        return out;
+    }
+    FILE* f = fopen(arg, "r");
+    if (f) {
+        char buf[512];
+        size_t len;
+        while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+            out.append(buf, len);
+        }
+        fclose(f);
+    }
+    return out;
+}
+
+// GET /aggregates: each figure against what the plant can produce; prints
+// the ones outside and returns their count. runH: hours since boot.
+uint32_t checkAggregates(const std::string& json, double runH) {
+    uint32_t bad = 0;
+    size_t pos = 0;
+    while ((pos = json.find('"', pos)) != std::string::npos) {
+        size_t end = json.find('"', pos + 1);
+        if (end == std::string::npos || end + 1 >= json.size() || json[end + 1] != ':') {
+            break;
+        }
+        std::string key = json.substr(pos + 1, end - pos - 1);
+        const char* v = json.c_str() + end + 2;
+        pos = end + 2;
+        if (key == "windowS" || !strncmp(v, "null", 4)) {
+            continue;
+        }
+        double x = strtod(v, nullptr);
+        double lo = -40.0, hi = 120.0;   // temperatures, C
+        if (key.find(".duty") != std::string::npos) {
+            lo = 0.0, hi = 100.0;
+        } else if (key.find(".perHour") != std::string::npos) {
+            lo = 0.0, hi = 120.0;
+        } else if (key.find(".runtimeH") != std::string::npos) {
+            lo = 0.0, hi = runH;
+        } else if (!key.compare(0, 7, "spread.")) {
+            lo = -20.0, hi = 40.0;   // flow - return, K
+        }
+        if (!(x >= lo && x <= hi)) {
+            printf("implausible: aggregate %s = %.2f (expected %.0f..%.2f)\n", key.c_str(), x, lo, hi);
+            bad++;
+        }
+    }
+    return bad;
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [--duration S] [--fast-ms N] [--medium-ms N] [--slow-ms N]\n"
+        "          [--slider-every-ms N] [--console-cost-us N] [--mqtt-cost-us N]\n"
+        "          [--metrics-out FILE] [--profile]\n"
+        "          [--history-out FILE] [--fs-dir DIR] [--broker-outage S:L]\n"
+        "          [--wifi-outage S:L] [--sse-clients N[:K]] [--api-rps N] [--defs FILE|N]\n"
+        "          [--dispatch-rounds N] [--trace-out FILE] [--csv FILE]\n"
+        "          [--verbose] [emulator options]\n", argv0);
+    printEmulatorUsage(stderr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    VitotronicEmulatorConfig emuCfg;
+    double      durationS = 60.0;
+    uint32_t    fastMs = 0, mediumMs = 0, slowMs = 0;
+    uint32_t    sliderEveryMs = 0;
+    uint32_t    consoleCostUs = 0;
+    uint32_t    mqttCostUs = 0;
+    const char* csvPath = nullptr;
+    const char* metricsPath = nullptr;
+    const char* historyPath = nullptr;
+    const char* tracePath = nullptr;
+    const char* fsDir = nullptr;
+    double      outageStartS = -1.0, outageLenS = 0.0;
+    double      wifiOutStartS = -1.0, wifiOutLenS = 0.0;
+    unsigned    sseClients = 0, sseSlow = 0;
+    uint32_t    apiRps = 0;
+    uint32_t    dispatchRounds = 1000;
+    const char* defsArg = nullptr;
+    bool        verbose = false;
+    bool        profile = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (parseEmulatorOption(argc, argv, i, emuCfg)) continue;
+        if (i + 1 < argc && !strcmp(a, "--duration"))  { durationS = atof(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--fast-ms"))   { fastMs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--medium-ms")) { mediumMs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--slow-ms"))   { slowMs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--slider-every-ms")) { sliderEveryMs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--console-cost-us")) { consoleCostUs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--mqtt-cost-us"))    { mqttCostUs = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--metrics-out")) { metricsPath = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--history-out")) { historyPath = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--trace-out"))   { tracePath = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--fs-dir"))    { fsDir = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--sse-clients") && sscanf(argv[++i], "%u:%u", &sseClients, &sseSlow) >= 1) {
+            continue;
+        }
+        if (i + 1 < argc && !strcmp(a, "--defs"))      { defsArg = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--api-rps"))   { apiRps = (uint32_t)atoi(argv[++i]); continue; }
+        if (i + 1 < argc && !strcmp(a, "--broker-outage") &&
+            sscanf(argv[++i], "%lf:%lf", &outageStartS, &outageLenS) == 2) {
+            continue;
+        }
+        if (i + 1 < argc && !strcmp(a, "--wifi-outage") &&
+            sscanf(argv[++i], "%lf:%lf", &wifiOutStartS, &wifiOutLenS) == 2) {
+            continue;
+        }
+        if (i + 1 < argc && !strcmp(a, "--csv"))       { csvPath = argv[++i]; continue; }
+        if (i + 1 < argc && !strcmp(a, "--dispatch-rounds")) { dispatchRounds = (uint32_t)atoi(argv[++i]); continue; }
+        if (!strcmp(a, "--verbose"))                   { verbose = true; continue; }
+        if (!strcmp(a, "--profile"))                   { profile = true; continue; }
+        usage(argv[0]);
+        return 2;
+    }
+
+    VitotronicEmulator emu(emuCfg);
+    if (!emu.start()) {
+        return 1;
+    }
+    hostSetSerialDevice(0, emu.slavePath());
+    hostSetConsoleEcho(verbose);
+    char fsTemplate[] = "/tmp/vito_littlefs_XXXXXX";
+    if (!fsDir) {
+        fsDir = mkdtemp(fsTemplate);
+    }
+    hostSetLittleFSRoot(fsDir);
+    std::string defs;
+    if (defsArg) {
+        defs = readDefinitions(defsArg);
+        FILE* f = fopen((std::string(fsDir) + "/datapoints.csv").c_str(), "w");
+        if (f) {
+            fwrite(defs.data(), 1, defs.size(), f);
+            fclose(f);
+        }
+    }
+
+    BenchObserver observer;
+    VitoWiFi::hostObserver() = &observer;
+
+    uint32_t setupStartMs = millis();
+    setup();
+    uint32_t setupMs = millis() - setupStartMs;
+    if (tracePath && hostHttpGet("/capture/stats").body.find("\"running\":true") == std::string::npos) {
+        hostHttpPost("/capture?run=1", "");   // unless VITO_CAP_BOOT has started it
+    }
+    // groups are final once setup() has planned the block reads
+    HostPollGroup groups[8];
+    size_t groupCount = hostPollGroups(groups, 8);
+    for (size_t i = 0; i < groupCount; ++i) {
+        GroupStats g;
+        g.group = groups[i];
+        observer.groups.push_back(g);
+    }
+    hostSetPollIntervals(fastMs, mediumMs, slowMs);
+    WebSerial.hostSetFrameCostUs(consoleCostUs);
+    hostSetPublishCostUs(mqttCostUs);
+    std::vector<AsyncEventSourceClient*> sse;
+    for (unsigned i = 0; i < sseClients; ++i) {
+        sse.push_back(hostEvents().hostConnect());
+    }
+    hostTakeLoopStats();
+
+    uint64_t loops = 0;
+    observer.measuring = true;
+    uint32_t startMs = millis();
+    uint32_t durationMs = (uint32_t)(durationS * 1000.0);
+    // slider drag: SLIDER_STEPS commands SLIDER_STEP_MS apart, every sliderEveryMs
+    const uint32_t SLIDER_STEPS = 5, SLIDER_STEP_MS = 100;
+    uint32_t sliderCommands = 0, sliderDrag = 0, sliderStartMs = startMs;
+    // broker outage: down at outageOnMs, up at outageOffMs, replay done at replayDoneMs
+    uint32_t outageOnMs  = outageStartS >= 0.0 ? (uint32_t)(outageStartS * 1000.0) : UINT32_MAX;
+    uint32_t outageOffMs = outageOnMs == UINT32_MAX ? UINT32_MAX : outageOnMs + (uint32_t)(outageLenS * 1000.0);
+    uint32_t replayDoneMs = 0;
+    // AP loss: gone at wifiOffMs, back at wifiOnMs, MQTT connected again at wifiBackMs
+    uint32_t wifiOffMs = wifiOutStartS >= 0.0 ? (uint32_t)(wifiOutStartS * 1000.0) : UINT32_MAX;
+    uint32_t wifiOnMs  = wifiOffMs == UINT32_MAX ? UINT32_MAX : wifiOffMs + (uint32_t)(wifiOutLenS * 1000.0);
+    uint32_t wifiBackMs = 0, wifiReads = 0, wifiReadsAtCut = 0;
+    bool     wifiCut = false;
+    uint64_t wifiMaxLoopUs = 0;
+    // REST pollers: each remembers the ETag it got and sends it back
+    const char* apiUrls[] = {"/api/state", "/api/datapoint/AussenTemp"};
+    std::string apiEtags[2];
+    uint64_t apiRequests = 0, api304 = 0, apiBytes = 0, apiUs = 0, apiMaxUs = 0, apiOptolink = 0;
+    std::vector<ConnectStats> connects;
+    const HostMqttStats& mqs = hostMqttStats();
+    while (millis() - startMs < durationMs) {
+        uint32_t sinceStart = millis() - startMs;
+        if (sinceStart >= outageOnMs && sinceStart < outageOffMs) {
+            hostSetBrokerUp(false);
+        } else if (sinceStart >= outageOffMs) {
+            hostSetBrokerUp(true);
+            if (replayDoneMs == 0 && hostMqttQueueStats().depth == 0 && hostMqttQueueStats().replayed > 0) {
+                replayDoneMs = sinceStart;
+            }
+        }
+        if (sliderEveryMs) {
+            uint32_t now = millis();
+            uint32_t step = (now - sliderStartMs) / SLIDER_STEP_MS;
+            if (step >= SLIDER_STEPS && now - sliderStartMs >= sliderEveryMs) {
+                sliderStartMs = now;
+                sliderDrag++;
+                step = 0;
+            }
+            while (sliderCommands < sliderDrag * SLIDER_STEPS + (step < SLIDER_STEPS ? step + 1 : SLIDER_STEPS)) {
+                hostRaumSollCommand(20.0f + 0.5f * (float)(sliderCommands % 5));
+                sliderCommands++;
+            }
+        }
+        while (apiRps && apiRequests < (uint64_t)(millis() - startMs) * apiRps / 1000) {
+            size_t k = apiRequests % 2;
+            HostHttpHeaders headers;
+            if (!apiEtags[k].empty()) {
+                headers.emplace_back("If-None-Match", apiEtags[k]);
+            }
+            uint32_t before = observer.loopRequests;
+            auto t0 = std::chrono::steady_clock::now();
+            HostHttpResponse r = hostHttpGet(apiUrls[k], headers);
+            uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            apiOptolink += observer.loopRequests - before;
+            apiUs += us;
+            apiMaxUs = us > apiMaxUs ? us : apiMaxUs;
+            apiBytes += r.body.size();
+            api304 += r.code == 304;
+            if (r.header("ETag")) {
+                apiEtags[k] = r.header("ETag");
+            }
+            apiRequests++;
+        }
+        bool wifiDown = sinceStart >= wifiOffMs && sinceStart < wifiOnMs;
+        if (wifiDown && !wifiCut) {
+            hostSetWiFiLinkUp(false);
+            hostSetWiFiLinkUpAt(startMs + wifiOnMs);
+            wifiCut = true;
+            wifiReadsAtCut = observer.responses;
+        } else if (sinceStart >= wifiOnMs && wifiBackMs == 0) {
+            hostSetWiFiLinkUp(true);
+            if (HAMqtt::instance() && HAMqtt::instance()->isConnected()) {
+                wifiBackMs = sinceStart;
+                wifiReads = observer.responses - wifiReadsAtCut;
+            }
+        }
+        uint32_t connectsBefore = mqs.connects;
+        uint64_t bytesBefore = mqs.stateBytes + mqs.discoveryBytes + mqs.otherBytes;
+        auto loopT0 = std::chrono::steady_clock::now();
+        loop();
+        uint64_t loopUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - loopT0).count();
+        if (wifiDown || (sinceStart >= wifiOnMs && wifiBackMs == 0)) {
+            wifiMaxLoopUs = loopUs > wifiMaxLoopUs ? loopUs : wifiMaxLoopUs;
+        }
+        if (mqs.connects != connectsBefore) {
+            ConnectStats c;
+            c.atMs = sinceStart;
+            connects.push_back(c);
+        }
+        if (!connects.empty() && connects.back().open) {
+            ConnectStats& c = connects.back();
+            uint64_t bytes = mqs.stateBytes + mqs.discoveryBytes + mqs.otherBytes - bytesBefore;
+            c.bytes += bytes;
+            c.maxLoopBytes = bytes > c.maxLoopBytes ? bytes : c.maxLoopBytes;
+            c.maxLoopUs = loopUs > c.maxLoopUs ? loopUs : c.maxLoopUs;
+            if (c.firstStateMs < 0.0 && mqs.firstStateUs) {
+                c.firstStateMs = (mqs.firstStateUs - mqs.connectUs) / 1000.0;
+            }
+            uint32_t since = millis() - startMs - c.atMs;
+            if ((hostDiscoveryStats().queued == 0 && c.firstStateMs >= 0.0) || since >= CONNECT_WINDOW_MS) {
+                c.passMs = since;
+                c.open = false;
+            }
+        }
+        loops++;
+        for (size_t i = sseSlow; i < sse.size(); ++i) {
+            sse[i]->hostDrain(AsyncEventSourceClient::MAX_QUEUED);   // browsers that keep up
+        }
+        yield();
+    }
+    uint32_t endMs = millis();
+    observer.measuring = false;
+    hostStopOptolink();
+    HostLoopStats loopStats = hostTakeLoopStats();
+    emu.stop();
+
+    double elapsedS = (endMs - startMs) / 1000.0;
+    VitotronicEmulatorStats es = emu.stats();
+
+    printf("== poller bench (%s, %s) ==\n", HOST_SKETCH_NAME, hostProtocolName());
+    printf("link: %u baud, sync %u ms, latency %u(+%u) ms, drop %.3f trunc %.3f corrupt %.3f\n",
+           emuCfg.baud, emuCfg.syncIntervalMs, emuCfg.latencyMs, emuCfg.latencyJitterMs,
+           emuCfg.dropRate, emuCfg.truncateRate, emuCfg.corruptRate);
+    printf("elapsed %.1f s, loop() calls %llu\n", elapsedS, (unsigned long long)loops);
+    printf("requests %u (writes %u), responses %u, errors timeout=%u length=%u nack=%u crc=%u error=%u\n",
+           observer.requests.load(), observer.writes, observer.responses.load(),
+           observer.errorsByCode[(int)VitoWiFi::OptolinkResult::TIMEOUT],
+           observer.errorsByCode[(int)VitoWiFi::OptolinkResult::LENGTH],
+           observer.errorsByCode[(int)VitoWiFi::OptolinkResult::NACK],
+           observer.errorsByCode[(int)VitoWiFi::OptolinkResult::CRC],
+           observer.errorsByCode[(int)VitoWiFi::OptolinkResult::ERROR]);
+    printf("reads/s %.3f, datapoint updates/s %.3f, rtt mean %.1f ms max %u ms\n",
+           observer.responses / elapsedS, observer.updates / elapsedS,
+           observer.responses ? (double)observer.rttSumMs / observer.responses : 0.0,
+           observer.rttMaxMs);
+    HostOptoStats opto = hostOptoStats();
+    size_t gaps = observer.gapUs.size();
+    printf("optolink timing: request gap p50 %.1f p99 %.1f max %.1f ms (%zu), rtt p50 %.1f p99 %.1f max %.1f ms; "
+           "%s step every %.2f ms (max %.1f ms), %u queued at most, %u dropped\n",
+           percentileMs(observer.gapUs, 0.5), percentileMs(observer.gapUs, 0.99),
+           percentileMs(observer.gapUs, 1.0), gaps, percentileMs(observer.rttUs, 0.5),
+           percentileMs(observer.rttUs, 0.99), percentileMs(observer.rttUs, 1.0),
+           opto.task ? "task" : "loop()", opto.stepMeanUs / 1000.0, opto.stepMaxUs / 1000.0, opto.ringHighWater,
+           opto.ringDropped);
+    printf("emulator: syncs %llu, p300 inits %llu, reads %llu, writes %llu, rx %llu B, tx %llu B\n",
+           (unsigned long long)es.syncs, (unsigned long long)es.p300Inits,
+           (unsigned long long)es.reads, (unsigned long long)es.writes,
+           (unsigned long long)es.bytesRx, (unsigned long long)es.bytesTx);
+    printf("boot: setup() %u ms, first Optolink value %u ms after boot\n",
+           setupMs, observer.firstResponseMs);
+    printf("loop dt (us): min %u max %u mean %.1f (%u samples)\n",
+           loopStats.minUs, loopStats.maxUs, loopStats.meanUs, loopStats.samples);
+    const HostMqttStats& mq = hostMqttStats();
+    printf("mqtt: state publishes %llu (%llu B), discovery %llu (%llu B), WebSerial %llu B in %llu writes\n",
+           (unsigned long long)mq.statePublishes, (unsigned long long)mq.stateBytes,
+           (unsigned long long)mq.discoveryPublishes, (unsigned long long)mq.discoveryBytes,
+           (unsigned long long)WebSerial.hostBytesWritten(), (unsigned long long)WebSerial.hostFramesWritten());
+    // on the wire each packet adds about 44 B: MQTT fixed header and topic length, TCP/IP headers
+    double perHour = 3600.0 / durationS;
+    double packets = (double)(mq.statePublishes + mq.otherPublishes) * perHour;
+    double bytes   = (double)(mq.stateBytes + mq.otherBytes) * perHour;
+    printf("mqtt per hour: %.0f packets, %.0f B topic+payload, ~%.0f B on the wire "
+           "(entity states %.0f, other topics %.0f; discovery not counted)\n",
+           packets, bytes, bytes + 44.0 * packets, (double)mq.statePublishes * perHour,
+           (double)mq.otherPublishes * perHour);
+    for (const ConnectStats& c : connects) {
+        printf("mqtt connect at %.1f s: first state after %.2f ms, longest loop() %.2f ms, "
+               "at most %llu B written in one loop(), %llu B until discovery done after %u ms\n",
+               c.atMs / 1000.0, c.firstStateMs, c.maxLoopUs / 1000.0, (unsigned long long)c.maxLoopBytes,
+               (unsigned long long)c.bytes, c.passMs);
+    }
+    HostDiscoveryStats disc = hostDiscoveryStats();
+    printf("discovery: %u configs sent, %u unchanged skipped, %u still queued, last pass %u ms\n",
+           disc.sent, disc.skipped, disc.queued, disc.lastPassMs);
+    std::string aggregates = hostHttpGet("/aggregates").body;
+    printf("aggregates: %s\n", aggregates.c_str());
+    uint32_t implausible = checkAggregates(aggregates, (endMs - startMs) / 3600000.0 + 0.01);
+
+    uint32_t errors = 0;
+    for (uint32_t e : observer.errorsByCode) {
+        errors += e;
+    }
+    if (errors) {
+        HostBreakerStats br = hostBreakerStats();
+        printf("breakers: %u quarantines, %u open at the end, %.1f s of Optolink time lost on failed reads; "
+               "link %s, %u recoveries (last %u ms)\n",
+               br.quarantines, br.open, br.lostS, br.linkState, br.recoveries, br.lastRecoveryMs);
+    }
+
+    if (sliderEveryMs) {
+        HostWriteStats ws = hostWriteStats();
+        printf("writes: commands %u, coalesced %u, confirmed %u, failed %u, latency mean %.0f ms max %u ms\n",
+               sliderCommands, ws.coalesced, ws.confirmed, ws.failed, ws.meanLatencyMs, ws.maxLatencyMs);
+    }
+
+    if (metricsPath) {
+        HostHttpResponse m = hostHttpGet("/metrics");
+        FILE* f = fopen(metricsPath, "w");
+        if (f) {
+            fwrite(m.body.data(), 1, m.body.size(), f);
+            fclose(f);
+        }
+        printf("metrics: HTTP %d, %zu B in %u chunks of <= %zu B\n", m.code, m.body.size(), m.chunks, HOST_HTTP_CHUNK);
+    }
+
+    if (!sse.empty()) {
+        printf("sse: %s\n", hostHttpGet("/live/stats").body.c_str());
+        for (size_t i = 0; i < sse.size(); ++i) {
+            printf("sse client %zu%s: %llu messages, %llu B, %s\n", i, i < sseSlow ? " (slow)" : "",
+                   (unsigned long long)sse[i]->hostMessages(), (unsigned long long)sse[i]->hostBytes(),
+                   sse[i]->connected() ? "connected" : "closed");
+        }
+        HostHttpResponse page = hostHttpGet("/live");
+        printf("sse: GET /live HTTP %d, %zu B (gzip)\n", page.code, page.body.size());
+    }
+
+    if (apiRps) {
+        printf("api: %llu requests (%.0f/s), %llu x 304, %llu B of JSON, handler mean %.1f us max %llu us, "
+               "Optolink requests caused %llu\n",
+               (unsigned long long)apiRequests, apiRequests / elapsedS, (unsigned long long)api304,
+               (unsigned long long)apiBytes, apiRequests ? (double)apiUs / apiRequests : 0.0,
+               (unsigned long long)apiMaxUs, (unsigned long long)apiOptolink);
+        HostHttpResponse state = hostHttpGet("/api/state");
+        printf("api: GET /api/state HTTP %d, ETag %s, %zu B in %u chunks\n", state.code,
+               state.header("ETag") ? state.header("ETag") : "-", state.body.size(), state.chunks);
+        printf("api: %s\n", hostHttpGet("/api/datapoint/AussenTemp").body.c_str());
+        printf("api: GET /api/datapoint/Nope HTTP %d\n", hostHttpGet("/api/datapoint/Nope").code);
+    }
+
+    if (defsArg) {
+        HostDefsStats d = hostDefsStats();
+        printf("defs: %u loaded (%u bad lines), %u B RAM (%.1f B each), %u reads, %u errors, "
+               "%u never read, oldest value %.1f s\n",
+               d.count, d.badLines, d.ramBytes, d.count ? (double)d.ramBytes / d.count : 0.0, d.reads, d.errors,
+               d.neverRead, d.maxAgeMs / 1000.0);
+        printf("defs: %zu entities registered, HAMqtt capacity %u\n", HABaseDeviceType::hostRegistry().size(),
+               HAMqtt::instance() ? HAMqtt::instance()->maxDevicesTypes() : 0);
+        HostHttpResponse post = hostHttpPost("/datapoints", defs);
+        printf("defs: POST /datapoints HTTP %d %s\n", post.code, post.body.c_str());
+        post = hostHttpPost("/datapoints", defs + "Broken,0x10000,2,div10,60,sensor,,1\n");
+        printf("defs: POST with a bad line HTTP %d %s\n", post.code, post.body.c_str());
+    }
+
+    if (outageOnMs != UINT32_MAX) {
+        HostMqttQueueStats q = hostMqttQueueStats();
+        printf("broker outage %.0f s at %.0f s: queued %u (high water %u, dropped %u), replayed %u at %.1f msg/s, "
+               "queue empty %.1f s after reconnect\n",
+               outageLenS, outageStartS, q.queued, q.highWater, q.dropped, q.replayed, q.replayRate,
+               replayDoneMs ? (replayDoneMs - outageOffMs) / 1000.0 : -1.0);
+    }
+
+    if (wifiOffMs != UINT32_MAX) {
+        printf("wifi outage %.0f s at %.0f s: longest loop() %.1f ms, Optolink reads during it %u "
+               "(%.2f/s), MQTT back %.1f s after the AP\n",
+               wifiOutLenS, wifiOutStartS, wifiMaxLoopUs / 1000.0, wifiReads,
+               wifiBackMs ? wifiReads / ((wifiBackMs - wifiOffMs) / 1000.0) : 0.0,
+               wifiBackMs ? (wifiBackMs - wifiOnMs) / 1000.0 : -1.0);
+    }
+
+    if (profile) {
+        printf("profile: %s\n", hostHttpGet("/profile").body.c_str());
+    }
+
+    printf("history: %s\n", hostHttpGet("/history/stats").body.c_str());
+    if (historyPath) {
+        HostHttpResponse h = hostHttpGet("/history");
+        FILE* f = fopen(historyPath, "w");
+        if (f) {
+            fwrite(h.body.data(), 1, h.body.size(), f);
+            fclose(f);
+        }
+        printf("history export: HTTP %d, %zu B in %u chunks (LittleFS in %s)\n", h.code, h.body.size(), h.chunks,
+               fsDir ? fsDir : "-");
+    }
+
+    if (tracePath) {
+        printf("capture: %s\n", hostHttpGet("/capture/stats").body.c_str());
+        HostHttpResponse t = hostHttpGet("/capture");
+        FILE* f = fopen(tracePath, "wb");
+        if (f) {
+            fwrite(t.body.data(), 1, t.body.size(), f);
+            fclose(f);
+        }
+        printf("trace: HTTP %d, %zu B in %u chunks, written to %s\n", t.code, t.body.size(), t.chunks, tracePath);
+    }
+
+    HostValueStats vs = hostValueStats();
+    printf("values: %u replies, %u with unchanged bytes (%.0f%%, not decoded), %u decodes\n", vs.replies,
+           vs.unchanged, vs.replies ? 100.0 * vs.unchanged / vs.replies : 0.0, vs.decodes);
+    // Decoded temperatures outside what a heat pump can report mean wrong
+    // bytes reached the decoder (overlapping reads, a bad block split).
+    HostTemperature temps[64];
+    size_t tempCount = hostTemperatures(temps, 64);
+    uint32_t implausibleTemps = 0;
+    for (size_t i = 0; i < tempCount; ++i) {
+        if (!(temps[i].value >= -40.0f && temps[i].value <= 120.0f)) {
+            printf("implausible: %s = %.1f C\n", temps[i].name, temps[i].value);
+            implausibleTemps++;
+        }
+    }
+    printf("temperatures: %zu decoded, %u outside -40..120 C\n", tempCount, implausibleTemps);
+    implausible += implausibleTemps;
+    if (dispatchRounds) {
+        HostDispatchCost dc = hostDispatchCost(dispatchRounds);
+        printf("dispatch: %.0f ns per reply with unchanged bytes, %.0f ns with new bytes (%u replies each)\n",
+               dc.unchangedNs, dc.changedNs, dc.messages);
+    }
+
+    printf("\n%-8s %5s %5s %7s %10s %10s %10s\n", "group", "dps", "reads", "rounds", "min ms", "mean ms", "max ms");
+    for (const GroupStats& g : observer.groups) {
+        printf("%-8s %5d %5d %7u %10u %10.0f %10u\n", g.group.name, g.group.size, g.group.transactions, g.rounds,
+               g.rounds ? g.minMs : 0, g.rounds ? (double)g.sumMs / g.rounds : 0.0, g.maxMs);
+    }
+
+    printf("\n%-22s %6s %5s %5s %5s %12s %12s %12s\n",
+           "datapoint", "addr", "req", "ok", "err", "period ms", "max gap ms", "age@end ms");
+    FILE* csv = csvPath ? fopen(csvPath, "w") : nullptr;
+    if (csv) {
+        fprintf(csv, "datapoint,address,requests,updates,errors,period_mean_ms,gap_max_ms,age_end_ms\n");
+    }
+    for (const auto& it : observer.dps) {
+        const DpStats& s = it.second;
+        double   period = s.gapSamples ? (double)s.gapSumMs / s.gapSamples : 0.0;
+        uint32_t age    = s.lastOkMs ? endMs - s.lastOkMs : endMs - startMs;
+        printf("%-22s 0x%04X %5u %5u %5u %12.0f %12u %12u\n",
+               it.first.c_str(), s.address, s.requests, s.updates, s.errors, period, s.gapMaxMs, age);
+        if (csv) {
+            fprintf(csv, "%s,0x%04X,%u,%u,%u,%.0f,%u,%u\n",
+                    it.first.c_str(), s.address, s.requests, s.updates, s.errors, period, s.gapMaxMs, age);
+        }
+    }
+    if (csv) {
+        fclose(csv);
+    }
+    return implausible ? 1 : 0;
+}
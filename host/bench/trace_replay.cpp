@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------------
+// Trace replay: feeds an Optolink trace (GET /capture, Vitocal_capture.h, or
+// vito_poller_bench --trace-out) through the sketch's VitoWiFi parser,
+// onVitoResponse()/onVitoError() and the loop() dispatch, on a manual clock
+// that jumps from record to record, and reports
+//   - what the trace holds: protocol, records, requests, bytes, time span
+//   - divergence: bytes the parser wrote other than recorded, requests it
+//     refused, RX it left unread, reads of addresses the sketch does not know
+//   - a digest of the messages dispatched to loop(); the same trace gives the
+//     same digest on every pass and every build that decodes the same
+//   - throughput: records, bytes and replies per second, and the speedup
+//     over the recorded time
+//
+// The sketch boots against the software Vitotronic (same protocol as the
+// trace) and its Optolink task is stopped before the replay starts.
+//
+// Usage: vito_trace_replay TRACE [--repeat N] [--verbose] [emulator options]
+// ---------------------------------------------------------------------------
+#include "HostSketch.h"
+#include "../emulator/EmulatorOptions.h"
+
+#include <LittleFS.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s TRACE [--repeat N] [--verbose] [emulator options]\n", argv0);
+    printEmulatorUsage(stderr);
+}
+
+bool readFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    VitotronicEmulatorConfig emuCfg;
+    const char* tracePath = nullptr;
+    uint32_t    repeat = 1;
+    bool        verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (parseEmulatorOption(argc, argv, i, emuCfg)) continue;
+        if (i + 1 < argc && !strcmp(a, "--repeat")) { repeat = (uint32_t)atoi(argv[++i]); continue; }
+        if (!strcmp(a, "--verbose"))                { verbose = true; continue; }
+        if (a[0] != '-' && !tracePath)              { tracePath = a; continue; }
+        usage(argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> trace;
+    if (!tracePath || !readFile(tracePath, trace)) {
+        usage(argv[0]);
+        return 2;
+    }
+    // boot on the protocol of the trace (header byte 5: VitoProtocol, 1 = VS2)
+    if (trace.size() > 5 && trace[5] != 1) {
+        emuCfg.p300 = false;
+    }
+
+    VitotronicEmulator emu(emuCfg);
+    if (!emu.start()) {
+        return 1;
+    }
+    hostSetSerialDevice(0, emu.slavePath());
+    hostSetConsoleEcho(verbose);
+    char fsTemplate[] = "/tmp/vito_littlefs_XXXXXX";
+    hostSetLittleFSRoot(mkdtemp(fsTemplate));
+    setup();
+    hostStopOptolink();
+    emu.stop();
+
+    printf("== trace replay (%s, %s) ==\n", HOST_SKETCH_NAME, tracePath);
+    for (uint32_t pass = 1; pass <= repeat; ++pass) {
+        HostReplayStats r = hostReplayTrace(trace.data(), trace.size());
+        if (!r.valid) {
+            fprintf(stderr, "%s: not an Optolink trace\n", tracePath);
+            return 1;
+        }
+        if (pass == 1) {
+            printf("trace: %zu B, %s, %u records over %.1f s (%u skipped before the replay start)%s\n",
+                   trace.size(), r.protocol == 1 ? "VS2 (P300)" : "VS1 (KW)", r.records, r.traceS, r.skipped,
+                   r.truncated ? ", truncated" : "");
+            printf("replay: %u requests (%u unresolved, %u refused), rx %u B, tx %u B (%u differ), %u B unread\n",
+                   r.requests, r.unresolved, r.rejected, r.rxBytes, r.txBytes, r.txMismatches, r.stalled);
+            printf("results: %u responses, %u errors, %u messages to loop()\n", r.responses, r.errors, r.messages);
+        }
+        printf("pass %u: digest %08x, %.1f ms, %.0f records/s, %.0f responses/s, %.2f MB/s of trace, "
+               "%.0fx recorded time\n",
+               pass, r.digest, r.wallS * 1000.0, r.wallS > 0 ? r.records / r.wallS : 0.0,
+               r.wallS > 0 ? r.responses / r.wallS : 0.0,
+               r.wallS > 0 ? trace.size() / r.wallS / 1e6 : 0.0, r.wallS > 0 ? r.traceS / r.wallS : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Command line options shared by the standalone emulator and the benches.
+#pragma once
+
+#include "VitotronicEmulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Consumes argv[i] (and its value) if it is an emulator option; returns false otherwise.
+inline bool parseEmulatorOption(int argc, char** argv, int& i, VitotronicEmulatorConfig& cfg) {
+    const char* opt = argv[i];
+    auto value = [&](void) -> const char* {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value for %s\n", opt);
+            exit(2);
+        }
+        return argv[++i];
+    };
+    if      (!strcmp(opt, "--baud"))           cfg.baud = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--sync-ms"))        cfg.syncIntervalMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--followup-ms"))    cfg.followupWindowMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--no-p300"))        cfg.p300 = false;
+    else if (!strcmp(opt, "--latency-ms"))     cfg.latencyMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--jitter-ms"))      cfg.latencyJitterMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--drop-rate"))      cfg.dropRate = atof(value());
+    else if (!strcmp(opt, "--truncate-rate"))  cfg.truncateRate = atof(value());
+    else if (!strcmp(opt, "--corrupt-rate"))   cfg.corruptRate = atof(value());
+    else if (!strcmp(opt, "--stall-every-ms")) cfg.stallEveryMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--stall-for-ms"))   cfg.stallForMs = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--plant-speed"))    cfg.plantSpeed = atof(value());
+    else if (!strcmp(opt, "--noise"))          cfg.sensorNoise = atof(value());
+    else if (!strcmp(opt, "--seed"))           cfg.seed = (uint32_t)atoi(value());
+    else if (!strcmp(opt, "--unsupported"))    cfg.unsupported.insert((uint16_t)strtoul(value(), nullptr, 0));
+    else return false;
+    return true;
+}
+
+inline void printEmulatorUsage(FILE* out) {
+    fprintf(out,
+        "emulator options:\n"
+        "  --baud N            line rate, 8E1 (default 4800)\n"
+        "  --sync-ms N         idle time between 0x05 syncs (default 2000)\n"
+        "  --followup-ms N     accept next command without sync within N ms (default 0)\n"
+        "  --no-p300           KW only: ignore the VS2/P300 init\n"
+        "  --latency-ms N      controller response latency (default 20)\n"
+        "  --jitter-ms N       extra uniform latency 0..N\n"
+        "  --drop-rate P       probability a reply is never sent\n"
+        "  --truncate-rate P   probability a reply is one byte short\n"
+        "  --corrupt-rate P    probability of a flipped bit in a reply\n"
+        "  --stall-every-ms N  go silent (no sync) every N ms ...\n"
+        "  --stall-for-ms N    ... for N ms\n"
+        "  --plant-speed X     simulated seconds per real second (default 60)\n"
+        "  --noise K           temperature sensor noise +-K (default 0.1)\n"
+        "  --seed N            RNG seed for noise and faults\n"
+        "  --unsupported ADDR  never answer ADDR (repeatable, e.g. 0x1A54)\n");
+}
@@ -0,0 +1,515 @@
+// Software Vitotronic emulator (see VitotronicEmulator.h)
+#include "VitotronicEmulator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+const Clock::time_point kEpoch = Clock::now();
+
+// Addresses from Vitocal_datapoints.h
+const uint16_t ADDR_TEMP_OUTSIDE   = 0x0101;
+const uint16_t ADDR_VORLAUF        = 0x0105;
+const uint16_t ADDR_RUECKLAUF      = 0x0106;
+const uint16_t ADDR_WW_OBEN        = 0x010D;
+const uint16_t ADDR_VORLAUF_SOLL   = 0x1800;
+const uint16_t ADDR_COMP_FREQ      = 0x1A54;
+const uint16_t ADDR_RAUM_SOLL      = 0x2000;
+const uint16_t ADDR_RAUM_SOLL_RED  = 0x2001;
+const uint16_t ADDR_HK_NIVEAU      = 0x2006;
+const uint16_t ADDR_HK_NEIGUNG     = 0x2007;
+const uint16_t ADDR_WW_SOLL        = 0x6000;
+const uint16_t ADDR_WW_HYST        = 0x6007;
+const uint16_t ADDR_WW_SOLL2       = 0x600C;
+const uint16_t ADDR_OPMODE         = 0xB000;
+const uint16_t ADDR_MANUALMODE     = 0xB020;
+const uint16_t ADDR_REL_VERDICHTER = 0x0480;
+const uint16_t ADDR_REL_PRIMAER    = 0x0482;
+const uint16_t ADDR_REL_SEKUNDAER  = 0x0484;
+const uint16_t ADDR_REL_EHEIZ1     = 0x0488;
+const uint16_t ADDR_REL_EHEIZ2     = 0x0489;
+const uint16_t ADDR_HEIZKREISPUMPE = 0x048D;
+const uint16_t ADDR_WW_ZIRKPUMPE   = 0x0490;
+const uint16_t ADDR_STOERUNG       = 0x0491;
+const uint16_t ADDR_VENTIL_HZ_WW   = 0x0494;
+
+void sleepUs(uint64_t us) {
+    if (us) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+}
+
+VitotronicEmulator::VitotronicEmulator(const VitotronicEmulatorConfig& config)
+    : mConfig(config), mRng(config.seed ? config.seed : 1) {
+    memset(mMem, 0, sizeof(mMem));
+    // 0x0105/2 and 0x0106/2 share a byte in the address map
+    addRegister(ADDR_VORLAUF, 2);
+    addRegister(ADDR_RUECKLAUF, 2);
+    seedMemory();
+}
+
+VitotronicEmulator::~VitotronicEmulator() {
+    stop();
+}
+
+uint32_t VitotronicEmulator::nowMs() const {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - kEpoch).count();
+}
+
+double VitotronicEmulator::random01() {
+    // xorshift32, deterministic per seed
+    mRng ^= mRng << 13;
+    mRng ^= mRng >> 17;
+    mRng ^= mRng << 5;
+    return (mRng & 0xFFFFFF) / (double)0x1000000;
+}
+
+bool VitotronicEmulator::start() {
+    mMasterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (mMasterFd < 0 || grantpt(mMasterFd) != 0 || unlockpt(mMasterFd) != 0) {
+        perror("[emu] posix_openpt");
+        return false;
+    }
+    const char* name = ptsname(mMasterFd);
+    if (!name) {
+        perror("[emu] ptsname");
+        return false;
+    }
+    mSlavePath = name;
+
+    // Keep one slave handle open: raw line discipline, and the master never
+    // sees a hangup while the firmware closes/reopens the port (end/begin).
+    mSlaveKeepFd = open(name, O_RDWR | O_NOCTTY);
+    if (mSlaveKeepFd >= 0) {
+        termios tio;
+        if (tcgetattr(mSlaveKeepFd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(mSlaveKeepFd, TCSANOW, &tio);
+        }
+    }
+    fcntl(mMasterFd, F_SETFL, fcntl(mMasterFd, F_GETFL) | O_NONBLOCK);
+
+    mRunning = true;
+    mThread = std::thread(&VitotronicEmulator::run, this);
+    return true;
+}
+
+void VitotronicEmulator::stop() {
+    if (mRunning.exchange(false) && mThread.joinable()) {
+        mThread.join();
+    }
+    if (mSlaveKeepFd >= 0) { close(mSlaveKeepFd); mSlaveKeepFd = -1; }
+    if (mMasterFd >= 0) { close(mMasterFd); mMasterFd = -1; }
+}
+
+void VitotronicEmulator::addRegister(uint16_t address, uint8_t length) {
+    Register r = {address, length, {0, 0, 0, 0}};
+    mRegisters.push_back(r);
+}
+
+void VitotronicEmulator::poke(uint16_t address, const uint8_t* data, uint8_t length) {
+    std::lock_guard<std::mutex> lock(mMemMutex);
+    for (Register& r : mRegisters) {
+        if (r.address == address && r.length == length) {
+            memcpy(r.bytes, data, length);
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < length; ++i) {
+        mMem[(uint16_t)(address + i)] = data[i];
+    }
+}
+
+// Address map, then the registers the range touches; one it covers
+// completely wins over one it only cuts.
+void VitotronicEmulator::peek(uint16_t address, uint8_t* data, uint8_t length) const {
+    std::lock_guard<std::mutex> lock(mMemMutex);
+    for (uint8_t i = 0; i < length; ++i) {
+        data[i] = mMem[(uint16_t)(address + i)];
+    }
+    uint32_t end = (uint32_t)address + length;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const Register& r : mRegisters) {
+            uint32_t rEnd = (uint32_t)r.address + r.length;
+            bool inside = r.address >= address && rEnd <= end;
+            if (inside != (pass == 1) || rEnd <= address || r.address >= end) {
+                continue;
+            }
+            for (uint32_t a = r.address; a < rEnd; ++a) {
+                if (a >= address && a < end) {
+                    data[a - address] = r.bytes[a - r.address];
+                }
+            }
+        }
+    }
+}
+
+void VitotronicEmulator::pokeTemp(uint16_t address, float value) {
+    int16_t raw = (int16_t)lrintf(value * 10.0f);
+    uint8_t buf[2] = {(uint8_t)(raw & 0xFF), (uint8_t)((uint16_t)raw >> 8)};
+    poke(address, buf, 2);
+}
+
+float VitotronicEmulator::peekTemp(uint16_t address) const {
+    uint8_t buf[2];
+    peek(address, buf, 2);
+    return (int16_t)(buf[0] | (buf[1] << 8)) / 10.0f;
+}
+
+VitotronicEmulatorStats VitotronicEmulator::stats() const {
+    std::lock_guard<std::mutex> lock(mMemMutex);
+    return mStats;
+}
+
+void VitotronicEmulator::seedMemory() {
+    pokeTemp(ADDR_TEMP_OUTSIDE, 5.0f);
+    pokeTemp(ADDR_VORLAUF, 30.0f);
+    pokeTemp(ADDR_RUECKLAUF, 28.0f);
+    pokeTemp(ADDR_WW_OBEN, 45.0f);
+    pokeTemp(ADDR_VORLAUF_SOLL, 32.0f);
+    pokeTemp(ADDR_RAUM_SOLL, 20.0f);
+    pokeTemp(ADDR_RAUM_SOLL_RED, 17.0f);
+    pokeTemp(ADDR_HK_NIVEAU, 0.0f);
+    pokeTemp(ADDR_HK_NEIGUNG, 0.6f);
+    pokeTemp(ADDR_WW_SOLL, 48.0f);
+    pokeTemp(ADDR_WW_HYST, 5.0f);
+    pokeTemp(ADDR_WW_SOLL2, 60.0f);
+    pokeByte(ADDR_OPMODE, 2);
+    pokeByte(ADDR_MANUALMODE, 0);
+}
+
+// --- plant model --------------------------------------------------------------
+void VitotronicEmulator::plantStep(double dt) {
+    double& vl = mVorlauf;
+    double& ww = mWwOben;
+    mSimSeconds += dt;
+
+    float raum    = peekTemp(ADDR_RAUM_SOLL);
+    float niveau  = peekTemp(ADDR_HK_NIVEAU);
+    float neigung = peekTemp(ADDR_HK_NEIGUNG);
+    float wwSoll  = peekTemp(ADDR_WW_SOLL);
+    float wwHyst  = peekTemp(ADDR_WW_HYST);
+
+    double out = 5.0 + 4.0 * sin(2.0 * M_PI * mSimSeconds / 86400.0);
+    double vlSoll = raum + niveau + neigung * (raum - out);
+    if (vlSoll < 20) vlSoll = 20;
+    if (vlSoll > 55) vlSoll = 55;
+    bool heatDemand = out < 15.0;
+
+    if (!mDhwMode && ww < wwSoll - wwHyst) mDhwMode = true;
+    if (mDhwMode && ww >= wwSoll) mDhwMode = false;
+
+    if (!mCompressor && (mDhwMode || (heatDemand && vl < vlSoll - 2.0))) mCompressor = true;
+    if (mCompressor && !mDhwMode && vl > vlSoll + 2.0) mCompressor = false;
+
+    vl += dt * (mCompressor ? 0.5 : -0.3) / 60.0;
+    if (vl < 20.0) vl = 20.0;
+    if (mDhwMode && mCompressor) {
+        ww += dt * 0.8 / 60.0;
+    } else {
+        ww -= dt * 0.05 / 60.0;
+    }
+    double rl = vl - (mCompressor ? 5.0 : 1.5);
+
+    double n = mConfig.sensorNoise;
+    pokeTemp(ADDR_TEMP_OUTSIDE, (float)(out + n * (2 * random01() - 1)));
+    pokeTemp(ADDR_VORLAUF,      (float)(vl  + n * (2 * random01() - 1)));
+    pokeTemp(ADDR_RUECKLAUF,    (float)(rl  + n * (2 * random01() - 1)));
+    pokeTemp(ADDR_WW_OBEN,      (float)(ww  + n * (2 * random01() - 1)));
+    pokeTemp(ADDR_VORLAUF_SOLL, (float)vlSoll);
+
+    pokeByte(ADDR_REL_VERDICHTER, mCompressor);
+    pokeByte(ADDR_REL_PRIMAER,    mCompressor);
+    pokeByte(ADDR_REL_SEKUNDAER,  mCompressor);
+    pokeByte(ADDR_REL_EHEIZ1,     mCompressor && out < -5.0);
+    pokeByte(ADDR_REL_EHEIZ2,     mCompressor && out < -10.0);
+    pokeByte(ADDR_HEIZKREISPUMPE, heatDemand);
+    pokeByte(ADDR_WW_ZIRKPUMPE,   fmod(mSimSeconds, 1800.0) < 300.0);
+    pokeByte(ADDR_VENTIL_HZ_WW,   mDhwMode);
+    pokeByte(ADDR_STOERUNG,       0);
+    pokeByte(ADDR_COMP_FREQ,      mCompressor ? 50 : 0);
+}
+
+// --- protocol ----------------------------------------------------------------------
+void VitotronicEmulator::transmit(const uint8_t* data, size_t length) {
+    // pace the bytes at the configured line rate (8E1 = 11 bit times)
+    uint64_t byteUs = 11ULL * 1000000ULL / (mConfig.baud ? mConfig.baud : 4800);
+    for (size_t i = 0; i < length; ++i) {
+        sleepUs(byteUs);
+        while (write(mMasterFd, &data[i], 1) < 0) {
+            sleepUs(100);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mMemMutex);
+    mStats.bytesTx += length;
+}
+
+void VitotronicEmulator::handleByte(uint8_t c, uint32_t now) {
+    // 0x04 outside a command/telegram: back to KW, sync right away
+    if (c == 0x04 && mState != State::COMMAND && mState != State::P300_TELEGRAM) {
+        mP300 = false;
+        mState = State::IDLE;
+        mNextSyncMs = now;
+        return;
+    }
+    // 16 00 00 starts P300, from KW (after a sync or not) and from P300 itself
+    if (c == 0x16 && mConfig.p300 &&
+        (mState == State::IDLE || mState == State::SYNC_SENT || mState == State::P300_IDLE)) {
+        mState = State::P300_INIT;
+        mStateMs = now;
+        mCmdLen = 0;
+        return;
+    }
+
+    switch (mState) {
+    case State::IDLE:
+        break;
+    case State::SYNC_SENT:
+        if (c == 0x01) {
+            mState = State::COMMAND;
+            mStateMs = now;
+            mCmdLen = 0;
+        }
+        break;
+    case State::P300_INIT:
+        if (c != 0x00) {
+            mState = mP300 ? State::P300_IDLE : State::IDLE;
+            break;
+        }
+        if (++mCmdLen == 2) {
+            uint8_t ack = 0x06;
+            transmit(&ack, 1);
+            mP300 = true;
+            mState = State::P300_IDLE;
+            std::lock_guard<std::mutex> lock(mMemMutex);
+            mStats.p300Inits++;
+        }
+        break;
+    case State::P300_IDLE:
+        if (c == 0x41) {
+            mState = State::P300_TELEGRAM;
+            mStateMs = now;
+            mCmdLen = 0;
+        }
+        break;  // 0x06 acks from the master need no action
+    case State::P300_TELEGRAM:
+        mCmd[mCmdLen++] = c;
+        // <len> <len bytes> <checksum>
+        if (mCmdLen >= 1 && mCmdLen == (size_t)mCmd[0] + 2) {
+            executeP300(now);
+        }
+        break;
+    case State::FOLLOWUP:
+        if (c == 0xF7 || c == 0xF4) {
+            mState = State::COMMAND;
+            mStateMs = now;
+            mCmd[0] = c;
+            mCmdLen = 1;
+        }
+        break;
+    case State::COMMAND:
+        mCmd[mCmdLen++] = c;
+        if (mCmd[0] != 0xF7 && mCmd[0] != 0xF4) {
+            mState = State::IDLE;
+            break;
+        }
+        if (mCmdLen >= 4) {
+            size_t need = mCmd[0] == 0xF7 ? 4 : 4 + (size_t)mCmd[3];
+            if (mCmdLen >= need) {
+                execute(now);
+            }
+        }
+        break;
+    }
+}
+
+void VitotronicEmulator::execute(uint32_t now) {
+    uint16_t address = (uint16_t)((mCmd[1] << 8) | mCmd[2]);
+    uint8_t  length  = mCmd[3];
+    bool     isWrite = mCmd[0] == 0xF4;
+
+    uint64_t byteUs = 11ULL * 1000000ULL / (mConfig.baud ? mConfig.baud : 4800);
+    uint32_t latency = mConfig.latencyMs;
+    if (mConfig.latencyJitterMs) {
+        latency += (uint32_t)(random01() * mConfig.latencyJitterMs);
+    }
+    // the command bytes took this long on the wire; the pty delivered them instantly
+    sleepUs(byteUs * mCmdLen + latency * 1000ULL);
+
+    bool unsupported = mConfig.unsupported.count(address) != 0;
+    bool drop        = !unsupported && random01() < mConfig.dropRate;
+    {
+        std::lock_guard<std::mutex> lock(mMemMutex);
+        if (isWrite) mStats.writes++; else mStats.reads++;
+        if (unsupported) mStats.unsupported++;
+        if (drop) mStats.dropped++;
+    }
+
+    if (!unsupported && !drop) {
+        uint8_t reply[255];
+        size_t  replyLen;
+        if (isWrite) {
+            poke(address, &mCmd[4], length);
+            reply[0] = 0x00;
+            replyLen = 1;
+        } else {
+            peek(address, reply, length);
+            replyLen = length;
+            injectFaults(reply, replyLen);
+        }
+        transmit(reply, replyLen);
+    }
+
+    now = nowMs();
+    mCmdLen = 0;
+    mState = mConfig.followupWindowMs ? State::FOLLOWUP : State::IDLE;
+    mStateMs = now;
+    mNextSyncMs = now + mConfig.syncIntervalMs;
+}
+
+void VitotronicEmulator::injectFaults(uint8_t* data, size_t& length) {
+    if (length > 0 && random01() < mConfig.truncateRate) {
+        length--;
+        std::lock_guard<std::mutex> lock(mMemMutex);
+        mStats.truncated++;
+    } else if (length > 0 && random01() < mConfig.corruptRate) {
+        data[(size_t)(random01() * length)] ^= (uint8_t)(1u << (int)(random01() * 8));
+        std::lock_guard<std::mutex> lock(mMemMutex);
+        mStats.corrupted++;
+    }
+}
+
+// mCmd holds <len> <type> <fn> <addr hi> <addr lo> <n> [data] <checksum>
+void VitotronicEmulator::executeP300(uint32_t now) {
+    uint8_t len = mCmd[0];
+    uint8_t sum = 0;
+    for (size_t i = 0; i <= len; ++i) {
+        sum += mCmd[i];
+    }
+    mState = State::P300_IDLE;
+    mStateMs = now;
+    if (sum != mCmd[len + 1] || len < 5 || mCmd[1] != 0x00) {
+        uint8_t nack = 0x15;
+        transmit(&nack, 1);
+        std::lock_guard<std::mutex> lock(mMemMutex);
+        mStats.crcErrors++;
+        return;
+    }
+
+    uint8_t  fn      = mCmd[2];
+    uint16_t address = (uint16_t)((mCmd[3] << 8) | mCmd[4]);
+    uint8_t  length  = mCmd[5];
+    bool     isWrite = fn == 0x02;
+
+    uint64_t byteUs = 11ULL * 1000000ULL / (mConfig.baud ? mConfig.baud : 4800);
+    uint32_t latency = mConfig.latencyMs;
+    if (mConfig.latencyJitterMs) {
+        latency += (uint32_t)(random01() * mConfig.latencyJitterMs);
+    }
+    sleepUs(byteUs * (mCmdLen + 1) + latency * 1000ULL);
+
+    bool unsupported = mConfig.unsupported.count(address) != 0;
+    bool drop        = !unsupported && random01() < mConfig.dropRate;
+    {
+        std::lock_guard<std::mutex> lock(mMemMutex);
+        if (isWrite) mStats.writes++; else mStats.reads++;
+        if (unsupported) mStats.unsupported++;
+        if (drop) mStats.dropped++;
+    }
+    if (drop) {
+        return;
+    }
+
+    uint8_t ack = 0x06;
+    transmit(&ack, 1);
+
+    // 41 <len> <type> <fn> <addr hi> <addr lo> <n> [data] <checksum>
+    uint8_t reply[8 + 255];
+    size_t  n = 0;
+    reply[n++] = 0x41;
+    reply[n++] = 0;  // length, filled below
+    reply[n++] = unsupported ? 0x03 : 0x01;
+    reply[n++] = fn;
+    reply[n++] = mCmd[3];
+    reply[n++] = mCmd[4];
+    reply[n++] = length;
+    if (isWrite && !unsupported) {
+        poke(address, &mCmd[6], length);
+    } else if (!isWrite && !unsupported) {
+        peek(address, &reply[n], length);
+        n += length;
+    }
+    reply[1] = (uint8_t)(n - 2);
+    uint8_t replySum = 0;
+    for (size_t i = 1; i < n; ++i) {
+        replySum += reply[i];
+    }
+    reply[n++] = replySum;
+    size_t tail = n - 7;  // faults hit the payload and checksum only
+    injectFaults(&reply[7], tail);
+    transmit(reply, 7 + tail);
+}
+
+void VitotronicEmulator::run() {
+    uint32_t lastPlantMs = nowMs();
+    mNextSyncMs = lastPlantMs + mConfig.syncIntervalMs;
+
+    while (mRunning) {
+        uint32_t now = nowMs();
+
+        if (now - lastPlantMs >= 100) {
+            plantStep((now - lastPlantMs) / 1000.0 * mConfig.plantSpeed);
+            lastPlantMs = now;
+        }
+
+        bool stalled = mConfig.stallEveryMs && mConfig.stallForMs &&
+                       (now % mConfig.stallEveryMs) < mConfig.stallForMs;
+
+        if (mState == State::SYNC_SENT && now - mStateMs > mConfig.syncAckWindowMs) {
+            mState = State::IDLE;
+        } else if (mState == State::COMMAND && now - mStateMs > 500) {
+            mState = State::IDLE;
+        } else if (mState == State::FOLLOWUP && now - mStateMs > mConfig.followupWindowMs) {
+            mState = State::IDLE;
+        } else if ((mState == State::P300_INIT || mState == State::P300_TELEGRAM) && now - mStateMs > 500) {
+            mState = mP300 ? State::P300_IDLE : State::IDLE;
+        }
+
+        if (mState == State::IDLE && !stalled && (int32_t)(now - mNextSyncMs) >= 0) {
+            uint8_t sync = 0x05;
+            transmit(&sync, 1);
+            {
+                std::lock_guard<std::mutex> lock(mMemMutex);
+                mStats.syncs++;
+            }
+            mState = State::SYNC_SENT;
+            mStateMs = nowMs();
+            mNextSyncMs = now + mConfig.syncIntervalMs;
+        }
+
+        pollfd pfd = {mMasterFd, POLLIN, 0};
+        if (poll(&pfd, 1, 2) > 0 && (pfd.revents & POLLIN)) {
+            uint8_t buf[64];
+            ssize_t n = read(mMasterFd, buf, sizeof(buf));
+            if (n > 0) {
+                {
+                    std::lock_guard<std::mutex> lock(mMemMutex);
+                    mStats.bytesRx += (uint64_t)n;
+                }
+                for (ssize_t i = 0; i < n; ++i) {
+                    // a stalled controller in P300 mode ignores telegrams
+                    if (!(stalled && mP300)) {
+                        handleByte(buf[i], nowMs());
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+// ---------------------------------------------------------------------------
+// Software Vitotronic 200 (WO1C) speaking VS1/KW and VS2/P300 on the master
+// side of a pty.
+//
+// - sends the periodic 0x05 sync while idle, accepts 0x01 + F7/F4 commands
+// - 16 00 00 switches to P300 (acknowledged 0x06, no more syncs), 0x04 goes
+//   back to KW; P300 telegrams are checksummed and acknowledged
+// - answers reads from a 64 KiB address map, applies writes to it; datapoints
+//   whose addresses overlap (flow 0x0105/2, return 0x0106/2) keep their own
+//   bytes as registers, so a read of one never returns half of the other
+// - a small plant model (compressor cycling, flow/return/DHW temperatures,
+//   pumps, valve, E-heater) keeps the addresses from Vitocal_datapoints.h
+//   moving; it runs on a scaled clock (plantSpeed simulated s per real s)
+// - link timing: 8E1 byte time at the configured baud plus response latency
+// - fault injection: dropped / truncated / corrupted replies, unsupported
+//   addresses (never answered) and periodic link stalls (no sync)
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct VitotronicEmulatorConfig {
+    uint32_t baud              = 4800;   // 8E1 -> 11 bit times per byte
+    uint32_t syncIntervalMs    = 2000;   // idle time between 0x05 sync bytes
+    uint32_t syncAckWindowMs   = 100;    // 0x01 must follow 0x05 within this
+    uint32_t followupWindowMs  = 0;      // >0: accept next command without sync
+    bool     p300              = true;   // controller understands VS2/P300
+    uint32_t latencyMs         = 20;     // controller think time per request
+    uint32_t latencyJitterMs   = 0;      // uniform extra latency 0..jitter
+    double   dropRate          = 0.0;    // reply never sent
+    double   truncateRate      = 0.0;    // reply one byte short
+    double   corruptRate       = 0.0;    // one bit flipped in the reply
+    uint32_t stallEveryMs      = 0;      // >0: every N ms ...
+    uint32_t stallForMs        = 0;      // ... go silent for this long
+    double   plantSpeed        = 60.0;   // simulated seconds per real second
+    double   sensorNoise       = 0.1;    // +- K noise on temperature sensors
+    uint32_t seed              = 1;
+    std::set<uint16_t> unsupported;      // addresses that are never answered
+};
+
+struct VitotronicEmulatorStats {
+    uint64_t syncs       = 0;
+    uint64_t reads       = 0;
+    uint64_t writes      = 0;
+    uint64_t dropped     = 0;
+    uint64_t truncated   = 0;
+    uint64_t corrupted   = 0;
+    uint64_t unsupported = 0;
+    uint64_t p300Inits   = 0;
+    uint64_t crcErrors   = 0;            // P300 request telegrams with a bad checksum
+    uint64_t bytesRx     = 0;
+    uint64_t bytesTx     = 0;
+};
+
+class VitotronicEmulator {
+public:
+    explicit VitotronicEmulator(const VitotronicEmulatorConfig& config);
+    ~VitotronicEmulator();
+
+    // Create the pty and start the controller thread; false on failure.
+    bool start();
+    void stop();
+
+    // Path of the pty slave the firmware should open as its Optolink UART.
+    const char* slavePath() const { return mSlavePath.c_str(); }
+
+    // Direct access to the address map (thread-safe).
+    void    poke(uint16_t address, const uint8_t* data, uint8_t length);
+    void    peek(uint16_t address, uint8_t* data, uint8_t length) const;
+    void    pokeTemp(uint16_t address, float value);   // int16 LE, x10
+    float   peekTemp(uint16_t address) const;
+    void    pokeByte(uint16_t address, uint8_t value) { poke(address, &value, 1); }
+    uint8_t peekByte(uint16_t address) const { uint8_t v; peek(address, &v, 1); return v; }
+
+    VitotronicEmulatorStats stats() const;
+
+private:
+    enum class State { IDLE, SYNC_SENT, COMMAND, FOLLOWUP, P300_INIT, P300_IDLE, P300_TELEGRAM };
+
+    void     run();
+    void     handleByte(uint8_t c, uint32_t now);
+    void     execute(uint32_t now);
+    void     executeP300(uint32_t now);
+    void     injectFaults(uint8_t* data, size_t& length);
+    void     transmit(const uint8_t* data, size_t length);
+    void     plantStep(double dtSimSeconds);
+    void     seedMemory();
+    void     addRegister(uint16_t address, uint8_t length);
+    double   random01();
+    uint32_t nowMs() const;
+
+    VitotronicEmulatorConfig mConfig;
+    std::string              mSlavePath;
+    int                      mMasterFd = -1;
+    int                      mSlaveKeepFd = -1;
+    std::thread              mThread;
+    std::atomic<bool>        mRunning{false};
+
+    mutable std::mutex       mMemMutex;
+    uint8_t                  mMem[65536];
+    struct Register {                    // a datapoint with bytes of its own
+        uint16_t address;
+        uint8_t  length;
+        uint8_t  bytes[4];
+    };
+    std::vector<Register>    mRegisters;
+    VitotronicEmulatorStats  mStats;
+
+    State    mState = State::IDLE;
+    uint32_t mStateMs = 0;
+    uint32_t mNextSyncMs = 0;
+    uint8_t  mCmd[4 + 255];
+    size_t   mCmdLen = 0;
+    uint32_t mRng;
+    bool     mP300 = false;
+
+    // plant model state
+    double   mSimSeconds = 0;
+    bool     mCompressor = false;
+    bool     mDhwMode = false;
+    double   mVorlauf = 30.0;
+    double   mWwOben = 45.0;
+};
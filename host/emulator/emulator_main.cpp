@@ -0,0 +1,42 @@
+// Standalone Vitotronic emulator: prints the pty path and serves until Ctrl-C.
+// Point any VS1/KW client (e.g. VitoWiFi's Linux build, vcontrold) at the path.
+#include "EmulatorOptions.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t gStop = 0;
+static void onSignal(int) { gStop = 1; }
+
+int main(int argc, char** argv) {
+    VitotronicEmulatorConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        if (!parseEmulatorOption(argc, argv, i, cfg)) {
+            fprintf(stderr, "usage: %s [options]\n", argv[0]);
+            printEmulatorUsage(stderr);
+            return 2;
+        }
+    }
+
+    VitotronicEmulator emu(cfg);
+    if (!emu.start()) {
+        return 1;
+    }
+    printf("%s\n", emu.slavePath());
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    while (!gStop) {
+        usleep(100000);
+    }
+    emu.stop();
+
+    VitotronicEmulatorStats s = emu.stats();
+    fprintf(stderr, "syncs=%llu p300_inits=%llu reads=%llu writes=%llu dropped=%llu truncated=%llu corrupted=%llu crc_errors=%llu unsupported=%llu rx=%llu tx=%llu\n",
+            (unsigned long long)s.syncs, (unsigned long long)s.p300Inits, (unsigned long long)s.reads,
+            (unsigned long long)s.writes, (unsigned long long)s.dropped, (unsigned long long)s.truncated,
+            (unsigned long long)s.corrupted, (unsigned long long)s.crcErrors, (unsigned long long)s.unsupported,
+            (unsigned long long)s.bytesRx, (unsigned long long)s.bytesTx);
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Host implementation of the Arduino core shim (see Arduino.h)
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+const Clock::time_point kBoot = Clock::now();
+
+const char* gSerialDevice[3] = {nullptr, nullptr, nullptr};
+bool        gConsoleEcho     = false;
+std::atomic<int64_t> gFrozenUs{-1};   // manual clock, -1 = steady clock
+}
+
+uint64_t hostClockUs() {
+    int64_t frozen = gFrozenUs.load(std::memory_order_relaxed);
+    if (frozen >= 0) {
+        return (uint64_t)frozen;
+    }
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - kBoot).count();
+}
+
+void hostFreezeClock(uint64_t us) { gFrozenUs = (int64_t)us; }
+void hostReleaseClock() { gFrozenUs = -1; }
+
+uint32_t millis() {
+    return (uint32_t)(hostClockUs() / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)hostClockUs();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char*, uint32_t, void* param, UBaseType_t, TaskHandle_t* handle) {
+    std::thread t(fn, param);
+    if (handle) {
+        *handle = nullptr;
+    }
+    t.detach();
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void hostSetSerialDevice(int uartNr, const char* path) {
+    if (uartNr >= 0 && uartNr < 3) {
+        gSerialDevice[uartNr] = path;
+    }
+}
+
+void hostSetConsoleEcho(bool enabled) { gConsoleEcho = enabled; }
+bool hostConsoleEcho() { return gConsoleEcho; }
+
+// --- HardwareSerial ----------------------------------------------------------
+// UART numbers without a bound device behave like the USB console: writes go
+// to stdout when echo is enabled, reads never return data.
+HardwareSerial Serial(-1);
+HardwareSerial Serial0(0);
+EspClass       ESP;
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t, int8_t) {
+    mBaud = baud;
+    if (mUartNr < 0 || mUartNr >= 3 || gSerialDevice[mUartNr] == nullptr) {
+        return;
+    }
+    end();
+    mFd = ::open(gSerialDevice[mUartNr], O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (mFd < 0) {
+        fprintf(stderr, "[host] cannot open %s: %s\n", gSerialDevice[mUartNr], strerror(errno));
+        return;
+    }
+    termios tio;
+    if (tcgetattr(mFd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        if (config == SERIAL_8E1 || config == SERIAL_8E2) {
+            tio.c_cflag |= PARENB;
+        }
+        if (config == SERIAL_8E2) {
+            tio.c_cflag |= CSTOPB;
+        }
+        tcsetattr(mFd, TCSANOW, &tio);
+    }
+}
+
+void HardwareSerial::end() {
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+    mPeek = -1;
+}
+
+int HardwareSerial::peek() {
+    if (mPeek < 0) {
+        mPeek = readFd();
+    }
+    return mPeek;
+}
+
+int HardwareSerial::available() {
+    if (mPeek >= 0) return 1;
+    if (mFd < 0) return 0;
+    mPeek = readFd();
+    return mPeek >= 0 ? 1 : 0;
+}
+
+int HardwareSerial::read() {
+    if (mPeek >= 0) {
+        int c = mPeek;
+        mPeek = -1;
+        return c;
+    }
+    return readFd();
+}
+
+int HardwareSerial::readFd() {
+    if (mFd < 0) return -1;
+    uint8_t c;
+    ssize_t n = ::read(mFd, &c, 1);
+    return n == 1 ? c : -1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (mFd < 0) {
+        if (gConsoleEcho) {
+            fwrite(buffer, 1, size, stdout);
+        }
+        return size;
+    }
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(mFd, buffer + done, size - done);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            break;
+        }
+        done += (size_t)n;
+    }
+    return done;
+}
@@ -0,0 +1,247 @@
+// ---------------------------------------------------------------------------
+// Host shim for the subset of the Arduino core used by the sketches.
+//
+// - millis()/micros() run off the host steady clock (ms since process start),
+//   or off a manual one for trace replays (hostFreezeClock())
+// - Serial  : USB console, echoed to stdout only when hostSetConsoleEcho(true)
+// - Serial0 : Optolink UART, backed by a tty/pty set via hostSetSerialDevice()
+// - xTaskCreate(): the FreeRTOS task runs on a std::thread
+// Only what the sketches actually call is provided; extend on demand.
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <time.h>
+
+#ifndef ARDUINO
+  #define ARDUINO 10819
+#endif
+#ifndef VITO_HOST_BUILD
+  #define VITO_HOST_BUILD 1
+#endif
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+#define F(s)     (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+#define DEC 10
+#define HEX 16
+
+// --- timing ----------------------------------------------------------------
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+void     yield();
+
+// --- FreeRTOS tasks (std::thread) ---------------------------------------------
+// Just enough for xTaskCreate()/vTaskDelay(): a task is a detached thread, a
+// tick is 1 ms. Priorities and stack sizes are ignored; Linux schedules.
+typedef void*    TaskHandle_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+#define pdPASS             1
+#define pdFAIL             0
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define tskIDLE_PRIORITY   0
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                       UBaseType_t priority, TaskHandle_t* handle);
+void       vTaskDelay(TickType_t ticks);
+// Only vTaskDelete(nullptr) at the end of the task function; the thread ends when it returns.
+inline void vTaskDelete(TaskHandle_t) {}
+
+// SNTP: the host clock is already set, so time() is valid right away
+inline void configTime(long /*gmtOffsetSec*/, int /*daylightOffsetSec*/, const char* /*server1*/,
+                       const char* /*server2*/ = nullptr, const char* /*server3*/ = nullptr) {}
+
+// --- String (minimal, std::string backed) ------------------------------------
+class String {
+public:
+    String() {}
+    String(const char* s) : mStr(s ? s : "") {}
+    String(const std::string& s) : mStr(s) {}
+    String(const __FlashStringHelper* s) : mStr(reinterpret_cast<const char*>(s)) {}
+    explicit String(int v)           : mStr(std::to_string(v)) {}
+    explicit String(unsigned int v)  : mStr(std::to_string(v)) {}
+    explicit String(long v)          : mStr(std::to_string(v)) {}
+    explicit String(unsigned long v) : mStr(std::to_string(v)) {}
+    explicit String(float v, unsigned int digits = 2) { char buf[32]; snprintf(buf, sizeof(buf), "%.*f", (int)digits, v); mStr = buf; }
+
+    const char* c_str() const { return mStr.c_str(); }
+    unsigned int length() const { return (unsigned int)mStr.size(); }
+    bool isEmpty() const { return mStr.empty(); }
+    bool equals(const char* s) const { return mStr == (s ? s : ""); }
+    bool startsWith(const char* s) const { return mStr.rfind(s, 0) == 0; }
+    String substring(unsigned int from) const { return from < mStr.size() ? String(mStr.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const { return from < mStr.size() && to > from ? String(mStr.substr(from, to - from)) : String(); }
+    int toInt() const { return atoiSafe(); }
+    float toFloat() const { return (float)strtod(mStr.c_str(), nullptr); }
+
+    String& operator+=(const String& o) { mStr += o.mStr; return *this; }
+    String& operator+=(const char* s) { mStr += (s ? s : ""); return *this; }
+    String& operator+=(char c) { mStr += c; return *this; }
+    bool operator==(const String& o) const { return mStr == o.mStr; }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& o) const { return mStr != o.mStr; }
+    friend String operator+(const String& a, const String& b) { return String(a.mStr + b.mStr); }
+    friend String operator+(const String& a, const char* b) { return String(a.mStr + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.mStr); }
+
+private:
+    int atoiSafe() const { return (int)strtol(mStr.c_str(), nullptr, 10); }
+    std::string mStr;
+};
+
+// --- IPAddress ----------------------------------------------------------------
+class IPAddress {
+public:
+    IPAddress() : mAddr{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : mAddr{a, b, c, d} {}
+    uint8_t operator[](int i) const { return mAddr[i & 3]; }
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", mAddr[0], mAddr[1], mAddr[2], mAddr[3]);
+        return String(buf);
+    }
+private:
+    uint8_t mAddr[4];
+};
+
+// --- Print ------------------------------------------------------------------
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* s) { return s ? write(reinterpret_cast<const uint8_t*>(s), strlen(s)) : 0; }
+
+    size_t print(const char* s)                 { return write(s); }
+    size_t print(const String& s)               { return write(s.c_str()); }
+    size_t print(const __FlashStringHelper* s)  { return write(reinterpret_cast<const char*>(s)); }
+    size_t print(char c)                        { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC)      { return printNumber((unsigned long long)v, base); }
+    size_t print(int v, int base = DEC)                { return printSigned((long long)v, base); }
+    size_t print(unsigned int v, int base = DEC)       { return printNumber((unsigned long long)v, base); }
+    size_t print(long v, int base = DEC)               { return printSigned((long long)v, base); }
+    size_t print(unsigned long v, int base = DEC)      { return printNumber((unsigned long long)v, base); }
+    size_t print(long long v, int base = DEC)          { return printSigned(v, base); }
+    size_t print(unsigned long long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(double v, int digits = 2) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        return write(buf);
+    }
+    size_t print(const IPAddress& ip) { return print(ip.toString()); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len <= 0) return 0;
+        return write(reinterpret_cast<const uint8_t*>(buf), (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+    }
+
+private:
+    size_t printNumber(unsigned long long v, int base) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), base == HEX ? "%llX" : "%llu", v);
+        return write(buf);
+    }
+    size_t printSigned(long long v, int base) {
+        if (base != DEC) return printNumber((unsigned long long)v, base);
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%lld", v);
+        return write(buf);
+    }
+};
+
+// --- Stream / HardwareSerial -------------------------------------------------
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#define SERIAL_8N1 0x800001cU
+#define SERIAL_8E1 0x800001eU
+#define SERIAL_8E2 0x800003eU
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uartNr) : mUartNr(uartNr) {}
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end();
+    void setDebugOutput(bool) {}
+    void flush() {}
+    int  available() override;
+    int  read() override;
+    int  peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    operator bool() const { return true; }
+
+    unsigned long baudRate() const { return mBaud; }
+    int uartNr() const { return mUartNr; }
+
+private:
+    int           readFd();   // read() without a subclass in between (available(), peek())
+
+    int           mUartNr;
+    int           mFd = -1;
+    int           mPeek = -1;
+    unsigned long mBaud = 0;
+};
+
+extern HardwareSerial Serial;   // USB CDC console
+extern HardwareSerial Serial0;  // UART0 -> Optolink
+
+// Chip functions; on the host restart() is only counted, the process keeps running.
+class EspClass {
+public:
+    void     restart() { mRestarts++; }
+    uint32_t hostRestarts() const { return mRestarts; }
+private:
+    uint32_t mRestarts = 0;
+};
+extern EspClass ESP;
+
+// --- host control hooks (not part of the Arduino API) -----------------------
+// Bind a UART number to a tty path; must be called before <Serial>.begin().
+void hostSetSerialDevice(int uartNr, const char* path);
+// Echo USB console / WebSerial output to stdout (default off).
+void hostSetConsoleEcho(bool enabled);
+bool hostConsoleEcho();
+// Manual clock (trace replay): from hostFreezeClock() on, millis()/micros()
+// return the time set last, in us since boot; delay() still sleeps.
+void hostFreezeClock(uint64_t us);
+void hostReleaseClock();
+uint64_t hostClockUs();
@@ -0,0 +1,267 @@
+// Host implementation of the ArduinoHA shim (see ArduinoHA.h)
+#include "ArduinoHA.h"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+HostMqttStats gStats;
+bool          gBrokerUp = true;
+uint32_t      gPublishCostUs = 0;
+
+void publishCost() {
+    if (gPublishCostUs) {
+        std::this_thread::sleep_for(std::chrono::microseconds(gPublishCostUs));
+    }
+}
+
+size_t stateTopicLength(const HABaseDeviceType* entity) {
+    // <dataPrefix>/<device>/<entity>/stat_t
+    const HAMqtt* mqtt = HAMqtt::instance();
+    size_t len = strlen(entity->uniqueId()) + 8;
+    if (mqtt) {
+        len += strlen(mqtt->getDataPrefix()) + strlen(mqtt->device().getUniqueId());
+    }
+    return len;
+}
+
+void formatNumber(char* buf, size_t size, const HANumeric& value, int precision) {
+    if (!value.isSet()) {
+        snprintf(buf, size, "None");
+    } else {
+        snprintf(buf, size, "%.*f", precision, value.toFloat());
+    }
+}
+}
+
+HostMqttStats& hostMqttStats() { return gStats; }
+void hostSetBrokerUp(bool up) { gBrokerUp = up; }
+void hostSetPublishCostUs(uint32_t us) { gPublishCostUs = us; }
+
+// --- HABaseDeviceType --------------------------------------------------------
+std::vector<HABaseDeviceType*>& HABaseDeviceType::hostRegistry() {
+    static std::vector<HABaseDeviceType*> registry;
+    return registry;
+}
+
+HABaseDeviceType::HABaseDeviceType(const char* componentName, const char* uniqueId)
+    : mComponent(componentName), mUniqueId(uniqueId) {
+    hostRegistry().push_back(this);
+}
+
+bool HABaseDeviceType::mqttConnected() {
+    return HAMqtt::instance() && HAMqtt::instance()->isConnected();
+}
+
+bool HABaseDeviceType::publishState(const char* payload, bool retained) {
+    (void)retained;
+    if (!mqttConnected()) {
+        return false;
+    }
+    mPublishes++;
+    if (gStats.firstStateUs == 0) {
+        gStats.firstStateUs = micros() | 1;
+    }
+    gStats.statePublishes++;
+    gStats.stateBytes += stateTopicLength(this) + strlen(payload);
+    publishCost();
+    return true;
+}
+
+void HABaseDeviceType::onMqttConnected() {
+    // discovery config: a JSON document of roughly this many bytes
+    const HAMqtt* mqtt = HAMqtt::instance();
+    size_t len = 180 + strlen(mUniqueId) * 3;
+    if (mName) len += strlen(mName);
+    if (mIcon) len += strlen(mIcon);
+    if (mUnit) len += strlen(mUnit);
+    if (mqtt) len += strlen(mqtt->getDiscoveryPrefix()) + strlen(mComponent);
+    gStats.discoveryPublishes++;
+    gStats.discoveryBytes += len;
+    publishCost();
+    hostPublishCurrent();
+}
+
+// --- entities ----------------------------------------------------------------
+bool HASensor::setValue(const char* value) {
+    std::string next = value ? value : "";
+    if (next == mValue && !mForceUpdate) {
+        return true;
+    }
+    mValue = next;
+    return publishState(mValue.c_str());
+}
+
+bool HASensorNumber::setValue(const HANumeric& value, bool force) {
+    if (!force && value == mCurrent) {
+        return true;
+    }
+    mCurrent = value;
+    char buf[32];
+    formatNumber(buf, sizeof(buf), value, mPrecision);
+    return publishState(buf);
+}
+
+void HASensorNumber::hostPublishCurrent() {
+    if (mCurrent.isSet()) {
+        setValue(mCurrent, true);
+    }
+}
+
+bool HABinarySensor::setState(bool state, bool force) {
+    if (!force && mPublished && state == mState) {
+        return true;
+    }
+    mState = state;
+    mPublished = publishState(state ? "ON" : "OFF");
+    return mPublished;
+}
+
+void HABinarySensor::hostPublishCurrent() {
+    setState(mState, true);
+}
+
+bool HANumber::setState(const HANumeric& state, bool force) {
+    if (!force && state == mCurrent) {
+        return true;
+    }
+    mCurrent = state;
+    char buf[32];
+    formatNumber(buf, sizeof(buf), state, mPrecision);
+    return publishState(buf, mRetain);
+}
+
+// a retained state is still on the broker
+void HANumber::hostPublishCurrent() {
+    if (mCurrent.isSet() && !mRetain) {
+        setState(mCurrent, true);
+    }
+}
+
+bool HASelect::setState(int8_t state, bool force) {
+    if (!force && state == mState) {
+        return true;
+    }
+    mState = state;
+    char buf[8];
+    snprintf(buf, sizeof(buf), "%d", state);
+    return publishState(buf, mRetain);
+}
+
+void HASelect::hostPublishCurrent() {
+    if (mState >= 0 && !mRetain) {
+        setState(mState, true);
+    }
+}
+
+bool HAHVAC::setCurrentTemperature(const HANumeric& temperature, bool force) {
+    if (!force && temperature == mCurrentTemp) return true;
+    mCurrentTemp = temperature;
+    char buf[32];
+    formatNumber(buf, sizeof(buf), temperature, mPrecision);
+    return publishState(buf);
+}
+
+bool HAHVAC::setTargetTemperature(const HANumeric& temperature, bool force) {
+    if (!force && temperature == mTargetTemp) return true;
+    mTargetTemp = temperature;
+    char buf[32];
+    formatNumber(buf, sizeof(buf), temperature, mPrecision);
+    return publishState(buf);
+}
+
+bool HAHVAC::setAuxState(bool state, bool force) {
+    if (!force && mAuxSet && state == mAux) return true;
+    mAux = state;
+    mAuxSet = true;
+    return publishState(state ? "ON" : "OFF");
+}
+
+bool HAHVAC::setMode(Mode mode, bool force) {
+    if (!force && mode == mMode) return true;
+    mMode = mode;
+    return publishState(mode == HeatMode ? "heat" : mode == CoolMode ? "cool" : mode == OffMode ? "off" : "auto");
+}
+
+// --- device / mqtt -----------------------------------------------------------
+bool HADevice::setUniqueId(const byte* uniqueId, uint16_t length) {
+    size_t pos = 0;
+    for (uint16_t i = 0; i < length && pos + 2 < sizeof(mMacId); ++i) {
+        pos += snprintf(mMacId + pos, sizeof(mMacId) - pos, "%02x", uniqueId[i]);
+    }
+    mUniqueId = mMacId;
+    return true;
+}
+
+void HADevice::publishAvailability() {
+    HAMqtt* mqtt = HAMqtt::instance();
+    if (mqtt) {
+        mqtt->publish("avty_t", "online", true);
+    }
+}
+
+HAMqtt* HAMqtt::sInstance = nullptr;
+
+HAMqtt::HAMqtt(WiFiClient&, HADevice& device, uint8_t maxDevicesTypes)
+    : mDevice(device), mMaxDevicesTypes(maxDevicesTypes) {
+    sInstance = this;
+}
+
+bool HAMqtt::begin(const char*, uint16_t, const char*, const char*) {
+    size_t entities = HABaseDeviceType::hostRegistry().size();
+    if (entities > mMaxDevicesTypes) {
+        fprintf(stderr, "[host] HAMqtt: %u entities exceed maxDevicesTypes=%u (ArduinoHA drops the rest)\n",
+                (unsigned)entities, (unsigned)mMaxDevicesTypes);
+    }
+    mBegun = true;
+    return true;
+}
+
+void HAMqtt::loop() {
+    if (!mBegun) {
+        return;
+    }
+    bool linkUp = gBrokerUp && WiFi.status() == WL_CONNECTED;
+    if (mConnected && !linkUp) {
+        mConnected = false;
+        return;
+    }
+    if (!mConnected && linkUp) {
+        mConnected = true;
+        gStats.connects++;
+        gStats.connectUs = micros();
+        gStats.firstStateUs = 0;
+        uint8_t n = 0;
+        for (HABaseDeviceType* entity : HABaseDeviceType::hostRegistry()) {
+            if (n++ >= mMaxDevicesTypes) break;
+            entity->onMqttConnected();
+        }
+        if (mOnConnected) {
+            mOnConnected();
+        }
+    }
+}
+
+bool HAMqtt::publish(const char* topic, const char* payload, bool) {
+    if (!mConnected) {
+        return false;
+    }
+    size_t prefixLen = strlen(mDiscoveryPrefix);
+    if (strncmp(topic, mDiscoveryPrefix, prefixLen) == 0 && topic[prefixLen] == '/') {
+        // a config the sketch sends itself (batched state)
+        gStats.discoveryPublishes++;
+        gStats.discoveryBytes += strlen(topic) + strlen(payload);
+        publishCost();
+        return true;
+    }
+    gStats.otherPublishes++;
+    gStats.otherBytes += strlen(topic) + strlen(payload);
+    if (strchr(topic, '/') == nullptr) {
+        // ArduinoHA's own topics (availability) are relative to <data prefix>/<device>
+        gStats.otherBytes += strlen(mDataPrefix) + strlen(mDevice.getUniqueId()) + 2;
+    } else if (gStats.firstStateUs == 0) {
+        gStats.firstStateUs = micros() | 1;   // the sketch's own data topics (batches, replay)
+    }
+    publishCost();
+    return true;
+}
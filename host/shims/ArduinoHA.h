@@ -0,0 +1,309 @@
+// ---------------------------------------------------------------------------
+// Host shim for the ArduinoHA entity API used by HA_mqtt_addin.h.
+//
+// Entities keep their last state and account every would-be MQTT publish
+// (count + approximate topic/payload bytes) in hostMqttStats(). Publishing
+// follows ArduinoHA semantics: only while connected and only if the value
+// changed, unless forced. Commands from HA can be injected with hostCommand().
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+
+class HAMqtt;
+
+// Value wrapper mirroring ArduinoHA's HANumeric (unset by default).
+class HANumeric {
+public:
+    HANumeric() : mIsSet(false), mValue(0) {}
+    HANumeric(float v)              : mIsSet(true), mValue(v) {}
+    HANumeric(double v)             : mIsSet(true), mValue(v) {}
+    HANumeric(int8_t v)             : mIsSet(true), mValue(v) {}
+    HANumeric(uint8_t v)            : mIsSet(true), mValue(v) {}
+    HANumeric(int16_t v)            : mIsSet(true), mValue(v) {}
+    HANumeric(uint16_t v)           : mIsSet(true), mValue(v) {}
+    HANumeric(int32_t v)            : mIsSet(true), mValue(v) {}
+    HANumeric(uint32_t v)           : mIsSet(true), mValue(v) {}
+    HANumeric(long v)               : mIsSet(true), mValue((double)v) {}
+    HANumeric(unsigned long v)      : mIsSet(true), mValue((double)v) {}
+
+    bool  isSet() const { return mIsSet; }
+    float toFloat() const { return (float)mValue; }
+    int32_t toInt32() const { return (int32_t)mValue; }
+    uint8_t toUInt8() const { return (uint8_t)mValue; }
+    bool operator==(const HANumeric& o) const { return mIsSet == o.mIsSet && mValue == o.mValue; }
+    bool operator!=(const HANumeric& o) const { return !(*this == o); }
+
+private:
+    bool   mIsSet;
+    double mValue;
+};
+
+// Aggregate publish accounting for the whole device.
+struct HostMqttStats {
+    uint64_t statePublishes     = 0;
+    uint64_t stateBytes         = 0;
+    uint64_t discoveryPublishes = 0;
+    uint64_t discoveryBytes     = 0;
+    uint64_t otherPublishes     = 0;
+    uint64_t otherBytes         = 0;
+    uint32_t connects           = 0;
+    uint32_t connectUs          = 0;   // micros() of the last connect
+    uint32_t firstStateUs       = 0;   // micros() of the first state/data publish after it, 0 = none yet
+};
+HostMqttStats& hostMqttStats();
+
+class HABaseDeviceType {
+public:
+    enum NumberPrecision { PrecisionP0 = 0, PrecisionP1, PrecisionP2, PrecisionP3 };
+
+    HABaseDeviceType(const char* componentName, const char* uniqueId);
+    virtual ~HABaseDeviceType() {}
+
+    const char* uniqueId() const { return mUniqueId; }
+    const char* componentName() const { return mComponent; }
+    void setName(const char* name) { mName = name; }
+    const char* getName() const { return mName; }
+    void setObjectId(const char* objectId) { mObjectId = objectId; }
+    const char* getObjectId() const { return mObjectId; }
+    void setIcon(const char* icon) { mIcon = icon; }
+    void setUnitOfMeasurement(const char* unit) { mUnit = unit; }
+    void setDeviceClass(const char* deviceClass) { mDeviceClass = deviceClass; }
+    void setRetain(bool retain) { mRetain = retain; }
+
+    // host-only accounting
+    uint32_t hostPublishCount() const { return mPublishes; }
+    static std::vector<HABaseDeviceType*>& hostRegistry();
+
+    // ArduinoHA calls this for each entity when the broker (re)connects:
+    // config, then the entity's current state (hostPublishCurrent())
+    virtual void onMqttConnected();
+
+protected:
+    virtual void hostPublishCurrent() {}   // what ArduinoHA sends after the config
+    bool publishState(const char* payload, bool retained = false);
+    static bool mqttConnected();
+
+    const char* mComponent;
+    const char* mUniqueId;
+    const char* mName = nullptr;
+    const char* mObjectId = nullptr;
+    const char* mIcon = nullptr;
+    const char* mUnit = nullptr;
+    const char* mDeviceClass = nullptr;
+    bool        mRetain = false;
+    uint32_t    mPublishes = 0;
+};
+
+class HASensor : public HABaseDeviceType {
+public:
+    explicit HASensor(const char* uniqueId) : HABaseDeviceType("sensor", uniqueId) {}
+    bool setValue(const char* value);
+    void setForceUpdate(bool force) { mForceUpdate = force; }
+    const char* hostValue() const { return mValue.c_str(); }
+private:
+    bool        mForceUpdate = false;
+    std::string mValue;
+};
+
+class HASensorNumber : public HASensor {
+public:
+    HASensorNumber(const char* uniqueId, NumberPrecision precision = PrecisionP0)
+        : HASensor(uniqueId), mPrecision(precision) {}
+    bool setValue(const HANumeric& value, bool force = false);
+    const HANumeric& getCurrentValue() const { return mCurrent; }
+protected:
+    void hostPublishCurrent() override;
+private:
+    NumberPrecision mPrecision;
+    HANumeric       mCurrent;
+};
+
+class HABinarySensor : public HABaseDeviceType {
+public:
+    explicit HABinarySensor(const char* uniqueId) : HABaseDeviceType("binary_sensor", uniqueId) {}
+    bool setState(bool state, bool force = false);
+    void setCurrentState(bool state) { mState = state; }
+    bool getCurrentState() const { return mState; }
+protected:
+    void hostPublishCurrent() override;
+private:
+    bool mState = false;
+    bool mPublished = false;
+};
+
+class HANumber : public HABaseDeviceType {
+public:
+    enum Mode { ModeAuto = 0, ModeBox, ModeSlider };
+    typedef void (*CommandCallback)(HANumeric number, HANumber* sender);
+
+    HANumber(const char* uniqueId, NumberPrecision precision = PrecisionP0)
+        : HABaseDeviceType("number", uniqueId), mPrecision(precision) {}
+
+    bool setState(const HANumeric& state, bool force = false);
+    void setCurrentState(const HANumeric& state) { mCurrent = state; }
+    const HANumeric& getCurrentState() const { return mCurrent; }
+    void setMin(float v) { mMin = v; }
+    void setMax(float v) { mMax = v; }
+    void setStep(float v) { mStep = v; }
+    void setMode(Mode mode) { mMode = mode; }
+    void setOptimistic(bool optimistic) { mOptimistic = optimistic; }
+    void onCommand(CommandCallback callback) { mCommand = callback; }
+
+    // host-only: simulate a command arriving from Home Assistant
+    void hostCommand(const HANumeric& value) { if (mCommand) mCommand(value, this); }
+
+protected:
+    void hostPublishCurrent() override;
+
+private:
+    NumberPrecision mPrecision;
+    HANumeric       mCurrent;
+    float           mMin = 1, mMax = 100, mStep = 1;
+    Mode            mMode = ModeAuto;
+    bool            mOptimistic = false;
+    CommandCallback mCommand = nullptr;
+};
+
+class HASelect : public HABaseDeviceType {
+public:
+    typedef void (*CommandCallback)(int8_t index, HASelect* sender);
+
+    explicit HASelect(const char* uniqueId) : HABaseDeviceType("select", uniqueId) {}
+    void setOptions(const char* options) { mOptions = options; }
+    bool setState(int8_t state, bool force = false);
+    int8_t getCurrentState() const { return mState; }
+    void onCommand(CommandCallback callback) { mCommand = callback; }
+
+    void hostCommand(int8_t index) { if (mCommand) mCommand(index, this); }
+
+protected:
+    void hostPublishCurrent() override;
+
+private:
+    const char*     mOptions = nullptr;
+    int8_t          mState = -1;
+    CommandCallback mCommand = nullptr;
+};
+
+class HAHVAC : public HABaseDeviceType {
+public:
+    enum Features {
+        DefaultFeatures          = 0,
+        ActionFeature            = 1,
+        AuxStateFeature          = 2,
+        PowerFeature             = 4,
+        FanFeature               = 8,
+        SwingFeature             = 16,
+        ModesFeature             = 32,
+        TargetTemperatureFeature = 64
+    };
+    enum Mode {
+        UnknownMode = 0,
+        AutoMode    = 1,
+        OffMode     = 2,
+        CoolMode    = 4,
+        HeatMode    = 8,
+        DryMode     = 16,
+        FanOnlyMode = 32
+    };
+    typedef void (*TargetTemperatureCallback)(HANumeric temperature, HAHVAC* sender);
+    typedef void (*PowerCallback)(bool state, HAHVAC* sender);
+    typedef void (*ModeCallback)(Mode mode, HAHVAC* sender);
+
+    HAHVAC(const char* uniqueId, uint16_t features = DefaultFeatures, NumberPrecision precision = PrecisionP1)
+        : HABaseDeviceType("climate", uniqueId), mFeatures(features), mPrecision(precision) {}
+
+    bool setCurrentTemperature(const HANumeric& temperature, bool force = false);
+    bool setTargetTemperature(const HANumeric& temperature, bool force = false);
+    bool setAuxState(bool state, bool force = false);
+    bool setMode(Mode mode, bool force = false);
+    void setMinTemp(float v) { mMinTemp = v; }
+    void setMaxTemp(float v) { mMaxTemp = v; }
+    void setTempStep(float v) { mTempStep = v; }
+    void setModes(uint8_t modes) { mModes = modes; }
+    void onTargetTemperatureCommand(TargetTemperatureCallback cb) { mTargetCb = cb; }
+    void onPowerCommand(PowerCallback cb) { mPowerCb = cb; }
+    void onModeCommand(ModeCallback cb) { mModeCb = cb; }
+
+    void hostTargetTemperatureCommand(const HANumeric& t) { if (mTargetCb) mTargetCb(t, this); }
+    void hostModeCommand(Mode mode) { if (mModeCb) mModeCb(mode, this); }
+
+private:
+    uint16_t        mFeatures;
+    NumberPrecision mPrecision;
+    HANumeric       mCurrentTemp, mTargetTemp;
+    bool            mAux = false, mAuxSet = false;
+    Mode            mMode = UnknownMode;
+    float           mMinTemp = 7, mMaxTemp = 35, mTempStep = 1;
+    uint8_t         mModes = 0;
+    TargetTemperatureCallback mTargetCb = nullptr;
+    PowerCallback             mPowerCb = nullptr;
+    ModeCallback              mModeCb = nullptr;
+};
+
+class HADevice {
+public:
+    HADevice() : mUniqueId("") {}
+    explicit HADevice(const char* uniqueId) : mUniqueId(uniqueId) {}
+    bool setUniqueId(const byte* uniqueId, uint16_t length);
+    const char* getUniqueId() const { return mUniqueId; }
+    void setName(const char* name) { mName = name; }
+    void setSoftwareVersion(const char* v) { mSwVersion = v; }
+    void setManufacturer(const char* m) { mManufacturer = m; }
+    void setModel(const char* m) { mModel = m; }
+    void enableSharedAvailability() {}
+    void enableLastWill() {}
+    void publishAvailability();
+
+private:
+    const char* mUniqueId;
+    char        mMacId[13] = {0};
+    const char* mName = nullptr;
+    const char* mSwVersion = nullptr;
+    const char* mManufacturer = nullptr;
+    const char* mModel = nullptr;
+};
+
+class HAMqtt {
+public:
+    typedef void (*ConnectedCallback)();
+    typedef void (*MessageCallback)(const char* topic, const uint8_t* payload, uint16_t length);
+
+    HAMqtt(WiFiClient& client, HADevice& device, uint8_t maxDevicesTypes = 6);
+
+    static HAMqtt* instance() { return sInstance; }
+
+    void onConnected(ConnectedCallback cb) { mOnConnected = cb; }
+    void onMessage(MessageCallback cb) { mOnMessage = cb; }
+    void setDataPrefix(const char* prefix) { mDataPrefix = prefix; }
+    void setDiscoveryPrefix(const char* prefix) { mDiscoveryPrefix = prefix; }
+    const char* getDataPrefix() const { return mDataPrefix; }
+    const char* getDiscoveryPrefix() const { return mDiscoveryPrefix; }
+    HADevice& device() const { return mDevice; }
+    bool begin(const char* host, uint16_t port = 1883, const char* user = nullptr, const char* pass = nullptr);
+    void loop();
+    bool isConnected() const { return mConnected; }
+    bool publish(const char* topic, const char* payload, bool retained = false);
+    uint8_t maxDevicesTypes() const { return mMaxDevicesTypes; }
+
+private:
+    static HAMqtt*    sInstance;
+    HADevice&         mDevice;
+    uint8_t           mMaxDevicesTypes;
+    bool              mBegun = false;
+    bool              mConnected = false;
+    const char*       mDataPrefix = "aha";
+    const char*       mDiscoveryPrefix = "homeassistant";
+    ConnectedCallback mOnConnected = nullptr;
+    MessageCallback   mOnMessage = nullptr;
+};
+
+// --- host control hooks ------------------------------------------------------
+// Simulate broker availability (default up). The connection also drops while
+// WiFi is down and is re-established on the next HAMqtt::loop().
+void hostSetBrokerUp(bool up);
+// Every publish blocks the caller for us (a TCP write to a slow broker), default 0.
+void hostSetPublishCostUs(uint32_t us);
@@ -0,0 +1,2 @@
+// Host shim: AsyncTCP is only pulled in for ESPAsyncWebServer, nothing to provide.
+#pragma once
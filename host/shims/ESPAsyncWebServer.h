@@ -0,0 +1,345 @@
+// Host shim for ESPAsyncWebServer.
+// Routes are registered as on the device; the bench can dispatch a request
+// in-process via AsyncWebServer::hostRequest() and inspect the response.
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include <utility>
+#include <vector>
+
+typedef enum {
+    HTTP_GET    = 0b00000001,
+    HTTP_POST   = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT    = 0b00001000,
+    HTTP_ANY    = 0b01111111
+} WebRequestMethod;
+
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+// filler result: no data yet, call again (0xFFFFFFFF as size_t on the device)
+#define RESPONSE_TRY_AGAIN ((size_t)-1)
+
+// Result of an in-process request (host only).
+struct HostHttpResponse {
+    int         code = 0;
+    std::string contentType;
+    std::string body;
+    uint32_t    chunks = 0;   // filler calls that returned data (chunked responses)
+    std::vector<std::pair<std::string, std::string>> headers;   // added by the handler
+
+    const char* header(const char* name) const {
+        for (const auto& h : headers) {
+            if (h.first == name) return h.second.c_str();
+        }
+        return nullptr;
+    }
+};
+
+// Chunked response (the filler is called until it returns 0) or fixed content.
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(const char* contentType, AwsResponseFiller filler)
+        : mContentType(contentType ? contentType : ""), mFiller(filler) {}
+    AsyncWebServerResponse(int code, const char* contentType, const uint8_t* content, size_t len)
+        : mCode(code), mContentType(contentType ? contentType : ""),
+          mContent(reinterpret_cast<const char*>(content), len) {}
+    void addHeader(const char* name, const char* value) { mHeaders.emplace_back(name, value); }
+
+    // host-only: drain the filler with chunks of at most chunkSize bytes
+    void hostFill(HostHttpResponse& out, size_t chunkSize) {
+        std::vector<uint8_t> buf(chunkSize);
+        out.code = mCode;
+        out.contentType = mContentType;
+        out.headers = mHeaders;
+        if (!mFiller) {
+            out.body = mContent;
+            return;
+        }
+        size_t index = 0;
+        for (int idle = 0; idle < 1000;) {
+            size_t n = mFiller(buf.data(), buf.size(), index);
+            if (n == 0) {
+                break;
+            }
+            if (n == RESPONSE_TRY_AGAIN) {
+                idle++;
+                continue;
+            }
+            out.body.append(reinterpret_cast<const char*>(buf.data()), n);
+            out.chunks++;
+            index += n;
+        }
+    }
+
+private:
+    int               mCode = 200;
+    std::string       mContentType;
+    AwsResponseFiller mFiller;
+    std::string       mContent;
+    std::vector<std::pair<std::string, std::string>> mHeaders;
+};
+
+// Chunk size of host responses (about one TCP segment on the device)
+static const size_t HOST_HTTP_CHUNK = 1436;
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const std::string& name, const std::string& value) : mName(name), mValue(value) {}
+    String name() const { return String(mName); }
+    String value() const { return String(mValue); }
+private:
+    std::string mName;
+    std::string mValue;
+};
+
+// Request header as seen by a handler
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const std::string& name, const std::string& value) : mName(name), mValue(value) {}
+    const String& name() const { return mName; }
+    const String& value() const { return mValue; }
+private:
+    String mName;
+    String mValue;
+};
+
+typedef std::vector<std::pair<std::string, std::string>> HostHttpHeaders;
+
+class AsyncWebServerRequest {
+public:
+    // url may carry a query string ("/history?dp=x&since=600"); no %-decoding
+    AsyncWebServerRequest(WebRequestMethod method, const char* url, const HostHttpHeaders& headers = {})
+        : mMethod(method) {
+        for (const auto& h : headers) {
+            mHeaders.emplace_back(h.first, h.second);
+        }
+        std::string u(url);
+        size_t q = u.find('?');
+        mUrl = String(u.substr(0, q));
+        while (q != std::string::npos) {
+            size_t next = u.find('&', q + 1);
+            std::string kv = u.substr(q + 1, next == std::string::npos ? std::string::npos : next - q - 1);
+            size_t eq = kv.find('=');
+            mParams.emplace_back(kv.substr(0, eq), eq == std::string::npos ? "" : kv.substr(eq + 1));
+            q = next;
+        }
+    }
+
+    WebRequestMethod method() const { return mMethod; }
+    const String& url() const { return mUrl; }
+    bool hasParam(const char* name) const { return getParam(name) != nullptr; }
+    const AsyncWebParameter* getParam(const char* name) const {
+        for (const AsyncWebParameter& p : mParams) {
+            if (p.name() == name) return &p;
+        }
+        return nullptr;
+    }
+    bool hasHeader(const char* name) const { return getHeader(name) != nullptr; }
+    const AsyncWebHeader* getHeader(const char* name) const {
+        for (const AsyncWebHeader& h : mHeaders) {
+            if (strcasecmp(h.name().c_str(), name) == 0) return &h;
+        }
+        return nullptr;
+    }
+
+    void send(int code, const char* contentType = "", const char* content = "") {
+        mResponse.code = code;
+        mResponse.contentType = contentType ? contentType : "";
+        mResponse.body = content ? content : "";
+    }
+    void send(int code, const char* contentType, const String& content) {
+        send(code, contentType, content.c_str());
+    }
+    // file from the filesystem, 404 if it does not exist
+    void send(fs::FS& fs, const char* path, const char* contentType) {
+        File f = fs.open(path, FILE_READ);
+        if (!f) {
+            send(404, "text/plain", "Not found");
+            return;
+        }
+        mResponse = HostHttpResponse();
+        mResponse.code = 200;
+        mResponse.contentType = contentType ? contentType : "";
+        uint8_t buf[512];
+        size_t n;
+        while ((n = f.read(buf, sizeof(buf))) > 0) {
+            mResponse.body.append(reinterpret_cast<const char*>(buf), n);
+        }
+    }
+    AsyncWebServerResponse* beginChunkedResponse(const char* contentType, AwsResponseFiller filler) {
+        return new AsyncWebServerResponse(contentType, filler);
+    }
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType, const uint8_t* content, size_t len) {
+        return new AsyncWebServerResponse(code, contentType, content, len);
+    }
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType = "", const char* content = "") {
+        return beginResponse(code, contentType, reinterpret_cast<const uint8_t*>(content), strlen(content));
+    }
+    void send(AsyncWebServerResponse* response) {
+        mResponse = HostHttpResponse();
+        response->hostFill(mResponse, HOST_HTTP_CHUNK);
+        delete response;
+    }
+
+    const HostHttpResponse& hostResponse() const { return mResponse; }
+
+private:
+    WebRequestMethod               mMethod;
+    String                         mUrl;
+    std::vector<AsyncWebParameter> mParams;
+    std::vector<AsyncWebHeader>    mHeaders;
+    HostHttpResponse               mResponse;
+};
+
+class AsyncEventSource;
+
+// One SSE connection. On the device messages wait in a per-client queue until
+// TCP takes them; here the bench drains it with hostDrain(). A closed client
+// stays allocated (connected() == false) so the bench can keep its pointer.
+class AsyncEventSourceClient {
+public:
+    explicit AsyncEventSourceClient(AsyncEventSource* source) : mSource(source) {}
+
+    // false if the queue is full (the library's SSE_MAX_QUEUED_MESSAGES)
+    bool send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        (void)reconnect;
+        if (!mConnected || mQueue.size() >= MAX_QUEUED) {
+            return false;
+        }
+        std::string m;
+        if (id) m += "id: " + std::to_string(id) + "\r\n";
+        if (event) m += std::string("event: ") + event + "\r\n";
+        m += std::string("data: ") + (message ? message : "") + "\r\n\r\n";
+        mQueue.push_back(m);
+        return true;
+    }
+    size_t packetsWaiting() const { return mQueue.size(); }
+    bool   connected() const { return mConnected; }
+    void   close();
+    uint32_t lastId() const { return 0; }
+
+    // host-only: deliver up to max queued messages, returns the bytes taken
+    size_t hostDrain(size_t max) {
+        size_t bytes = 0;
+        for (; max > 0 && !mQueue.empty(); --max) {
+            bytes += mQueue.front().size();
+            mQueue.pop_front();
+            mMessages++;
+        }
+        mBytes += bytes;
+        return bytes;
+    }
+    uint64_t hostMessages() const { return mMessages; }
+    uint64_t hostBytes() const { return mBytes; }
+
+    static const size_t MAX_QUEUED = 32;
+
+private:
+    AsyncEventSource*       mSource;
+    bool                    mConnected = true;
+    std::deque<std::string> mQueue;
+    uint64_t                mMessages = 0;
+    uint64_t                mBytes = 0;
+};
+
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+class AsyncEventSource {
+public:
+    explicit AsyncEventSource(const char* url) : mUrl(url) {}
+    const char* url() const { return mUrl; }
+    void onConnect(ArEventHandlerFunction cb) { mOnConnect = cb; }
+    void onDisconnect(ArEventHandlerFunction cb) { mOnDisconnect = cb; }
+    size_t count() const {
+        size_t n = 0;
+        for (const auto& c : mClients) n += c->connected();
+        return n;
+    }
+
+    // host-only: a browser opens the stream
+    AsyncEventSourceClient* hostConnect() {
+        mClients.emplace_back(new AsyncEventSourceClient(this));
+        AsyncEventSourceClient* c = mClients.back().get();
+        if (mOnConnect) mOnConnect(c);
+        return c;
+    }
+    void hostDisconnected(AsyncEventSourceClient* c) {
+        if (mOnDisconnect) mOnDisconnect(c);
+    }
+
+private:
+    const char* mUrl;
+    ArEventHandlerFunction mOnConnect;
+    ArEventHandlerFunction mOnDisconnect;
+    std::vector<std::unique_ptr<AsyncEventSourceClient>> mClients;
+};
+
+inline void AsyncEventSourceClient::close() {
+    if (mConnected) {
+        mConnected = false;
+        mQueue.clear();
+        mSource->hostDisconnected(this);
+    }
+}
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : mPort(port) {}
+
+    void on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction onRequest,
+            ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr) {
+        (void)onUpload;   // multipart uploads are not used by the sketches
+        mRoutes.push_back({uri, method, onRequest, onBody});
+    }
+    AsyncEventSource& addHandler(AsyncEventSource* handler) { return *handler; }
+    void begin() { mStarted = true; }
+    void end() { mStarted = false; }
+
+    // host-only: run the first matching handler synchronously, 404 if none.
+    // As on the device, a route also matches the paths below it ("/x" takes "/x/y").
+    // A body is handed to the route's body handler in HOST_HTTP_CHUNK pieces first.
+    HostHttpResponse hostRequest(WebRequestMethod method, const char* url, const HostHttpHeaders& headers = {},
+                                 const std::string& body = std::string()) {
+        AsyncWebServerRequest request(method, url, headers);
+        std::string path = request.url().c_str();
+        for (const Route& route : mRoutes) {
+            bool match = path == route.uri ||
+                         (path.compare(0, route.uri.size(), route.uri) == 0 && path[route.uri.size()] == '/');
+            if ((route.method & method) && match) {
+                for (size_t i = 0; route.body && i < body.size(); i += HOST_HTTP_CHUNK) {
+                    std::string chunk = body.substr(i, HOST_HTTP_CHUNK);
+                    route.body(&request, reinterpret_cast<uint8_t*>(&chunk[0]), chunk.size(), i, body.size());
+                }
+                route.handler(&request);
+                return request.hostResponse();
+            }
+        }
+        request.send(404, "text/plain", "Not found");
+        return request.hostResponse();
+    }
+
+private:
+    struct Route {
+        std::string              uri;
+        WebRequestMethod         method;
+        ArRequestHandlerFunction handler;
+        ArBodyHandlerFunction    body;
+    };
+    uint16_t           mPort;
+    bool               mStarted = false;
+    std::vector<Route> mRoutes;
+};
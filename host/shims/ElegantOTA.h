@@ -0,0 +1,12 @@
+// Host shim for ElegantOTA (async mode): OTA is a no-op on the host.
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+
+class ElegantOTAClass {
+public:
+    void begin(AsyncWebServer*, const char* = "", const char* = "") {}
+    void loop() {}
+};
+
+extern ElegantOTAClass ElegantOTA;
@@ -0,0 +1,113 @@
+// Host shim for the ESP32 LittleFS API (FS.h File + LittleFS object).
+// Paths map into a host directory set with hostSetLittleFSRoot(); without a
+// root begin() fails, as on a device without a filesystem partition.
+#pragma once
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Print {
+public:
+    File() {}
+    explicit File(FILE* f, const std::string& name) : mFile(f), mName(name) {}
+    File(File&& o) noexcept : mFile(o.mFile), mName(o.mName) { o.mFile = nullptr; }
+    File& operator=(File&& o) noexcept {
+        if (this != &o) {
+            close();
+            mFile = o.mFile;
+            mName = o.mName;
+            o.mFile = nullptr;
+        }
+        return *this;
+    }
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+    ~File() { close(); }
+
+    explicit operator bool() const { return mFile != nullptr; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override {
+        return mFile ? fwrite(buf, 1, size, mFile) : 0;
+    }
+    using Print::write;
+    size_t read(uint8_t* buf, size_t size) { return mFile ? fread(buf, 1, size, mFile) : 0; }
+    int    read() { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    int    available() { return mFile ? (int)(size() - position()) : 0; }
+    bool   seek(uint32_t pos, SeekMode mode = SeekSet) {
+        return mFile && fseek(mFile, (long)pos, mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+    }
+    size_t position() const { return mFile ? (size_t)ftell(mFile) : 0; }
+    size_t size() const {
+        if (!mFile) return 0;
+        long cur = ftell(mFile);
+        fseek(mFile, 0, SEEK_END);
+        long end = ftell(mFile);
+        fseek(mFile, cur, SEEK_SET);
+        return (size_t)end;
+    }
+    void flush() { if (mFile) fflush(mFile); }
+    void close() {
+        if (mFile) {
+            fclose(mFile);
+            mFile = nullptr;
+        }
+    }
+    const char* name() const { return mName.c_str(); }
+
+private:
+    FILE*       mFile = nullptr;
+    std::string mName;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool /*formatOnFail*/ = false, const char* /*basePath*/ = "/littlefs", uint8_t /*maxOpenFiles*/ = 10,
+               const char* /*partitionLabel*/ = "spiffs") {
+        mMounted = !root().empty();
+        if (mMounted) {
+            mkdir(root().c_str(), 0755);
+        }
+        return mMounted;
+    }
+    void end() { mMounted = false; }
+    File open(const char* path, const char* mode = FILE_READ, bool /*create*/ = false) {
+        if (!mMounted) return File();
+        std::string p = root() + path;
+        return File(fopen(p.c_str(), mode[0] == 'r' && mode[1] == '+' ? "r+b" : mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb"), path);
+    }
+    bool exists(const char* path) {
+        struct stat st;
+        return mMounted && stat((root() + path).c_str(), &st) == 0;
+    }
+    bool remove(const char* path) { return mMounted && ::remove((root() + path).c_str()) == 0; }
+    bool rename(const char* from, const char* to) {
+        return mMounted && ::rename((root() + from).c_str(), (root() + to).c_str()) == 0;
+    }
+    size_t totalBytes() const { return 1536 * 1024; }   // default ESP32-C3 partition table
+
+    // host-only: directory that stands in for the partition ("" = no filesystem)
+    static std::string& root() { static std::string r; return r; }
+
+private:
+    bool mMounted = false;
+};
+
+typedef LittleFSFS FS;   // the only filesystem of the host build
+
+}  // namespace fs
+
+using fs::File;
+
+extern fs::LittleFSFS LittleFS;
+
+inline void hostSetLittleFSRoot(const char* dir) { fs::LittleFSFS::root() = dir ? dir : ""; }
@@ -0,0 +1,91 @@
+// Host implementation of the WiFi / WebSerial / ElegantOTA / LittleFS shims
+#include <WiFi.h>
+#include <WebSerial.h>
+#include <ElegantOTA.h>
+#include <LittleFS.h>
+
+namespace {
+bool     gWiFiLinkUp = true;
+uint32_t gWiFiLinkUpAtMs = 0;   // 0: none scheduled
+}
+
+WiFiClass       WiFi;
+WebSerialClass  WebSerial;
+ElegantOTAClass ElegantOTA;
+fs::LittleFSFS  LittleFS;
+
+void hostSetWiFiLinkUpAt(uint32_t ms) { gWiFiLinkUpAtMs = ms; }
+
+void hostSetWiFiLinkUp(bool up) {
+    if (up) {
+        gWiFiLinkUpAtMs = 0;
+    }
+    if (up == gWiFiLinkUp) {
+        return;
+    }
+    gWiFiLinkUp = up;
+    if (!up && WiFi.mAssociated) {
+        WiFi.mAssociated = false;
+        WiFi.hostEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    } else if (up && WiFi.mStarted && WiFi.getAutoReconnect()) {
+        WiFi.mAssociated = true;
+        WiFi.hostEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    }
+}
+
+wl_status_t WiFiClass::status() const {
+    // without begin() (WiFiMulti shim) the link alone counts
+    if (gWiFiLinkUp && (mAssociated || !mStarted)) {
+        return WL_CONNECTED;
+    }
+    return mStarted && !gWiFiLinkUp ? WL_NO_SSID_AVAIL : WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*) {
+    mStarted = true;
+    if (gWiFiLinkUp) {
+        mAssociated = true;
+        hostEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    } else {
+        hostEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    return status();
+}
+
+bool WiFiClass::disconnect(bool) {
+    if (mAssociated) {
+        mAssociated = false;
+        hostEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    return true;
+}
+
+int WiFiClass::onEvent(WiFiEventCb cb, arduino_event_id_t event) {
+    for (int i = 0; i < 4; ++i) {
+        if (mHandlers[i].cb == nullptr) {
+            mHandlers[i] = {cb, event};
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void WiFiClass::hostEvent(arduino_event_id_t event) {
+    for (const Handler& h : mHandlers) {
+        if (h.cb && (h.event == ARDUINO_EVENT_MAX || h.event == event)) {
+            h.cb(event);
+        }
+    }
+}
+
+// Like the ESP32 core this blocks until connected or the timeout expires.
+uint8_t WiFiClass::waitForConnectResult(unsigned long timeoutLength) {
+    uint32_t start = millis();
+    while (!gWiFiLinkUp && (millis() - start) < timeoutLength) {
+        delay(100);
+        if (gWiFiLinkUpAtMs && millis() >= gWiFiLinkUpAtMs) {
+            hostSetWiFiLinkUp(true);
+        }
+    }
+    return status();
+}
@@ -0,0 +1,607 @@
+// ---------------------------------------------------------------------------
+// Host shim for the VitoWiFi v3 API used by the sketches.
+//
+// Mirrors the public surface of bertmelis/VitoWiFi (Datapoint, converters,
+// VariantValue, OptolinkResult and VitoWiFi<VS1|VS2>) and implements the
+// VS1/KW and VS2/P300 protocols on top of the HardwareSerial shim, so the
+// sketch talks to a real byte stream (the Vitotronic emulator on a pty).
+//
+// KW in short: the controller sends 0x05 when idle; the master answers with
+// 0x01 followed by F7 <addr hi> <addr lo> <len> (read) or
+// F4 <addr hi> <addr lo> <len> <data...> (write). Reads are answered with
+// <len> raw bytes, writes with a single 0x00.
+//
+// P300 (VS2): the master resets the link with 0x04, waits for 0x05 and sends
+// 16 00 00, which the controller acknowledges with 0x06. Requests are then
+// checksummed telegrams 41 <len> 00 <fn> <addr hi> <addr lo> <n> [data] <sum>
+// (fn 01 read, 02 write), each acknowledged with 0x06 (0x15 on a bad sum)
+// and answered with a telegram of type 01 (response) or 03 (error), which the
+// master acknowledges in turn. No sync wait per request.
+//
+// A HostObserver can be installed to watch requests/responses without
+// touching the sketch (used by the bench).
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef VS1_SYNC_TIMEOUT_MS
+#define VS1_SYNC_TIMEOUT_MS 3000UL      // max wait for the controller's 0x05
+#endif
+#ifndef VS1_RESPONSE_TIMEOUT_MS
+#define VS1_RESPONSE_TIMEOUT_MS 2000UL  // max wait for the reply bytes
+#endif
+#ifndef VS2_INIT_TIMEOUT_MS
+#define VS2_INIT_TIMEOUT_MS 3000UL      // max wait for 0x05 / 0x06 during the P300 init
+#endif
+#ifndef VS2_ACK_TIMEOUT_MS
+#define VS2_ACK_TIMEOUT_MS 200UL        // max wait for the 0x06 after a request telegram
+#endif
+#ifndef VS2_RESPONSE_TIMEOUT_MS
+#define VS2_RESPONSE_TIMEOUT_MS 2000UL  // max wait for the complete response telegram
+#endif
+#ifndef VS1_FOLLOWUP_WINDOW_MS
+#define VS1_FOLLOWUP_WINDOW_MS 0UL      // >0: send next command without 0x05 within this window
+#endif
+
+namespace VitoWiFi {
+
+enum class OptolinkResult {
+    CONTINUE,
+    PACKET,
+    TIMEOUT,
+    LENGTH,
+    NACK,
+    CRC,
+    ERROR
+};
+
+// --- VariantValue ----------------------------------------------------------
+class VariantValue {
+public:
+    explicit VariantValue(uint8_t v)  : _type(Type::UINT), _u(v) {}
+    explicit VariantValue(uint16_t v) : _type(Type::UINT), _u(v) {}
+    explicit VariantValue(uint32_t v) : _type(Type::UINT), _u(v) {}
+    explicit VariantValue(uint64_t v) : _type(Type::UINT), _u(v) {}
+    explicit VariantValue(float v)    : _type(Type::FLOAT), _f(v) {}
+    explicit VariantValue(const uint8_t* raw) : _type(Type::RAW), _raw(raw) {}
+
+    operator uint8_t() const  { return (uint8_t)asUInt(); }
+    operator uint16_t() const { return (uint16_t)asUInt(); }
+    operator uint32_t() const { return (uint32_t)asUInt(); }
+    operator uint64_t() const { return asUInt(); }
+    operator float() const    { return _type == Type::FLOAT ? _f : (float)asUInt(); }
+    operator const uint8_t*() const { return _type == Type::RAW ? _raw : nullptr; }
+
+private:
+    enum class Type { UINT, FLOAT, RAW };
+    uint64_t asUInt() const {
+        if (_type == Type::FLOAT) return (uint64_t)(_f < 0 ? 0 : _f);
+        if (_type == Type::RAW) return 0;
+        return _u;
+    }
+    Type _type;
+    union {
+        uint64_t       _u;
+        float          _f;
+        const uint8_t* _raw;
+    };
+};
+
+// --- Converters ----------------------------------------------------------------
+class Converter {
+public:
+    virtual ~Converter() {}
+    virtual VariantValue decode(const uint8_t* data, uint8_t length) const = 0;
+    virtual void encode(uint8_t* buf, uint8_t length, const VariantValue& value) const = 0;
+    bool operator==(const Converter& rhs) const { return this == &rhs; }
+    bool operator!=(const Converter& rhs) const { return this != &rhs; }
+};
+
+namespace detail {
+inline int32_t readSignedLE(const uint8_t* data, uint8_t length) {
+    if (length >= 4) return (int32_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+    if (length == 2) return (int16_t)(data[0] | (data[1] << 8));
+    return length ? (int8_t)data[0] : 0;
+}
+inline uint64_t readUnsignedLE(const uint8_t* data, uint8_t length) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < length && i < 8; ++i) v |= (uint64_t)data[i] << (8 * i);
+    return v;
+}
+inline void writeLE(uint8_t* buf, uint8_t length, uint64_t v) {
+    for (uint8_t i = 0; i < length; ++i) buf[i] = (uint8_t)(v >> (8 * (i < 8 ? i : 7)));
+}
+}  // namespace detail
+
+class DivNConvert : public Converter {
+public:
+    explicit DivNConvert(float divisor) : _divisor(divisor) {}
+    VariantValue decode(const uint8_t* data, uint8_t length) const override {
+        return VariantValue((float)detail::readSignedLE(data, length) / _divisor);
+    }
+    void encode(uint8_t* buf, uint8_t length, const VariantValue& value) const override {
+        float scaled = (float)value * _divisor;
+        int32_t raw = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        detail::writeLE(buf, length, (uint64_t)(uint32_t)raw);
+    }
+private:
+    float _divisor;
+};
+
+class NoconvConvert : public Converter {
+public:
+    VariantValue decode(const uint8_t* data, uint8_t length) const override {
+        switch (length) {
+            case 1:  return VariantValue((uint8_t)data[0]);
+            case 2:  return VariantValue((uint16_t)detail::readUnsignedLE(data, 2));
+            case 4:  return VariantValue((uint32_t)detail::readUnsignedLE(data, 4));
+            case 8:  return VariantValue((uint64_t)detail::readUnsignedLE(data, 8));
+            default: return VariantValue(data);
+        }
+    }
+    void encode(uint8_t* buf, uint8_t length, const VariantValue& value) const override {
+        detail::writeLE(buf, length, (uint64_t)value);
+    }
+};
+
+inline DivNConvert   div10(10.0f);
+inline DivNConvert   div2(2.0f);
+inline DivNConvert   div3600(3600.0f);
+inline NoconvConvert noconv;
+
+// --- Datapoint -------------------------------------------------------------------
+class Datapoint {
+public:
+    Datapoint(const char* name, uint16_t address, uint8_t length, const Converter& converter)
+        : _name(name), _address(address), _length(length), _converter(&converter) {}
+
+    const char* name() const { return _name; }
+    uint16_t address() const { return _address; }
+    uint8_t length() const { return _length; }
+    const Converter& converter() const { return *_converter; }
+
+    VariantValue decode(const uint8_t* data, uint8_t length) const { return _converter->decode(data, length); }
+    void encode(uint8_t* buf, uint8_t length, const VariantValue& value) const { _converter->encode(buf, length, value); }
+
+private:
+    const char*      _name;
+    uint16_t         _address;
+    uint8_t          _length;
+    const Converter* _converter;
+};
+
+// --- host observation hook -------------------------------------------------------
+class HostObserver {
+public:
+    virtual ~HostObserver() {}
+    virtual void onRequest(const Datapoint& /*dp*/, bool /*isWrite*/) {}
+    virtual void onResponse(const Datapoint& /*dp*/, const uint8_t* /*data*/, uint8_t /*length*/) {}
+    virtual void onError(OptolinkResult /*error*/, const Datapoint& /*dp*/) {}
+};
+
+inline HostObserver*& hostObserver() {
+    static HostObserver* observer = nullptr;
+    return observer;
+}
+
+// --- VS1 / KW protocol ---------------------------------------------------------------
+class VS1 {
+public:
+    typedef void (*OnResponseCallback)(const uint8_t* data, uint8_t length, const Datapoint& request);
+    typedef void (*OnErrorCallback)(OptolinkResult error, const Datapoint& request);
+
+    explicit VS1(HardwareSerial* iface) : _iface(iface), _request("", 0, 0, noconv) {}
+
+    void onResponse(OnResponseCallback cb) { _onResponse = cb; }
+    void onError(OnErrorCallback cb) { _onError = cb; }
+
+    bool begin() {
+        _iface->begin(4800, SERIAL_8E1);
+        _state = State::IDLE;
+        return true;
+    }
+
+    void end() {
+        _iface->end();
+        _state = State::UNDEF;
+    }
+
+    bool read(const Datapoint& dp) {
+        if (_state != State::IDLE || dp.length() > sizeof(_buf)) {
+            return false;
+        }
+        _request = dp;
+        _isWrite = false;
+        _cmdLen = 0;
+        _cmd[_cmdLen++] = 0xF7;
+        _cmd[_cmdLen++] = (uint8_t)(dp.address() >> 8);
+        _cmd[_cmdLen++] = (uint8_t)(dp.address() & 0xFF);
+        _cmd[_cmdLen++] = dp.length();
+        _expected = dp.length();
+        startRequest();
+        return true;
+    }
+
+    bool write(const Datapoint& dp, const uint8_t* data, uint8_t length) {
+        if (_state != State::IDLE || length > sizeof(_buf) || length + 4 > (int)sizeof(_cmd)) {
+            return false;
+        }
+        _request = dp;
+        _isWrite = true;
+        _cmdLen = 0;
+        _cmd[_cmdLen++] = 0xF4;
+        _cmd[_cmdLen++] = (uint8_t)(dp.address() >> 8);
+        _cmd[_cmdLen++] = (uint8_t)(dp.address() & 0xFF);
+        _cmd[_cmdLen++] = length;
+        memcpy(&_cmd[_cmdLen], data, length);
+        _cmdLen += length;
+        memcpy(_buf, data, length);
+        _writeLen = length;
+        _expected = 1;
+        startRequest();
+        return true;
+    }
+
+    void loop() {
+        uint32_t now = millis();
+        switch (_state) {
+        case State::UNDEF:
+            break;
+        case State::IDLE:
+            // discard idle traffic (periodic 0x05)
+            while (_iface->available()) {
+                _iface->read();
+            }
+            break;
+        case State::WAIT_SYNC:
+            while (_iface->available()) {
+                if (_iface->read() == 0x05) {
+                    uint8_t ack = 0x01;
+                    _iface->write(&ack, 1);
+                    sendCommand(now);
+                    return;
+                }
+            }
+            if (now - _stateMs > VS1_SYNC_TIMEOUT_MS) {
+                finishError(OptolinkResult::TIMEOUT);
+            }
+            break;
+        case State::RECEIVE:
+            while (_iface->available() && _received < _expected) {
+                _rx[_received++] = (uint8_t)_iface->read();
+            }
+            if (_received >= _expected) {
+                finishResponse(now);
+            } else if (now - _stateMs > VS1_RESPONSE_TIMEOUT_MS) {
+                finishError(_received ? OptolinkResult::LENGTH : OptolinkResult::TIMEOUT);
+            }
+            break;
+        }
+    }
+
+private:
+    enum class State { UNDEF, IDLE, WAIT_SYNC, RECEIVE };
+
+    void startRequest() {
+        uint32_t now = millis();
+        if (HostObserver* o = hostObserver()) {
+            o->onRequest(_request, _isWrite);
+        }
+#if VS1_FOLLOWUP_WINDOW_MS > 0
+        if (_lastResponseMs != 0 && now - _lastResponseMs < VS1_FOLLOWUP_WINDOW_MS) {
+            sendCommand(now);
+            return;
+        }
+#endif
+        // drop syncs that arrived while nobody was listening; only a fresh
+        // 0x05 opens the controller's command window
+        while (_iface->available()) {
+            _iface->read();
+        }
+        _state = State::WAIT_SYNC;
+        _stateMs = now;
+    }
+
+    void sendCommand(uint32_t now) {
+        _iface->write(_cmd, _cmdLen);
+        _received = 0;
+        _state = State::RECEIVE;
+        _stateMs = now;
+    }
+
+    void finishResponse(uint32_t now) {
+        _state = State::IDLE;
+        _lastResponseMs = now;
+        if (_isWrite) {
+            if (_rx[0] != 0x00) {
+                finishError(OptolinkResult::NACK);
+                return;
+            }
+            memcpy(_rx, _buf, _writeLen);
+            _received = _writeLen;
+        }
+        if (HostObserver* o = hostObserver()) {
+            o->onResponse(_request, _rx, _received);
+        }
+        if (_onResponse) {
+            _onResponse(_rx, _received, _request);
+        }
+    }
+
+    void finishError(OptolinkResult result) {
+        _state = State::IDLE;
+        _lastResponseMs = 0;
+        while (_iface->available()) {
+            _iface->read();
+        }
+        if (HostObserver* o = hostObserver()) {
+            o->onError(result, _request);
+        }
+        if (_onError) {
+            _onError(result, _request);
+        }
+    }
+
+    HardwareSerial*    _iface;
+    State              _state = State::UNDEF;
+    uint32_t           _stateMs = 0;
+    uint32_t           _lastResponseMs = 0;
+    Datapoint          _request;
+    bool               _isWrite = false;
+    uint8_t            _cmd[4 + 32];
+    uint8_t            _cmdLen = 0;
+    uint8_t            _buf[32];
+    uint8_t            _writeLen = 0;
+    uint8_t            _rx[32];
+    uint8_t            _expected = 0;
+    uint8_t            _received = 0;
+    OnResponseCallback _onResponse = nullptr;
+    OnErrorCallback    _onError = nullptr;
+};
+
+// --- VS2 / P300 protocol -------------------------------------------------------------
+class VS2 {
+public:
+    typedef void (*OnResponseCallback)(const uint8_t* data, uint8_t length, const Datapoint& request);
+    typedef void (*OnErrorCallback)(OptolinkResult error, const Datapoint& request);
+
+    explicit VS2(HardwareSerial* iface) : _iface(iface), _request("", 0, 0, noconv) {}
+
+    void onResponse(OnResponseCallback cb) { _onResponse = cb; }
+    void onError(OnErrorCallback cb) { _onError = cb; }
+
+    bool begin() {
+        _iface->begin(4800, SERIAL_8E2);
+        startInit(millis());
+        return true;
+    }
+
+    void end() {
+        _iface->end();
+        _state = State::UNDEF;
+    }
+
+    bool read(const Datapoint& dp) {
+        if (_state != State::IDLE || dp.length() > sizeof(_rx) - 8) {
+            return false;
+        }
+        return startRequest(dp, 0x01, nullptr, dp.length());
+    }
+
+    bool write(const Datapoint& dp, const uint8_t* data, uint8_t length) {
+        if (_state != State::IDLE || length > sizeof(_tx) - 8) {
+            return false;
+        }
+        return startRequest(dp, 0x02, data, length);
+    }
+
+    void loop() {
+        uint32_t now = millis();
+        switch (_state) {
+        case State::UNDEF:
+            break;
+        case State::RESET:
+            // back in KW mode the controller syncs with 0x05; answer with the P300 start
+            while (_iface->available()) {
+                if (_iface->read() == 0x05) {
+                    const uint8_t start[] = {0x16, 0x00, 0x00};
+                    _iface->write(start, sizeof(start));
+                    _state = State::INIT;
+                    _stateMs = now;
+                    return;
+                }
+            }
+            if (now - _stateMs > VS2_INIT_TIMEOUT_MS) {
+                startInit(now);
+            }
+            break;
+        case State::INIT:
+            while (_iface->available()) {
+                if (_iface->read() == 0x06) {
+                    _state = State::IDLE;
+                    return;
+                }
+            }
+            if (now - _stateMs > VS2_ACK_TIMEOUT_MS) {
+                startInit(now);
+            }
+            break;
+        case State::IDLE:
+            while (_iface->available()) {
+                _iface->read();
+            }
+            break;
+        case State::WAIT_ACK:
+            if (_iface->available()) {
+                int c = _iface->read();
+                if (c == 0x06) {
+                    _received = 0;
+                    _state = State::RECEIVE;
+                    _stateMs = now;
+                } else {
+                    finishError(c == 0x15 ? OptolinkResult::NACK : OptolinkResult::ERROR, now);
+                }
+            } else if (now - _stateMs > VS2_ACK_TIMEOUT_MS) {
+                finishError(OptolinkResult::TIMEOUT, now);
+            }
+            break;
+        case State::RECEIVE:
+            while (_iface->available() && _received < sizeof(_rx)) {
+                _rx[_received++] = (uint8_t)_iface->read();
+                if (_received == 1 && _rx[0] != 0x41) {
+                    _received = 0;  // skip anything before the start byte
+                }
+                if (_received >= 2 && _received == (size_t)_rx[1] + 3) {
+                    parseResponse(now);
+                    return;
+                }
+            }
+            if (now - _stateMs > VS2_RESPONSE_TIMEOUT_MS) {
+                finishError(_received ? OptolinkResult::LENGTH : OptolinkResult::TIMEOUT, now);
+            }
+            break;
+        }
+    }
+
+private:
+    enum class State { UNDEF, RESET, INIT, IDLE, WAIT_ACK, RECEIVE };
+
+    void startInit(uint32_t now) {
+        while (_iface->available()) {
+            _iface->read();
+        }
+        uint8_t reset = 0x04;
+        _iface->write(&reset, 1);
+        _state = State::RESET;
+        _stateMs = now;
+    }
+
+    bool startRequest(const Datapoint& dp, uint8_t fn, const uint8_t* data, uint8_t length) {
+        _request = dp;
+        _isWrite = fn == 0x02;
+        size_t n = 0;
+        _tx[n++] = 0x41;
+        _tx[n++] = (uint8_t)(5 + (_isWrite ? length : 0));
+        _tx[n++] = 0x00;  // request
+        _tx[n++] = fn;
+        _tx[n++] = (uint8_t)(dp.address() >> 8);
+        _tx[n++] = (uint8_t)(dp.address() & 0xFF);
+        _tx[n++] = length;
+        if (_isWrite) {
+            memcpy(&_tx[n], data, length);
+            memcpy(_buf, data, length);
+            _writeLen = length;
+            n += length;
+        }
+        _tx[n] = checksum(&_tx[1], n - 1);
+        n++;
+        if (HostObserver* o = hostObserver()) {
+            o->onRequest(_request, _isWrite);
+        }
+        _iface->write(_tx, n);
+        _state = State::WAIT_ACK;
+        _stateMs = millis();
+        return true;
+    }
+
+    void parseResponse(uint32_t now) {
+        uint8_t ack = 0x06;
+        uint8_t len = _rx[1];
+        if (checksum(&_rx[1], len + 1) != _rx[len + 2]) {
+            finishError(OptolinkResult::CRC, now);
+            return;
+        }
+        _iface->write(&ack, 1);
+        if (_rx[2] == 0x03) {
+            finishError(OptolinkResult::ERROR, now);
+            return;
+        }
+        uint8_t n = _rx[6];
+        _state = State::IDLE;
+        if (_isWrite) {
+            memcpy(_rx, _buf, _writeLen);
+            n = _writeLen;
+        } else {
+            if (len < 5 + n) {
+                finishError(OptolinkResult::LENGTH, now);
+                return;
+            }
+            memmove(_rx, &_rx[7], n);
+        }
+        if (HostObserver* o = hostObserver()) {
+            o->onResponse(_request, _rx, n);
+        }
+        if (_onResponse) {
+            _onResponse(_rx, n, _request);
+        }
+    }
+
+    void finishError(OptolinkResult result, uint32_t now) {
+        // a lost or garbled exchange may have left the controller out of step: re-init
+        if (result == OptolinkResult::TIMEOUT || result == OptolinkResult::LENGTH) {
+            startInit(now);
+        } else {
+            _state = State::IDLE;
+        }
+        if (HostObserver* o = hostObserver()) {
+            o->onError(result, _request);
+        }
+        if (_onError) {
+            _onError(result, _request);
+        }
+    }
+
+    static uint8_t checksum(const uint8_t* data, size_t length) {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < length; ++i) sum += data[i];
+        return sum;
+    }
+
+    HardwareSerial*    _iface;
+    State              _state = State::UNDEF;
+    uint32_t           _stateMs = 0;
+    Datapoint          _request;
+    bool               _isWrite = false;
+    uint8_t            _tx[8 + 32];
+    uint8_t            _buf[32];
+    uint8_t            _writeLen = 0;
+    uint8_t            _rx[8 + 32];
+    size_t             _received = 0;
+    OnResponseCallback _onResponse = nullptr;
+    OnErrorCallback    _onError = nullptr;
+};
+
+// --- VitoWiFi facade ------------------------------------------------------------------
+template <class PROTOCOLVERSION>
+class VitoWiFi {
+public:
+    template <class IFACE>
+    explicit VitoWiFi(IFACE* iface) : _optolink(iface) {}
+
+    void onResponse(typename PROTOCOLVERSION::OnResponseCallback cb) { _optolink.onResponse(cb); }
+    void onError(typename PROTOCOLVERSION::OnErrorCallback cb) { _optolink.onError(cb); }
+
+    bool read(const Datapoint& datapoint) { return _optolink.read(datapoint); }
+
+    template <typename T>
+    bool write(const Datapoint& datapoint, T value) {
+        uint8_t buf[32];
+        uint8_t len = datapoint.length() <= sizeof(buf) ? datapoint.length() : sizeof(buf);
+        datapoint.encode(buf, len, VariantValue(value));
+        return _optolink.write(datapoint, buf, len);
+    }
+
+    bool write(const Datapoint& datapoint, const uint8_t* data, uint8_t length) {
+        return _optolink.write(datapoint, data, length);
+    }
+
+    bool begin() { return _optolink.begin(); }
+    void loop() { _optolink.loop(); }
+    void end() { _optolink.end(); }
+
+private:
+    PROTOCOLVERSION _optolink;
+};
+
+}  // namespace VitoWiFi
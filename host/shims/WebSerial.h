@@ -0,0 +1,40 @@
+// Host shim for WebSerial: output is counted and echoed to stdout only when
+// console echo is enabled (hostSetConsoleEcho), so benches stay quiet.
+// Every write() is one websocket frame on the device; hostSetFrameCostUs()
+// makes each of them busy the caller for that long.
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+
+class WebSerialClass : public Print {
+public:
+    void begin(AsyncWebServer*, const char* = "/webserial") {}
+    void loop() {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        mBytes += size;
+        mFrames++;
+        if (mFrameCostUs) {
+            uint32_t start = micros();
+            while (micros() - start < mFrameCostUs) {
+            }
+        }
+        if (hostConsoleEcho()) {
+            fwrite(buffer, 1, size, stdout);
+        }
+        return size;
+    }
+    using Print::write;
+
+    // host-only: bytes written since boot
+    uint64_t hostBytesWritten() const { return mBytes; }
+    uint64_t hostFramesWritten() const { return mFrames; }
+    void     hostSetFrameCostUs(uint32_t us) { mFrameCostUs = us; }
+
+private:
+    uint64_t mBytes = 0;
+    uint64_t mFrames = 0;
+    uint32_t mFrameCostUs = 0;
+};
+
+extern WebSerialClass WebSerial;
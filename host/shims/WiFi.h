@@ -0,0 +1,89 @@
+// Host shim for the ESP32 WiFi station API used by the sketches.
+// The link is "up" by default; the bench can drop it via hostSetWiFiLinkUp().
+// Events are delivered synchronously from begin() and hostSetWiFiLinkUp();
+// on the device they come from the WiFi task.
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS     = 0,
+    WL_NO_SSID_AVAIL   = 1,
+    WL_CONNECTED       = 3,
+    WL_CONNECT_FAILED  = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED    = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WIFI_POWER_8_5dBm = 34 } wifi_power_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_START        = 2,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED    = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP       = 7,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP      = 9,
+    ARDUINO_EVENT_MAX                   = 255
+} arduino_event_id_t;
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t) { return true; }
+    bool config(IPAddress local, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) {
+        mLocalIP = local;
+        return true;
+    }
+    bool setTxPower(wifi_power_t) { return true; }
+    // starts connecting; GOT_IP right away while the link is up, else
+    // DISCONNECTED (no AP found)
+    wl_status_t begin(const char*, const char* = nullptr);
+    bool disconnect(bool = false);
+    bool reconnect() { return begin(nullptr) == WL_CONNECTED; }
+    // like the ESP32 core, the station reconnects by itself unless disabled
+    bool setAutoReconnect(bool autoReconnect) {
+        mAutoReconnect = autoReconnect;
+        return true;
+    }
+    bool getAutoReconnect() const { return mAutoReconnect; }
+    int onEvent(WiFiEventCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    wl_status_t status() const;
+    uint8_t waitForConnectResult(unsigned long timeoutLength = 60000);
+    IPAddress localIP() const { return mLocalIP; }
+    uint8_t* macAddress(uint8_t* mac) const {
+        static const uint8_t kMac[6] = {0x02, 0x00, 0x00, 0xC3, 0x00, 0x01};
+        memcpy(mac, kMac, 6);
+        return mac;
+    }
+    int8_t RSSI() const { return -60; }
+
+    // host side: deliver an event to the registered handlers
+    void hostEvent(arduino_event_id_t event);
+
+    bool mStarted = false;       // begin() called
+    bool mAssociated = false;    // got an IP since
+
+private:
+    IPAddress mLocalIP = IPAddress(127, 0, 0, 1);
+    bool      mAutoReconnect = true;
+    struct Handler {
+        WiFiEventCb        cb;
+        arduino_event_id_t event;
+    };
+    Handler   mHandlers[4] = {};
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient {
+public:
+    bool connected() { return WiFi.status() == WL_CONNECTED; }
+};
+
+// --- host control hooks ------------------------------------------------------
+void hostSetWiFiLinkUp(bool up);
+// The link comes back at millis() == ms, also while a sketch blocks in
+// waitForConnectResult() (the bench cannot call hostSetWiFiLinkUp() then).
+void hostSetWiFiLinkUpAt(uint32_t ms);
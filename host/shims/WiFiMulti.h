@@ -0,0 +1,10 @@
+// Host shim for WiFiMulti: run() reports the simulated station state.
+#pragma once
+
+#include <WiFi.h>
+
+class WiFiMulti {
+public:
+    bool addAP(const char*, const char* = nullptr) { return true; }
+    uint8_t run(uint32_t = 5000) { return WiFi.status(); }
+};
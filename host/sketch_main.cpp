@@ -0,0 +1,440 @@
+// ---------------------------------------------------------------------------
+// Compiles a sketch (.ino) as a regular translation unit on the host.
+// HOST_SKETCH_INO is set by CMake to the absolute path of the sketch; local
+// headers (Vitocal_*.h, HA_mqtt_addin.h) resolve next to it as usual.
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+
+#include HOST_SKETCH_INO
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "bench/HostSketch.h"
+
+static HostPollGroup hostGroup(const char* name, const VitoBlockRange& blocks, int size,
+                               std::vector<VitoWiFi::Datapoint>& members) {
+    // a group's members are contiguous in vitoBlockMembers[], sorted by address
+    members.clear();
+    if (blocks.count) {
+        const uint8_t* ids = &vitoBlockMembers[vitoBlocks[blocks.first].first];
+        for (int i = 0; i < size; ++i) {
+            members.push_back(vitoDpDatapoint(ids[i]));
+        }
+    }
+    return {name, members.data(), (int)members.size(), blocks.count};
+}
+
+size_t hostPollGroups(HostPollGroup* out, size_t max) {
+    static std::vector<VitoWiFi::Datapoint> members[3];
+    const HostPollGroup groups[] = {
+        hostGroup("fast",   vitoFastBlocks,   vitoFastSize,   members[0]),
+        hostGroup("medium", vitoMediumBlocks, vitoMediumSize, members[1]),
+        hostGroup("slow",   vitoSlowBlocks,   vitoSlowSize,   members[2]),
+    };
+    size_t n = 0;
+    for (const HostPollGroup& g : groups) {
+        if (n < max) out[n++] = g;
+    }
+    return n;
+}
+
+void hostSetPollIntervals(uint32_t fastMs, uint32_t mediumMs, uint32_t slowMs) {
+    if (fastMs)   vitoSetClassInterval(VITO_CLASS_FAST,   fastMs);
+    if (mediumMs) vitoSetClassInterval(VITO_CLASS_MEDIUM, mediumMs);
+    if (slowMs)   vitoSetClassInterval(VITO_CLASS_SLOW,   slowMs);
+}
+
+const char* hostProtocolName() {
+    return vitoWIFI.protocolName();
+}
+
+void hostRaumSollCommand(float value) {
+    RaumSollTempSens.hostCommand(HANumeric(value));
+}
+
+HostWriteStats hostWriteStats() {
+    HostWriteStats w = {0, 0, 0, 0.0, 0};
+    uint64_t sum = 0;
+    for (const VitoWriteSlot& s : vitoWriteSlots) {
+        w.confirmed += s.confirmed;
+        w.failed    += s.failed;
+        w.coalesced += s.coalesced;
+        sum         += s.sumLatencyMs;
+        if (s.maxLatencyMs > w.maxLatencyMs) w.maxLatencyMs = s.maxLatencyMs;
+    }
+    w.meanLatencyMs = w.confirmed ? (double)sum / w.confirmed : 0.0;
+    return w;
+}
+
+HostLoopStats hostTakeLoopStats() {
+    HostLoopStats s;
+    s.minUs   = rtSamples ? rtMinUs : 0;
+    s.maxUs   = rtMaxUs;
+    s.meanUs  = rtSamples ? (float)rtSumUs / (float)rtSamples : 0.0f;
+    s.samples = rtSamples;
+    rtMinUs   = UINT32_MAX;
+    rtMaxUs   = 0;
+    rtSumUs   = 0;
+    rtSamples = 0;
+    return s;
+}
+
+HostDiscoveryStats hostDiscoveryStats() {
+    // batched configs (publishBatches()) still to go count as queued
+    uint32_t batched = VITO_MQTT_BATCH && vitoBatchConfigNext < DP_COUNT ? DP_COUNT - vitoBatchConfigNext : 0;
+    return {vitoDiscSent, vitoDiscSkipped, vitoDiscCount + batched, vitoDiscLastPassMs};
+}
+
+HostMqttQueueStats hostMqttQueueStats() {
+    return {vitoMqCount, vitoMqHighWater, vitoMqQueued, vitoMqDropped, vitoMqReplayed, vitoMqReplayRate};
+}
+
+HostDefsStats hostDefsStats() {
+    HostDefsStats d = {vitoDefCount, vitoDefBadLines, (uint32_t)vitoDefRamBytes, 0, 0, 0, 0};
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < vitoDefCount; ++i) {
+        const VitoDefState& s = vitoDefStates[i];
+        d.reads  += s.reads;
+        d.errors += s.errors;
+        if (s.lastOkMs == 0) {
+            d.neverRead++;
+        } else if (now - s.lastOkMs > d.maxAgeMs) {
+            d.maxAgeMs = now - s.lastOkMs;
+        }
+    }
+    return d;
+}
+
+HostBreakerStats hostBreakerStats() {
+    HostBreakerStats b = {0, vitoBreakersOpen, (double)vitoBreakerLostMs / 1000.0, vitoLinkRecoveries,
+                          vitoLinkLastRecoveryMs, vitoLinkStateNames[vitoLinkState]};
+    for (const VitoBreaker& br : vitoDpBreakers) {
+        b.quarantines += br.quarantines;
+    }
+    for (uint8_t i = 0; i < vitoDefCount; ++i) {
+        b.quarantines += vitoDefStates[i].breaker.quarantines;
+    }
+    return b;
+}
+
+HostOptoStats hostOptoStats() {
+    return {VITO_OPTO_TASK != 0, vitoOptoSteps, vitoOptoStepMaxUs,
+            vitoOptoSteps > 1 ? (double)vitoOptoStepSumUs / (vitoOptoSteps - 1) : 0.0,
+            vitoOptoOut.highWater, vitoOptoOut.dropped.load()};
+}
+
+HostValueStats hostValueStats() {
+    return {vitoValPuts, vitoValUnchanged, vitoValDecodes};
+}
+
+size_t hostTemperatures(HostTemperature* out, size_t max) {
+    size_t n = 0;
+    for (uint8_t id = 0; id < DP_COUNT && n < max; ++id) {
+        if (vitoDpTable[id].kind == VitoDpKind::Temperature && vitoValHas(id)) {
+            out[n++] = {vitoDpTable[id].tag, vitoValGet(id).f};
+        }
+    }
+    return n;
+}
+
+// Each known datapoint as a VITO_MSG_VALUE with its stored bytes; flip
+// toggles the lowest bit of the first byte every round.
+static double hostDispatchRun(uint32_t rounds, bool flip, uint32_t& messages) {
+    VitoOptoMsg msgs[DP_COUNT];
+    uint8_t n = 0;
+    for (uint8_t id = 0; id < DP_COUNT; ++id) {
+        if (!vitoValHas(id)) {
+            continue;
+        }
+        VitoOptoMsg& m = msgs[n++];
+        m = {0, VITO_MSG_VALUE, id, VITO_WRITE_NOT_OURS, vitoValRawLen[id], {0, 0, 0, 0}, 0.0f, 0};
+        memcpy(m.raw, vitoValRaw[id], vitoValRawLen[id]);
+    }
+    messages = rounds * n;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; ++r) {
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < n; ++i) {
+            msgs[i].ms = now;
+            if (flip) {
+                msgs[i].raw[0] ^= 1;
+            }
+            vitoDispatch(msgs[i]);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return messages ? std::chrono::duration<double, std::nano>(t1 - t0).count() / messages : 0.0;
+}
+
+HostDispatchCost hostDispatchCost(uint32_t rounds) {
+    HostDispatchCost c = {0.0, 0.0, 0};
+    c.unchangedNs = hostDispatchRun(rounds, false, c.messages);
+    c.changedNs   = hostDispatchRun(rounds, true, c.messages);
+    return c;
+}
+
+// --- trace replay -------------------------------------------------------------------
+// The UART of a replay: the parser reads what the trace says it read, and
+// what it writes is compared with the recorded TX.
+class HostTraceSerial : public HardwareSerial {
+public:
+    HostTraceSerial() : HardwareSerial(-1) {}
+
+    int available() override { return (int)rx.size(); }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+    int read() override {
+        if (rx.empty()) {
+            return -1;
+        }
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!checking) {
+            return size;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            written++;
+            if (txPos >= tx.size() || tx[txPos++] != buffer[i]) {
+                mismatches++;
+            }
+        }
+        return size;
+    }
+    using HardwareSerial::write;
+
+    std::deque<uint8_t>  rx;          // released to the parser
+    std::vector<uint8_t> tx;          // recorded, in order
+    size_t               txPos = 0;
+    uint32_t             written = 0;
+    uint32_t             mismatches = 0;
+    bool                 checking = true;
+};
+
+struct HostTraceRecord {
+    uint8_t        kind;   // VitoCapKind
+    uint64_t       us;     // since the header's start
+    const uint8_t* data;
+    uint8_t        n;
+};
+
+struct HostReplayObserver : VitoWiFi::HostObserver {
+    uint32_t responses = 0;
+    uint32_t errors = 0;
+    void onResponse(const VitoWiFi::Datapoint&, const uint8_t*, uint8_t) override { responses++; }
+    void onError(VitoWiFi::OptolinkResult, const VitoWiFi::Datapoint&) override { errors++; }
+};
+
+static uint32_t hostGet32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// The datapoint the sketch reads at address/length: block, single, definition.
+static VitoWiFi::Datapoint hostTraceDatapoint(uint16_t address, uint8_t length, bool& known) {
+    known = true;
+    for (uint8_t b = 0; b < vitoBlockCount; ++b) {
+        VitoWiFi::Datapoint dp = vitoBlockDatapoint(b);
+        if (dp.address() == address && dp.length() == length) return dp;
+    }
+    for (uint8_t i = 0; i < DP_COUNT; ++i) {
+        VitoWiFi::Datapoint dp = vitoDpDatapoint(i);
+        if (dp.address() == address && dp.length() == length) return dp;
+    }
+    for (uint8_t i = 0; i < vitoDefCount; ++i) {
+        VitoWiFi::Datapoint dp = vitoDefDatapoint(i);
+        if (dp.address() == address && dp.length() == length) return dp;
+    }
+    known = false;
+    return VitoWiFi::Datapoint("trace", address, length, VitoWiFi::noconv);
+}
+
+static uint32_t hostFnv(uint32_t h, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+HostReplayStats hostReplayTrace(const uint8_t* trace, size_t len) {
+    HostReplayStats r = {};
+    if (len < VITO_CAP_HEADER || hostGet32(trace) != VITO_CAP_MAGIC || trace[4] != VITO_CAP_VERSION) {
+        return r;
+    }
+    r.valid    = true;
+    r.protocol = trace[5];
+    size_t bytes = hostGet32(trace + 12);
+    if (bytes > len - VITO_CAP_HEADER) {
+        bytes = len - VITO_CAP_HEADER;
+        r.truncated = true;
+    }
+
+    // records; one cut off at the end is left out
+    std::vector<HostTraceRecord> recs;
+    const uint8_t* p   = trace + VITO_CAP_HEADER;
+    const uint8_t* end = p + bytes;
+    uint64_t us = 0;
+    while (p < end) {
+        HostTraceRecord rec = {(uint8_t)(*p >> 6), 0, nullptr, (uint8_t)(*p & VITO_CAP_MAX_N)};
+        const uint8_t* q = p + 1;
+        uint32_t dt = 0;
+        for (uint8_t shift = 0; q < end; shift += 7) {
+            uint8_t b = *q++;
+            dt |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        if (q + rec.n > end) {
+            r.truncated = true;
+            break;
+        }
+        us += dt;
+        rec.us   = us;
+        rec.data = q;
+        recs.push_back(rec);
+        p = q + rec.n;
+    }
+    r.records = (uint32_t)recs.size();
+    r.traceS  = recs.empty() ? 0.0 : (recs.back().us - recs.front().us) / 1e6;
+
+    // start where the parser was idle: at a BEGIN, or at the CALL of a request
+    // it accepted; earlier bytes are the protocol detection or the tail of an
+    // exchange the ring cut off
+    size_t first = recs.size();
+    for (size_t i = 0, call = recs.size(); i < recs.size() && first == recs.size(); ++i) {
+        if (recs[i].kind != VITO_CAP_EVENT || recs[i].n == 0) {
+            continue;
+        }
+        uint8_t type = recs[i].data[0];
+        if (type == VITO_CAP_EV_BEGIN) {
+            first = i;
+        } else if (type == VITO_CAP_EV_CALL) {
+            call = i;
+        } else if ((type == VITO_CAP_EV_READ || type == VITO_CAP_EV_WRITE) && call != recs.size()) {
+            first = call;
+        }
+    }
+    r.skipped = (uint32_t)first;
+    if (first == recs.size()) {
+        return r;
+    }
+
+    HostTraceSerial port;
+    for (size_t i = first; i < recs.size(); ++i) {
+        if (recs[i].kind == VITO_CAP_TX) {
+            port.tx.insert(port.tx.end(), recs[i].data, recs[i].data + recs[i].n);
+        }
+    }
+    HostReplayObserver observer;
+    VitoWiFi::HostObserver* saved = VitoWiFi::hostObserver();
+    VitoWiFi::hostObserver() = &observer;
+
+    // messages of the live run still waiting do not belong to the replay
+    vitoOptoDrain(VITO_OPTO_RING, vitoDispatchMsg);
+    uint32_t digest = VITO_DISC_FNV;
+    auto dispatch = [&](const VitoOptoMsg& m) {
+        digest = hostFnv(digest, &m.kind, 4);   // kind, id, aux, len
+        digest = hostFnv(digest, m.raw, sizeof(m.raw));
+        digest = hostFnv(digest, &m.value, sizeof(m.value));
+        r.messages++;
+        vitoDispatchMsg(m);
+    };
+
+    VitoOptolink parser(&port);
+    parser.onResponse(onVitoResponse);
+    parser.onError(onVitoError);
+    parser.select(r.protocol == (uint8_t)VitoProtocol::VS2 ? VITO_PROTOCOL_VS2 : VITO_PROTOCOL_VS1);
+    if (recs[first].data[0] != VITO_CAP_EV_BEGIN) {
+        // capture started in a session: bring the parser to idle first
+        port.checking = false;
+        parser.begin();
+        if (parser.protocol() == VitoProtocol::VS2) {
+            for (uint8_t c : {0x05, 0x06}) {
+                port.rx.push_back(c);
+                parser.loop();
+            }
+        }
+        port.checking = true;
+    }
+
+    // the clock only moves forward, also from one replay to the next
+    static uint64_t lastUs = 0;
+    uint64_t t0 = std::max(hostClockUs(), lastUs) - recs[first].us;
+    auto wall0 = std::chrono::steady_clock::now();
+    for (size_t i = first; i < recs.size(); ++i) {
+        const HostTraceRecord& rec = recs[i];
+        hostFreezeClock(t0 + rec.us);
+        parser.loop();   // timeouts due before this record
+        if (rec.kind == VITO_CAP_RX) {
+            port.rx.insert(port.rx.end(), rec.data, rec.data + rec.n);
+            r.rxBytes += rec.n;
+            for (uint8_t idle = 0; !port.rx.empty() && idle < 8;) {
+                size_t before = port.rx.size();
+                parser.loop();
+                idle = port.rx.size() < before ? 0 : idle + 1;
+            }
+            r.stalled += (uint32_t)port.rx.size();
+            port.rx.clear();
+        } else if (rec.kind == VITO_CAP_EVENT && rec.n >= 1) {
+            uint8_t type = rec.data[0];
+            if (type == VITO_CAP_EV_BEGIN && rec.n >= 2) {
+                parser.select(rec.data[1] == (uint8_t)VitoProtocol::VS2 ? VITO_PROTOCOL_VS2 : VITO_PROTOCOL_VS1);
+                parser.begin();
+            } else if (type == VITO_CAP_EV_END) {
+                parser.end();
+            } else if ((type == VITO_CAP_EV_READ || type == VITO_CAP_EV_WRITE) && rec.n >= 4) {
+                uint16_t address = (uint16_t)(rec.data[1] << 8 | rec.data[2]);
+                bool known = false;
+                bool ok;
+                if (type == VITO_CAP_EV_READ) {
+                    VitoWiFi::Datapoint dp = hostTraceDatapoint(address, rec.data[3], known);
+                    ok = parser.read(dp);
+                    r.unresolved += known ? 0 : 1;
+                } else {
+                    // the sketch's write datapoints are not in its read tables
+                    VitoWiFi::Datapoint dp("trace", address, rec.data[3], VitoWiFi::noconv);
+                    ok = parser.write(dp, rec.data + 4, (uint8_t)(rec.n - 4));
+                }
+                if (ok) {
+                    r.requests++;
+                } else {
+                    r.rejected++;
+                }
+            }
+        }
+        vitoOptoDrain(VITO_OPTO_RING, dispatch);
+    }
+    parser.loop();
+    vitoOptoDrain(VITO_OPTO_RING, dispatch);
+    r.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+    lastUs = hostClockUs();
+    hostReleaseClock();
+    VitoWiFi::hostObserver() = saved;
+
+    r.txBytes      = port.written;
+    r.txMismatches = port.mismatches + (uint32_t)(port.tx.size() - std::min(port.txPos, port.tx.size()));
+    r.responses    = observer.responses;
+    r.errors       = observer.errors;
+    r.digest       = digest;
+    return r;
+}
+
+void hostStopOptolink() {
+    vitoOptoStop();
+}
+
+AsyncEventSource& hostEvents() {
+    return events;
+}
+
+HostHttpResponse hostHttpGet(const char* url, const HostHttpHeaders& headers) {
+    return server.hostRequest(HTTP_GET, url, headers);
+}
+
+HostHttpResponse hostHttpPost(const char* url, const std::string& body) {
+    return server.hostRequest(HTTP_POST, url, {}, body);
+}
@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------------
+// Block-read planner test (Vitocal_blockread.h), run by ctest.
+//
+// Plans the sketch's polling groups the way setup() does and checks that
+// every block covers its members and that no two members of a block share a
+// byte: a block reply is sliced per member, so overlapping datapoints (e.g.
+// VorlaufTemp 0x0105/2 and RuecklaufTemp 0x0106/2) must be read separately.
+//
+// Usage: vito_planner_test
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <VitoWiFi.h>
+#include "Vitocal_blockread.h"
+
+#include <stdio.h>
+
+namespace {
+
+int gFailures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            gFailures++;                                                   \
+        }                                                                  \
+    } while (0)
+
+uint8_t blockOf(uint8_t id) {
+    for (uint8_t b = 0; b < vitoBlockCount; ++b) {
+        const VitoBlock& blk = vitoBlocks[b];
+        for (uint8_t i = 0; i < blk.count; ++i) {
+            if (vitoBlockMembers[blk.first + i] == id) {
+                return b;
+            }
+        }
+    }
+    return VITO_DP_NONE;
+}
+
+// Every member inside its block, in address order, without shared bytes.
+void checkBlocks() {
+    for (uint8_t b = 0; b < vitoBlockCount; ++b) {
+        const VitoBlock& blk = vitoBlocks[b];
+        uint32_t prevEnd = blk.address;
+        for (uint8_t i = 0; i < blk.count; ++i) {
+            const VitoDpSpec& s = vitoDpSpecs[vitoBlockMembers[blk.first + i]];
+            CHECK(s.address >= prevEnd);
+            CHECK(s.address + s.length <= (uint32_t)blk.address + blk.length);
+            prevEnd = s.address + s.length;
+        }
+    }
+}
+
+void testSketchGroups() {
+    vitoPlanReset();
+    vitoPlanGroup(vitoFast, vitoFastSize);
+    vitoPlanGroup(vitoMedium, vitoMediumSize);
+    vitoPlanGroup(vitoSlow, vitoSlowSize);
+    checkBlocks();
+    for (uint8_t id = 0; id < DP_COUNT; ++id) {
+        CHECK(blockOf(id) != VITO_DP_NONE);
+    }
+    CHECK(blockOf(DP_VORLAUF_IST) != blockOf(DP_RUECKLAUF));
+}
+
+void testOverlapSplits() {
+    const uint8_t group[] = {DP_RUECKLAUF, DP_VORLAUF_IST};
+    vitoPlanReset();
+    VitoBlockRange r = vitoPlanGroup(group, 2);
+    CHECK(r.count == 2);
+    CHECK(vitoBlocks[0].address == 0x0105 && vitoBlocks[0].length == 2);
+    CHECK(vitoBlocks[1].address == 0x0106 && vitoBlocks[1].length == 2);
+    checkBlocks();
+}
+
+void testNeighboursMerge() {
+    // 0x0101/2 and 0x0105/2: two unused bytes apart, one read of 6 bytes
+    const uint8_t group[] = {DP_VORLAUF_IST, DP_TEMP_OUTSIDE};
+    vitoPlanReset();
+    VitoBlockRange r = vitoPlanGroup(group, 2);
+    CHECK(r.count == 1);
+    CHECK(vitoBlocks[0].address == 0x0101 && vitoBlocks[0].length == 6 && vitoBlocks[0].count == 2);
+    checkBlocks();
+}
+
+void testNoCoalescing() {
+    vitoPlanReset();
+    VitoBlockRange r = vitoPlanGroup(vitoMedium, vitoMediumSize, 0, 0);
+    CHECK(r.count == vitoMediumSize);
+    checkBlocks();
+}
+
+}  // namespace
+
+int main() {
+    testSketchGroups();
+    testOverlapSplits();
+    testNeighboursMerge();
+    testNoCoalescing();
+    if (gFailures) {
+        fprintf(stderr, "planner test: %d check(s) failed\n", gFailures);
+        return 1;
+    }
+    printf("planner test: ok\n");
+    return 0;
+}
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+"""Embed scripts/live.html gzipped into Vitocal_dashboard.h of both sketches.
+
+Run after editing live.html:  python3 scripts/gen_dashboard.py
+"""
+import gzip
+import os
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SKETCHES = ["Vitocal_Optolink-esp32C3", "Vitocal_Optolink-esp32C3-Bartels"]
+
+
+def main():
+    with open(os.path.join(ROOT, "scripts", "live.html"), "rb") as f:
+        html = f.read()
+    data = gzip.compress(html, compresslevel=9, mtime=0)
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    header = (
+        "#pragma once\n\n"
+        "// Generated by scripts/gen_dashboard.py from scripts/live.html - do not edit.\n"
+        "// Live datapoint page (GET /live), gzipped: %d bytes, %d uncompressed.\n\n"
+        "#include <Arduino.h>\n\n"
+        "static const uint8_t vitoDashboardGz[] PROGMEM = {\n%s\n};\n"
+        % (len(data), len(html), "\n".join(lines))
+    )
+    for sketch in SKETCHES:
+        with open(os.path.join(ROOT, sketch, "Vitocal_dashboard.h"), "w", newline="\n") as f:
+            f.write(header)
+    print("live.html: %d -> %d bytes" % (len(html), len(data)))
+
+
+if __name__ == "__main__":
+    main()
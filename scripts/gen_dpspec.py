@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+"""Generate the datapoint tables of each sketch from its dpspec.toml.
+
+Writes Vitocal_dpspec.h (IDs, names, address records, poll groups, labels)
+and Vitocal_dpentities.h (HA entities, dispatch, discovery, adaptive and
+publish tables) next to the spec. Run after editing a spec:
+
+    python3 scripts/gen_dpspec.py            # both sketches
+    python3 scripts/gen_dpspec.py --check    # fail if a header is stale
+
+Needs Python 3.11 (tomllib).
+"""
+import os
+import sys
+import tomllib
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SKETCHES = ["Vitocal_Optolink-esp32C3", "Vitocal_Optolink-esp32C3-Bartels"]
+
+NAME_LEN = 24           # VITO_DP_NAME_LEN
+MAX_DATAPOINTS = 254    # VitoDpId is a uint8_t, 0xFF is VITO_DP_NONE
+CLASSES = ["fast", "medium", "slow"]
+CONVERTERS = {"noconv": "VITO_CONV_NOCONV", "div10": "VITO_CONV_DIV10",
+              "div2": "VITO_CONV_DIV2", "div3600": "VITO_CONV_DIV3600"}
+KINDS = {"temperature": "Temperature", "setpoint": "Setpoint", "binary": "Binary",
+         "label": "Label", "raw": "Raw"}
+# paced discovery (Vitocal_discovery.h)
+ENTITY_TYPES = {"temperature": "VitoPaced<HASensorNumber>", "setpoint": "VitoPaced<HANumber>",
+                "binary": "VitoPaced<HABinarySensor>", "label": "VitoPaced<HASensor>"}
+FILTERS = {"none": "VITO_FILTER_NONE", "ema": "VITO_FILTER_EMA", "median": "VITO_FILTER_MEDIAN"}
+ADAPT_FLAGS = {"boost": "VITO_ADAPT_BOOST", "trigger_on": "VITO_ADAPT_TRIGGER_ON",
+               "trigger_chg": "VITO_ADAPT_TRIGGER_CHG"}
+GENERATED = "// Generated by scripts/gen_dpspec.py from dpspec.toml - do not edit.\n"
+
+
+class SpecError(Exception):
+    pass
+
+
+def c_str(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def c_float(v):
+    s = repr(float(v))
+    return s + "f"
+
+
+def c_ms(v):
+    return "%dUL" % v
+
+
+def table(rows, indent="  "):
+    """Align the comma-separated cells of rows (lists of strings) in columns."""
+    widths = [max(len(r[i]) for r in rows if i < len(r)) for i in range(max(len(r) for r in rows))]
+    out = []
+    for r in rows:
+        cells = [c + "," if i < len(r) - 1 else c for i, c in enumerate(r)]
+        line = " ".join(c.ljust(widths[i] + 1) if i < len(r) - 1 else c for i, c in enumerate(cells))
+        out.append(line)
+    return out
+
+
+class Datapoint:
+    def __init__(self, index, d, spec):
+        self.where = "datapoint %d (%s)" % (index, d.get("name", "?"))
+        self.name = self.req(d, "name", str)
+        self.id = "DP_" + self.req(d, "id", str)
+        self.address = self.req(d, "address", int)
+        self.length = self.req(d, "length", int)
+        self.conv = self.choice(self.req(d, "conv", str), CONVERTERS, "conv")
+        self.kind = self.req(d, "kind", str)
+        self.choice(self.kind, KINDS, "kind")
+        self.tag = self.req(d, "tag", str)
+        self.hook = d.get("hook")
+        self.write = bool(d.get("write", False))
+        self.labels = d.get("labels")
+
+        if len(self.name.encode()) >= NAME_LEN:
+            self.fail("name longer than %d bytes" % (NAME_LEN - 1))
+        if not 0 <= self.address <= 0xFFFF:
+            self.fail("address out of range")
+        if self.length not in (1, 2, 4):
+            self.fail("length must be 1, 2 or 4")
+        if self.kind == "label":
+            if self.labels not in spec.get("labels", {}):
+                self.fail("label kind needs labels = <name in [labels]>")
+        elif self.labels is not None:
+            self.fail("labels only apply to kind = \"label\"")
+        if self.kind == "setpoint" and not self.write:
+            self.fail("a setpoint is written from its HA Number: set write = true")
+
+        poll = self.req(d, "poll", dict)
+        self.cls = self.choice(self.req(poll, "class", str), CLASSES, "poll.class")
+        cls_ms = spec["classes"][self.cls]
+        self.period_ms = self.ms(self.req(poll, "period", (int, float)), cls_ms)
+        self.max_age_ms = self.ms(self.req(poll, "max_age", (int, float)), cls_ms)
+
+        adapt = self.req(d, "adapt", dict)
+        self.adapt_min_ms = self.ms(self.req(adapt, "min", (int, float)), cls_ms)
+        self.adapt_max_ms = self.ms(self.req(adapt, "max", (int, float)), cls_ms)
+        self.adapt_deadband = self.req(adapt, "deadband", (int, float))
+        self.adapt_flags = [self.choice(f, ADAPT_FLAGS, "adapt.flags") for f in adapt.get("flags", [])]
+
+        pub = d.get("publish", {})
+        self.pub_abs = pub.get("deadband", 0.0)
+        self.pub_rel = pub.get("rel_deadband", 0.0)
+        self.pub_filter = self.choice(pub.get("filter", "none"), FILTERS, "publish.filter")
+        self.pub_min_s = pub.get("min_interval", 0)
+        self.pub_heartbeat = pub.get("heartbeat", 0)
+
+        self.ha = d.get("ha")
+        if self.kind == "raw":
+            if self.ha is not None:
+                self.fail("raw datapoints have no entity")
+        else:
+            if self.ha is None:
+                self.fail("needs an [datapoint.ha] table")
+            for key in ("entity", "unique_id", "object_id", "name", "icon"):
+                self.req(self.ha, key, str)
+            if self.kind in ("temperature", "setpoint"):
+                if self.ha.get("precision", 0) not in (0, 1, 2, 3):
+                    self.fail("ha.precision must be 0..3")
+            if self.kind == "setpoint":
+                for key in ("min", "max", "step"):
+                    self.req(self.ha, key, (int, float))
+
+    def fail(self, msg):
+        raise SpecError("%s: %s" % (self.where, msg))
+
+    def req(self, d, key, types):
+        if key not in d:
+            self.fail("missing '%s'" % key)
+        if not isinstance(d[key], types) or isinstance(d[key], bool):
+            self.fail("'%s' has the wrong type" % key)
+        return d[key]
+
+    def choice(self, value, allowed, key):
+        if value not in allowed:
+            self.fail("%s must be one of %s" % (key, ", ".join(allowed)))
+        return value
+
+    def ms(self, multiple, cls_ms):
+        """Period given in multiples of the class interval -> ms."""
+        if multiple < 0:
+            self.fail("negative period")
+        return int(round(multiple * cls_ms))
+
+
+def load(sketch):
+    path = os.path.join(ROOT, sketch, "dpspec.toml")
+    with open(path, "rb") as f:
+        spec = tomllib.load(f)
+    classes = spec.get("classes", {})
+    if sorted(classes) != sorted(CLASSES) or not all(isinstance(v, int) and v > 0 for v in classes.values()):
+        raise SpecError("[classes] needs fast, medium and slow intervals in ms")
+    for key, labels in spec.get("labels", {}).items():
+        if not labels or not all(isinstance(l, str) for l in labels) or len(labels) > 255:
+            raise SpecError("labels.%s: 1..255 strings" % key)
+    dps = [Datapoint(i, d, spec) for i, d in enumerate(spec.get("datapoint", []))]
+    if not 0 < len(dps) <= MAX_DATAPOINTS:
+        raise SpecError("1..%d datapoints" % MAX_DATAPOINTS)
+    for attr in ("name", "id"):
+        seen = set()
+        for dp in dps:
+            if getattr(dp, attr) in seen:
+                dp.fail("duplicate %s" % attr)
+            seen.add(getattr(dp, attr))
+    entities = set()
+    for dp in dps:
+        if dp.ha:
+            for key in ("entity", "unique_id"):
+                if (key, dp.ha[key]) in entities:
+                    dp.fail("duplicate ha.%s" % key)
+                entities.add((key, dp.ha[key]))
+    return spec, dps
+
+
+def gen_spec(spec, dps):
+    counts = {c: sum(1 for dp in dps if dp.cls == c) for c in CLASSES}
+    out = ["#pragma once", "", GENERATED.rstrip("\n"),
+           "// %d datapoints (fast %d, medium %d, slow %d); constant data only, the compiler"
+           % (len(dps), counts["fast"], counts["medium"], counts["slow"]),
+           "// keeps all of it in flash. Included by Vitocal_datapoints.h.",
+           "",
+           "// Default interval of each poll class (ms); the periods below are written for these",
+           "static constexpr uint32_t vitoClassDefaultMs[VITO_CLASS_COUNT] = {%s};"
+           % ", ".join(c_ms(spec["classes"][c]) for c in CLASSES),
+           "",
+           "// Polled datapoint IDs (row in vitoDpNames / vitoDpSpecs / per-DP tables)",
+           "enum VitoDpId : uint8_t {"]
+    for i, dp in enumerate(dps):
+        out.append("  %s%s," % (dp.id, " = 0" if i == 0 else ""))
+    out += ["  DP_COUNT", "};", "",
+            "// Names of the polled datapoints, one fixed-size row per ID. A request's",
+            "// Datapoint points into this table, which is how the ID travels with it.",
+            "static const size_t VITO_DP_NAME_LEN = %d;" % NAME_LEN,
+            "static const char vitoDpNames[DP_COUNT][VITO_DP_NAME_LEN] = {"]
+    out += ["  %s%s" % (c_str(dp.name), "," if i < len(dps) - 1 else "") for i, dp in enumerate(dps)]
+    out += ["};", ""]
+
+    labels = spec.get("labels", {})
+    if labels:
+        out.append("// Value texts of the Label datapoints")
+        for key, texts in labels.items():
+            out.append("static const char* const %sLabels[] = {" % key)
+            out += ["  %s%s" % (c_str(t), "," if i < len(texts) - 1 else "") for i, t in enumerate(texts)]
+            out += ["};", ""]
+
+    out.append("// {address, length, converter, class, flags, period, max age}; period and age")
+    out.append("// budget at the class default interval, scaled with it (Vitocal_scheduler.h)")
+    out.append("static constexpr VitoDpSpec vitoDpSpecs[DP_COUNT] = {")
+    width = max(len(dp.id) for dp in dps)
+    rows = [["{ 0x%04X" % dp.address, str(dp.length), CONVERTERS[dp.conv], "VITO_CLASS_" + dp.cls.upper(),
+             "VITO_DP_WRITABLE" if dp.write else "0", c_ms(dp.period_ms), c_ms(dp.max_age_ms) + " },"]
+            for dp in dps]
+    for dp, line in zip(dps, table(rows)):
+        out.append("  /* %s */ %s" % (dp.id.ljust(width), line))
+    out += ["};", ""]
+
+    out.append("// Poll groups: only members of the same group are merged into one block read")
+    for c in CLASSES:
+        members = [dp.id for dp in dps if dp.cls == c]
+        var = "vito" + c.capitalize()
+        out.append("static constexpr uint8_t %s[] = {" % var)
+        out += ["  %s%s" % (m, "," if i < len(members) - 1 else "") for i, m in enumerate(members)]
+        out.append("};")
+        out.append("static constexpr int %sSize = sizeof(%s);" % (var, var))
+    return "\n".join(out) + "\n"
+
+
+def gen_entities(spec, dps):
+    width = max(len(dp.id) for dp in dps)
+    out = ["#pragma once", "", GENERATED.rstrip("\n"),
+           "// HA entities of the datapoints and the per-datapoint tables that refer to",
+           "// them or to module types. Included by HA_mqtt_addin.h (HA_PREFIX).",
+           ""]
+
+    out.append("//*** entities ***************************************************")
+    rows = []
+    for dp in dps:
+        if dp.kind == "raw":
+            continue
+        args = "HA_PREFIX %s" % c_str(dp.ha["unique_id"])
+        if dp.kind in ("temperature", "setpoint"):
+            args += ", HANumber::PrecisionP%d" % dp.ha.get("precision", 0)
+        rows.append([ENTITY_TYPES[dp.kind], dp.ha["entity"], "(%s);" % args])
+    tw = max(len(r[0]) for r in rows)
+    ew = max(len(r[1]) for r in rows)
+    out += ["%s %s %s" % (r[0].ljust(tw), r[1].ljust(ew), r[2]) for r in rows]
+    out.append("")
+
+    hooks = []
+    for dp in dps:
+        if dp.hook and dp.hook not in hooks:
+            hooks.append(dp.hook)
+    if hooks:
+        out.append("// Side effects beyond the datapoint's own entity, defined in the sketch")
+        out += ["static void %s(const VitoDpValue& v);" % h for h in hooks]
+        out.append("")
+
+    out.append("// Dispatch table (Vitocal_registry.h): {log tag, kind, entity, labels, label count, hook}")
+    out.append("static constexpr VitoDpEntry vitoDpTable[DP_COUNT] = {")
+    rows = []
+    for dp in dps:
+        labels = ["nullptr", "0"]
+        if dp.kind == "label":
+            labels = ["%sLabels" % dp.labels, str(len(spec["labels"][dp.labels]))]
+        rows.append(["{ " + c_str(dp.tag), "VitoDpKind::" + KINDS[dp.kind],
+                     "&" + dp.ha["entity"] if dp.ha else "nullptr"] + labels + [(dp.hook or "nullptr") + " },"])
+    for dp, line in zip(dps, table(rows, "")):
+        out.append("  /* %s */ %s" % (dp.id.ljust(width), line))
+    out += ["};", ""]
+
+    out.append("// Discovery metadata: {object id, name, icon, unit, min, max, step (Setpoint)}")
+    out.append("static const VitoDpHaMeta vitoDpHaMeta[DP_COUNT] = {")
+    rows = []
+    for dp in dps:
+        if dp.ha is None:
+            rows.append(["{ nullptr", "nullptr", "nullptr", "nullptr", "0.0f", "0.0f", "0.0f }"])
+            continue
+        unit = c_str(dp.ha["unit"]) if "unit" in dp.ha else "nullptr"
+        limits = [c_float(dp.ha.get(k, 0)) for k in ("min", "max", "step")]
+        rows.append(["{ HA_PREFIX " + c_str(dp.ha["object_id"]), c_str(dp.ha["name"]), c_str(dp.ha["icon"]), unit]
+                    + limits[:2] + [limits[2] + " }"])
+    for dp, line in zip(dps, table(rows, "")):
+        out.append("  /* %s */ %s," % (dp.id.ljust(width), line))
+    out += ["};", ""]
+
+    out.append("// Adaptive polling bounds (Vitocal_adaptive.h): {min period, max period, deadband, flags}")
+    out.append("const VitoAdaptRule vitoAdaptRules[DP_COUNT] = {")
+    rows = [["{ " + c_ms(dp.adapt_min_ms), c_ms(dp.adapt_max_ms), c_float(dp.adapt_deadband),
+             (" | ".join(ADAPT_FLAGS[f] for f in dp.adapt_flags) or "0") + " },"] for dp in dps]
+    for dp, line in zip(dps, table(rows, "")):
+        out.append("  /* %s */ %s" % (dp.id.ljust(width), line))
+    out += ["};", ""]
+
+    out.append("// Publish policy (Vitocal_publish.h): {abs deadband, rel deadband, filter, min interval s, heartbeat min}")
+    out.append("const VitoPublishPolicy vitoPublishPolicy[DP_COUNT] = {")
+    rows = [["{ " + c_float(dp.pub_abs), c_float(dp.pub_rel), FILTERS[dp.pub_filter], str(dp.pub_min_s),
+             str(dp.pub_heartbeat) + " },"] for dp in dps]
+    for dp, line in zip(dps, table(rows, "")):
+        out.append("  /* %s */ %s" % (dp.id.ljust(width), line))
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def main(argv):
+    check = "--check" in argv
+    sketches = [a for a in argv if not a.startswith("--")] or SKETCHES
+    stale = []
+    for sketch in sketches:
+        try:
+            spec, dps = load(sketch)
+        except (SpecError, tomllib.TOMLDecodeError) as e:
+            sys.exit("%s/dpspec.toml: %s" % (sketch, e))
+        for name, text in (("Vitocal_dpspec.h", gen_spec(spec, dps)),
+                           ("Vitocal_dpentities.h", gen_entities(spec, dps))):
+            path = os.path.join(ROOT, sketch, name)
+            old = open(path, encoding="utf-8").read() if os.path.exists(path) else None
+            if old == text:
+                continue
+            if check:
+                stale.append(os.path.join(sketch, name))
+                continue
+            with open(path, "w", encoding="utf-8", newline="\n") as f:
+                f.write(text)
+        print("%s: %d datapoints, %d writable" % (sketch, len(dps), sum(1 for dp in dps if dp.write)))
+    if stale:
+        sys.exit("stale, run scripts/gen_dpspec.py: " + ", ".join(stale))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])